@@ -3,6 +3,7 @@
 
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <glad/glad.h>
@@ -13,30 +14,114 @@
 #include <imgui_impl_opengl3.h>
 
 #include "ArrayBuffer.h"
+#include "Benchmark.h"
 #include "Buffers.h"
+#include "FramePacer.h"
+#include "GLDeletionQueue.h"
+#include "GLState.h"
+#include "GpuProfiler.h"
 #include "Gui.h"
-#include "Pointer.h"
+#include "LightClusters.h"
+#include "Profiler.h"
+#include "RenderThread.h"
 #include "Scene.h"
+#include "SceneFile.h"
 #include "Shader.h"
+#include "ShaderPermutations.h"
+#include "StressScene.h"
 #include "Image.h"
 #include "Texture.h"
+#include "TextureStreamer.h"
+#include "UniformBuffer.h"
+#include "WorkerPool.h"
 
 namespace ntr
 {
-	struct StringID
+	struct Selected
 	{
-		std::string str;
 	};
 
-	struct Selected
+	// Per-frame data shared by every shader variant, matches the std140 FrameUniforms block.
+	struct FrameUniforms
+	{
+		glm::mat4	view;
+		glm::mat4	projection;
+		glm::mat4	inverseViewProjection;
+		glm::vec3	cameraPosition;
+		float		cameraFarPlane;
+		glm::vec3	directionalLightDirection;
+		float		padding0;
+		glm::vec3	directionalLightColor;
+		float		padding1;
+		glm::vec2	clusterTileSize;
+		float		clusterScale;
+		float		clusterBias;
+	};
+
+	// One mesh instance to draw, with everything the render thread needs so it never reads the scene.
+	struct DrawItem
+	{
+		glm::mat4		model;
+		glm::mat3		normal;
+		GLuint			vao;
+		GLsizei			indexCount;
+		GLint			materialIndex;
+		ShaderFeatures	materialFeatures;
+		TextureHandle	textures[5];		// albedo, normal, roughness, metallic, occlusion
+		float			screenSizePixels;	// for texture streaming
+	};
+
+	// What the render thread reports back about a frame it rendered.
+	struct RenderResults
+	{
+		struct TextureResidency
+		{
+			std::string	id;
+			int			width			= 0;
+			int			height			= 0;
+			int			residentLevel	= 0;
+			size_t		sizeBytes		= 0;
+		};
+
+		GLStateCounters					counters;
+		std::vector<GpuProfiler::Pass>	passes;
+		size_t							droppedGpuFrames	= 0;
+		size_t							pointLights			= 0;
+		size_t							shaderVariants		= 0;
+		size_t							textureLoadsInFlight	= 0;
+		std::vector<TextureResidency>	textures;
+	};
+
+	// Everything a frame renders, extracted from the scene by the main thread. The render thread only reads it and
+	// writes the results of the frame back into the same slot.
+	struct RenderSnapshot
 	{
+		Camera						camera;
+		DirectionalLight			directionalLight;
+		RenderPath					renderPath			= RenderPath::FORWARD;
+		bool						shadowsEnabled		= true;
+		std::vector<float>			shadowCascadeLevels;
+		std::vector<glm::mat4>		lightMatrices;
+		std::vector<PointLight>		pointLights;
+		std::vector<MaterialFactors>	materials;			// index 0 holds the defaults
+		std::vector<StreamedTexture>	textures;			// every texture of the scene, for streaming and residency
+		std::vector<DrawItem>		selectedDraws;
+		std::vector<std::vector<DrawItem>>	drawLists;		// one per worker, replayed in order after the selected draws
+		GuiDrawData					gui;
+		bool						gpuProfilerEnabled	= true;
+		size_t						textureBudgetBytes	= 0;
+		bool						finish				= false;	// glFinish instead of swapping, for headless runs
+
+		RenderResults				results;
 	};
 
 	class App
 	{
 	public:
 
-		App();
+		// Runs headless through benchmark when given, the window is not shown and input is ignored.
+		// Starts with the scene file at scenePath instead of the default scene when given.
+		App(Benchmark* benchmark = nullptr, const std::filesystem::path& scenePath = {});
 		~App();
 
 		void run();
@@ -52,17 +137,48 @@ namespace ntr
 		const int			M_TARGET_FPS			= 0;
 		const bool			M_VSYNC_ENABLED			= true;
 		const int			M_SHADOW_RESOLUTION		= 8192;
+		const int			M_PROFILER_CAPTURE_KEY	= GLFW_KEY_F11;
+		const uint32_t		M_PROFILER_CAPTURE_FRAMES	= 60;
+		const size_t		M_MIN_DRAW_SOURCES_PER_WORKER	= 256; // below this waking a worker costs more than it saves
 
+		Benchmark*			mBenchmark;
+		std::filesystem::path	mScenePath;
 		GLFWwindow*			mWindow;
-		Shader				mShaderPBR;
+		ShaderPermutations	mShaderPBR;
+		ShaderPermutations	mShaderGBuffer;
+		ShaderPermutations	mShaderDeferred;
 		Shader				mShaderDepth;
 		Shader				mShaderStencil;
 		Shader				mDebugShaderShadows;
 		Scene				mScene;
+		RenderThread		mRenderThread;
+		WorkerPool			mWorkers;
+		std::array<RenderSnapshot, RenderThread::SLOT_COUNT>	mSnapshots;
+		RenderResults		mFrameResults; // of the latest frame rendered
 
 		std::vector<float>	mShadowCascadeLevels;
 		FrameBuffer			mLightFBO;
 		Texture2DArray		mLightDepthMaps;
+		GBuffer				mGBuffer;
+		LightClusters		mLightClusters;
+		TextureStreamer		mTextureStreamer;
+		size_t				mTextureBudgetBytes;
+		UniformBuffer<FrameUniforms>	mFrameUniforms;
+		ArrayBuffer<MaterialFactors>	mMaterials;
+		std::unordered_map<TextureHandle, GLuint>	mTextureNames; // render thread, GL name of each texture of the frame being rendered
+		ArrayBuffer<glm::mat4>			mLightMatrices;
+		ArrayBuffer<float>				mCascadePlaneDistances;
+		std::vector<std::pair<const Model*, const WorldMatrix*>>	mDrawSources; // unselected entities, split across the workers, valid for one extract
+
+		FramePacer			mFramePacer;
+		float				mAverageFrameTimeMs[2]; // indexed by RenderPath
+		GpuProfiler			mGpuProfiler;
+		bool				mGpuProfilerEnabled;
+		bool				mProfilerOpen;
+		bool				mStressOpen;
+		StressSweep			mStressSweep;
+		entt::entity		mPickedEntity;	// under the cursor at the last viewport click, entt::null for nothing
+		bool				mPickRequested;	// until the Scene window selects mPickedEntity
 
 		FileExplorer		mFileExplorer;
 
@@ -71,18 +187,47 @@ namespace ntr
 
 		bool isWindowMinimized() const;
 
-		float getDeltaTimeSeconds() const;
-
 		void setViewport(const Rect& rect);
 
-		entt::entity addEntityModel3D(const std::string& id = "", const Model* model = Model::EMPTY, const Transform& transform = {});
+		entt::entity addEntityModel3D(const std::string& id = "", ModelHandle model = {}, const Transform& transform = {});
+		entt::entity addEntityPointLight(const std::string& id = "", const PointLight& light = {});
 
 		void	processViewerMovement(float deltaTimeSeconds);
 		void	processViewerRotation();
-		void	renderDepth(const FrameBuffer& lightFBO);
-		void	renderModelPBR(const Model* model, const Transform& transform);
+		void	processViewerPicking(); // ray cast through the cursor on a left click in the viewport
+		void	processProfilerCapture(); // writes a CPU trace of the next frames on M_PROFILER_CAPTURE_KEY
+
+		// main thread: fills frame from the scene
+		void	extractSnapshot(RenderSnapshot& frame);
+		void	extractMaterials(RenderSnapshot& frame);
+		void	extractTextures(RenderSnapshot& frame);
+		void	extractDraws(std::vector<DrawItem>& draws, const Camera& camera, const Model* model, const WorldMatrix& world, float pixelsPerUnit) const; // thread safe
+
+		// render thread: everything below only reads frame and the GL resources of App
+		void	renderFrame(RenderSnapshot& frame);
+		void	renderDepth(const RenderSnapshot& frame);
+		void	renderSceneForward(const RenderSnapshot& frame);
+		void	renderSceneDeferred(const RenderSnapshot& frame);
+		void	renderSelectedOutline(const RenderSnapshot& frame);
+		void	renderDrawPBR(ShaderPermutations& shaders, ShaderFeatures frameFeatures, const DrawItem& draw);
+		void	updateFrameUniforms(const RenderSnapshot& frame);
+		void	updateMaterials(const RenderSnapshot& frame);
+		void	updateTextureNames(const RenderSnapshot& frame);
+		void	requestTextureMips(const RenderSnapshot& frame);
+		void	collectResults(RenderSnapshot& frame);
+
+		void	updateShadowCascadeLevels();
+		void	prepareShaders();
+		// Returns false if the script names a model that could not be loaded, the results would describe another scene.
+		bool	loadBenchmarkScene();
+
+		// Returns the features shared by every draw of a frame (shadows, cascade count).
+		static ShaderFeatures getFrameFeatures(size_t cascadeCount, bool shadowsEnabled);
+		
+		// Returns a bit for each map of material that holds a real texture.
+		ShaderFeatures getMaterialFeatures(const Material* material) const;
 		
-		void	renderGui();
+		void	renderGui(GuiDrawData& drawData);
 		void	renderMenuBar();
 		void	renderAssetsWindow();
 		void	renderAssetsWindowSectionMeshes();
@@ -90,6 +235,8 @@ namespace ntr
 		void	renderAssetsWindowSectionModels();
 		void	renderAssetsWindowSectionMaterials();
 		void	renderSceneWindow();
+		void	renderProfilerWindow();
+		void	renderStressWindow();
 
 		void renderDebugQuad();
 
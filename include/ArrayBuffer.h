@@ -13,7 +13,7 @@ namespace ntr
 
 		GLuint binding;
 
-		ArrayBuffer(size_t size, const T* data = {}, GLuint binding = 0, GLenum usage = GL_DYNAMIC_COPY);
+		ArrayBuffer(size_t size, const T* data = {}, GLuint binding = 0);
 		ArrayBuffer(const ArrayBuffer& arr) = delete;
 		ArrayBuffer& operator=(const ArrayBuffer& arr) = delete;
 		~ArrayBuffer();
@@ -21,8 +21,9 @@ namespace ntr
 		size_t size() const;
 
 		void bind() const;
-		void unbind() const;
-		// Updates data in the range [start, end).
+		// Reallocates storage for size elements, previous contents are discarded.
+		void resize(size_t size);
+		// Updates data in the range [start, end), the buffer doesn't need to be bound.
 		void update(size_t start, size_t end, const T* data);
 		void update(size_t index, const T& data);
 
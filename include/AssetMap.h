@@ -0,0 +1,89 @@
+#ifndef NTR_ASSET_MAP_H
+#define NTR_ASSET_MAP_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "SlotMap.h"
+
+namespace ntr
+{
+	// Assets of one type, owned by a SlotMap and referred to by Handle, with a separate hash index from string ID to
+	// handle. IDs are only for lookups by name and the GUI, everything that refers to an asset holds its handle.
+	// Iterating visits id, handle and asset of every asset, contiguously and in no particular order.
+	template <typename T>
+	class AssetMap
+	{
+	public:
+
+		template <typename Value>
+		struct Entry
+		{
+			const std::string&	id;
+			Handle<T>			handle;
+			Value&				asset;
+		};
+
+		template <typename Map, typename Value>
+		class Iterator
+		{
+		public:
+
+			Iterator(Map& map, size_t index);
+
+			Entry<Value> operator*() const;
+			Iterator& operator++();
+			bool operator!=(const Iterator& itr) const;
+
+		private:
+
+			Map&	mMap;
+			size_t	mIndex;
+		};
+
+		// Returns an empty handle if id is taken.
+		Handle<T> add(const std::string& id, T&& asset);
+
+		// Returns an empty handle if no asset has id.
+		Handle<T> find(const std::string& id) const;
+
+		bool contains(const std::string& id) const;
+
+		// Returns nullptr if handle is empty or stale.
+		T* get(Handle<T> handle);
+		const T* get(Handle<T> handle) const;
+
+		// Returns nullptr if handle is empty or stale.
+		const std::string* findID(Handle<T> handle) const;
+
+		// Returns id, with "+" appended until no asset has it.
+		std::string getUniqueID(const std::string& id) const;
+
+		// Returns false if handle is empty or stale, or another asset has id.
+		bool rename(Handle<T> handle, const std::string& id);
+
+		// Returns false if handle is empty or stale.
+		bool remove(Handle<T> handle);
+
+		// Position of the asset in iteration order, SlotMap<T>::NPOS if handle is empty or stale.
+		size_t indexOf(Handle<T> handle) const;
+
+		size_t size() const;
+
+		Iterator<AssetMap<T>, T>				begin();
+		Iterator<AssetMap<T>, T>				end();
+		Iterator<const AssetMap<T>, const T>	begin() const;
+		Iterator<const AssetMap<T>, const T>	end() const;
+
+	private:
+
+		SlotMap<T>								mAssets;
+		std::vector<std::string>				mIDs;		// same order as mAssets
+		std::unordered_map<std::string, Handle<T>>	mHandles;
+	};
+} // namespace ntr
+
+#include "AssetMap.hpp"
+
+#endif
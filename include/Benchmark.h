@@ -0,0 +1,126 @@
+#ifndef NTR_BENCHMARK_H
+#define NTR_BENCHMARK_H
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "Camera.h"
+#include "GLState.h"
+#include "GpuProfiler.h"
+#include "Light.h"
+#include "Scene.h"
+#include "StressScene.h"
+#include "Transform.h"
+
+namespace ntr
+{
+	// Scene and camera path of a headless benchmark run, read from a plain text script.
+	// One statement per line, '#' starts a comment:
+	//
+	// resolution <width> <height>
+	// frames <count>								measured frames
+	// warmup <count>								frames rendered at the first camera key before measuring
+	// renderpath forward|deferred
+	// shadows on|off
+	// model <id> <filepath>
+	// entity <model id> <px py pz> [<sx sy sz> [<rx ry rz>]]
+	// pointlight <px py pz> <r g b> <radius>
+	// sun <dx dy dz> <r g b>
+	// stress <entities> [<point lights> [<seed>]]	procedural entities instancing the loaded models
+	// camera <px py pz> <pitch yaw>				key of the camera path, at least one
+	struct BenchmarkScript
+	{
+		struct ModelEntry
+		{
+			std::string				id;
+			std::filesystem::path	filepath;
+		};
+
+		struct EntityEntry
+		{
+			std::string	model;
+			Transform	transform;
+		};
+
+		struct CameraKey
+		{
+			glm::vec3 position;
+			glm::vec3 rotation; // degrees
+		};
+
+		std::filesystem::path		filepath;
+		int							width			= 1920;
+		int							height			= 1080;
+		size_t						frames			= 600;
+		size_t						warmupFrames	= 60;
+		RenderPath					renderPath		= RenderPath::FORWARD;
+		bool						shadows			= true;
+		std::vector<ModelEntry>		models;
+		std::vector<EntityEntry>	entities;
+		std::vector<PointLight>		pointLights;
+		DirectionalLight			directionalLight;
+		StressSceneSettings			stress;
+		std::vector<CameraKey>		cameraPath;
+
+		// Returns false and prints the offending line if the script can not be read.
+		bool load(const std::filesystem::path& scriptPath);
+	};
+
+	// Drives a benchmark run: poses the camera along the script's path each frame and records frame times,
+	// draw calls and GPU pass timings of the measured frames, then writes them as JSON.
+	class Benchmark
+	{
+	public:
+
+		Benchmark(const BenchmarkScript& script, const std::filesystem::path& outputPath);
+
+		const BenchmarkScript& script() const;
+
+		bool finished() const;
+
+		// True once finish() wrote the results.
+		bool resultsWritten() const;
+
+		// Moves camera to the pose of the frame about to render.
+		void beginFrame(Camera& camera);
+
+		// Call once the GPU finished the frame, counters are the ones of that frame.
+		void endFrame(const GLStateCounters& counters, const std::vector<GpuProfiler::Pass>& passes);
+
+		// Collects the GPU timings still in flight and writes the results.
+		bool finish(const std::vector<GpuProfiler::Pass>& passes);
+
+	private:
+
+		struct PassSamples
+		{
+			std::string			name;
+			size_t				seen = 0;	// samples of the pass collected so far, measured or not
+			std::vector<float>	samplesMs;
+		};
+
+		BenchmarkScript							mScript;
+		std::filesystem::path					mOutputPath;
+		size_t									mFrame;
+		bool									mResultsWritten;
+		std::chrono::steady_clock::time_point	mFrameBegin;
+		std::vector<float>						mFrameTimesMs;
+		std::vector<size_t>						mDrawCalls;
+		std::vector<size_t>						mStateCallsIssued;
+		std::vector<PassSamples>				mPasses; // indexed like GpuProfiler::passes()
+
+		BenchmarkScript::CameraKey getCameraPose(float t) const;
+
+		// Takes the samples passes got since the last call, keeping them if measure is set.
+		void collectPassSamples(const std::vector<GpuProfiler::Pass>& passes, bool measure);
+
+		// Returns the value at percentile (0-100) of sorted values.
+		static float getPercentile(const std::vector<float>& sorted, float percentile);
+	};
+} // namespace ntr
+
+#endif
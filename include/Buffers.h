@@ -23,6 +23,71 @@ namespace ntr
 
 		GLuint mID;
 	};
+
+	// Render targets for the geometry pass of deferred shading.
+	// albedo: RGBA8 (sRGB-encoded albedo), normal: RGBA16_SNORM (octahedral shading normal in xy, octahedral geometric normal in zw),
+	// material: RGBA8 (roughness, metallic, occlusion), depth: DEPTH24_STENCIL8.
+	class GBuffer
+	{
+	public:
+
+		GBuffer(GLsizei width, GLsizei height);
+		GBuffer(const GBuffer& gb) = delete;
+		GBuffer& operator=(const GBuffer& gb) = delete;
+		~GBuffer();
+
+		GLuint id() const;
+		GLuint albedo() const;
+		GLuint normal() const;
+		GLuint material() const;
+		GLuint depth() const;
+		GLsizei width() const;
+		GLsizei height() const;
+
+		void bind() const;
+		void unbind() const;
+
+		// Reallocates all attachments, does nothing if the size is unchanged or zero.
+		void resize(GLsizei width, GLsizei height);
+
+	private:
+
+		GLuint	mID;
+		GLuint	mAlbedo;
+		GLuint	mNormal;
+		GLuint	mMaterial;
+		GLuint	mDepth;
+		GLsizei	mWidth;
+		GLsizei	mHeight;
+
+		void init();
+		void release();
+	};
+
+	// Color and depth target standing in for the window surface when there is none.
+	// color: RGBA8, depth: DEPTH24_STENCIL8.
+	class RenderTarget
+	{
+	public:
+
+		RenderTarget(GLsizei width, GLsizei height);
+		RenderTarget(const RenderTarget& rt) = delete;
+		RenderTarget& operator=(const RenderTarget& rt) = delete;
+		~RenderTarget();
+
+		GLuint id() const;
+		GLuint color() const;
+		GLsizei width() const;
+		GLsizei height() const;
+
+	private:
+
+		GLuint	mID;
+		GLuint	mColor;
+		GLuint	mDepth;
+		GLsizei	mWidth;
+		GLsizei	mHeight;
+	};
 }
 
 #endif
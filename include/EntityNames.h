@@ -0,0 +1,59 @@
+#ifndef NTR_ENTITY_NAMES_H
+#define NTR_ENTITY_NAMES_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include <entt/entt.hpp>
+
+namespace ntr
+{
+	// Name of an entity, unique among the entities of a registry with an EntityNames.
+	struct StringID
+	{
+		std::string str;
+	};
+
+	// Hash index from StringID to entity, kept up to date by the StringID signals of the registry.
+	// Every name is stored once, as a key of the index, and each entity refers to its key.
+	// A StringID that is emplaced, or patched, with a name another entity already uses gets a "+N" suffix, so names stay
+	// unique whichever way they are added. Change names through rename, or patch the StringID after editing it.
+	class EntityNames
+	{
+	public:
+
+		EntityNames(entt::registry& registry);
+		EntityNames(const EntityNames& names) = delete;
+		EntityNames& operator=(const EntityNames& names) = delete;
+		~EntityNames();
+
+		// Returns entt::null if no entity uses name.
+		entt::entity find(const std::string& name) const;
+
+		bool contains(const std::string& name) const;
+
+		// Returns name if no entity uses it, otherwise name with the lowest "+N" suffix not tried for name before.
+		std::string getUnique(const std::string& name);
+
+		// Returns false, leaving entity as it is, if another entity uses name.
+		bool rename(entt::entity entity, const std::string& name);
+
+		size_t size() const;
+
+	private:
+
+		entt::registry&										mRegistry;
+		std::unordered_map<std::string, entt::entity>		mEntities;
+		std::unordered_map<entt::entity, const std::string*>	mNames;		// keys of mEntities, stable across rehashes
+		std::unordered_map<std::string, uint32_t>			mSuffixes;	// last suffix handed out per name
+
+		void onConstruct(entt::registry& registry, entt::entity entity);
+		void onUpdate(entt::registry& registry, entt::entity entity);
+		void onDestroy(entt::registry& registry, entt::entity entity);
+
+		void erase(entt::entity entity);
+	};
+} // namespace ntr
+
+#endif
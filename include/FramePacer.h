@@ -0,0 +1,70 @@
+#ifndef NTR_FRAME_PACER_H
+#define NTR_FRAME_PACER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ntr
+{
+	// Timing of the recent frames, published by FramePacer.
+	struct FramePacerStats
+	{
+		double	averageMs		= 0.0;
+		double	jitterMs		= 0.0;	// standard deviation of the frame time
+		double	worstMs			= 0.0;
+		double	targetMs		= 0.0;	// 0 when nothing limits the rate
+		double	sleepErrorMs	= 0.0;	// how much longer than asked the OS sleeps, the spin tail covers it
+		size_t	missedFrames	= 0;	// frames that took more than 1.5 times the target, since the start
+	};
+
+	// Starts each frame at a steady rate without burning a core: sleeps most of the wait and spins only for
+	// the last part, whose length follows the measured sleep accuracy of the OS. Time is kept in integer
+	// nanoseconds of a steady clock, so long sessions lose no precision.
+	//
+	// With vsync the swap already waits for the display, so a target at or above the refresh rate is not waited
+	// for at all, and a lower one is rounded to a whole number of refresh intervals to avoid judder.
+	class FramePacer
+	{
+	public:
+
+		static constexpr size_t HISTORY_SIZE = 120;
+
+		FramePacer();
+
+		// 0 runs unlimited.
+		void setTargetRate(double framesPerSecond);
+		void setVsync(bool enabled, double refreshRate);
+
+		double targetRate() const;
+
+		// Waits until the next frame is due and returns the seconds since the previous call.
+		double wait();
+
+		// Statistics over the last HISTORY_SIZE frames.
+		FramePacerStats stats() const;
+
+	private:
+
+		double						mTargetRate;
+		bool						mVsync;
+		double						mRefreshRate;
+		int64_t						mPeriodNs;			// 0 when frames are not waited for
+		int64_t						mDeadlineNs;
+		int64_t						mPrevFrameNs;
+		std::array<int64_t, HISTORY_SIZE>	mFrameTimesNs;	// ring buffer
+		size_t						mFrameCount;
+		size_t						mMissedFrames;
+
+		// running estimate of how long a 1 ms sleep really takes
+		double						mSleepMeanNs;
+		double						mSleepVariance;
+
+		void updatePeriod();
+		void sleepUntil(int64_t deadlineNs);
+
+		static int64_t getTimeNs();
+	};
+} // namespace ntr
+
+#endif
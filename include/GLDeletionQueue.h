@@ -0,0 +1,74 @@
+#ifndef NTR_GL_DELETION_QUEUE_H
+#define NTR_GL_DELETION_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace ntr
+{
+	// Deletes the GL objects of scene assets once the GPU finished every frame that may still use them, so releasing an
+	// asset needs no GL context and never makes the driver wait for a frame in flight.
+	// Objects are tagged with the frame being built when they are queued. Once the render thread rendered that frame it
+	// puts a fence behind it, and the objects are deleted through GLState at the end of the first frame that finds the
+	// fence signaled. Fences are only polled, nothing here waits for the GPU except flush().
+	class GLDeletionQueue
+	{
+	public:
+
+		// Any thread, no GL context needed. Names of 0 are ignored.
+		static void deleteVertexArrays(GLsizei count, const GLuint* vaos);
+		static void deleteBuffers(GLsizei count, const GLuint* buffers);
+		static void deleteTextures(GLsizei count, const GLuint* textures);
+
+		// Main thread, right before handing the snapshot of a frame to the render thread.
+		static void submitFrame();
+
+		// GL thread, once after rendering each submitted frame.
+		static void collect();
+
+		// GL thread, with no frame left to render. Waits for the GPU and deletes everything queued.
+		static void flush();
+
+		// Objects queued or fenced but not deleted yet.
+		static size_t pendingCount();
+
+	private:
+
+		enum ObjectType : uint8_t
+		{
+			VERTEX_ARRAY,
+			BUFFER,
+			TEXTURE
+		};
+
+		struct Object
+		{
+			GLuint		name;
+			ObjectType	type;
+			uint64_t	frame;	// last frame that may use the object
+		};
+
+		struct Batch
+		{
+			GLsync				fence;
+			std::vector<Object>	objects;
+		};
+
+		static std::mutex			mutex;
+		static std::vector<Object>	queued;		// waiting for their frame to be rendered
+		static std::deque<Batch>	fenced;		// oldest first, fences signal in order
+		static uint64_t				submittedFrames;
+		static uint64_t				renderedFrames;
+
+		static void enqueue(ObjectType type, GLsizei count, const GLuint* names);
+
+		static void deleteObjects(const std::vector<Object>& objects);
+	};
+} // namespace ntr
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef NTR_GL_STATE_H
+#define NTR_GL_STATE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+namespace ntr
+{
+	// Calls that reached the driver versus calls dropped because they would not have changed anything.
+	struct GLStateCounters
+	{
+		size_t issued	= 0;
+		size_t filtered	= 0;
+		size_t draws	= 0;
+	};
+
+	// CPU shadow of the GL bindings and fixed-function state the renderer touches.
+	// Every change goes through here so redundant calls are dropped and state is never read back from the driver.
+	// Objects must be deleted through the delete functions below, the driver reuses names of deleted objects
+	// and a stale shadow would otherwise filter the first bind of the new object.
+	class GLState
+	{
+	public:
+
+		// Texture uploads that need a bind-to-edit target (mutable compressed levels) happen on this unit,
+		// so they never disturb the units shaders sample from.
+		static constexpr GLuint UPLOAD_TEXTURE_UNIT = 31;
+
+		// Starts counting a new frame, lastFrameCounters() returns the frame that just ended.
+		static void beginFrame();
+
+		static const GLStateCounters& lastFrameCounters();
+		static const GLStateCounters& frameCounters(); // the frame in progress
+
+		// Framebuffer that binding 0 resolves to, headless runs have no window surface and render into an offscreen target.
+		static void		setDefaultFramebuffer(GLuint fbo);
+		static GLuint	defaultFramebuffer();
+
+		// BINDINGS
+
+		static void useProgram(GLuint program);
+		static void bindVertexArray(GLuint vao);
+		static void bindFramebuffer(GLuint fbo);
+		static void bindTextureUnit(GLuint unit, GLuint texture);
+		static void bindUploadTexture(GLenum target, GLuint texture);
+		static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+		// FIXED-FUNCTION STATE
+
+		static void		setEnabled(GLenum capability, bool enabled);
+		static bool		isEnabled(GLenum capability);
+		static void		cullFace(GLenum mode);
+		static GLenum	cullFaceMode();
+		static void		depthFunc(GLenum func);
+		static void		stencilFunc(GLenum func, GLint ref, GLuint mask);
+		static void		stencilMask(GLuint mask);
+		static void		stencilOp(GLenum stencilFail, GLenum depthFail, GLenum depthPass);
+		static void		blendFunc(GLenum source, GLenum destination);
+		static void		clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+		static void		viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+		// DRAWS
+
+		static void drawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
+		static void drawArrays(GLenum mode, GLint first, GLsizei count);
+
+		// DELETION
+
+		static void deletePrograms(GLsizei count, const GLuint* programs);
+		static void deleteVertexArrays(GLsizei count, const GLuint* vaos);
+		static void deleteFramebuffers(GLsizei count, const GLuint* fbos);
+		static void deleteTextures(GLsizei count, const GLuint* textures);
+		static void deleteBuffers(GLsizei count, const GLuint* buffers);
+
+	private:
+
+		static constexpr size_t TEXTURE_UNIT_COUNT		= UPLOAD_TEXTURE_UNIT;
+		static constexpr size_t BUFFER_BINDING_COUNT	= 16;
+
+		enum Capability : uint8_t
+		{
+			CAPABILITY_BLEND,
+			CAPABILITY_CULL_FACE,
+			CAPABILITY_DEPTH_TEST,
+			CAPABILITY_STENCIL_TEST,
+			CAPABILITY_COUNT
+		};
+
+		struct Shadow
+		{
+			GLuint	program				= 0;
+			GLuint	vao					= 0;
+			GLuint	fbo					= 0;
+			GLuint	defaultFbo			= 0;
+			GLuint	activeTexture		= 0;
+			GLuint	uploadTexture		= 0;
+			GLenum	uploadTarget		= GL_TEXTURE_2D;
+
+			std::array<GLuint, TEXTURE_UNIT_COUNT>		textureUnits{};
+			std::array<GLuint, BUFFER_BINDING_COUNT>	shaderStorageBuffers{};
+			std::array<GLuint, BUFFER_BINDING_COUNT>	uniformBuffers{};
+			std::array<bool, CAPABILITY_COUNT>			capabilities{}; // indexed by Capability
+
+			// GL defaults
+			GLenum	cullFaceMode		= GL_BACK;
+			GLenum	depthFunc			= GL_LESS;
+			GLenum	stencilFunc			= GL_ALWAYS;
+			GLint	stencilRef			= 0;
+			GLuint	stencilFuncMask		= 0xFFFFFFFF;
+			GLuint	stencilWriteMask	= 0xFFFFFFFF;
+			GLenum	stencilOps[3]		= { GL_KEEP, GL_KEEP, GL_KEEP };
+			GLenum	blendFunc[2]		= { GL_ONE, GL_ZERO };
+			GLfloat	clearColor[4]		= { 0.0f, 0.0f, 0.0f, 0.0f };
+			GLint	viewport[4]			= { -1, -1, -1, -1 }; // unknown until first set, the default is the window size
+		};
+
+		static Shadow			shadow;
+		static GLStateCounters	counters;
+		static GLStateCounters	lastCounters;
+
+		// Returns true if the call has to be issued, counting it either way.
+		static bool changed(bool different);
+
+		static int getCapabilityIndex(GLenum capability);
+	};
+} // namespace ntr
+
+#endif
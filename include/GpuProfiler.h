@@ -0,0 +1,89 @@
+#ifndef NTR_GPU_PROFILER_H
+#define NTR_GPU_PROFILER_H
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace ntr
+{
+	// Times named GPU passes with GL_TIMESTAMP queries.
+	// Queries of the last FRAMES_IN_FLIGHT frames are kept in their own slots and only read back once the driver reports
+	// them available, so timing never waits on the GPU. A frame whose results are still pending when its slot comes
+	// around again is dropped.
+	class GpuProfiler
+	{
+	public:
+
+		static constexpr size_t FRAMES_IN_FLIGHT	= 3;
+		static constexpr size_t HISTORY_SIZE		= 240;
+
+		struct Pass
+		{
+			std::string						name;
+			std::array<float, HISTORY_SIZE>	historyMs{};	// ring buffer, oldest sample at historyOffset
+			size_t							historyOffset	= 0;
+			size_t							historyCount	= 0;
+			size_t							sampleCount		= 0;	// collected since the start, the history keeps the last HISTORY_SIZE
+			float							minMs			= 0.0f;
+			float							avgMs			= 0.0f;
+			float							p99Ms			= 0.0f;
+		};
+
+		bool enabled = true;
+
+		GpuProfiler();
+		GpuProfiler(const GpuProfiler& profiler) = delete;
+		GpuProfiler& operator=(const GpuProfiler& profiler) = delete;
+		~GpuProfiler();
+
+		// Collects every finished frame, then starts recording the next one.
+		void beginFrame();
+
+		// Scopes may nest, a name used more than once in a frame adds up.
+		void begin(const std::string& name);
+		void end();
+
+		// Passes in the order they were first recorded.
+		const std::vector<Pass>& passes() const;
+
+		size_t droppedFrames() const;
+
+	private:
+
+		struct Scope
+		{
+			size_t	pass;
+			size_t	beginQuery;
+			size_t	endQuery;
+		};
+
+		struct Frame
+		{
+			std::vector<GLuint>	queries;	// grows to the most scopes recorded in one frame, reused afterwards
+			std::vector<Scope>	scopes;
+			size_t				queryCount	= 0;
+			bool				pending		= false;
+		};
+
+		std::array<Frame, FRAMES_IN_FLIGHT>		mFrames;
+		size_t									mCurrentFrame;
+		std::vector<size_t>						mOpenScopes;
+		std::vector<Pass>						mPasses;
+		std::unordered_map<std::string, size_t>	mPassIndices;
+		size_t									mDroppedFrames;
+
+		// Returns false if the last query of frame is not available yet.
+		bool collect(Frame& frame);
+
+		// Returns the index of the query in frame.queries.
+		size_t recordTimestamp(Frame& frame);
+
+		static void updateStats(Pass& pass);
+	};
+} // namespace ntr
+
+#endif
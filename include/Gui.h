@@ -14,6 +14,30 @@
 
 namespace ntr
 {
+	// Copy of the draw data of one ImGui frame. It stays valid while the next frame is built, so another thread can
+	// render it.
+	class GuiDrawData
+	{
+	public:
+
+		GuiDrawData();
+		GuiDrawData(const GuiDrawData& data) = delete;
+		GuiDrawData& operator=(const GuiDrawData& data) = delete;
+		~GuiDrawData();
+
+		// Takes the draw data of the frame ImGui::Render() finished last.
+		void capture();
+		void clear();
+
+		bool empty() const;
+
+		ImDrawData* data();
+
+	private:
+
+		ImDrawData mData;
+	};
+
 	class Gui
 	{
 	public:
@@ -50,8 +74,11 @@ namespace ntr
 
 		static void showErrorTooltip(const std::string& message);
 
+		// Starts a frame, render() ends it into drawData, draw() issues its GL calls.
+		// The first two only touch ImGui state, draw() may run on any thread that has the context.
 		static void clear();
-		static void draw();
+		static void render(GuiDrawData& drawData);
+		static void draw(GuiDrawData& drawData);
 	};
 
 	class FileExplorer
@@ -0,0 +1,34 @@
+#ifndef NTR_HASH_H
+#define NTR_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ntr
+{
+	constexpr uint64_t FNV_OFFSET_BASIS	= 0xCBF29CE484222325ull;
+	constexpr uint64_t FNV_PRIME		= 0x100000001B3ull;
+
+	// 64-bit FNV-1a, chain calls by passing the previous result as hash.
+	inline uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= FNV_PRIME;
+		}
+
+		return hash;
+	}
+
+	inline uint64_t hashString(uint64_t hash, const std::string& str)
+	{
+		// include the terminator so {"ab", "c"} and {"a", "bc"} hash differently
+		return hashBytes(hash, str.c_str(), str.size() + 1);
+	}
+} // namespace ntr
+
+#endif
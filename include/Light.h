@@ -11,9 +11,12 @@ namespace ntr
         alignas(16) glm::vec3 color = { 10.0f, 10.0f, 10.0f };
     };
 
+    // Matches the std430 PointLight struct in the shaders (radius packed after position).
+    // On an entity with a WorldMatrix the position is relative to it, otherwise it is in world space.
     struct PointLight
     {
         alignas(16) glm::vec3 position = { 0.0f, 0.0f, 0.0f };
+        float radius = 10.0f; // light contribution fades to zero at this distance
         alignas(16) glm::vec3 color = { 100.0f, 100.0f, 100.0f };
     };
 } // namespace ntr
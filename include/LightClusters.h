@@ -0,0 +1,57 @@
+#ifndef NTR_LIGHT_CLUSTERS_H
+#define NTR_LIGHT_CLUSTERS_H
+
+#include <vector>
+
+#include <glad/glad.h>
+
+#include <glm/vec4.hpp>
+
+#include "ArrayBuffer.h"
+#include "Camera.h"
+#include "Light.h"
+#include "Shader.h"
+
+namespace ntr
+{
+	// Bins point lights into a view-space froxel grid (tiles in x/y, exponential slices in z) with a compute shader.
+	// Lighting shaders then only loop over the lights overlapping the cluster a fragment falls into.
+	class LightClusters
+	{
+	public:
+
+		static constexpr GLuint GRID_SIZE_X				= 16;
+		static constexpr GLuint GRID_SIZE_Y				= 9;
+		static constexpr GLuint GRID_SIZE_Z				= 24;
+		static constexpr GLuint CLUSTER_COUNT			= GRID_SIZE_X * GRID_SIZE_Y * GRID_SIZE_Z;
+		static constexpr GLuint MAX_LIGHTS_PER_CLUSTER	= 128;
+
+		// SSBO binding points, 0 and 1 are used by the shadow cascades
+		static constexpr GLuint BINDING_POINT_LIGHTS			= 2;
+		static constexpr GLuint BINDING_CLUSTER_LIGHT_COUNTS	= 3;
+		static constexpr GLuint BINDING_CLUSTER_LIGHT_INDICES	= 4;
+
+		LightClusters();
+		LightClusters(const LightClusters& lc) = delete;
+		LightClusters& operator=(const LightClusters& lc) = delete;
+
+		// Uploads the lights and rebuilds the per-cluster light lists for the camera.
+		void update(const Camera& camera, const std::vector<PointLight>& lights);
+
+		// Returns what a lighting shader needs to find the cluster of a fragment:
+		// tile size in pixels (xy), depth slice scale (z) and bias (w).
+		glm::vec4 getClusterParams(const Camera& camera) const;
+
+		size_t lightCount() const;
+
+	private:
+
+		Shader					mShaderCull;
+		ArrayBuffer<PointLight>	mLights;
+		ArrayBuffer<GLuint>		mClusterLightCounts;
+		ArrayBuffer<GLuint>		mClusterLightIndices;
+		size_t					mLightCount;
+	};
+} // namespace ntr
+
+#endif
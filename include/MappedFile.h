@@ -0,0 +1,37 @@
+#ifndef NTR_MAPPED_FILE_H
+#define NTR_MAPPED_FILE_H
+
+#include <cstddef>
+#include <filesystem>
+
+namespace ntr
+{
+	// Read only view of a whole file mapped into memory. Pages are read from disk when first touched, nothing is copied
+	// up front.
+	class MappedFile
+	{
+	public:
+
+		MappedFile();
+		MappedFile(const MappedFile& file)				= delete;
+		MappedFile& operator=(const MappedFile& file)	= delete;
+		MappedFile(MappedFile&& file)				noexcept;
+		MappedFile& operator=(MappedFile&& file)	noexcept;
+		~MappedFile();
+
+		// Returns false if the file is missing, empty or can't be mapped.
+		bool open(const std::filesystem::path& filepath);
+		void close();
+
+		bool isOpen() const;
+		const unsigned char* data() const;
+		size_t size() const;
+
+	private:
+
+		const unsigned char*	mData;
+		size_t					mSize;
+	};
+} // namespace ntr
+
+#endif
@@ -1,20 +1,46 @@
 #ifndef NTR_MATERIAL_H
 #define NTR_MATERIAL_H
 
-#include "Pointer.h"
+#include <glm/vec4.hpp>
+
+#include "SlotMap.h"
 #include "Texture.h"
 
 namespace ntr
 {
+	// glTF style metallic-roughness material. Each factor scales its map, or is used as is when the map is empty,
+	// so untextured materials cost no texture fetches.
 	struct Material
 	{
-		TextureHandle albedo	= Texture::EMPTY;
-		TextureHandle normal	= Texture::EMPTY;
-		TextureHandle roughness	= Texture::EMPTY;
-		TextureHandle metallic	= Texture::EMPTY;
-		TextureHandle occlusion	= Texture::EMPTY;
+		TextureHandle albedo	= {};
+		TextureHandle normal	= {};
+		TextureHandle roughness	= {};
+		TextureHandle metallic	= {};
+		TextureHandle occlusion	= {};
+
+		glm::vec4	baseColorFactor		= { 0.5f, 0.5f, 0.5f, 1.0f }; // sRGB
+		float		roughnessFactor		= 0.5f;
+		float		metallicFactor		= 0.5f;
+		float		occlusionStrength	= 1.0f;
+		float		normalScale			= 1.0f;
+
+		// Replaces every map of this Material that is texture with new_texture.
+		void replaceTextures(TextureHandle texture, TextureHandle new_texture);
+	};
+
+	// An empty MaterialHandle stands for the default Material of the Scene.
+	using MaterialHandle = Handle<Material>;
+
+	// Material factors as laid out in the std430 Materials buffer of the PBR shaders.
+	struct MaterialFactors
+	{
+		glm::vec4	baseColor;
+		float		roughness;
+		float		metallic;
+		float		occlusionStrength;
+		float		normalScale;
 
-		static const ScopedPointer<Material> EMPTY;
+		MaterialFactors(const Material& material = {});
 	};
 }
 
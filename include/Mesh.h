@@ -8,9 +8,12 @@
 
 #include "Material.h"
 #include "Math.h"
+#include "Structs.h"
 #include "Texture.h"
 #include "Transform.h"
+#include "TriangleBVH.h"
 #include "Vertex.h"
+#include "WorkerPool.h"
 
 namespace ntr
 {
@@ -21,15 +24,25 @@ namespace ntr
 		STREAM	= GL_STREAM_DRAW	// The data store contents will be modified once and used at most a few times.
 	};
 
+	// What a Mesh keeps in memory once its buffers are uploaded.
+	enum CpuData : int
+	{
+		CPU_ALL			= 0,	// Vertices and indices.
+		CPU_POSITIONS	= 1,	// Vertex positions and indices, enough for ray queries at a fraction of the size.
+		CPU_NONE		= 2		// Nothing, the GPU buffers are the only copy.
+	};
+
 	class Mesh
 	{
 	public:
 
-		static const ScopedPointer<Mesh> EMPTY;
-
 		Mesh();
-		Mesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, RenderUsage usage = RenderUsage::DYNAMIC);
-		Mesh(std::vector<Vertex>&& vertices, std::vector<GLuint>&& indices, RenderUsage usage = RenderUsage::DYNAMIC);
+		// With triangleBVHWorkers, a triangle BVH is built on them for raycast(), unless cpuData is CPU_NONE.
+		Mesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, RenderUsage usage = RenderUsage::DYNAMIC, CpuData cpuData = CpuData::CPU_ALL, WorkerPool* triangleBVHWorkers = nullptr);
+		Mesh(std::vector<Vertex>&& vertices, std::vector<GLuint>&& indices, RenderUsage usage = RenderUsage::DYNAMIC, CpuData cpuData = CpuData::CPU_ALL, WorkerPool* triangleBVHWorkers = nullptr);
+		// Uploads straight from vertices and indices, e.g. a memory-mapped file, and copies only what cpuData keeps.
+		// triangleBVH must have been built over the same triangles, it is dropped with CPU_NONE.
+		Mesh(const Vertex* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount, RenderUsage usage, CpuData cpuData, TriangleBVH&& triangleBVH);
 
 		Mesh(const Mesh& mesh)				= delete;
 		Mesh& operator=(const Mesh& mesh)	= delete;
@@ -41,6 +54,25 @@ namespace ntr
 
 		GLuint vao() const;
 		GLsizei	indexCount() const;
+		RenderUsage renderUsage() const;
+
+		// Radius of a sphere around the mesh origin that contains every vertex.
+		float boundingRadius() const;
+
+		// Box around every vertex, in mesh space.
+		const AABB& bounds() const;
+
+		CpuData cpuData() const;
+
+		bool hasTriangleBVH() const;
+		const TriangleBVH& triangleBVH() const;
+
+		// Nearest triangle hit within maxDistance, in mesh space. Always misses without a triangle BVH.
+		bool raycast(const Ray& ray, float maxDistance, TriangleHit& hit) const;
+
+		// Copies of the geometry, read back from the GPU buffers if it's not kept on the CPU. Needs the GL context then.
+		void readVertices(std::vector<Vertex>& vertices) const;
+		void readIndices(std::vector<GLuint>& indices) const;
 
 		void printVertices() const;
 		void printIndices() const;
@@ -52,22 +84,33 @@ namespace ntr
 		GLuint					mEBO;
 		
 		std::vector<Vertex>		mVertices;
+		std::vector<glm::vec3>	mPositions;		// instead of mVertices with CPU_POSITIONS
 		std::vector<GLuint>		mIndices;
+		GLsizei					mIndexCount;
 		RenderUsage				mRenderUsage;
+		CpuData					mCpuData;
+		float					mBoundingRadius;
+		AABB					mBounds;
+		TriangleBVH				mTriangleBVH;
+
+		void initMesh(const Vertex* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount, WorkerPool* triangleBVHWorkers);
 
-		void initMesh();
+		TriangleMesh getTriangleMesh() const;
 	};
 
+	using MeshHandle = Handle<Mesh>;
+
 	struct MeshInstance
 	{
-		static MeshInstance EMPTY;
+		MeshInstance(MeshHandle mesh = {}, MaterialHandle material = {}, const Transform& transform = {});
 
-		MeshInstance(const Mesh* mesh = Mesh::EMPTY, const Material* material = Material::EMPTY, const Transform& transform = {});
+		// Call after changing transform.
+		void updateMatrix();
 
-		GLuint			vao;
-		GLsizei			indexCount;
-		const Material*	material;
+		MeshHandle		mesh;		// resolved in the Scene wherever its GL fields or bounds are needed
+		MaterialHandle	material;
 		Transform		transform;
+		WorldMatrix		matrix; // of transform, relative to the model
 	};
 } // namespace ntr
 
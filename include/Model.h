@@ -6,21 +6,21 @@
 #include <map>
 
 #include "Mesh.h"
-#include "Pointer.h"
+#include "SlotMap.h"
 
 namespace ntr
 {
 	struct Model
 	{
-		static const ScopedPointer<Model> EMPTY;
-
 		std::map<std::string, MeshInstance> meshes;
 
-		// Replaces all Meshinstances in this Model that use mesh with new_mesh.
-		void replaceMeshes(const Mesh* mesh, const Mesh* new_mesh);
+		// Replaces all Meshes in all MeshInstances in this Model that use mesh with new_mesh.
+		void replaceMeshes(MeshHandle mesh, MeshHandle new_mesh);
 		// Replaces all Materials in all MeshInstances in this Model that use material with new_material.
-		void replaceMaterials(const Material* material, const Material* new_material);
+		void replaceMaterials(MaterialHandle material, MaterialHandle new_material);
 	};
+
+	using ModelHandle = Handle<Model>;
 }
 
 #endif
@@ -0,0 +1,142 @@
+#ifndef NTR_PROFILER_H
+#define NTR_PROFILER_H
+
+// CPU instrumentation. Every macro below expands to nothing unless NTR_PROFILING is defined
+// (CMake option NTR_ENABLE_PROFILING), so instrumented code pays nothing in builds without it.
+//
+// NTR_PROFILE_SCOPE(name)				zone from here to the end of the enclosing scope
+// NTR_PROFILE_COUNTER(name, value)		sample of a named value
+// NTR_PROFILE_FRAME()					frame boundary, captures are counted in frames
+// NTR_PROFILE_THREAD(name)				name of the calling thread in the trace
+// NTR_PROFILE_CAPTURE(frames)			records the next frames into a Chrome trace
+//
+// Names are stored by pointer and must outlive the capture, string literals are expected.
+
+#ifdef NTR_PROFILING
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ntr
+{
+	// Events are only recorded while a capture is running. Each thread writes into its own fixed-size ring buffer
+	// without locking, the capture reads the rings once recording stopped and writes them as Chrome trace JSON
+	// (chrome://tracing, ui.perfetto.dev). A thread recording more than EVENTS_PER_THREAD events in one capture
+	// loses its oldest ones.
+	class Profiler
+	{
+	public:
+
+		static constexpr size_t EVENTS_PER_THREAD = 1 << 16;
+
+		// RAII zone, records the time between construction and destruction.
+		class Zone
+		{
+		public:
+
+			explicit Zone(const char* name);
+			Zone(const Zone& zone) = delete;
+			Zone& operator=(const Zone& zone) = delete;
+			~Zone();
+
+		private:
+
+			const char*	mName;
+			int64_t		mStartNs; // negative if no capture was running on construction
+		};
+
+		// Records from now through the next frames complete frames, then writes the trace to filepath.
+		// Ignored while another capture is running.
+		static void capture(uint32_t frames, const std::filesystem::path& filepath = "nitor_trace.json");
+
+		static void frameMark();
+		static void counter(const char* name, double value);
+		static void setThreadName(const std::string& name);
+
+	private:
+
+		enum class EventType : uint8_t
+		{
+			ZONE,
+			COUNTER,
+			FRAME
+		};
+
+		struct Event
+		{
+			const char*	name;
+			int64_t		startNs;
+			union
+			{
+				int64_t	endNs;	// ZONE
+				double	value;	// COUNTER
+			};
+			EventType	type;
+		};
+
+		// Written by its thread only, head is published with release so a reader sees every event before it.
+		struct ThreadBuffer
+		{
+			std::array<Event, EVENTS_PER_THREAD>	events;
+			std::atomic<uint64_t>					head{ 0 };
+			uint64_t								captureBegin	= 0;		// head when the current capture started
+			uint32_t								id				= 0;		// tid in the trace
+			std::string								name;
+			bool									retired			= false;	// owning thread exited
+		};
+
+		// Hands the buffer back when its thread exits.
+		struct ThreadBufferOwner
+		{
+			ThreadBuffer* buffer = nullptr;
+
+			~ThreadBufferOwner();
+		};
+
+		static std::atomic<bool>							recording;
+		static std::mutex									buffersMutex;	// guards buffers and everything capture related below
+		static std::vector<std::unique_ptr<ThreadBuffer>>	buffers;
+		static std::vector<ThreadBuffer*>					freeBuffers;
+		static uint32_t										framesLeft;
+		static int64_t										captureBeginNs;
+		static std::filesystem::path						capturePath;
+
+		// the buffer is only taken once the thread records during a capture, the name is kept until then
+		static thread_local ThreadBufferOwner				threadBuffer;
+		static thread_local std::string						threadName;
+
+		static void				record(const Event& event);
+		static ThreadBuffer&	getThreadBuffer();
+		static int64_t			getTimeNs();
+
+		// Called with buffersMutex held and recording already stopped.
+		static void writeTrace();
+	};
+} // namespace ntr
+
+#define NTR_PROFILE_CONCAT_INNER(a, b)		a##b
+#define NTR_PROFILE_CONCAT(a, b)			NTR_PROFILE_CONCAT_INNER(a, b)
+
+#define NTR_PROFILE_SCOPE(name)				::ntr::Profiler::Zone NTR_PROFILE_CONCAT(ntrProfileZone, __LINE__){ name }
+#define NTR_PROFILE_COUNTER(name, value)	::ntr::Profiler::counter(name, (double)(value))
+#define NTR_PROFILE_FRAME()					::ntr::Profiler::frameMark()
+#define NTR_PROFILE_THREAD(name)			::ntr::Profiler::setThreadName(name)
+#define NTR_PROFILE_CAPTURE(frames)			::ntr::Profiler::capture(frames)
+
+#else
+
+#define NTR_PROFILE_SCOPE(name)
+#define NTR_PROFILE_COUNTER(name, value)
+#define NTR_PROFILE_FRAME()
+#define NTR_PROFILE_THREAD(name)
+#define NTR_PROFILE_CAPTURE(frames)
+
+#endif
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef NTR_REFERENCES_H
+#define NTR_REFERENCES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ntr
+{
+	// Which assets each user refers to and, the other way round, which users refer to each asset, so the users of an
+	// asset are found without scanning every possible user, and an asset knows when its last user let go.
+	// Setting the assets of a user replaces the ones it had before, re-setting after an edit in place is enough.
+	// Empty assets, those equal to Asset{}, are not tracked.
+	template <typename User, typename Asset>
+	class References
+	{
+	public:
+
+		// Makes assets the assets user refers to, each counted once. Assets whose last user let go are appended to
+		// released, if given.
+		void set(User user, const std::vector<Asset>& assets, std::vector<Asset>* released = nullptr);
+
+		// Same as set with no assets.
+		void erase(User user, std::vector<Asset>* released = nullptr);
+
+		// Each user of asset once, in no particular order. Only valid until the next set or erase.
+		const std::vector<User>& getUsers(Asset asset) const;
+
+		// Number of users of asset.
+		size_t count(Asset asset) const;
+
+	private:
+
+		struct Link
+		{
+			Asset		asset;
+			uint32_t	slot;	// of the user in mUsers[asset]
+		};
+
+		std::unordered_map<User, std::vector<Link>>		mLinks;
+		std::unordered_map<Asset, std::vector<User>>	mUsers;
+
+		// Returns the slot of user in the users of asset.
+		uint32_t addUser(Asset asset, User user);
+		void removeUser(const Link& link, std::vector<Asset>* released);
+
+		static const Link* findLink(const std::vector<Link>& links, Asset asset);
+	};
+} // namespace ntr
+
+#include "References.hpp"
+
+#endif
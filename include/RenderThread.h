@@ -0,0 +1,79 @@
+#ifndef NTR_RENDER_THREAD_H
+#define NTR_RENDER_THREAD_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <GLFW/glfw3.h>
+
+namespace ntr
+{
+	// Runs GL submission on its own thread, which owns the window's GL context.
+	// The main thread fills one of SLOT_COUNT frame slots while the render thread draws one submitted earlier, so the
+	// update of frame N+1 overlaps the submission of frame N. Slots are handed out in order and a slot is only handed
+	// out again once the frame in it has been rendered.
+	class RenderThread
+	{
+	public:
+
+		static constexpr size_t SLOT_COUNT = 2;
+
+		// Gives the GL context to the calling thread until destroyed, for the rare main thread work that creates or
+		// deletes GL objects. Waits until every submitted frame has been rendered first. Locks may nest.
+		class ContextLock
+		{
+		public:
+
+			ContextLock(RenderThread& renderThread);
+			ContextLock(const ContextLock& lock) = delete;
+			ContextLock& operator=(const ContextLock& lock) = delete;
+			~ContextLock();
+
+		private:
+
+			RenderThread& mRenderThread;
+		};
+
+		RenderThread();
+		RenderThread(const RenderThread& rt) = delete;
+		RenderThread& operator=(const RenderThread& rt) = delete;
+		~RenderThread();
+
+		// Moves the context of window from the calling thread to a new thread, which calls render(slot) for every
+		// submitted frame.
+		void start(GLFWwindow* window, std::function<void(size_t slot)> render);
+
+		// Renders the frames still submitted, then hands the context back to the calling thread.
+		void stop();
+
+		// Returns the slot to fill for the next frame, waiting until the render thread is done with it.
+		size_t acquire();
+
+		// Submits the slot last returned by acquire().
+		void submit();
+
+		// Waits until every submitted frame has been rendered.
+		void wait();
+
+	private:
+
+		GLFWwindow*					mWindow;
+		std::function<void(size_t)>	mRender;
+		std::thread					mThread;
+		std::mutex					mMutex;
+		std::condition_variable		mCondition;
+		uint64_t					mSubmitted;
+		uint64_t					mRendered;
+		size_t						mLockDepth;			// only touched by the thread holding the locks
+		bool						mContextRequested;
+		bool						mContextReleased;
+		bool						mStopping;
+
+		void loop();
+	};
+} // namespace ntr
+
+#endif
@@ -3,7 +3,6 @@
 
 #include <filesystem>
 #include <string>
-#include <map>
 #include <unordered_set>
 
 #include <assimp/Importer.hpp>
@@ -15,15 +14,26 @@
 
 #include <entt/entt.hpp>
 
+#include "AssetMap.h"
 #include "Camera.h"
+#include "EntityNames.h"
 #include "Light.h"
 #include "Material.h"
 #include "Mesh.h"
 #include "Model.h"
+#include "References.h"
+#include "SceneBVH.h"
 #include "Transform.h"
+#include "TransformHierarchy.h"
 
 namespace ntr
 {
+	enum RenderPath : int
+	{
+		FORWARD		= 0,	// Material and lighting evaluated per fragment in ntr_pbr.fs.
+		DEFERRED	= 1		// Materials written to a GBuffer, lighting resolved in one fullscreen pass.
+	};
+
 	struct Scene
 	{
 	public:
@@ -33,57 +43,110 @@ namespace ntr
 
 		DirectionalLight directionalLight;
 
+		RenderPath renderPath = RenderPath::FORWARD;
+		bool shadowsEnabled = true;
+
+		CpuData meshCpuData = CpuData::CPU_ALL; // kept by the meshes of models loaded from now on
+
 		entt::registry registry;
 		
 		Scene();
+		~Scene();
 
 		Scene(const Scene& scene)				= delete;
 		Scene& operator=(const Scene& scene)	= delete;
 
 		Scene(Scene&& scene)			= delete;
 		Scene& operator=(Scene&& scene) = delete;
-
-		~Scene();
 				
-		// Returns Mesh::EMPTY if no Mesh found.
-		Mesh* findMesh(const std::string& id);
+		// Assets are owned by the Scene and referred to by handle. Handles of removed assets resolve to nullptr, and
+		// pointers from get are only valid until the next asset of the same type is added or removed.
+		//
+		// The Scene keeps which Models use each Mesh and Material, which Materials use each Texture and which entities
+		// use each Model, so removing an asset only visits its users. Meshes and Materials are released once the last
+		// Model using them lets go of them, Textures once the last Material does. Models stay until removed, they are
+		// what entities are placed from. Assets nothing ever used stay as well.
 
-		void replaceMeshID(const std::string& id, const std::string& new_id);
+		// Returns an empty handle if id is taken.
+		MeshHandle addMesh(const std::string& id, Mesh&& mesh);
+
+		// Returns an empty handle if no Mesh found.
+		MeshHandle findMesh(const std::string& id) const;
+
+		// Returns nullptr if mesh is empty or removed.
+		Mesh* getMesh(MeshHandle mesh);
+		const Mesh* getMesh(MeshHandle mesh) const;
+
+		// Returns false if mesh is empty or removed, or another Mesh has id.
+		bool renameMesh(MeshHandle mesh, const std::string& id);
 		
-		// Removes the Mesh and replaces all MeshInstances that use this Mesh with Mesh::EMPTY.
-		void removeMesh(const std::string& id);
+		// Removes the Mesh and empties the MeshInstances that use it.
+		void removeMesh(MeshHandle mesh);
+
+		// With triangleBVHWorkers, every new Mesh builds a triangle BVH on them for exact picking.
+		// The node tree of the file is flattened into one Model, which entities can be placed from. Lights are not loaded.
+		// Returns an empty handle if unsuccessful.
+		ModelHandle loadModel(const std::string& id, const std::filesystem::path& modelPath, WorkerPool* triangleBVHWorkers = nullptr);
 
-		Model* loadModel(const std::string& id, const std::filesystem::path& modelPath);
+		// Keeps the node tree of the file as entities: one for the root node named id, and one for every other node with
+		// meshes, with the Transform of the node relative to its parent entity. Each node with meshes gets a Model of them.
+		// Point lights of the file become children of the root entity, so every import carries its own lights.
+		// Returns the root entity, or entt::null if unsuccessful.
+		entt::entity importModel(const std::string& id, const std::filesystem::path& modelPath, WorkerPool* triangleBVHWorkers = nullptr);
+
+		// Returns an empty handle if id is taken.
+		ModelHandle addModel(const std::string& id, const Model& model);
 		
-		// Returns Model::EMPTY if no Model found.
-		Model* findModel(const std::string& id);
+		// Returns an empty handle if no Model found.
+		ModelHandle findModel(const std::string& id) const;
+
+		// Returns nullptr if model is empty or removed.
+		Model* getModel(ModelHandle model);
+		const Model* getModel(ModelHandle model) const;
 
-		void replaceModelID(const std::string& id, const std::string& new_id);
+		// Returns false if model is empty or removed, or another Model has id.
+		bool renameModel(ModelHandle model, const std::string& id);
 		
-		// Removes the Model and replaces all entities with ConstPointer<Model> component that use this Model with Model::EMPTY.
-		void removeModel(const std::string& id);
+		// Removes the Model and empties the ModelHandle of the entities that use it.
+		void removeModel(ModelHandle model);
 
-		// Returns Texture::EMPTY if unsuccessful.
-		TextureHandle loadTexture(const std::string& id, const std::filesystem::path& filepath);
+		// Returns an empty handle if id is taken.
+		TextureHandle loadTexture(const std::string& id, const std::filesystem::path& filepath, TextureUsage usage = TextureUsage::COLOR);
 		
-		// Returns Texture::EMPTY if no Texture found.
+		// Returns an empty handle if id is taken.
+		TextureHandle addTexture(const std::string& id, Texture&& texture);
+
+		// Returns an empty handle if no Texture found.
 		TextureHandle findTexture(const std::string& id) const;
 
-		void replaceTextureID(const std::string& id, const std::string& new_id);
+		// Returns nullptr if texture is empty or removed.
+		Texture* getTexture(TextureHandle texture);
+		const Texture* getTexture(TextureHandle texture) const;
+
+		// Returns false if texture is empty or removed, or another Texture has id.
+		bool renameTexture(TextureHandle texture, const std::string& id);
 		
-		// Removes the texture and replaces all Material textures that use this Texture with Texture::EMPTY.
-		void removeTexture(const std::string& id);
+		// Removes the Texture and empties the maps of the Materials that use it.
+		void removeTexture(TextureHandle texture);
 
-		// Returns Material::EMPTY if unsuccessful.
-		Material* addMaterial(const std::string& id, const Material& material);
+		// Returns an empty handle if id is taken.
+		MaterialHandle addMaterial(const std::string& id, const Material& material);
 		
-		// Returns Material::EMPTY if no Material found.
-		Material* findMaterial(const std::string& id);
+		// Returns an empty handle if no Material found.
+		MaterialHandle findMaterial(const std::string& id) const;
 
-		void replaceMaterialID(const std::string& id, const std::string& new_id);
+		// Returns nullptr if material is empty or removed.
+		Material* getMaterial(MaterialHandle material);
+		const Material* getMaterial(MaterialHandle material) const;
+
+		// Returns the default Material if material is empty or removed.
+		const Material& getMaterialOrDefault(MaterialHandle material) const;
+
+		// Returns false if material is empty or removed, or another Material has id.
+		bool renameMaterial(MaterialHandle material, const std::string& id);
 		
-		// Removes the Material and replaces all MeshInstance.material's that use this Material with Material::EMPTY.
-		void removeMaterial(const std::string id);
+		// Removes the Material, MeshInstances that use it fall back to the default Material.
+		void removeMaterial(MaterialHandle material);
 
 		// extra helpers - helpful if you have an asset, but don't know the string id
 
@@ -91,58 +154,102 @@ namespace ntr
 		std::string findTextureID(TextureHandle texture) const;
 
 		// Returns "None" if no Mesh found.
-		std::string findMeshID(const Mesh* mesh) const;
-		
-		// Returns "None" if no Mesh found.
-		std::string findMeshID(const MeshInstance& mesh) const;
+		std::string findMeshID(MeshHandle mesh) const;
 		
 		// Returns "None" if no Model found.
-		std::string findModelID(const Model* model) const;
+		std::string findModelID(ModelHandle model) const;
 		
 		// Returns "None" if no Material found.
-		std::string findMaterialID(const Material* material) const;
+		std::string findMaterialID(MaterialHandle material) const;
+
+		const AssetMap<Model>&						getModels() const;
+		const AssetMap<Material>&					getMaterials() const;
+		const AssetMap<Texture>&					getTextures() const;
+		const AssetMap<Mesh>&						getMeshes() const;
+
+		// Returns id if no entity uses it, otherwise id with a "+N" suffix. A StringID emplaced with an id that is taken gets
+		// one as well, this only tells the id beforehand.
+		std::string getUniqueEntityID(const std::string& id);
+
+		// Returns entt::null if no entity has the StringID id.
+		entt::entity findEntity(const std::string& id) const;
+
+		// Returns false, leaving entity as it is, if another entity uses id.
+		bool renameEntity(entt::entity entity, const std::string& id);
 
-		const std::map<std::string, Model*>&		getModelMap() const;
-		const std::map<std::string, Material*>&		getMaterialMap() const;
-		const std::map<std::string, Texture>&		getTextureMap() const;
-		const std::map<std::string, Mesh*>&			getMeshMap() const;
+		// Makes the Transform of entity relative to parent, entt::null detaches it.
+		// Returns false if parent is entity or one of its descendants.
+		bool setParent(entt::entity entity, entt::entity parent);
 
-		const Material* getDefaultMaterial() const;
+		// Returns entt::null if entity has no parent.
+		entt::entity getParent(entt::entity entity) const;
+
+		// Rebuilds the WorldMatrix of every entity whose Transform, or the Transform of an ancestor, was added or changed
+		// since the last call, and refits the BVH around the entities that moved.
+		void updateTransforms(WorkerPool& workers);
+
+		// Ray casts and overlap queries against the world bounds of every entity with a Model, as of updateTransforms.
+		const SceneBVH& getBVH() const;
+
+		// Call after editing the MeshInstances of model in place. Releases the Meshes and Materials model was the last
+		// user of, so pointers from getMesh and getMaterial are not valid afterwards.
+		void markModelChanged(ModelHandle model);
+
+		// Call after changing the maps of material in place.
+		void markMaterialChanged(MaterialHandle material);
+
+		// Textures whose last Material let go of them are only erased by releaseUnusedTextures, so a texture moved from one
+		// Material to another over several edits survives. Textures used again by then are kept.
+		bool hasUnusedTextures() const;
+		void releaseUnusedTextures();
 
 	private:
 
 		struct AssetCache
 		{
-			std::unordered_map<const aiMesh*, Mesh*> meshes;
+			std::unordered_map<const aiMesh*, MeshHandle> meshes;
 			std::unordered_map<std::filesystem::path, TextureHandle> textures;
-			std::unordered_map<std::filesystem::path, Material*> materials;
+			std::unordered_map<std::filesystem::path, MaterialHandle> materials;
 		};
 
-		const Texture					M_DEFAULT_TEXTURE_ALBEDO;
-		const Texture					M_DEFAULT_TEXTURE_NORMAL;
-		const Texture					M_DEFAULT_TEXTURE_ROUGHNESS;
-		const Texture					M_DEFAULT_TEXTURE_METALLIC;
-		const Texture					M_DEFAULT_TEXTURE_OCCLUSION;
-		const ScopedPointer<Material>	M_DEFAULT_MATERIAL;
+		const Material					M_DEFAULT_MATERIAL;
+
+		AssetMap<Mesh>					mMeshes;
+		AssetMap<Model>					mModels;
+		AssetMap<Material>				mMaterials;
+		AssetMap<Texture>				mTextures;
+
+		References<ModelHandle, MeshHandle>			mMeshUsers;
+		References<ModelHandle, MaterialHandle>		mMaterialUsers;
+		References<MaterialHandle, TextureHandle>	mTextureUsers;
+		References<entt::entity, ModelHandle>		mModelUsers;
+		std::vector<TextureHandle>					mUnusedTextures;
+
+		EntityNames						mEntityNames;
+		TransformHierarchy				mTransformHierarchy;
+		SceneBVH						mBVH;
 
-		std::map<std::string, Texture>				mMapTextures;
-		std::map<std::string, Mesh*>				mMapMeshes;
-		std::map<std::string, Model*>				mMapModels;
-		std::map<std::string, Material*>			mMapMaterials;
+		// Point the references of model, or material, at what it uses now, or at nothing once it was removed.
+		void			updateModelReferences(ModelHandle model);
+		void			updateMaterialReferences(MaterialHandle material);
+		void			releaseMeshes(const std::vector<MeshHandle>& meshes);
+		void			releaseMaterials(const std::vector<MaterialHandle>& materials);
 
-		std::map<TextureHandle,		std::string>		mRmapTextures;
-		std::map<GLuint,			std::string>		mRmapMeshes;
-		std::map<const Model*,		std::string>		mRmapModels;
-		std::map<const Material*,	std::string>		mRmapMaterials;
+		void			onModelAssigned(entt::registry& registry, entt::entity entity);
+		void			onModelRemoved(entt::registry& registry, entt::entity entity);
 
 		void			processCameras(const aiScene* scene);
-		void			processLights(const aiScene* scene);
-		Model*			processModel(const std::filesystem::path& modelPath, const aiNode* ai_node, const aiScene* ai_scene);
-		Mesh*			processMesh(const aiMesh* ai_mesh, const aiScene* ai_scene, AssetCache& assetCache);
+		void			processLights(const aiScene* scene, entt::entity root);
+		aiMatrix4x4		getNodeWorldMatrix(const aiNode* ai_node) const;
+		const aiScene*	readModelFile(Assimp::Importer& importer, const std::filesystem::path& modelPath);
+		entt::entity	processModel(const std::string& id, const std::filesystem::path& modelPath, const aiScene* ai_scene, WorkerPool* triangleBVHWorkers);
+		Model			flattenModel(const std::filesystem::path& modelPath, const aiScene* ai_scene, WorkerPool* triangleBVHWorkers);
+		void			processNodeMeshes(const std::filesystem::path& modelPath, const aiNode* ai_node, const aiScene* ai_scene, const Transform& meshTransform, AssetCache& assetCache, WorkerPool* triangleBVHWorkers, Model& model);
+		MeshHandle		processMesh(const aiMesh* ai_mesh, const aiScene* ai_scene, AssetCache& assetCache, WorkerPool* triangleBVHWorkers);
 		std::pair<std::vector<Vertex>, std::vector<GLuint>> processMeshVerticesAndIndices(const aiMesh* ai_mesh);
-		Material*		processMeshMaterial(const std::filesystem::path& modelPath, const aiMesh* ai_mesh, const aiNode* ai_node, const aiScene* ai_scene, AssetCache& assetCache);
-		Transform		processMeshTransform(const aiNode* ai_node, const aiScene* ai_scene);
-		TextureHandle	processMaterialTexture(const std::filesystem::path& modelPath, const aiMaterial* ai_material, aiTextureType ai_texture_type, unsigned int index, AssetCache& assetCache);
+		MaterialHandle	processMeshMaterial(const std::filesystem::path& modelPath, const aiMesh* ai_mesh, const aiNode* ai_node, const aiScene* ai_scene, AssetCache& assetCache);
+		Transform		processMeshTransform(const aiMatrix4x4& ai_matrix);
+		TextureHandle	processMaterialTexture(const std::filesystem::path& modelPath, const aiMaterial* ai_material, aiTextureType ai_texture_type, TextureUsage usage, unsigned int index, AssetCache& assetCache);
 		Transform		toTransform(const aiMatrix4x4& matrix);
 	};
 	
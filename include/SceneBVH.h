@@ -0,0 +1,116 @@
+#ifndef NTR_SCENE_BVH_H
+#define NTR_SCENE_BVH_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include "AssetMap.h"
+#include "Model.h"
+#include "Structs.h"
+#include "Transform.h"
+
+namespace ntr
+{
+	struct RayHit
+	{
+		entt::entity	entity			= entt::null;
+		float			distance		= 0.0f;
+		std::string		meshID;							// of the MeshInstance hit, in Model::meshes
+		bool			exact			= false;		// false if the Mesh has no triangle BVH and only its bounds were hit
+		uint32_t		triangle		= 0;			// the rest is only set for exact hits
+		glm::vec2		barycentrics	= { 0.0f, 0.0f };	// weights of the second and third vertex
+	};
+
+	// Bounding volume hierarchy over the world bounds of every entity with a ModelHandle and a WorldMatrix.
+	// Built top down with a binned surface area heuristic. Entities that moved only refit the boxes above them, and the
+	// tree is rebuilt once as many refits as entities have piled up, or when entities or their models are swapped.
+	// Queries are read only and run on the main thread, against the state of the last update.
+	class SceneBVH
+	{
+	public:
+
+		// The handles of the entities resolve in models, and those of their MeshInstances in meshes.
+		SceneBVH(entt::registry& registry, const AssetMap<Model>& models, const AssetMap<Mesh>& meshes);
+		SceneBVH(const SceneBVH& bvh) = delete;
+		SceneBVH& operator=(const SceneBVH& bvh) = delete;
+		~SceneBVH();
+
+		// movedEntities had their WorldMatrix changed since the last update, see TransformHierarchy::getUpdatedEntities.
+		void update(const std::vector<entt::entity>& movedEntities);
+
+		// The meshes of a Model were edited in place, the next update rebuilds the tree.
+		void markModelsChanged();
+
+		// Nearest entity whose meshes are hit within maxDistance. Meshes with a triangle BVH are tested exactly, the
+		// others by their bounds in mesh space.
+		bool raycast(const Ray& ray, RayHit& hit, float maxDistance = std::numeric_limits<float>::max()) const;
+
+		// Every hit within maxDistance, nearest first.
+		void raycastAll(const Ray& ray, std::vector<RayHit>& hits, float maxDistance = std::numeric_limits<float>::max()) const;
+
+		// Entities whose world bounds overlap the box or sphere, in no particular order.
+		void queryAABB(const AABB& aabb, std::vector<entt::entity>& entities) const;
+		void querySphere(const glm::vec3& center, float radius, std::vector<entt::entity>& entities) const;
+
+		size_t size() const;
+		size_t nodeCount() const;
+
+	private:
+
+		static constexpr uint32_t NO_PARENT = UINT32_MAX;
+		static constexpr uint32_t BIN_COUNT = 16;
+		static constexpr uint32_t MAX_LEAF_SIZE = 4;
+
+		// Children of an inner node are first and first + 1, always after it in mNodes.
+		struct Node
+		{
+			AABB		bounds;
+			uint32_t	first;		// child or item index
+			uint32_t	count;		// items, 0 for inner nodes
+			uint32_t	parent;		// NO_PARENT for the root
+		};
+
+		struct Item
+		{
+			entt::entity	entity;
+			AABB			bounds;		// world space
+		};
+
+		entt::registry&								mRegistry;
+		const AssetMap<Model>&						mModels;
+		const AssetMap<Mesh>&						mMeshes;
+		std::vector<Node>							mNodes;
+		std::vector<Item>							mItems;			// grouped by leaf
+		std::vector<uint32_t>						mItemLeaves;	// same order as mItems
+		std::unordered_map<entt::entity, uint32_t>	mIndices;		// into mItems
+		std::unordered_map<ModelHandle, AABB>		mModelBounds;	// model space, of the meshes with geometry
+		size_t										mRefitCount;	// items refit since the last build
+		bool										mStructureChanged;
+
+		void onStructureChanged(entt::registry& registry, entt::entity entity);
+
+		void rebuild();
+		void refit(const std::vector<uint32_t>& items);
+		void computeItemBounds(const uint32_t* items, size_t count);
+		bool fitNode(uint32_t node); // returns false if the bounds didn't change
+
+		// Returns false if the node stays a leaf, otherwise its children are appended to mNodes.
+		bool splitNode(uint32_t node, std::vector<uint32_t>& order, const std::vector<glm::vec3>& centroids);
+
+		// Returns false for removed models and models without geometry, which are left out of the tree.
+		bool getModelBounds(ModelHandle model, AABB& bounds);
+
+		// Nearest hit of the ray with the meshes of entity, in [0, maxDistance].
+		bool intersectEntity(const Ray& ray, entt::entity entity, float maxDistance, RayHit& hit) const;
+	};
+} // namespace ntr
+
+#endif
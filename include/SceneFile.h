@@ -0,0 +1,34 @@
+#ifndef NTR_SCENE_FILE_H
+#define NTR_SCENE_FILE_H
+
+#include <cstdint>
+#include <filesystem>
+
+#include "Scene.h"
+
+namespace ntr
+{
+	// Versioned binary snapshot of a Scene (.ntrscene). It holds the asset tables with their geometry, triangle BVHs and
+	// compressed mip chains, the StringID, Transform, Parent, ModelHandle and PointLight components of every
+	// entity, and the camera and lighting settings.
+	// Sections are listed in a table after the header, and every section and blob starts 64 byte aligned, little endian, so
+	// loading maps the file and reads it in place: vertex, index and mip data go straight to GL and the component
+	// arrays are inserted into the registry in bulk.
+	class SceneFile
+	{
+	public:
+
+		static constexpr uint32_t VERSION = 1;
+
+		// Meshes and textures that are not kept on the CPU are read back from VRAM, which needs the GL context.
+		static bool save(const std::filesystem::path& filepath, const Scene& scene);
+
+		// Adds the assets and entities in the file to scene, asset IDs that are taken get "+" appended and entity
+		// IDs a "+N" suffix. Needs the GL context.
+		// The whole file is checked first, if it is damaged scene is left as it was and false is returned.
+		// Meshes keep Scene::meshCpuData, and textures whose source file still exists stream their finer mips from it.
+		static bool load(const std::filesystem::path& filepath, Scene& scene);
+	};
+} // namespace ntr
+
+#endif
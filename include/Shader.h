@@ -1,8 +1,13 @@
 #ifndef NTR_SHADER_H
 #define NTR_SHADER_H
 
+#include <cstdint>
 #include <filesystem>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
 
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
@@ -13,7 +18,6 @@
 #include "Material.h"
 #include "Mesh.h"
 #include "Model.h"
-#include "Pointer.h"
 #include "Scene.h"
 #include "Texture.h"
 #include "Transform.h"
@@ -25,11 +29,37 @@ namespace ntr
 	public:
 
 		Shader();
-		Shader(const std::string& vertexFilepath, const std::string& fragmentFilepath, const std::string& geometryFilepath = "");
+		// defines are inserted as "#define <define>" lines after the #version directive of every stage.
+		Shader(const std::string& vertexFilepath, const std::string& fragmentFilepath, const std::string& geometryFilepath = "", const std::vector<std::string>& defines = {});
+		// Creates a compute program.
+		explicit Shader(const std::string& computeFilepath);
+
+		// A program still compiling owns its stage shaders until finalize(), so a Shader is only moved, never copied.
+		Shader(const Shader& shader)			= delete;
+		Shader& operator=(const Shader& shader)	= delete;
+		Shader(Shader&& shader) noexcept;
+		Shader& operator=(Shader&& shader) noexcept;
+
+		// Creates a program from precompiled SPIR-V modules (GL 4.6 / ARB_gl_spirv), e.g. from glslangValidator -G.
+		// SPIR-V drops uniform names, so uniforms outside blocks need explicit locations. Bypasses the ShaderCache.
+		static Shader fromSpirv(const std::string& vertexFilepath, const std::string& fragmentFilepath);
 
 		GLuint id() const;
+		
+		// Binds the program, finalizing it first if it was still compiling.
 		void use() const;
 
+		// Returns false while the driver is still compiling the program in the background.
+		// Always true without GL_KHR_parallel_shader_compile, where finalize() simply blocks.
+		bool isReady() const;
+
+		// Waits for the program to link and reports compile and link errors, done once on first use.
+		void finalize() const;
+
+		// Lets the driver compile on its own threads if GL_KHR_parallel_shader_compile (or the ARB version) is available.
+		// Returns false if not supported.
+		static bool enableParallelCompile(GLADloadproc getProcAddress);
+
 		void setBool(const std::string& name, bool value) const;
 		void setInt(const std::string& name, int value) const;
 		void setFloat(const std::string& name, float value) const;
@@ -45,15 +75,19 @@ namespace ntr
 
 		void draw(const Mesh& mesh);
 		void draw(const Mesh* mesh);
-		void draw(const MeshInstance& mesh);
-		void draw(const Model& model);
-		void draw(const Model* model);
+		void draw(GLuint vao, GLsizei indexCount);
+
+		// Draws a single screen-covering triangle, vertices are generated in the vertex shader from gl_VertexID.
+		void drawFullscreenTriangle();
+
+		// Runs a compute program with the given number of work groups.
+		void dispatch(GLuint groupsX, GLuint groupsY, GLuint groupsZ);
 		
 		void bindTexture(GLint unit, const Texture& texture);
-		void bindTexture(GLint unit, TextureHandle texture);
+		void bindTexture(GLint unit, GLuint texture);
 		void bindTexture(GLint unit, const DepthTexture2D& texture);
 		void bindTexture(GLint unit, const std::string& name, const Texture& texture) const;
-		void bindTexture(GLint unit, const std::string& name, TextureHandle texture) const;
+		void bindTexture(GLint unit, const std::string& name, GLuint texture) const;
 		void bindTexture(GLint unit, const std::string& name, const DepthTexture2D& texture) const;
 		void bindTexture(GLint unit, const Texture2DArray& textureArray);
 		void unbindTexture(GLint unit);
@@ -63,9 +97,20 @@ namespace ntr
 
 	private:
 
-		GLuint mID;
+		static bool parallelCompileEnabled;
+
+		GLuint		mID;
+		uint64_t	mCacheKey;
+
+		// stage shaders are kept until finalize() so their info logs can be read
+		mutable std::vector<GLuint>	mPendingStages;
+		mutable bool				mPending;
 
 		void checkCompileErrors(const unsigned int& shaderID, const std::string& type) const;
+
+		void submit(const std::vector<std::pair<GLenum, std::string>>& stages, uint64_t cacheKey);
+
+		static std::string injectDefines(const std::string& source, const std::vector<std::string>& defines);
 	};
 } // namespace ntr
 
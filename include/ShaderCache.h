@@ -0,0 +1,39 @@
+#ifndef NTR_SHADER_CACHE_H
+#define NTR_SHADER_CACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace ntr
+{
+	// On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary).
+	// Entries are keyed by a hash of the final shader sources (defines included) and the GL vendor, renderer and version strings,
+	// so edited shaders and driver updates miss the cache instead of loading stale binaries.
+	class ShaderCache
+	{
+	public:
+
+		static bool						enabled;
+		static std::filesystem::path	directory;
+
+		// Returns the cache key for a program built from sources.
+		static uint64_t getKey(const std::vector<std::string>& sources);
+
+		// Returns a linked program, or 0 if there is no entry for key or the driver rejects the binary.
+		static GLuint load(uint64_t key);
+
+		// Writes the binary of a linked program, program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT.
+		static void store(uint64_t key, GLuint program);
+
+	private:
+
+		static bool isSupported();
+		static std::filesystem::path getEntryPath(uint64_t key);
+	};
+} // namespace ntr
+
+#endif
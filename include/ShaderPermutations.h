@@ -0,0 +1,70 @@
+#ifndef NTR_SHADER_PERMUTATIONS_H
+#define NTR_SHADER_PERMUTATIONS_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Shader.h"
+
+namespace ntr
+{
+	using ShaderFeatures = uint32_t;
+
+	// Each set bit is compiled into the shader as a #define of the same name.
+	enum ShaderFeature : ShaderFeatures
+	{
+		ALBEDO_MAP		= 1 << 0,
+		NORMAL_MAP		= 1 << 1,
+		ROUGHNESS_MAP	= 1 << 2,
+		METALLIC_MAP	= 1 << 3,
+		OCCLUSION_MAP	= 1 << 4,
+		SHADOWS			= 1 << 5,
+
+		MATERIAL_MAPS	= ALBEDO_MAP | NORMAL_MAP | ROUGHNESS_MAP | METALLIC_MAP | OCCLUSION_MAP
+	};
+
+	// Shadow cascade count is stored in bits 8-11 and compiled as CASCADE_COUNT.
+	constexpr ShaderFeatures	SHADER_FEATURE_CASCADE_SHIFT	= 8;
+	constexpr ShaderFeatures	SHADER_FEATURE_CASCADE_MASK		= 0xF << SHADER_FEATURE_CASCADE_SHIFT;
+
+	constexpr ShaderFeatures toCascadeFeature(size_t cascadeCount)
+	{
+		return (static_cast<ShaderFeatures>(cascadeCount) << SHADER_FEATURE_CASCADE_SHIFT) & SHADER_FEATURE_CASCADE_MASK;
+	}
+
+	// Lazily compiled, #define-specialized variants of one shader program, keyed by feature bitmask.
+	class ShaderPermutations
+	{
+	public:
+
+		ShaderPermutations(const std::string& vertexFilepath, const std::string& fragmentFilepath, const std::string& geometryFilepath = "");
+
+		ShaderPermutations(const ShaderPermutations& sp)			= delete;
+		ShaderPermutations& operator=(const ShaderPermutations& sp)	= delete;
+
+		~ShaderPermutations();
+
+		// Returns the variant for features, submitting it on first use. While it is still compiling, a ready variant
+		// with the same cascade/instancing bits and a subset of its maps and shadows is returned instead.
+		// Blocks only if there is no such fallback.
+		Shader& get(ShaderFeatures features);
+
+		// Submits the variant for features without waiting for it to compile.
+		Shader& prepare(ShaderFeatures features);
+
+		size_t size() const;
+
+		static std::vector<std::string> toDefines(ShaderFeatures features);
+
+	private:
+
+		std::string									mVertexFilepath;
+		std::string									mFragmentFilepath;
+		std::string									mGeometryFilepath;
+		std::unordered_map<ShaderFeatures, Shader>	mVariants;
+	};
+} // namespace ntr
+
+#endif
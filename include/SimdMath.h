@@ -0,0 +1,77 @@
+#ifndef NTR_SIMD_MATH_H
+#define NTR_SIMD_MATH_H
+
+#include <cstddef>
+#include <ostream>
+
+#include <glm/matrix.hpp>
+
+#include "Structs.h"
+#include "Transform.h"
+
+// Kernels for the per-frame math that runs over many transforms at once, on structure-of-arrays batches of BATCH_SIZE
+// elements. A batch is processed 8 lanes at a time with AVX2 (NTR_ENABLE_AVX2), 4 with SSE on x86-64, 1 otherwise.
+// Results match the GLM versions (Transform::matrix(), WorldMatrix) up to float rounding.
+
+namespace ntr::simd
+{
+	constexpr size_t BATCH_SIZE = 8;
+
+	// Lane i of every array belongs to element i. load() pads lanes past count with identity elements.
+
+	struct alignas(32) TransformBatch
+	{
+		float position[3][BATCH_SIZE];
+		float rotation[3][BATCH_SIZE]; // degrees
+		float scale[3][BATCH_SIZE];
+
+		void load(const Transform* transforms, size_t count);
+	};
+
+	struct alignas(32) MatrixBatch
+	{
+		float m[4][4][BATCH_SIZE]; // [column][row], like glm
+
+		void load(const glm::mat4* matrices, size_t count);
+		void store(glm::mat4* matrices, size_t count) const;
+	};
+
+	struct alignas(32) Matrix3Batch
+	{
+		float m[3][3][BATCH_SIZE]; // [column][row], like glm
+
+		void store(glm::mat3* matrices, size_t count) const;
+	};
+
+	struct alignas(32) AABBBatch
+	{
+		float min[3][BATCH_SIZE];
+		float max[3][BATCH_SIZE];
+
+		void load(const AABB* aabbs, size_t count);
+		void store(AABB* aabbs, size_t count) const;
+	};
+
+	// Name of the instruction set the kernels were built for.
+	const char* instructionSet();
+
+	// Same as Transform::matrix().
+	void compose(const TransformBatch& transforms, MatrixBatch& matrices);
+
+	// Inverse transpose of the upper 3x3 of every matrix.
+	void inverseTranspose(const MatrixBatch& matrices, Matrix3Batch& normals);
+
+	// Smallest AABBs that contain the transformed boxes.
+	void transformAABBs(const MatrixBatch& matrices, const AABBBatch& aabbs, AABBBatch& transformed);
+
+	// Array versions of the kernels above, for any count.
+
+	void composeWorldMatrices(const Transform* transforms, size_t count, WorldMatrix* worlds);
+	void inverseTransposes(const glm::mat4* matrices, size_t count, glm::mat3* normals);
+	void transformAABBs(const glm::mat4* matrices, const AABB* aabbs, size_t count, AABB* transformed);
+
+	// Times every kernel against its GLM equivalent over count random elements and writes a table to out.
+	void benchmark(size_t count, std::ostream& out);
+} // namespace ntr::simd
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef NTR_SLOT_MAP_H
+#define NTR_SLOT_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace ntr
+{
+	// Generational index of an element in a SlotMap<T>. The low INDEX_BITS select a slot and the rest count how often
+	// the slot was reused, so a handle to an erased element never resolves to the element that took its place.
+	// A default constructed handle is empty, no element ever gets the value 0.
+	template <typename T>
+	struct Handle
+	{
+		static constexpr uint32_t INDEX_BITS		= 20;
+		static constexpr uint32_t INDEX_MASK		= (1u << INDEX_BITS) - 1;
+		static constexpr uint32_t GENERATION_MASK	= UINT32_MAX >> INDEX_BITS;
+
+		uint32_t value = 0;
+
+		uint32_t index() const;
+		uint32_t generation() const;
+
+		explicit operator bool() const;
+		bool operator==(Handle<T> handle) const;
+		bool operator!=(Handle<T> handle) const;
+	};
+
+	// Elements stored densely in one array, addressed through Handles that stay valid while other elements come and go.
+	// Resolving a handle is two array reads. Erasing moves the last element into the gap, so the order of iteration
+	// changes and pointers to elements are only valid until the next emplace or erase.
+	template <typename T>
+	class SlotMap
+	{
+	public:
+
+		static constexpr size_t NPOS = SIZE_MAX;
+
+		// Returns an empty handle once all 2^Handle<T>::INDEX_BITS slots are in use.
+		template <typename... Args>
+		Handle<T> emplace(Args&&... args);
+
+		// Returns false if handle is empty or stale.
+		bool erase(Handle<T> handle);
+
+		bool contains(Handle<T> handle) const;
+
+		// Returns nullptr if handle is empty or stale.
+		T* get(Handle<T> handle);
+		const T* get(Handle<T> handle) const;
+
+		// Position of the element in the dense array, NPOS if handle is empty or stale.
+		size_t indexOf(Handle<T> handle) const;
+
+		// Handle of the element at index in the dense array.
+		Handle<T> handleAt(size_t index) const;
+
+		T& operator[](size_t index);
+		const T& operator[](size_t index) const;
+
+		size_t size() const;
+		bool empty() const;
+
+		typename std::vector<T>::iterator		begin();
+		typename std::vector<T>::iterator		end();
+		typename std::vector<T>::const_iterator	begin() const;
+		typename std::vector<T>::const_iterator	end() const;
+
+	private:
+
+		struct Slot
+		{
+			uint32_t index;			// into mValues while in use, the next free slot while free
+			uint32_t generation;
+		};
+
+		static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+		std::vector<T>			mValues;
+		std::vector<Handle<T>>	mHandles;		// same order as mValues
+		std::vector<Slot>		mSlots;
+		uint32_t				mFreeSlot = NO_SLOT;
+	};
+} // namespace ntr
+
+namespace std
+{
+	template <typename T>
+	struct hash<ntr::Handle<T>>
+	{
+		size_t operator()(ntr::Handle<T> handle) const;
+	};
+} // namespace std
+
+#include "SlotMap.hpp"
+
+#endif
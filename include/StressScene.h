@@ -0,0 +1,97 @@
+#ifndef NTR_STRESS_SCENE_H
+#define NTR_STRESS_SCENE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "GLState.h"
+#include "Scene.h"
+
+namespace ntr
+{
+	// Tag of the entities StressScene spawns. They carry no StringID, which keeps them out of the Entities list
+	// and out of the entity name index.
+	struct StressEntity
+	{
+	};
+
+	struct StressSceneSettings
+	{
+		size_t		entityCount			= 0;
+		size_t		pointLightCount		= 0;
+		size_t		materialVariants	= 16;	// each variant is a copy of a scene model with its own material
+		uint32_t	seed				= 1;
+		float		spacing				= 3.0f;	// average distance between entities on the ground plane
+	};
+
+	// Procedural scenes for scaling tests, built from the models already in the scene.
+	// The same settings always give the same scene: transforms and materials come from a seeded mt19937
+	// and are derived from its raw output, not from the implementation-defined std distributions.
+	class StressScene
+	{
+	public:
+
+		// Replaces the previous stress scene. Entities are created and their components inserted in bulk.
+		// Returns false if the scene has no models to instance.
+		static bool spawn(Scene& scene, const StressSceneSettings& settings);
+
+		// Removes the stress entities, lights, model variants and materials.
+		static void clear(Scene& scene);
+
+		static size_t entityCount(Scene& scene);
+
+		// Storage the registry holds for the stress entities and lights: components plus the dense and sparse
+		// entity arrays of each pool, counted at capacity.
+		static size_t registryBytes(Scene& scene);
+
+	private:
+
+		static constexpr const char* VARIANT_PREFIX = "stress_";
+	};
+
+	// Spawns increasing entity counts one after another and measures each for a number of frames,
+	// giving frame time, draw call and memory curves over entity count.
+	class StressSweep
+	{
+	public:
+
+		struct Sample
+		{
+			size_t	entities		= 0;
+			float	spawnMs			= 0.0f;
+			float	frameMs			= 0.0f;	// average CPU frame time
+			float	drawCalls		= 0.0f;	// average per frame
+			float	bytesPerEntity	= 0.0f;
+		};
+
+		size_t warmupFrames		= 10;
+		size_t measuredFrames	= 60;
+
+		// Steps through 1k, 3k, 10k, 30k, ... entities up to maxEntities.
+		void start(const StressSceneSettings& settings, size_t maxEntities);
+		void stop();
+
+		bool active() const;
+
+		// Call once per frame with the timing of the frame before, spawns the next step when due.
+		void update(Scene& scene, float frameTimeMs, const GLStateCounters& lastFrame);
+
+		const std::vector<Sample>& samples() const;
+
+		bool writeCsv(const std::filesystem::path& filepath) const;
+
+	private:
+
+		StressSceneSettings	mSettings;
+		std::vector<size_t>	mSteps;
+		std::vector<Sample>	mSamples;
+		size_t				mStep		= 0;
+		size_t				mFrame		= 0;
+		bool				mActive		= false;
+
+		void spawnStep(Scene& scene);
+	};
+} // namespace ntr
+
+#endif
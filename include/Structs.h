@@ -1,6 +1,7 @@
 #ifndef NTR_STRUCTS_H
 #define NTR_STRUCTS_H
 
+#include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 
 namespace ntr
@@ -25,6 +26,19 @@ namespace ntr
 		Rect(const glm::vec4& v);
 		operator glm::vec4() const;
 	};
+
+	struct AABB
+	{
+		glm::vec3 min = { 0.0f, 0.0f, 0.0f };
+		glm::vec3 max = { 0.0f, 0.0f, 0.0f };
+	};
+
+	// Distances along a ray are in units of the length of direction, which doesn't have to be normalized.
+	struct Ray
+	{
+		glm::vec3 origin	= { 0.0f, 0.0f, 0.0f };
+		glm::vec3 direction	= { 0.0f, 0.0f, -1.0f };
+	};
 }
 
 #endif
\ No newline at end of file
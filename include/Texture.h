@@ -3,6 +3,7 @@
 
 #include <filesystem>
 #include <string>
+#include <vector>
 
 #include <assimp/material.h>
 
@@ -11,11 +12,11 @@
 #include <glm/vec4.hpp>
 
 #include "Buffers.h"
+#include "SlotMap.h"
+#include "TextureCooker.h"
 
 namespace ntr
 {
-	using TextureHandle = GLuint;
-
 	enum TextureFilter : GLint
 	{
 		BILINEAR = GL_LINEAR,
@@ -29,13 +30,20 @@ namespace ntr
 
 		static TextureFilter defaultFilter;
 
-		static constexpr TextureHandle EMPTY = 0;
+		// Compressed textures start with only the mips at or below this size resident, TextureStreamer loads the rest.
+		// 0 uploads every level up front.
+		static int streamingResidentSize;
 
 		Texture();
 
-		Texture(const std::filesystem::path& filepath, TextureFilter filter = defaultFilter);
+		// .dds and .ktx2 files are uploaded as they are, other images are cooked to a block-compressed format picked by usage
+		// (see TextureCooker), or uploaded uncompressed if TextureCooker::enabled is false.
+		Texture(const std::filesystem::path& filepath, TextureUsage usage = TextureUsage::COLOR, TextureFilter filter = defaultFilter);
 		Texture(int width, int height, const glm::vec4& color, TextureFilter filter = defaultFilter);
 
+		// Uploads image as it is. filepath is where TextureStreamer reads the finer mips from, empty uploads every level.
+		Texture(const CompressedImageView& image, const std::filesystem::path& filepath, TextureUsage usage = TextureUsage::COLOR, TextureFilter filter = defaultFilter);
+
 		Texture(const Texture& texture)				= delete;
 		Texture& operator=(const Texture& texture)	= delete;
 
@@ -45,11 +53,39 @@ namespace ntr
 		~Texture();
 
 		int						channels() const;
+		bool					compressed() const;
 		TextureFilter			filter() const;
 		int						height() const;
-		TextureHandle			handle() const;
+		GLuint					id() const;
 		int						width() const;
 
+		// Returns the VRAM used by the resident mip levels in bytes.
+		size_t					sizeBytes() const;
+
+		// STREAMING
+
+		const std::filesystem::path&	filepath() const;
+		TextureUsage					usage() const;
+		GLenum							format() const;
+		int								levelCount() const;
+		size_t							levelSizeBytes(int level) const;
+
+		// Finest mip level uploaded when the texture was created. The finer levels TextureStreamer streams in and out
+		// on the render thread are tracked there, and so are not counted in sizeBytes().
+		int								residentLevel() const;
+
+		// Finest mip level that is never evicted, the one the texture was created with.
+		int								pinnedLevel() const;
+
+		// Returns true if finer mips than pinnedLevel() can be streamed in.
+		bool							streamable() const;
+
+		// Copies every level back from VRAM. Returns false if the texture isn't compressed or was created without every level.
+		bool							readCompressed(CompressedImage& image) const;
+
+		// Reads filepath as a compressed mip chain, cooking it if it's not a .dds / .ktx2. Safe to call from any thread.
+		static bool						loadCompressed(const std::filesystem::path& filepath, TextureUsage usage, CompressedImage& image);
+
 	private:
 
 		GLuint					mID;
@@ -57,10 +93,23 @@ namespace ntr
 		int						mHeight;
 		int						mChannels;
 		TextureFilter			mFilter;
+		size_t					mSizeBytes;
+		bool					mCompressed;
+
+		std::filesystem::path	mFilepath;
+		TextureUsage			mUsage;
+		GLenum					mFormat;
+		std::vector<size_t>		mLevelSizes;
+		int						mResidentLevel;
+		int						mPinnedLevel;
 
 		void init(GLenum format, const unsigned char* pixels);
+		void initCompressed(const CompressedImageView& image);
+		void initParameters();
 	};
 
+	using TextureHandle = Handle<Texture>;
+
 	class DepthTexture2D
 	{
 	public:
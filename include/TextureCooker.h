@@ -0,0 +1,39 @@
+#ifndef NTR_TEXTURE_COOKER_H
+#define NTR_TEXTURE_COOKER_H
+
+#include <cstdint>
+#include <filesystem>
+
+#include "TextureFile.h"
+
+namespace ntr
+{
+	// How a texture is sampled, decides the compressed format it is cooked to.
+	enum TextureUsage : uint8_t
+	{
+		COLOR,			// BC7, rgba
+		NORMAL,			// BC5, xy only, z is reconstructed in the shader
+		SINGLE_CHANNEL	// BC4, r only
+	};
+
+	// Import-time texture compression. Builds the mip chain on the CPU, encodes every level on worker threads
+	// and caches the result as a DDS keyed by the source path, size, modification time and usage.
+	class TextureCooker
+	{
+	public:
+
+		static bool						enabled;
+		static std::filesystem::path	directory;
+
+		// Returns false if the source image could not be read.
+		static bool cook(const std::filesystem::path& filepath, TextureUsage usage, CompressedImage& image);
+
+	private:
+
+		// Returns 0 if filepath can't be stat'ed.
+		static uint64_t getKey(const std::filesystem::path& filepath, TextureUsage usage);
+		static std::filesystem::path getEntryPath(uint64_t key);
+	};
+} // namespace ntr
+
+#endif
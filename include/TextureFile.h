@@ -0,0 +1,66 @@
+#ifndef NTR_TEXTURE_FILE_H
+#define NTR_TEXTURE_FILE_H
+
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace ntr
+{
+	// Block-compressed pixels stored in DRAM, one buffer per mip level (level 0 first).
+	struct CompressedImage
+	{
+		GLenum									format		= 0;
+		int										width		= 0;
+		int										height		= 0;
+		int										channels	= 0;
+		std::vector<std::vector<unsigned char>>	levels;
+	};
+
+	// Mip levels of a compressed image read in place, e.g. from a memory-mapped file, instead of copied into a CompressedImage.
+	struct CompressedImageView
+	{
+		GLenum								format		= 0;
+		int									width		= 0;
+		int									height		= 0;
+		int									channels	= 0;
+		std::vector<const unsigned char*>	levels;
+		std::vector<size_t>					levelSizes;	// same order as levels
+
+		CompressedImageView() = default;
+		CompressedImageView(const CompressedImage& image);
+	};
+
+	// Reads and writes block-compressed 2D textures (BC1-BC5, BC7) in DDS and KTX2 containers.
+	class TextureFile
+	{
+	public:
+
+		// Largest width or height accepted from a file, the smallest GL_MAX_TEXTURE_SIZE of GL 4.x.
+		static constexpr int MAX_DIMENSION = 16384;
+
+		// Returns true if filepath has an extension handled here (.dds, .ktx2).
+		static bool isCompressedFile(const std::filesystem::path& filepath);
+
+		// Returns false if the file is missing, not a single 2D image or uses an unsupported format.
+		static bool load(const std::filesystem::path& filepath, CompressedImage& image);
+
+		static bool loadDDS(const std::filesystem::path& filepath, CompressedImage& image);
+		static bool loadKTX2(const std::filesystem::path& filepath, CompressedImage& image);
+
+		// Writes image as a DDS with a DX10 header.
+		static bool saveDDS(const std::filesystem::path& filepath, const CompressedImage& image);
+
+		// Returns the size in bytes of one 4x4 block, or 0 if format is not supported.
+		static size_t getBlockSize(GLenum format);
+
+		static size_t getLevelSize(GLenum format, int width, int height);
+
+		// Returns the length of the full mip chain of a width x height image, down to 1x1, or 0 if either is not positive.
+		static int getMaxLevelCount(int width, int height);
+	};
+} // namespace ntr
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef NTR_TEXTURE_STREAMER_H
+#define NTR_TEXTURE_STREAMER_H
+
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Material.h"
+#include "Texture.h"
+
+namespace ntr
+{
+	// What the streamer needs of a Texture, copied into each frame on the main thread so streaming never reads the Scene.
+	struct StreamedTexture
+	{
+		std::string				id;
+		TextureHandle			handle;
+		GLuint					name			= 0;		// of the GL texture, only valid while the frame is in flight
+		int						width			= 0;
+		int						height			= 0;
+		size_t					sizeBytes		= 0;		// as created
+		bool					streamable		= false;	// the rest is only set if true
+		std::filesystem::path	filepath;
+		TextureUsage			usage			= TextureUsage::COLOR;
+		GLenum					format			= 0;
+		std::vector<size_t>		levelSizes;
+		int						pinnedLevel		= 0;
+
+		// Copies texture, reusing the storage of the strings and level sizes.
+		void assign(const std::string& textureID, TextureHandle textureHandle, const Texture& texture);
+	};
+
+	// Streams the finer mips of compressed textures in and out of VRAM.
+	// The renderer requests each material at the screen size it covers, the mip level that needs is loaded on a worker
+	// thread and uploaded in update(). When over budgetBytes the least recently needed mips are evicted first.
+	// The streamer owns the residency of the levels finer than the pinned one, the Texture in the Scene keeps describing
+	// the levels it was created with.
+	class TextureStreamer
+	{
+	public:
+
+		size_t budgetBytes		= 256 * 1024 * 1024;
+		size_t maxLoadsInFlight	= 4;
+
+		TextureStreamer();
+		TextureStreamer(const TextureStreamer& ts) = delete;
+		TextureStreamer& operator=(const TextureStreamer& ts) = delete;
+
+		// Records that the textures of material are sampled this frame by a surface about screenSizePixels across.
+		void request(const Material* material, float screenSizePixels);
+		void request(TextureHandle texture, float screenSizePixels);
+
+		// Uploads finished loads, evicts over budget and starts loads for the mips requested since the last update.
+		// textures are all the textures of the frame, streaming states of the ones missing are dropped.
+		void update(const std::vector<StreamedTexture>& textures);
+
+		// Finest mip level of texture in VRAM and the bytes it uses, as of the last update.
+		void getResidency(const StreamedTexture& texture, int& residentLevel, size_t& sizeBytes) const;
+
+		size_t residentBytes() const;
+		size_t loadsInFlight() const;
+
+	private:
+
+		struct StreamState
+		{
+			StreamedTexture				texture;		// as first seen, later copies only differ in the id
+			int							residentLevel	= 0;
+			size_t						sizeBytes		= 0;
+			uint64_t					lastNeededFrame	= 0;
+			int							targetLevel		= 0;
+			int							loadLevel		= 0;
+			std::future<CompressedImage>	load;
+		};
+
+		std::unordered_map<TextureHandle, float>		mRequests;
+		std::unordered_map<TextureHandle, StreamState>	mStates;
+		uint64_t										mFrame;
+		size_t											mResidentBytes;
+		size_t											mLoadsInFlight;
+
+		// Returns the bytes needed to make the texture of state resident from level up to its current resident level.
+		static size_t getMissingBytes(const StreamState& state, int level);
+
+		// Uploads the levels from level up to the resident level out of image, which must hold the full mip chain.
+		static void makeResident(StreamState& state, const CompressedImage& image, int level);
+
+		// Frees every level finer than level, never past the pinned level.
+		static void evict(StreamState& state, int level);
+
+		// Returns the state whose finest resident mip is least needed, nullptr if nothing can be evicted.
+		// Mips needed at their current level this frame are only candidates if includeNeeded is true.
+		StreamState* findEvictionVictim(const std::vector<StreamState*>& states, bool includeNeeded);
+	};
+} // namespace ntr
+
+#endif
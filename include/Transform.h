@@ -17,6 +17,18 @@ namespace ntr
 		glm::mat4 matrixRotation() const;
 		glm::mat4 matrixScale() const;
 	};
+
+	// Matrices of a Transform, cached so they are only rebuilt when it changes.
+	// Scene::updateTransforms() rebuilds the WorldMatrix component of the entities whose Transform component changed,
+	// which therefore has to be changed through registry.patch or registry.replace rather than a plain reference.
+	struct WorldMatrix
+	{
+		glm::mat4 model		= glm::mat4(1.0f);
+		glm::mat3 normal	= glm::mat3(1.0f); // inverse transpose of model
+
+		WorldMatrix() = default;
+		WorldMatrix(const Transform& transform);
+	};
 } // namespace ntr
 
 #endif
\ No newline at end of file
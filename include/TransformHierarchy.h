@@ -0,0 +1,86 @@
+#ifndef NTR_TRANSFORM_HIERARCHY_H
+#define NTR_TRANSFORM_HIERARCHY_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "Transform.h"
+#include "WorkerPool.h"
+
+namespace ntr
+{
+	// Parent of an entity in the transform hierarchy, whose Transform is then relative to the parent's world matrix.
+	// Set it with TransformHierarchy::setParent, which refuses cycles.
+	struct Parent
+	{
+		entt::entity entity = entt::null;
+	};
+
+	// Keeps the WorldMatrix component of every entity with a Transform up to date.
+	// The entities are flattened into one array sorted depth first, so every parent comes before its children and every
+	// subtree is a contiguous range. An update composes only the subtrees below changed transforms, in one forward pass
+	// per subtree over local transforms and parent worlds kept in arrays of the same order, and hands independent
+	// subtrees to the workers. The WorldMatrix storage is sorted into that order as well, so the results are written
+	// back to the registry in one pass in storage order.
+	class TransformHierarchy
+	{
+	public:
+
+		TransformHierarchy(entt::registry& registry);
+		TransformHierarchy(const TransformHierarchy& hierarchy) = delete;
+		TransformHierarchy& operator=(const TransformHierarchy& hierarchy) = delete;
+		~TransformHierarchy();
+
+		// entt::null detaches entity. Returns false if parent is entity or one of its descendants.
+		bool setParent(entt::entity entity, entt::entity parent);
+
+		// Returns entt::null for roots.
+		entt::entity getParent(entt::entity entity) const;
+
+		void update(WorkerPool& workers);
+
+		// Entities whose WorldMatrix was rebuilt by the last update, every entity after a structural change.
+		const std::vector<entt::entity>& getUpdatedEntities() const;
+
+	private:
+
+		static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+		// below this many nodes a subtree is composed on one worker
+		static constexpr uint32_t MIN_SPLIT_NODES = 1024;
+
+		struct Node
+		{
+			entt::entity	entity;
+			uint32_t		parent;			// index, NO_PARENT for roots
+			uint32_t		subtreeEnd;		// one past the last descendant
+		};
+
+		using Range = std::pair<uint32_t, uint32_t>;
+
+		entt::registry&							mRegistry;
+		std::vector<Node>						mNodes;
+		std::vector<Transform>					mLocals;		// same order as mNodes, copies of the Transform components
+		std::vector<WorldMatrix>				mWorlds;		// same order as mNodes
+		std::unordered_map<entt::entity, uint32_t>	mIndices;
+		std::vector<uint32_t>					mChanged;		// nodes whose Transform was patched since the last update
+		std::vector<Range>						mRanges;
+		std::vector<entt::entity>				mUpdated;
+		bool									mStructureChanged;
+
+		void onTransformChanged(entt::registry& registry, entt::entity entity);
+		void onStructureChanged(entt::registry& registry, entt::entity entity);
+
+		void rebuild();
+		void collectRanges();
+		void splitRanges(size_t targetCount);
+		void updateNodes(uint32_t begin, uint32_t end);
+		void writeWorlds(const std::vector<Range>& ranges);
+	};
+} // namespace ntr
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef NTR_TRIANGLE_BVH_H
+#define NTR_TRIANGLE_BVH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "Structs.h"
+#include "WorkerPool.h"
+
+namespace ntr
+{
+	// Indexed triangles, read in place. Positions may be interleaved with other vertex attributes.
+	struct TriangleMesh
+	{
+		const unsigned char*	positions		= nullptr;
+		size_t					stride			= sizeof(glm::vec3);
+		const uint32_t*			indices			= nullptr;	// 3 per triangle
+		size_t					triangleCount	= 0;
+
+		const glm::vec3& position(uint32_t index) const;
+	};
+
+	struct TriangleHit
+	{
+		uint32_t	triangle	= 0;
+		float		distance	= 0.0f;
+		float		u			= 0.0f;	// barycentric weight of the second vertex
+		float		v			= 0.0f;	// barycentric weight of the third vertex, the first weighs 1 - u - v
+	};
+
+	// Bounding volume hierarchy over the triangles of one mesh, for exact ray queries on the CPU.
+	// Built with a binned surface area heuristic: the top of the tree is split serially until there are enough subtrees
+	// to share, then every worker builds whole subtrees. Only triangle indices are stored, queries read the positions
+	// from the same TriangleMesh the tree was built from.
+	class TriangleBVH
+	{
+	public:
+
+		static constexpr size_t NODE_SIZE = 32;
+
+		// Every triangle on workers, or on the calling thread if null.
+		void build(const TriangleMesh& mesh, WorkerPool* workers);
+		void clear();
+
+		bool empty() const;
+		size_t nodeCount() const;
+		size_t bytes() const;
+
+		// The tree as stored, nodeCount() nodes of NODE_SIZE bytes and one index per triangle, to save it with the mesh.
+		const void* nodeData() const;
+		const std::vector<uint32_t>& triangles() const;
+
+		// Adopts a tree saved from nodeData() and triangles() of a TriangleBVH built over the same triangles.
+		// Returns false and stays empty if a node points outside of the tree or the triangles.
+		bool assign(const void* nodes, size_t nodeCount, const uint32_t* triangles, size_t triangleCount);
+
+		// Nearest triangle hit within maxDistance, culling neither side.
+		bool raycast(const TriangleMesh& mesh, const Ray& ray, float maxDistance, TriangleHit& hit) const;
+
+	private:
+
+		static constexpr uint32_t BIN_COUNT = 16;
+		static constexpr uint32_t MAX_LEAF_SIZE = 8;
+
+		// below this many triangles a subtree is built on one worker
+		static constexpr uint32_t MIN_PARALLEL_TRIANGLES = 4096;
+
+		// Children of an inner node are first and first + 1. Bounds and index share 16 bytes, so a box is two loads.
+		struct alignas(32) Node
+		{
+			float		min[3];
+			uint32_t	first;		// child or index into mTriangles
+			float		max[3];
+			uint32_t	count;		// triangles, 0 for inner nodes
+		};
+
+		static_assert(sizeof(Node) == NODE_SIZE, "TriangleBVH::Node must stay NODE_SIZE bytes");
+
+		std::vector<Node>		mNodes;
+		std::vector<uint32_t>	mTriangles;	// grouped by leaf
+
+		void buildSubtree(std::vector<Node>& nodes, const std::vector<AABB>& bounds, const std::vector<glm::vec3>& centroids);
+
+		// Returns false if the node stays a leaf, otherwise its children are appended to nodes.
+		bool splitNode(std::vector<Node>& nodes, uint32_t node, const std::vector<AABB>& bounds, const std::vector<glm::vec3>& centroids);
+	};
+} // namespace ntr
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef NTR_UNIFORM_BUFFER_H
+#define NTR_UNIFORM_BUFFER_H
+
+#include <glad/glad.h>
+
+namespace ntr
+{
+	// Stores a single struct inside a Uniform Buffer Object (UBO), T must match the std140 block layout.
+	template <typename T>
+	class UniformBuffer
+	{
+	public:
+
+		GLuint binding;
+
+		UniformBuffer(GLuint binding = 0);
+		UniformBuffer(const UniformBuffer& ub) = delete;
+		UniformBuffer& operator=(const UniformBuffer& ub) = delete;
+		~UniformBuffer();
+
+		void bind() const;
+		void update(const T& data);
+
+	private:
+
+		GLuint	mID;
+	};
+}
+
+#include "UniformBuffer.hpp"
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef NTR_WORKER_POOL_H
+#define NTR_WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ntr
+{
+	// Threads kept alive for per-frame parallel work, where starting threads each frame would cost more than the work.
+	// The calling thread takes part as worker 0.
+	class WorkerPool
+	{
+	public:
+
+		// 0 uses the hardware threads the main and render threads leave free, at least one.
+		WorkerPool(size_t workerCount = 0);
+		WorkerPool(const WorkerPool& pool) = delete;
+		WorkerPool& operator=(const WorkerPool& pool) = delete;
+		~WorkerPool();
+
+		// Workers including the calling thread.
+		size_t size() const;
+
+		// Splits [0, count) into contiguous ranges of at least minRange elements, at most one per worker, and runs
+		// task(range, begin, end) for each of them. Ranges are numbered in order, range 0 runs on the calling thread.
+		// Returns once every range is done, with the number of ranges used.
+		size_t parallelFor(size_t count, size_t minRange, const std::function<void(size_t range, size_t begin, size_t end)>& task);
+
+	private:
+
+		using Task = std::function<void(size_t, size_t, size_t)>;
+
+		std::vector<std::thread>	mThreads;
+		std::mutex					mMutex;
+		std::condition_variable		mWake;
+		std::condition_variable		mDone;
+		const Task*					mTask;
+		size_t						mCount;
+		size_t						mRanges;
+		size_t						mPending;
+		uint64_t					mGeneration;
+		bool						mStopping;
+
+		void loop(size_t worker);
+	};
+} // namespace ntr
+
+#endif
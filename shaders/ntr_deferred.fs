@@ -0,0 +1,345 @@
+#version 460 core
+out vec4 FragColor;
+in vec2 TexCoords;
+
+// Structs
+
+struct DirectionalLight
+{
+    vec3 direction;
+    vec3 color;
+};
+
+struct PointLight
+{
+    vec3 position;
+    float radius;
+    vec3 color;
+};
+
+// SSBO's
+
+layout (std430, binding = 0) buffer LightSpaceMatrices
+{
+    mat4 lightSpaceMatrices[];
+};
+
+layout (std430, binding = 1) buffer CasCadePlaneDistances
+{
+    float cascadePlaneDistances[];
+};
+
+layout (std430, binding = 2) readonly buffer PointLights
+{
+    PointLight pointLights[];
+};
+
+layout (std430, binding = 3) readonly buffer ClusterLightCounts
+{
+    uint clusterLightCounts[];
+};
+
+layout (std430, binding = 4) readonly buffer ClusterLightIndices
+{
+    uint clusterLightIndices[];
+};
+
+// Uniforms
+
+layout (std140, binding = 0) uniform FrameUniforms
+{
+    mat4  view;
+    mat4  projection;
+    mat4  inverseViewProjection;
+    vec3  cameraPosition;
+    float cameraFarPlane;
+    vec3  directionalLightDirection;
+    vec3  directionalLightColor;
+    vec2  clusterTileSize;
+    float clusterScale;
+    float clusterBias;
+};
+
+layout (binding = 0) uniform sampler2D gAlbedo;
+layout (binding = 1) uniform sampler2D gNormal;
+layout (binding = 2) uniform sampler2D gMaterial;
+layout (binding = 3) uniform sampler2D gDepth;
+
+#ifdef SHADOWS
+layout (binding = 5) uniform sampler2DArray shadowMap;
+#endif
+
+// Other
+
+const float PI = 3.14159265359;
+
+// must match LightClusters.h
+const uvec3 CLUSTER_GRID_SIZE = uvec3(16, 9, 24);
+const uint  MAX_LIGHTS_PER_CLUSTER = 128u;
+
+// Bayer Dithering Matrix (4x4)
+const float bayerMatrix[16] = float[](
+    0.0/16.0,  8.0/16.0,  2.0/16.0, 10.0/16.0,
+    12.0/16.0, 4.0/16.0, 14.0/16.0,  6.0/16.0,
+    3.0/16.0, 11.0/16.0,  1.0/16.0,  9.0/16.0,
+    15.0/16.0, 7.0/16.0, 13.0/16.0,  5.0/16.0
+);
+
+// ----------------------------------------------------------------------------
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+// ----------------------------------------------------------------------------
+float DistributionGGX(vec3 N, vec3 H, float roughness)
+{
+    float a = roughness*roughness;
+    float a2 = a*a;
+    float NdotH = max(dot(N, H), 0.0);
+    float NdotH2 = NdotH*NdotH;
+
+    float nom   = a2;
+    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
+    denom = PI * denom * denom;
+
+    return nom / denom;
+}
+// ----------------------------------------------------------------------------
+float GeometrySchlickGGX(float NdotV, float roughness)
+{
+    float r = (roughness + 1.0);
+    float k = (r*r) / 8.0;
+
+    float nom   = NdotV;
+    float denom = NdotV * (1.0 - k) + k;
+
+    return nom / denom;
+}
+// ----------------------------------------------------------------------------
+float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
+{
+    float NdotV = max(dot(N, V), 0.0);
+    float NdotL = max(dot(N, L), 0.0);
+    float ggx2 = GeometrySchlickGGX(NdotV, roughness);
+    float ggx1 = GeometrySchlickGGX(NdotL, roughness);
+
+    return ggx1 * ggx2;
+}
+// ----------------------------------------------------------------------------
+vec3 fresnelSchlick(float cosTheta, vec3 F0)
+{
+    return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
+// ----------------------------------------------------------------------------
+vec3 calculateDirectionalLight(DirectionalLight dirLight, vec3 N, vec3 V, vec3 F0, vec3 albedo, float metallic, float roughness)
+{
+    vec3 L = normalize(-dirLight.direction);
+    vec3 H = normalize(V + L);
+
+    // Cook-Torrance BRDF
+    float NDF = DistributionGGX(N, H, roughness);
+    float G = GeometrySmith(N, V, L, roughness);
+    vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
+
+    vec3 numerator = NDF * G * F;
+    float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001;
+    vec3 specular = numerator / denominator;
+
+    // Diffuse component
+    vec3 kS = F;
+    vec3 kD = vec3(1.0) - kS;
+    kD *= 1.0 - metallic;
+
+    float NdotL = max(dot(N, L), 0.0);
+    vec3 radiance = dirLight.color;
+
+    // Combine diffuse and specular
+    return (kD * albedo / PI + specular) * radiance * NdotL;
+}
+// ----------------------------------------------------------------------------
+vec3 calculatePointLight(PointLight pointLight, vec3 fragPosWorldSpace, vec3 N, vec3 V, vec3 F0, vec3 albedo, float metallic, float roughness)
+{
+    vec3 L = normalize(pointLight.position - fragPosWorldSpace);
+    vec3 H = normalize(V + L);
+    float distance = length(pointLight.position - fragPosWorldSpace);
+    // inverse square falloff, windowed to reach zero at the light radius used for clustering
+    float window = clamp(1.0 - pow(distance / pointLight.radius, 4.0), 0.0, 1.0);
+    float attenuation = (window * window) / max(distance * distance, 0.0001);
+    vec3 radiance = pointLight.color * attenuation;
+
+    // Cook-Torrance BRDF
+    float NDF = DistributionGGX(N, H, roughness);
+    float G = GeometrySmith(N, V, L, roughness);
+    vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
+
+    vec3 numerator = NDF * G * F;
+    float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001;
+    vec3 specular = numerator / denominator;
+
+    // Diffuse component
+    vec3 kS = F;
+    vec3 kD = vec3(1.0) - kS;
+    kD *= 1.0 - metallic;
+
+    float NdotL = max(dot(N, L), 0.0);
+
+    // Combine diffuse and specular
+    return (kD * albedo / PI + specular) * radiance * NdotL;
+}
+// ----------------------------------------------------------------------------
+#ifdef SHADOWS
+float calculateShadow(DirectionalLight dirLight, vec3 fragPosWorldSpace, vec3 geometryNormal)
+{
+    // Select cascade layer
+    vec4 fragPosViewSpace = view * vec4(fragPosWorldSpace, 1.0);
+    float depthValue = abs(fragPosViewSpace.z);
+
+    int layer = -1;
+    for (int i = 0; i < CASCADE_COUNT; ++i)
+    {
+        if (depthValue < cascadePlaneDistances[i])
+        {
+            layer = i;
+            break;
+        }
+    }
+    // Beyond the last cascade? No shadow.
+    if (layer == -1)
+    {
+        return 0.0;
+    }
+
+    // Apply normal offset to reduce peter panning
+    vec3 normal = geometryNormal;
+    float normalOffsetScale = 0.02; // Adjust based on scene scale
+    vec3 offsetPos = fragPosWorldSpace + normal * normalOffsetScale;
+
+    // Transform to light space
+    vec4 fragPosLightSpace = lightSpaceMatrices[layer] * vec4(offsetPos, 1.0);
+    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+    projCoords = projCoords * 0.5 + 0.5;
+
+    // Clamp to avoid edge artifacts
+    projCoords.xy = clamp(projCoords.xy, 0.0, 1.0);
+    if (projCoords.z > 1.0)
+    {
+        return 0.0;
+    }
+
+    // Calculate bias (slope-scaled + cascade-aware)
+    float bias = max(0.005 * (1.0 - dot(normal, -dirLight.direction)), 0.001);
+    bias *= cascadePlaneDistances[layer] / cameraFarPlane; // Scale bias with cascade
+
+    // PCF Soft Shadows
+    float shadow = 0.0;
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    for (int x = -1; x <= 1; ++x)
+    {
+        for (int y = -1; y <= 1; ++y)
+        {
+            float pcfDepth = texture(shadowMap, vec3(projCoords.xy + vec2(x, y) * texelSize, layer)).r;
+            shadow += (projCoords.z - bias) > pcfDepth ? 1.0 : 0.0;
+        }
+    }
+    shadow /= 9.0;
+
+    return shadow;
+}
+#endif
+// ----------------------------------------------------------------------------
+// Returns the index of the light cluster containing the fragment (see ntr_light_clusters.cs).
+uint getClusterIndex(vec3 fragPosWorldSpace)
+{
+    float depth = -(view * vec4(fragPosWorldSpace, 1.0)).z;
+
+    uint slice = uint(max(log(depth) * clusterScale + clusterBias, 0.0));
+    uvec2 tile = uvec2(gl_FragCoord.xy / clusterTileSize);
+
+    slice = min(slice, CLUSTER_GRID_SIZE.z - 1u);
+    tile = min(tile, CLUSTER_GRID_SIZE.xy - uvec2(1));
+
+    return tile.x + tile.y * CLUSTER_GRID_SIZE.x + slice * CLUSTER_GRID_SIZE.x * CLUSTER_GRID_SIZE.y;
+}
+// ----------------------------------------------------------------------------
+vec3 applyDithering(vec3 color, ivec2 pixelCoords)
+{
+    int index = (pixelCoords.y % 4) * 4 + (pixelCoords.x % 4);
+    float ditherValue = bayerMatrix[index];
+    return color + vec3(ditherValue) / 256.0;
+}
+// ----------------------------------------------------------------------------
+
+void main()
+{
+    ivec2 pixelCoords = ivec2(gl_FragCoord.xy);
+
+    float depth = texelFetch(gDepth, pixelCoords, 0).r;
+
+    // Nothing was drawn here, keep the clear color
+    if (depth == 1.0)
+    {
+        discard;
+    }
+
+    // Reconstruct world position from depth
+    vec4 clipPos = vec4(TexCoords * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec4 worldPos = inverseViewProjection * clipPos;
+    vec3 WorldPos = worldPos.xyz / worldPos.w;
+
+    vec4 packedNormals  = texelFetch(gNormal, pixelCoords, 0);
+    vec4 packedMaterial = texelFetch(gMaterial, pixelCoords, 0);
+
+    vec3 albedo     = pow(texelFetch(gAlbedo, pixelCoords, 0).rgb, vec3(2.2));
+    float roughness = packedMaterial.r;
+    float metallic  = packedMaterial.g;
+    float ao        = packedMaterial.b;
+
+    vec3 N = decodeOctahedral(packedNormals.xy);
+    vec3 geometryNormal = decodeOctahedral(packedNormals.zw);
+    vec3 V = normalize(cameraPosition - WorldPos);
+
+    // calculate reflectance at normal incidence; if dia-electric (like plastic) use F0 
+    // of 0.04 and if it's a metal, use the albedo color as F0 (metallic workflow)    
+    vec3 F0 = vec3(0.04); 
+    F0 = mix(F0, albedo, metallic);
+
+    // reflectance equation
+    vec3 Lo = vec3(0.0);
+
+    DirectionalLight directionalLight = DirectionalLight(directionalLightDirection, directionalLightColor);
+
+#ifdef SHADOWS
+    float shadow = calculateShadow(directionalLight, WorldPos, geometryNormal);
+#else
+    float shadow = 0.0;
+#endif
+
+    Lo += (calculateDirectionalLight(directionalLight, N, V, F0, albedo, metallic, roughness) * (1.0 - shadow));
+
+    // point lights overlapping this pixel's cluster
+    uint clusterIndex = getClusterIndex(WorldPos);
+    uint clusterLightCount = clusterLightCounts[clusterIndex];
+
+    for (uint i = 0u; i < clusterLightCount; ++i)
+    {
+        uint lightIndex = clusterLightIndices[clusterIndex * MAX_LIGHTS_PER_CLUSTER + i];
+        Lo += calculatePointLight(pointLights[lightIndex], WorldPos, N, V, F0, albedo, metallic, roughness);
+    }
+
+    vec3 ambient = albedo * ao * 0.15;
+
+    vec3 color = ambient + Lo;
+
+    // HDR tonemapping
+    color = color / (color + vec3(1.0));
+    // gamma correct
+    color = pow(color, vec3(1.0/2.2));
+    // dithering
+    color = applyDithering(color, pixelCoords);
+
+    FragColor = vec4(color, 1.0);
+}
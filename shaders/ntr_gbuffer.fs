@@ -0,0 +1,112 @@
+#version 460 core
+layout (location = 0) out vec4 gAlbedo;
+layout (location = 1) out vec4 gNormal;
+layout (location = 2) out vec4 gMaterial;
+
+in vec2 TexCoords;
+in vec3 WorldPos;
+in vec3 Normal;
+in vec3 FragPos;
+
+// Buffers
+
+struct MaterialFactors
+{
+    vec4  baseColor; // sRGB
+    float roughness;
+    float metallic;
+    float occlusionStrength;
+    float normalScale;
+};
+
+layout (std430, binding = 5) readonly buffer Materials
+{
+    MaterialFactors materials[];
+};
+
+// Uniforms
+
+uniform int materialIndex;
+
+// Material maps only exist in variants compiled with the matching feature define
+
+#ifdef ALBEDO_MAP
+layout (binding = 0) uniform sampler2D albedoMap;
+#endif
+#ifdef NORMAL_MAP
+layout (binding = 1) uniform sampler2D normalMap;
+#endif
+#ifdef ROUGHNESS_MAP
+layout (binding = 2) uniform sampler2D roughnessMap;
+#endif
+#ifdef METALLIC_MAP
+layout (binding = 3) uniform sampler2D metallicMap;
+#endif
+#ifdef OCCLUSION_MAP
+layout (binding = 4) uniform sampler2D occlusionMap;
+#endif
+
+// ----------------------------------------------------------------------------
+// Same derivative-based TBN as ntr_pbr.fs so both render paths shade identical normals.
+vec3 getNormal()
+{
+#ifndef NORMAL_MAP
+    return normalize(Normal);
+#else
+    // BC5 normal maps only store xy, so z is always rebuilt
+    vec3 tangentNormal;
+    tangentNormal.xy = (texture(normalMap, TexCoords).xy * 2.0 - 1.0) * materials[materialIndex].normalScale;
+    tangentNormal.z  = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
+
+    vec3 Q1  = dFdx(WorldPos);
+    vec3 Q2  = dFdy(WorldPos);
+    vec2 st1 = dFdx(TexCoords);
+    vec2 st2 = dFdy(TexCoords);
+
+    vec3 N   = normalize(Normal);
+    vec3 T  = normalize(Q1*st2.t - Q2*st1.t);
+    vec3 B  = -normalize(cross(N, T));
+    mat3 TBN = mat3(T, B, N);
+
+    return normalize(TBN * tangentNormal);
+#endif
+}
+// ----------------------------------------------------------------------------
+// Octahedral mapping of a unit vector to [-1, 1]^2
+vec2 encodeOctahedral(vec3 n)
+{
+    n /= (abs(n.x) + abs(n.y) + abs(n.z));
+    vec2 wrapped = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return n.z >= 0.0 ? n.xy : wrapped;
+}
+// ----------------------------------------------------------------------------
+
+void main()
+{
+    MaterialFactors material = materials[materialIndex];
+
+#ifdef ALBEDO_MAP
+    vec3 albedo     = texture(albedoMap, TexCoords).rgb * material.baseColor.rgb;
+#else
+    vec3 albedo     = material.baseColor.rgb;
+#endif
+#ifdef ROUGHNESS_MAP
+    float roughness = texture(roughnessMap, TexCoords).r * material.roughness;
+#else
+    float roughness = material.roughness;
+#endif
+#ifdef METALLIC_MAP
+    float metallic  = texture(metallicMap, TexCoords).r * material.metallic;
+#else
+    float metallic  = material.metallic;
+#endif
+#ifdef OCCLUSION_MAP
+    float ao        = mix(1.0, texture(occlusionMap, TexCoords).r, material.occlusionStrength);
+#else
+    float ao        = 1.0;
+#endif
+
+    gAlbedo     = vec4(albedo, 1.0);
+    gNormal     = vec4(encodeOctahedral(getNormal()), encodeOctahedral(normalize(Normal)));
+    gMaterial   = vec4(roughness, metallic, ao, 1.0);
+}
@@ -0,0 +1,130 @@
+#version 460 core
+
+// One invocation per cluster, a work group covers 4 depth slices of the 16x9 tile grid.
+layout (local_size_x = 16, local_size_y = 9, local_size_z = 4) in;
+
+// Structs
+
+struct PointLight
+{
+    vec3 position;
+    float radius;
+    vec3 color;
+};
+
+// SSBO's
+
+layout (std430, binding = 2) readonly buffer PointLights
+{
+    PointLight pointLights[];
+};
+
+layout (std430, binding = 3) writeonly buffer ClusterLightCounts
+{
+    uint clusterLightCounts[];
+};
+
+layout (std430, binding = 4) writeonly buffer ClusterLightIndices
+{
+    uint clusterLightIndices[];
+};
+
+// Uniforms
+
+uniform mat4  view;
+uniform mat4  inverseProjection;
+uniform float zNear;
+uniform float zFar;
+uniform int   lightCount;
+
+// Other
+
+// must match LightClusters.h
+const uvec3 GRID_SIZE = uvec3(16, 9, 24);
+const uint  MAX_LIGHTS_PER_CLUSTER = 128u;
+
+const uint  GROUP_SIZE = 16u * 9u * 4u;
+
+// view-space position and radius of the lights of the current batch
+shared vec4 sharedLights[GROUP_SIZE];
+
+// ----------------------------------------------------------------------------
+// Returns the view-space point on the near plane behind an NDC xy coordinate.
+vec3 ndcToView(vec2 ndc)
+{
+    vec4 position = inverseProjection * vec4(ndc, -1.0, 1.0);
+    return position.xyz / position.w;
+}
+// ----------------------------------------------------------------------------
+// Returns the point along the eye ray through p at view-space depth (distance along -z).
+vec3 atDepth(vec3 p, float depth)
+{
+    return p * (depth / -p.z);
+}
+// ----------------------------------------------------------------------------
+bool sphereIntersectsAABB(vec3 center, float radius, vec3 aabbMin, vec3 aabbMax)
+{
+    vec3 closest = clamp(center, aabbMin, aabbMax);
+    vec3 d = center - closest;
+    return dot(d, d) <= radius * radius;
+}
+// ----------------------------------------------------------------------------
+
+void main()
+{
+    uvec3 cluster = gl_GlobalInvocationID;
+    uint clusterIndex = cluster.x + cluster.y * GRID_SIZE.x + cluster.z * GRID_SIZE.x * GRID_SIZE.y;
+
+    // exponential depth slices so clusters stay roughly cubic in view space
+    float sliceNear = zNear * pow(zFar / zNear, float(cluster.z)     / float(GRID_SIZE.z));
+    float sliceFar  = zNear * pow(zFar / zNear, float(cluster.z + 1) / float(GRID_SIZE.z));
+
+    vec2 tileMin = vec2(cluster.xy)            / vec2(GRID_SIZE.xy) * 2.0 - 1.0;
+    vec2 tileMax = vec2(cluster.xy + uvec2(1)) / vec2(GRID_SIZE.xy) * 2.0 - 1.0;
+
+    vec3 viewMin = ndcToView(tileMin);
+    vec3 viewMax = ndcToView(tileMax);
+
+    vec3 minNear = atDepth(viewMin, sliceNear);
+    vec3 maxNear = atDepth(viewMax, sliceNear);
+    vec3 minFar  = atDepth(viewMin, sliceFar);
+    vec3 maxFar  = atDepth(viewMax, sliceFar);
+
+    vec3 aabbMin = min(min(minNear, maxNear), min(minFar, maxFar));
+    vec3 aabbMax = max(max(minNear, maxNear), max(minFar, maxFar));
+
+    // lights are transformed to view space once per batch and shared by the whole work group
+
+    uint count = 0;
+    uint baseOutput = clusterIndex * MAX_LIGHTS_PER_CLUSTER;
+
+    for (uint batchStart = 0; batchStart < uint(lightCount); batchStart += GROUP_SIZE)
+    {
+        uint lightIndex = batchStart + gl_LocalInvocationIndex;
+
+        if (lightIndex < uint(lightCount))
+        {
+            PointLight light = pointLights[lightIndex];
+            sharedLights[gl_LocalInvocationIndex] = vec4((view * vec4(light.position, 1.0)).xyz, light.radius);
+        }
+
+        barrier();
+
+        uint batchCount = min(GROUP_SIZE, uint(lightCount) - batchStart);
+
+        for (uint i = 0; i < batchCount && count < MAX_LIGHTS_PER_CLUSTER; ++i)
+        {
+            vec4 light = sharedLights[i];
+
+            if (sphereIntersectsAABB(light.xyz, light.w, aabbMin, aabbMax))
+            {
+                clusterLightIndices[baseOutput + count] = batchStart + i;
+                ++count;
+            }
+        }
+
+        barrier();
+    }
+
+    clusterLightCounts[clusterIndex] = count;
+}
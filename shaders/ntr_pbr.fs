@@ -7,15 +7,6 @@ in vec3 FragPos;
 
 // Structs
 
-struct Material
-{
-    sampler2D albedo;
-    sampler2D normal;
-    sampler2D roughness;
-    sampler2D metallic;
-    sampler2D occlusion;
-};
-
 struct DirectionalLight
 {
     vec3 direction;
@@ -25,6 +16,7 @@ struct DirectionalLight
 struct PointLight
 {
     vec3 position;
+    float radius;
     vec3 color;
 };
 
@@ -40,24 +32,83 @@ layout (std430, binding = 1) buffer CasCadePlaneDistances
     float cascadePlaneDistances[];
 };
 
-// Uniforms
+layout (std430, binding = 2) readonly buffer PointLights
+{
+    PointLight pointLights[];
+};
+
+layout (std430, binding = 3) readonly buffer ClusterLightCounts
+{
+    uint clusterLightCounts[];
+};
+
+layout (std430, binding = 4) readonly buffer ClusterLightIndices
+{
+    uint clusterLightIndices[];
+};
+
+struct MaterialFactors
+{
+    vec4  baseColor; // sRGB
+    float roughness;
+    float metallic;
+    float occlusionStrength;
+    float normalScale;
+};
+
+layout (std430, binding = 5) readonly buffer Materials
+{
+    MaterialFactors materials[];
+};
 
-uniform Material            material;
-uniform DirectionalLight    directionalLight;
-uniform vec3                cameraPosition;
-uniform float               cameraFarPlane;
-uniform mat4                view;
+// Uniforms
 
-uniform samplerCube irradianceMap;
-uniform samplerCube prefilterMap;
-uniform sampler2D   brdflUT;
+layout (std140, binding = 0) uniform FrameUniforms
+{
+    mat4  view;
+    mat4  projection;
+    mat4  inverseViewProjection;
+    vec3  cameraPosition;
+    float cameraFarPlane;
+    vec3  directionalLightDirection;
+    vec3  directionalLightColor;
+    vec2  clusterTileSize;
+    float clusterScale;
+    float clusterBias;
+};
 
-uniform sampler2DArray shadowMap;
+uniform int materialIndex;
+
+// Material maps only exist in variants compiled with the matching feature define
+
+#ifdef ALBEDO_MAP
+layout (binding = 0) uniform sampler2D albedoMap;
+#endif
+#ifdef NORMAL_MAP
+layout (binding = 1) uniform sampler2D normalMap;
+#endif
+#ifdef ROUGHNESS_MAP
+layout (binding = 2) uniform sampler2D roughnessMap;
+#endif
+#ifdef METALLIC_MAP
+layout (binding = 3) uniform sampler2D metallicMap;
+#endif
+#ifdef OCCLUSION_MAP
+layout (binding = 4) uniform sampler2D occlusionMap;
+#endif
+
+#ifdef SHADOWS
+layout (binding = 5) uniform sampler2DArray shadowMap;
+#endif
 
 // Other
 
 const float PI = 3.14159265359;
 
+// must match LightClusters.h
+const uvec3 CLUSTER_GRID_SIZE = uvec3(16, 9, 24);
+const uint  MAX_LIGHTS_PER_CLUSTER = 128u;
+
 // Bayer Dithering Matrix (4x4)
 const float bayerMatrix[16] = float[](
     0.0/16.0,  8.0/16.0,  2.0/16.0, 10.0/16.0,
@@ -80,9 +131,16 @@ vec3 gridSamplingDisk[20] = vec3[](
 // Don't worry if you don't get what's going on; you generally want to do normal 
 // mapping the usual way for performance anyways; I do plan make a note of this 
 // technique somewhere later in the normal mapping tutorial.
-vec3 getNormalFromMap()
+vec3 getNormal()
 {
-    vec3 tangentNormal = texture(material.normal, TexCoords).xyz * 2.0 - 1.0;
+#ifndef NORMAL_MAP
+    // flat default normal map, skip the derivative TBN
+    return normalize(Normal);
+#else
+    // BC5 normal maps only store xy, so z is always rebuilt
+    vec3 tangentNormal;
+    tangentNormal.xy = (texture(normalMap, TexCoords).xy * 2.0 - 1.0) * materials[materialIndex].normalScale;
+    tangentNormal.z  = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
 
     vec3 Q1  = dFdx(WorldPos);
     vec3 Q2  = dFdy(WorldPos);
@@ -95,6 +153,7 @@ vec3 getNormalFromMap()
     mat3 TBN = mat3(T, B, N);
 
     return normalize(TBN * tangentNormal);
+#endif
 }
 // ----------------------------------------------------------------------------
 float DistributionGGX(vec3 N, vec3 H, float roughness)
@@ -169,7 +228,9 @@ vec3 calculatePointLight(PointLight pointLight, vec3 N, vec3 V, vec3 F0, vec3 al
         vec3 L = normalize(pointLight.position - WorldPos);
         vec3 H = normalize(V + L);
         float distance = length(pointLight.position - WorldPos);
-        float attenuation = 1.0 / (distance * distance);
+        // inverse square falloff, windowed to reach zero at the light radius used for clustering
+        float window = clamp(1.0 - pow(distance / pointLight.radius, 4.0), 0.0, 1.0);
+        float attenuation = (window * window) / max(distance * distance, 0.0001);
         vec3 radiance = pointLight.color * attenuation;
 
         // Cook-Torrance BRDF
@@ -199,6 +260,7 @@ vec3 calculatePointLight(PointLight pointLight, vec3 N, vec3 V, vec3 F0, vec3 al
         return (kD * albedo / PI + specular) * radiance * NdotL;  // note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
 }
 // ----------------------------------------------------------------------------
+#ifdef SHADOWS
 float calculateShadow(DirectionalLight dirLight, vec3 fragPosWorldSpace)
 {
     // Select cascade layer
@@ -206,8 +268,7 @@ float calculateShadow(DirectionalLight dirLight, vec3 fragPosWorldSpace)
     float depthValue = abs(fragPosViewSpace.z);
 
     int layer = -1;
-    int cascadeCount = cascadePlaneDistances.length();
-    for (int i = 0; i < cascadeCount; ++i)
+    for (int i = 0; i < CASCADE_COUNT; ++i)
     {
         if (depthValue < cascadePlaneDistances[i])
         {
@@ -257,6 +318,21 @@ float calculateShadow(DirectionalLight dirLight, vec3 fragPosWorldSpace)
 
     return shadow;
 }
+#endif
+// ----------------------------------------------------------------------------
+// Returns the index of the light cluster containing the fragment (see ntr_light_clusters.cs).
+uint getClusterIndex(vec3 fragPosWorldSpace)
+{
+    float depth = -(view * vec4(fragPosWorldSpace, 1.0)).z;
+
+    uint slice = uint(max(log(depth) * clusterScale + clusterBias, 0.0));
+    uvec2 tile = uvec2(gl_FragCoord.xy / clusterTileSize);
+
+    slice = min(slice, CLUSTER_GRID_SIZE.z - 1u);
+    tile = min(tile, CLUSTER_GRID_SIZE.xy - uvec2(1));
+
+    return tile.x + tile.y * CLUSTER_GRID_SIZE.x + slice * CLUSTER_GRID_SIZE.x * CLUSTER_GRID_SIZE.y;
+}
 // ----------------------------------------------------------------------------
 vec3 applyDithering(vec3 color, ivec2 pixelCoords)
 {
@@ -268,12 +344,32 @@ vec3 applyDithering(vec3 color, ivec2 pixelCoords)
 
 void main()
 {
-    vec3 albedo     = pow(texture(material.albedo, TexCoords).rgb, vec3(2.2));
-    float metallic  = texture(material.metallic, TexCoords).r;
-    float roughness = texture(material.roughness, TexCoords).r;
-    float ao        = texture(material.occlusion, TexCoords).r;
-
-    vec3 N = getNormalFromMap();
+    MaterialFactors material = materials[materialIndex];
+
+#ifdef ALBEDO_MAP
+    vec3 albedo     = pow(texture(albedoMap, TexCoords).rgb * material.baseColor.rgb, vec3(2.2));
+#else
+    vec3 albedo     = pow(material.baseColor.rgb, vec3(2.2));
+#endif
+#ifdef ROUGHNESS_MAP
+    float roughness = texture(roughnessMap, TexCoords).r * material.roughness;
+#else
+    float roughness = material.roughness;
+#endif
+#ifdef METALLIC_MAP
+    float metallic  = texture(metallicMap, TexCoords).r * material.metallic;
+#else
+    float metallic  = material.metallic;
+#endif
+#ifdef OCCLUSION_MAP
+    float ao        = mix(1.0, texture(occlusionMap, TexCoords).r, material.occlusionStrength);
+#else
+    float ao        = 1.0;
+#endif
+
+    DirectionalLight directionalLight = DirectionalLight(directionalLightDirection, directionalLightColor);
+
+    vec3 N = getNormal();
     vec3 V = normalize(cameraPosition - WorldPos);
     vec3 R = reflect(-V, N);
 
@@ -285,10 +381,24 @@ void main()
     // reflectance equation
     vec3 Lo = vec3(0.0);
 
+#ifdef SHADOWS
     float shadow = calculateShadow(directionalLight, FragPos);
+#else
+    float shadow = 0.0;
+#endif
     
     //Lo += calculateDirectionalLight(directionalLight, N, V, F0, albedo, metallic, roughness);
     Lo += (calculateDirectionalLight(directionalLight, N, V, F0, albedo, metallic, roughness) * (1.0 - shadow));
+
+    // point lights overlapping this fragment's cluster
+    uint clusterIndex = getClusterIndex(WorldPos);
+    uint clusterLightCount = clusterLightCounts[clusterIndex];
+
+    for (uint i = 0u; i < clusterLightCount; ++i)
+    {
+        uint lightIndex = clusterLightIndices[clusterIndex * MAX_LIGHTS_PER_CLUSTER + i];
+        Lo += calculatePointLight(pointLights[lightIndex], N, V, F0, albedo, metallic, roughness);
+    }
     
     // ambient lighting (note that the next IBL tutorial will replace 
     // this ambient lighting with environment lighting).
@@ -7,30 +7,35 @@ layout (location = 4) in vec3   aBitangent;
 layout (location = 5) in ivec4  aBoneIDs;
 layout (location = 6) in vec4   aWeights;
 
-layout (location = 7) in mat4   aModel;
-
 out vec2 TexCoords;
 out vec3 WorldPos;
 out vec3 Normal;
 out vec3 FragPos;
 
-uniform mat4 projection;
-uniform mat4 view;
+layout (std140, binding = 0) uniform FrameUniforms
+{
+    mat4  view;
+    mat4  projection;
+    mat4  inverseViewProjection;
+    vec3  cameraPosition;
+    float cameraFarPlane;
+    vec3  directionalLightDirection;
+    vec3  directionalLightColor;
+    vec2  clusterTileSize;
+    float clusterScale;
+    float clusterBias;
+};
+
 uniform mat4 model;
 uniform mat3 normal;
 
-uniform bool instancing = false;
-
 void main()
 {
-    mat4 effectiveModel = instancing ? aModel : model;
-
     TexCoords   = aTexCoords;
-    WorldPos    = vec3(effectiveModel * vec4(aPos, 1.0));
-    //Normal      = transpose(inverse(mat3(effectiveModel))) * aNormal;
-    Normal = normal * aNormal;
+    WorldPos    = vec3(model * vec4(aPos, 1.0));
+    Normal      = normal * aNormal;
 
-    FragPos     = vec3(effectiveModel * vec4(aPos, 1.0));
+    FragPos     = vec3(model * vec4(aPos, 1.0));
 
     gl_Position =  projection * view * vec4(WorldPos, 1.0);
 }
\ No newline at end of file
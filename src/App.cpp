@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <memory>
 #include <random>
 
 #include "App.h"
@@ -10,13 +13,21 @@
 
 namespace ntr
 {
-	App::App()
-		: mWindow{ createWindow() }
+	App::App(Benchmark* benchmark, const std::filesystem::path& scenePath)
+		: mBenchmark{ benchmark }
+		, mScenePath{ scenePath }
+		, mWindow{ createWindow() }
 		, mShaderPBR{ "shaders/ntr_pbr.vs", "shaders/ntr_pbr.fs" }
+		, mShaderGBuffer{ "shaders/ntr_pbr.vs", "shaders/ntr_gbuffer.fs" }
+		, mShaderDeferred{ "shaders/ntr_fullscreen.vs", "shaders/ntr_deferred.fs" }
 		, mShaderDepth{ "shaders/ntr_shadows_depth.vs", "shaders/ntr_shadows_depth.fs", "shaders/ntr_shadows_depth.gs" }
 		, mShaderStencil{ "shaders/ntr_stencil.vs", "shaders/ntr_stencil.fs" }
 		, mDebugShaderShadows{ "shaders/ntr_debug_quad.vs", "shaders/ntr_debug_quad.fs" }
 		, mScene{}
+		, mRenderThread{}
+		, mWorkers{}
+		, mSnapshots{}
+		, mFrameResults{}
 		, mShadowCascadeLevels{
 			mScene.selectedCamera.zFar / 50.0f,
 			mScene.selectedCamera.zFar / 25.0f,
@@ -24,12 +35,40 @@ namespace ntr
 			mScene.selectedCamera.zFar / 2.0f
 		}
 		, mLightDepthMaps{ M_SHADOW_RESOLUTION, mShadowCascadeLevels.size() + 1 }
+		, mGBuffer{ M_RESOLUTION_WIDTH, M_RESOLUTION_HEIGHT }
+		, mLightClusters{}
+		, mTextureStreamer{}
+		, mTextureBudgetBytes{ mTextureStreamer.budgetBytes }
+		, mFrameUniforms{ 0 }
+		, mMaterials{ 64, nullptr, 5 }
+		, mLightMatrices{ 16, nullptr, 0 }
+		, mCascadePlaneDistances{ 16, nullptr, 1 }
+		, mFramePacer{}
+		, mAverageFrameTimeMs{ 0.0f, 0.0f }
+		, mGpuProfiler{}
+		, mGpuProfilerEnabled{ true }
+		, mProfilerOpen{ false }
+		, mStressOpen{ false }
+		, mStressSweep{}
+		, mPickedEntity{ entt::null }
+		, mPickRequested{ false }
 	{
+		Gui::init(mWindow);
+
+		if (mBenchmark)
+		{
+			return;
+		}
+
 		M_VSYNC_ENABLED ? glfwSwapInterval(1) : glfwSwapInterval(0);
 
+		const GLFWvidmode* videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+
+		mFramePacer.setTargetRate(M_TARGET_FPS);
+		mFramePacer.setVsync(M_VSYNC_ENABLED, videoMode ? videoMode->refreshRate : 0.0);
+
 		centerWindowToScreen();
 		glfwShowWindow(mWindow);
-		Gui::init(mWindow);
 	}
 
 	App::~App()
@@ -41,177 +80,338 @@ namespace ntr
 
 	void App::run()
 	{
+		NTR_PROFILE_THREAD("Main");
+
 		// configure Light FBO
 
-		mLightFBO.bind();
-		glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mLightDepthMaps.id(), 0);
-		glDrawBuffer(GL_NONE);
-		glReadBuffer(GL_NONE);
+		glNamedFramebufferTexture(mLightFBO.id(), GL_DEPTH_ATTACHMENT, mLightDepthMaps.id(), 0);
+		glNamedFramebufferDrawBuffer(mLightFBO.id(), GL_NONE);
+		glNamedFramebufferReadBuffer(mLightFBO.id(), GL_NONE);
 
-		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		if (glCheckNamedFramebufferStatus(mLightFBO.id(), GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 		{
 			std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!";
 			throw 0;
 		}
 
-		mLightFBO.unbind();
-
-		// Configure SSBO
+		// shaders compile in the background while assets load
 
-		ArrayBuffer<glm::mat4> ssboLightMatrices(16, nullptr, 0, GL_DYNAMIC_DRAW);
-		ArrayBuffer<float> ssboCascadePlaneDistances(16, nullptr, 1, GL_DYNAMIC_COPY);
+		prepareShaders();
 
 		// assets
 
-		const Model* modelPlane = mScene.loadModel("Plane", "models/plane/Plane.fbx");
-		const Model* modelCube = mScene.loadModel("Cube", "models/cube/Cube.fbx");
+		if (mBenchmark)
+		{
+			if (!loadBenchmarkScene())
+			{
+				std::cerr << "ERROR: benchmark aborted, no results written" << std::endl;
+				return;
+			}
+		}
+		else if (mScenePath.empty() || !SceneFile::load(mScenePath, mScene))
+		{
+			ModelHandle modelPlane = mScene.loadModel("Plane", "models/plane/Plane.fbx", &mWorkers);
+			ModelHandle modelCube = mScene.loadModel("Cube", "models/cube/Cube.fbx", &mWorkers);
 
-		// entities with model components
+			// entities with model components
 
-		Transform transformPlane;
-		transformPlane.scale = { 16.0f, 1.0f, 16.0f };
+			Transform transformPlane;
+			transformPlane.scale = { 16.0f, 1.0f, 16.0f };
 
-		Transform transformCube;
-		transformCube.position = { 0.0f, 1.0f, 0.0f };
+			Transform transformCube;
+			transformCube.position = { 0.0f, 1.0f, 0.0f };
 
-		entt::entity entityPlane = addEntityModel3D("entity_plane_1", modelPlane, transformPlane);
-		entt::entity entityCube = addEntityModel3D("entity_cube_1", modelCube, transformCube);
+			addEntityModel3D("entity_plane_1", modelPlane, transformPlane);
+			addEntityModel3D("entity_cube_1", modelCube, transformCube);
+
+			mScene.selectedCamera.position = { 16.0f, 8.0f, 16.0f };
+			mScene.selectedCamera.rotation = { -23.0f, -135.0f, 0.0f };
+		}
 
 		Rect framebuffer = getWindowFramebufferRect();
 		mScene.selectedCamera.viewport = { 0.0f, 0.0f, framebuffer.width, framebuffer.height };
-		mScene.selectedCamera.position = { 16.0f, 8.0f, 16.0f };
-		mScene.selectedCamera.rotation = { -23.0f, -135.0f, 0.0f };
+
+		// headless runs have no window surface, everything drawn to framebuffer 0 lands in an offscreen target instead
+
+		std::unique_ptr<RenderTarget> offscreenTarget;
+
+		if (mBenchmark)
+		{
+			offscreenTarget = std::make_unique<RenderTarget>((GLsizei)framebuffer.width, (GLsizei)framebuffer.height);
+			GLState::setDefaultFramebuffer(offscreenTarget->id());
+			GLState::bindFramebuffer(0);
+		}
 
 		// shader config
 
-		mShaderPBR.setInt("shadowMap", 5);
 		mDebugShaderShadows.setInt("depthMap", 0);
 
-		// time logic
+		// from here on the render thread owns the GL context, the main thread only borrows it through ContextLock
 
-		const float TARGET_FRAME_TIME_SECONDS = 1.0f / M_TARGET_FPS;
+		mRenderThread.start(mWindow, [this](size_t slot) { renderFrame(mSnapshots[slot]); });
 
 		// render loop
 		
-		while (!glfwWindowShouldClose(mWindow))
+		while (!glfwWindowShouldClose(mWindow) && !(mBenchmark && mBenchmark->finished()))
 		{
-			float deltaTimeSeconds = getDeltaTimeSeconds();
+			NTR_PROFILE_FRAME();
+
+			float deltaTimeSeconds = 0.0f;
 
-			while (M_TARGET_FPS != 0 && deltaTimeSeconds < TARGET_FRAME_TIME_SECONDS)
 			{
-				deltaTimeSeconds += getDeltaTimeSeconds();
+				NTR_PROFILE_SCOPE("Frame pacing");
+
+				// frame times are short enough for a float, only the clock behind them needs the precision
+				deltaTimeSeconds = (float)mFramePacer.wait();
 			}
 
-			glfwPollEvents();
+			{
+				NTR_PROFILE_SCOPE("Poll events");
+				glfwPollEvents();
+			}
+
+			processProfilerCapture();
 
 			if (isWindowMinimized())
 			{
 				continue;
 			}
 
-			processViewerMovement(deltaTimeSeconds);
-			processViewerRotation();
+			// the slot comes back with the results of the frame rendered in it before
 
-			mShadowCascadeLevels = {
-				mScene.selectedCamera.zFar / 32.0f,
-				mScene.selectedCamera.zFar / 16.0f,
-				mScene.selectedCamera.zFar / 8.0f,
-				mScene.selectedCamera.zFar / 4.0f,
-				mScene.selectedCamera.zFar / 2.0f
-			};
+			size_t slot = 0;
 
-			// 0. SSBO setup
+			{
+				NTR_PROFILE_SCOPE("Wait for render thread");
+				slot = mRenderThread.acquire();
+			}
 
-			const std::vector<glm::mat4> lightMatrices = getLightSpaceMatrices(mScene.selectedCamera, mScene.directionalLight.direction, mShadowCascadeLevels);
-			ssboLightMatrices.bind();
-			ssboLightMatrices.update(0, lightMatrices.size(), lightMatrices.data());
-			ssboLightMatrices.unbind();
+			RenderSnapshot& frame = mSnapshots[slot];
+			mFrameResults = frame.results;
 
-			// 1. Render Scene Depth
+			NTR_PROFILE_COUNTER("GL calls issued", mFrameResults.counters.issued);
+			NTR_PROFILE_COUNTER("GL calls filtered", mFrameResults.counters.filtered);
+			NTR_PROFILE_COUNTER("Draw calls", mFrameResults.counters.draws);
+
+			mStressSweep.update(mScene, deltaTimeSeconds * 1000.0f, mFrameResults.counters);
+
+			// per render path frame time, smoothed so both paths can be compared in the Scene window
 
-			renderDepth(mLightFBO);
+			float& averageFrameTimeMs = mAverageFrameTimeMs[mScene.renderPath];
+			averageFrameTimeMs = averageFrameTimeMs * 0.95f + (deltaTimeSeconds * 1000.0f) * 0.05f;
+
+			if (mBenchmark)
+			{
+				mBenchmark->beginFrame(mScene.selectedCamera);
+			}
+			else
+			{
+				NTR_PROFILE_SCOPE("Input");
 
-			// 2. Render scene as normal
+				processViewerMovement(deltaTimeSeconds);
+				processViewerRotation();
+				processViewerPicking();
+			}
 
-			glClearColor(0.1f, 0.1f, 0.1f, 1.0f); // color range: [0.0f, 1.0f]
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			// the GUI may change the scene, so it is built before the snapshot is taken
 
-			mShaderPBR.use();
-			mShaderPBR.setMat4("view", mScene.selectedCamera.view());
-			mShaderPBR.setMat4("projection", mScene.selectedCamera.projection());
-			mShaderPBR.setVec3("directionalLight.color", mScene.directionalLight.color);
-			mShaderPBR.setVec3("directionalLight.direction", mScene.directionalLight.direction);
-			mShaderPBR.setVec3("cameraPosition", mScene.selectedCamera.position);
-			mShaderPBR.setFloat("cameraFarPlane", mScene.selectedCamera.zFar);
+			if (!mBenchmark)
+			{
+				NTR_PROFILE_SCOPE("GUI");
+				renderGui(frame.gui);
+			}
 
-			size_t cascadeCount = mShadowCascadeLevels.size();
+			// textures no material uses any more are erased once per frame, their GL names are deleted behind a fence
 
-			std::vector<float> cascadePlaneDistances;
-			cascadePlaneDistances.reserve(cascadeCount);
+			if (mScene.hasUnusedTextures())
+			{
+				mScene.releaseUnusedTextures();
+			}
 
-			for (size_t i = 0; i < cascadeCount; ++i)
 			{
-				cascadePlaneDistances.push_back(mShadowCascadeLevels[i]);
+				NTR_PROFILE_SCOPE("Extract snapshot");
+				extractSnapshot(frame);
 			}
 
-			ssboCascadePlaneDistances.bind();
-			ssboCascadePlaneDistances.update(0, cascadePlaneDistances.size(), cascadePlaneDistances.data());
-			ssboCascadePlaneDistances.unbind();
+			GLDeletionQueue::submitFrame();
+			mRenderThread.submit();
 
-			// enable stencil buffer writing, draw selected entity
+			// update window title each second
+
+			static float winTitleElapsedTimeSeconds = 0.0f;
 
-			glStencilFunc(GL_ALWAYS, 1, 0xFF);
-			glStencilMask(0xFF);
+			winTitleElapsedTimeSeconds += deltaTimeSeconds;
 
-			glClear(GL_STENCIL_BUFFER_BIT);
+			if (winTitleElapsedTimeSeconds >= 1.0f)
+			{
+				glfwSetWindowTitle(mWindow, (M_WINDOW_TITLE + " (FPS: " + std::to_string(1.0f / deltaTimeSeconds) + ") (FT: " + std::to_string(deltaTimeSeconds * 1000.0f) + "ms)").c_str());
+				winTitleElapsedTimeSeconds = 0.0f;
+			}
 
-			const auto entitySelectedView = mScene.registry.view<ConstPointer<Model>, Transform, Selected>();
+			// headless frames don't overlap, each one is timed from its update until the GPU finished it
 
-			for (const auto& [entity, model, transform] : entitySelectedView.each())
+			if (mBenchmark)
 			{
-				renderModelPBR(model, transform);
+				NTR_PROFILE_SCOPE("Finish");
+				mRenderThread.wait();
+				mBenchmark->endFrame(frame.results.counters, frame.results.passes);
 			}
+		}
+
+		mRenderThread.stop();
+
+		// what the scene releases on destruction is freed with the context
+		GLDeletionQueue::flush();
+
+		if (mBenchmark)
+		{
+			// the last frames finished with glFinish, this collects their timings
+			mGpuProfiler.beginFrame();
+			mBenchmark->finish(mGpuProfiler.passes());
+		}
+	}
 
-			// disable stencil buffer writing, draw unselected entities
+	void App::renderFrame(RenderSnapshot& frame)
+	{
+		GLState::beginFrame();
 
-			glStencilMask(0x00);
+		mGpuProfiler.enabled = frame.gpuProfilerEnabled;
+		mGpuProfiler.beginFrame();
 
-			const auto entityView = mScene.registry.view<ConstPointer<Model>, Transform>(entt::exclude<Selected>);
+		// the window may have been resized since the last frame
 
-			for (const auto& [entity, model, transform] : entityView.each())
+		const GLsizei WIDTH = (GLsizei)frame.camera.viewport.width;
+		const GLsizei HEIGHT = (GLsizei)frame.camera.viewport.height;
+
+		if (WIDTH > 0 && HEIGHT > 0 && (WIDTH != mGBuffer.width() || HEIGHT != mGBuffer.height()))
+		{
+			mGBuffer.resize(WIDTH, HEIGHT);
+		}
+
+		setViewport(frame.camera.viewport);
+
+		{
+			NTR_PROFILE_SCOPE("Shadows");
+
+			// 0. SSBO setup
+
+			mLightMatrices.update(0, frame.lightMatrices.size(), frame.lightMatrices.data());
+
+			// 1. Render Scene Depth
+
+			if (frame.shadowsEnabled)
 			{
-				renderModelPBR(model, transform);
+				mGpuProfiler.begin("Shadow depth");
+				renderDepth(frame);
+				mGpuProfiler.end();
 			}
 
-			//renderDebugQuad();
+			mCascadePlaneDistances.update(0, frame.shadowCascadeLevels.size(), frame.shadowCascadeLevels.data());
+		}
 
-			renderGui();
+		// upload point lights and bin them into clusters
 
-			// update window title each second
+		{
+			NTR_PROFILE_SCOPE("Light culling");
 
-			static float winTitleElapsedTimeSeconds = 0.0f;
+			mGpuProfiler.begin("Light culling");
+			mLightClusters.update(frame.camera, frame.pointLights);
+			mGpuProfiler.end();
+		}
 
-			winTitleElapsedTimeSeconds += deltaTimeSeconds;
+		{
+			NTR_PROFILE_SCOPE("Frame uniforms");
 
-			if (winTitleElapsedTimeSeconds >= 1.0f)
+			updateFrameUniforms(frame);
+			updateMaterials(frame);
+			updateTextureNames(frame);
+		}
+
+		// stream texture mips for what the camera sees
+
+		{
+			NTR_PROFILE_SCOPE("Texture streaming");
+
+			requestTextureMips(frame);
+			mTextureStreamer.budgetBytes = frame.textureBudgetBytes;
+			mTextureStreamer.update(frame.textures);
+
+			NTR_PROFILE_COUNTER("Texture resident MB", mTextureStreamer.residentBytes() / (1024.0 * 1024.0));
+		}
+
+		// 2. Render scene as normal
+
+		{
+			NTR_PROFILE_SCOPE("Render scene");
+
+			if (frame.renderPath == RenderPath::DEFERRED)
 			{
-				glfwSetWindowTitle(mWindow, (M_WINDOW_TITLE + " (FPS: " + std::to_string(1.0f / deltaTimeSeconds) + ") (FT: " + std::to_string(deltaTimeSeconds * 1000.0f) + "ms)").c_str());
-				winTitleElapsedTimeSeconds = 0.0f;
+				renderSceneDeferred(frame);
+			}
+			else
+			{
+				renderSceneForward(frame);
 			}
 
-			// --------------------------------
+			renderSelectedOutline(frame);
+		}
+
+		//renderDebugQuad();
+
+		if (!frame.gui.empty())
+		{
+			NTR_PROFILE_SCOPE("GUI");
+
+			mGpuProfiler.begin("GUI");
+			Gui::draw(frame.gui);
+			mGpuProfiler.end();
+		}
+
+		// nothing throttles a headless run, waiting for the GPU keeps frame times honest
 
+		if (frame.finish)
+		{
+			NTR_PROFILE_SCOPE("Finish");
+			glFinish();
+		}
+		else
+		{
+			NTR_PROFILE_SCOPE("Swap buffers");
 			glfwSwapBuffers(mWindow);
 		}
+
+		// objects released while this frame was built are deleted once the GPU finished it
+
+		GLDeletionQueue::collect();
+
+		NTR_PROFILE_COUNTER("GL deletions pending", GLDeletionQueue::pendingCount());
+
+		collectResults(frame);
 	}
 
 	GLFWwindow* App::createWindow()
 	{
 		glfwSetErrorCallback(glfw_error_callback);
 
-		// Init GLFW to create window
+		// Init GLFW to create window, headless on the null platform with an EGL context (surfaceless on Mesa)
+
+		const int WIDTH = mBenchmark ? mBenchmark->script().width : M_RESOLUTION_WIDTH;
+		const int HEIGHT = mBenchmark ? mBenchmark->script().height : M_RESOLUTION_HEIGHT;
+
+		if (mBenchmark)
+		{
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+			glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+		}
 
 		glfwInit();
+
+		if (mBenchmark)
+		{
+			glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+		}
+
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, M_OPENGL_VERSION_MAJOR);
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, M_OPENGL_VERSION_MINOR);
 		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -226,7 +426,7 @@ namespace ntr
 		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-		GLFWwindow* window = glfwCreateWindow(M_RESOLUTION_WIDTH, M_RESOLUTION_HEIGHT, M_WINDOW_TITLE.c_str(), nullptr, nullptr);
+		GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, M_WINDOW_TITLE.c_str(), nullptr, nullptr);
 		if (!window)
 		{
 			std::cerr << "ERROR: failed to create window" << std::endl;
@@ -242,7 +442,8 @@ namespace ntr
 				App* app = (App*)glfwGetWindowUserPointer(window);
 				app->mScene.selectedCamera.viewport.width = (float)width;
 				app->mScene.selectedCamera.viewport.height = (float)height;
-				app->setViewport(app->mScene.selectedCamera.viewport);
+
+				// the render thread resizes the GBuffer once a snapshot with the new viewport arrives
 			}
 		);
 
@@ -269,6 +470,10 @@ namespace ntr
 			exit(EXIT_FAILURE);
 		}
 
+		// shaders created from here on compile on driver threads when supported
+
+		Shader::enableParallelCompile((GLADloadproc)glfwGetProcAddress);
+
 		// Configure OpenGL
 
 		int flags; glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
@@ -280,17 +485,17 @@ namespace ntr
 			glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
 		}
 
-		glEnable(GL_DEPTH_TEST);
-		glDepthFunc(GL_LESS);
+		GLState::setEnabled(GL_DEPTH_TEST, true);
+		GLState::depthFunc(GL_LESS);
 
-		glEnable(GL_STENCIL_TEST);
-		glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
-		glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+		GLState::setEnabled(GL_STENCIL_TEST, true);
+		GLState::stencilFunc(GL_NOTEQUAL, 1, 0xFF);
+		GLState::stencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
 
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		GLState::setEnabled(GL_BLEND, true);
+		GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-		//glEnable(GL_CULL_FACE);
+		//GLState::setEnabled(GL_CULL_FACE, true);
 
 		return window;
 	}
@@ -312,23 +517,12 @@ namespace ntr
 		return width == 0 || height == 0;
 	}
 
-	float App::getDeltaTimeSeconds() const
-	{
-		static float prevTimeSeconds = 0.0f;
-
-		float currTimeSeconds	= (float)glfwGetTime();
-		float deltaTimeSeconds	= currTimeSeconds - prevTimeSeconds;
-		prevTimeSeconds			= currTimeSeconds;
-
-		return deltaTimeSeconds;
-	}
-
 	void App::setViewport(const Rect& rect)
 	{
-		glViewport((GLint)rect.x, (GLint)rect.y, (GLsizei)rect.width, (GLsizei)rect.height);
+		GLState::viewport((GLint)rect.x, (GLint)rect.y, (GLsizei)rect.width, (GLsizei)rect.height);
 	}
 
-	entt::entity App::addEntityModel3D(const std::string& id, const Model* model, const Transform& transform)
+	entt::entity App::addEntityModel3D(const std::string& id, ModelHandle model, const Transform& transform)
 	{
 		static unsigned int entNum = 0;
 		std::string idToUse = "";
@@ -343,38 +537,29 @@ namespace ntr
 		}
 
 		// handle duplicate id
-
-		auto entityView = mScene.registry.view<StringID>();
-		bool duplicateFound;
-
-		do
-		{
-			duplicateFound = false;
-
-			for (auto& [ent, id] : entityView.each())
-			{
-				if (idToUse == id.str)
-				{
-					duplicateFound = true;
-					break;
-				}
-			}
-
-			if (duplicateFound)
-			{
-				idToUse += "+";
-			}
-		} while (duplicateFound);
+		idToUse = mScene.getUniqueEntityID(idToUse);
 
 		// create entity
 		entt::entity ent = mScene.registry.create();
 		mScene.registry.emplace<StringID>(ent, idToUse);
-		mScene.registry.emplace<ConstPointer<Model>>(ent, model);
+		mScene.registry.emplace<ModelHandle>(ent, model);
 		mScene.registry.emplace<Transform>(ent, transform);
 
 		return ent;
 	}
 
+	entt::entity App::addEntityPointLight(const std::string& id, const PointLight& light)
+	{
+		static unsigned int lightNum = 0;
+		std::string idToUse = (id == "") ? "point_light_" + std::to_string(++lightNum) : id;
+
+		entt::entity ent = mScene.registry.create();
+		mScene.registry.emplace<StringID>(ent, mScene.getUniqueEntityID(idToUse));
+		mScene.registry.emplace<PointLight>(ent, light);
+
+		return ent;
+	}
+
 	void App::processViewerMovement(float deltaTimeSeconds)
 	{
 		// Only process camera movement if gui isn't using keyboard
@@ -469,7 +654,235 @@ namespace ntr
 		mScene.selectedCamera.rotation = rotation;
 	}
 
-	void App::renderDepth(const FrameBuffer& lightFBO)
+	void App::processViewerPicking()
+	{
+		static bool wasPressed = false;
+
+		const bool PRESSED = glfwGetMouseButton(mWindow, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+		const bool CLICKED = PRESSED && !wasPressed;
+
+		wasPressed = PRESSED;
+
+		if (!CLICKED || ImGui::GetIO().WantCaptureMouse)
+		{
+			return;
+		}
+
+		double xpos = 0.0;
+		double ypos = 0.0;
+		int windowWidth = 0;
+		int windowHeight = 0;
+
+		glfwGetCursorPos(mWindow, &xpos, &ypos);
+		glfwGetWindowSize(mWindow, &windowWidth, &windowHeight);
+
+		if (windowWidth == 0 || windowHeight == 0)
+		{
+			return;
+		}
+
+		const Camera& camera = mScene.selectedCamera;
+		const Rect FRAMEBUFFER = getWindowFramebufferRect();
+
+		// cursor to framebuffer pixels, which may be denser than screen coordinates and count rows from the bottom
+		const float X = (float)xpos * FRAMEBUFFER.width / windowWidth;
+		const float Y = FRAMEBUFFER.height - (float)ypos * FRAMEBUFFER.height / windowHeight;
+
+		const glm::vec2 NDC = {
+			2.0f * (X - camera.viewport.x) / camera.viewport.width - 1.0f,
+			2.0f * (Y - camera.viewport.y) / camera.viewport.height - 1.0f
+		};
+
+		const glm::mat4 INV = glm::inverse(camera.projection() * camera.view());
+
+		glm::vec4 nearPoint = INV * glm::vec4(NDC, -1.0f, 1.0f);
+		glm::vec4 farPoint = INV * glm::vec4(NDC, 1.0f, 1.0f);
+
+		nearPoint /= nearPoint.w;
+		farPoint /= farPoint.w;
+
+		// from the near to the far plane, so a distance of 1 is the far plane
+		const Ray RAY = { glm::vec3(nearPoint), glm::vec3(farPoint - nearPoint) };
+
+		RayHit hit;
+
+		mPickedEntity = mScene.getBVH().raycast(RAY, hit, 1.0f) ? hit.entity : entt::null;
+		mPickRequested = true;
+	}
+
+	void App::processProfilerCapture()
+	{
+		static bool wasPressed = false;
+
+		const bool PRESSED = glfwGetKey(mWindow, M_PROFILER_CAPTURE_KEY) == GLFW_PRESS;
+
+		if (PRESSED && !wasPressed)
+		{
+			NTR_PROFILE_CAPTURE(M_PROFILER_CAPTURE_FRAMES);
+		}
+
+		wasPressed = PRESSED;
+	}
+
+	void App::extractSnapshot(RenderSnapshot& frame)
+	{
+		const Camera& camera = mScene.selectedCamera;
+
+		mScene.updateTransforms(mWorkers);
+
+		frame.camera = camera;
+		frame.directionalLight = mScene.directionalLight;
+		frame.renderPath = mScene.renderPath;
+		frame.shadowsEnabled = mScene.shadowsEnabled;
+
+		updateShadowCascadeLevels();
+
+		frame.shadowCascadeLevels = mShadowCascadeLevels;
+		frame.lightMatrices = getLightSpaceMatrices(camera, mScene.directionalLight.direction, mShadowCascadeLevels);
+
+		frame.pointLights.clear();
+
+		for (const auto& [entity, light] : mScene.registry.view<PointLight>().each())
+		{
+			PointLight& extracted = frame.pointLights.emplace_back(light);
+
+			if (const WorldMatrix* world = mScene.registry.try_get<WorldMatrix>(entity))
+			{
+				extracted.position = glm::vec3(world->model * glm::vec4(light.position, 1.0f));
+			}
+		}
+
+		NTR_PROFILE_COUNTER("Point lights", frame.pointLights.size());
+
+		extractMaterials(frame);
+		extractTextures(frame);
+
+		// pixels covered by one world unit at distance 1
+		const float PIXELS_PER_UNIT = camera.viewport.height / (2.0f * std::tan(glm::radians(camera.fovY) * 0.5f));
+
+		frame.selectedDraws.clear();
+
+		const auto entitySelectedView = mScene.registry.view<ModelHandle, WorldMatrix, Selected>();
+
+		for (const auto& [entity, model, world] : entitySelectedView.each())
+		{
+			if (const Model* modelData = mScene.getModel(model))
+			{
+				extractDraws(frame.selectedDraws, camera, modelData, world, PIXELS_PER_UNIT);
+			}
+		}
+
+		// Gathering the entities is cheap, building their draws is not: every worker records a contiguous range into
+		// its own list, so replaying the lists in order draws in the same order as a serial loop would.
+
+		mDrawSources.clear();
+
+		const auto entityView = mScene.registry.view<ModelHandle, WorldMatrix>(entt::exclude<Selected>);
+
+		for (const auto& [entity, model, world] : entityView.each())
+		{
+			if (const Model* modelData = mScene.getModel(model))
+			{
+				mDrawSources.emplace_back(modelData, &world);
+			}
+		}
+
+		frame.drawLists.resize(mWorkers.size());
+
+		const size_t LISTS = mWorkers.parallelFor(mDrawSources.size(), M_MIN_DRAW_SOURCES_PER_WORKER, [this, &frame, &camera, PIXELS_PER_UNIT](size_t list, size_t begin, size_t end)
+		{
+			NTR_PROFILE_SCOPE("Record draws");
+
+			std::vector<DrawItem>& draws = frame.drawLists[list];
+			draws.clear();
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				extractDraws(draws, camera, mDrawSources[i].first, *mDrawSources[i].second, PIXELS_PER_UNIT);
+			}
+		});
+
+		for (size_t i = LISTS; i < frame.drawLists.size(); ++i)
+		{
+			frame.drawLists[i].clear();
+		}
+
+		frame.gpuProfilerEnabled = mGpuProfilerEnabled;
+		frame.textureBudgetBytes = mTextureBudgetBytes;
+		frame.finish = mBenchmark != nullptr;
+	}
+
+	void App::extractMaterials(RenderSnapshot& frame)
+	{
+		// the default material first, then the scene materials in their dense order, see extractDraws
+
+		frame.materials.clear();
+		frame.materials.emplace_back(mScene.getMaterialOrDefault(MaterialHandle{}));
+
+		for (const auto& [id, handle, material] : mScene.getMaterials())
+		{
+			frame.materials.emplace_back(material);
+		}
+	}
+
+	void App::extractTextures(RenderSnapshot& frame)
+	{
+		// assigned in place, so the ids, paths and level sizes of a slot reuse their storage from frame to frame
+
+		const auto& TEXTURES = mScene.getTextures();
+
+		frame.textures.resize(TEXTURES.size());
+
+		size_t i = 0;
+
+		for (const auto& [id, handle, texture] : TEXTURES)
+		{
+			frame.textures[i++].assign(id, handle, texture);
+		}
+	}
+
+	void App::extractDraws(std::vector<DrawItem>& draws, const Camera& camera, const Model* model, const WorldMatrix& world, float pixelsPerUnit) const
+	{
+		for (const auto& [id, mesh] : model->meshes)
+		{
+			const Mesh* MESH = mScene.getMesh(mesh.mesh);
+
+			if (!MESH)
+			{
+				continue;
+			}
+
+			DrawItem& draw = draws.emplace_back();
+
+			// both are cached, and the inverse transpose of a product is the product of the inverse transposes
+			draw.model				= world.model * mesh.matrix.model;
+			draw.normal				= world.normal * mesh.matrix.normal;
+			draw.vao				= MESH->vao();
+			draw.indexCount			= MESH->indexCount();
+			const Material& MATERIAL = mScene.getMaterialOrDefault(mesh.material);
+			const size_t MATERIAL_INDEX = mScene.getMaterials().indexOf(mesh.material);
+
+			draw.materialFeatures	= getMaterialFeatures(&MATERIAL);
+			draw.textures[0]		= MATERIAL.albedo;
+			draw.textures[1]		= MATERIAL.normal;
+			draw.textures[2]		= MATERIAL.roughness;
+			draw.textures[3]		= MATERIAL.metallic;
+			draw.textures[4]		= MATERIAL.occlusion;
+			draw.materialIndex		= MATERIAL_INDEX != SlotMap<Material>::NPOS ? (GLint)MATERIAL_INDEX + 1 : 0;
+
+			// assumes the uv space of the material spans the mesh once
+
+			const glm::vec3 CENTER = glm::vec3(draw.model[3]);
+
+			const float SCALE = std::max({ glm::length(glm::vec3(draw.model[0])), glm::length(glm::vec3(draw.model[1])), glm::length(glm::vec3(draw.model[2])) });
+			const float RADIUS = MESH->boundingRadius() * SCALE;
+			const float DISTANCE = std::max(glm::distance(camera.position, CENTER) - RADIUS, camera.zNear);
+
+			draw.screenSizePixels = 2.0f * RADIUS * pixelsPerUnit / DISTANCE;
+		}
+	}
+
+	void App::renderDepth(const RenderSnapshot& frame)
 	{
 		// Render depth of scene to texture (from light's perpective)
 
@@ -478,61 +891,416 @@ namespace ntr
 		glClear(GL_DEPTH_BUFFER_BIT);
 		
 		// Save original state before modifying
-		GLint cullFaceMode;
-		glGetIntegerv(GL_CULL_FACE_MODE, &cullFaceMode);
+		const GLenum CULL_FACE_MODE = GLState::cullFaceMode();
 
-		glCullFace(GL_FRONT); // peter panning
+		GLState::cullFace(GL_FRONT); // peter panning
 
 		mShaderDepth.use();
 
-		auto entityView = mScene.registry.view<ConstPointer<Model>, Transform>();
+		auto drawDepth = [this](const std::vector<DrawItem>& draws)
+		{
+			for (const DrawItem& draw : draws)
+			{
+				mShaderDepth.setMat4("model", draw.model);
+				mShaderDepth.draw(draw.vao, draw.indexCount);
+			}
+		};
+
+		drawDepth(frame.selectedDraws);
+
+		for (const std::vector<DrawItem>& draws : frame.drawLists)
+		{
+			drawDepth(draws);
+		}
+
+		// Restore original state
+		GLState::cullFace(CULL_FACE_MODE);
+
+		mLightFBO.unbind();
+
+		// reset viewport
+		setViewport(frame.camera.viewport);
+	}
+
+	void App::renderSceneForward(const RenderSnapshot& frame)
+	{
+		GLState::clearColor(0.1f, 0.1f, 0.1f, 1.0f); // color range: [0.0f, 1.0f]
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		const ShaderFeatures FRAME_FEATURES = getFrameFeatures(frame.shadowCascadeLevels.size(), frame.shadowsEnabled);
+
+		// per-frame data comes from the FrameUniforms block, only the shadow map is bound here
+
+		Shader& shader = mShaderPBR.get(FRAME_FEATURES);
+		shader.bindTexture(5, mLightDepthMaps);
+
+		// enable stencil buffer writing, draw selected entity
+
+		GLState::stencilFunc(GL_ALWAYS, 1, 0xFF);
+		GLState::stencilMask(0xFF);
+
+		glClear(GL_STENCIL_BUFFER_BIT);
+
+		mGpuProfiler.begin("Selection stencil");
+
+		for (const DrawItem& draw : frame.selectedDraws)
+		{
+			renderDrawPBR(mShaderPBR, FRAME_FEATURES, draw);
+		}
+
+		mGpuProfiler.end();
+
+		// disable stencil buffer writing, draw unselected entities
+
+		GLState::stencilMask(0x00);
+
+		mGpuProfiler.begin("PBR");
+
+		for (const std::vector<DrawItem>& draws : frame.drawLists)
+		{
+			for (const DrawItem& draw : draws)
+			{
+				renderDrawPBR(mShaderPBR, FRAME_FEATURES, draw);
+			}
+		}
+
+		mGpuProfiler.end();
+	}
+
+	void App::renderSceneDeferred(const RenderSnapshot& frame)
+	{
+		// 1. Geometry pass: write materials into the GBuffer (blending would mix packed normals)
+
+		mGBuffer.bind();
+		GLState::setEnabled(GL_BLEND, false);
+
+		GLState::stencilFunc(GL_ALWAYS, 1, 0xFF);
+		GLState::stencilMask(0xFF);
+
+		GLState::clearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+		// the GBuffer pass doesn't shade, so only material features select its variant
+
+		mGpuProfiler.begin("Selection stencil");
+
+		for (const DrawItem& draw : frame.selectedDraws)
+		{
+			renderDrawPBR(mShaderGBuffer, 0, draw);
+		}
+
+		mGpuProfiler.end();
+
+		GLState::stencilMask(0x00);
+
+		mGpuProfiler.begin("GBuffer");
+
+		for (const std::vector<DrawItem>& draws : frame.drawLists)
+		{
+			for (const DrawItem& draw : draws)
+			{
+				renderDrawPBR(mShaderGBuffer, 0, draw);
+			}
+		}
+
+		mGpuProfiler.end();
+
+		mGBuffer.unbind();
+		GLState::setEnabled(GL_BLEND, true);
+
+		// 2. Lighting pass: resolve directional light and cascaded shadows for every covered pixel
+
+		GLState::clearColor(0.1f, 0.1f, 0.1f, 1.0f); // color range: [0.0f, 1.0f]
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		GLState::setEnabled(GL_DEPTH_TEST, false);
+
+		mGpuProfiler.begin("Deferred lighting");
+
+		Shader& shaderDeferred = mShaderDeferred.get(getFrameFeatures(frame.shadowCascadeLevels.size(), frame.shadowsEnabled));
+
+		shaderDeferred.use();
+		shaderDeferred.bindTexture(0, mGBuffer.albedo());
+		shaderDeferred.bindTexture(1, mGBuffer.normal());
+		shaderDeferred.bindTexture(2, mGBuffer.material());
+		shaderDeferred.bindTexture(3, mGBuffer.depth());
+		shaderDeferred.bindTexture(5, mLightDepthMaps);
+		shaderDeferred.drawFullscreenTriangle();
+
+		mGpuProfiler.end();
+
+		GLState::setEnabled(GL_DEPTH_TEST, true);
+
+		// 3. Copy scene depth and selection stencil so the outline and overlays behave as in the forward path
+
+		glBlitNamedFramebuffer(
+			mGBuffer.id(), GLState::defaultFramebuffer(),
+			0, 0, mGBuffer.width(), mGBuffer.height(),
+			0, 0, mGBuffer.width(), mGBuffer.height(),
+			GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, GL_NEAREST
+		);
+	}
+
+	void App::renderSelectedOutline(const RenderSnapshot& frame)
+	{
+		if (frame.selectedDraws.empty())
+		{
+			return;
+		}
+
+		mGpuProfiler.begin("Outline");
+
+		// Save original state before modifying
+		const bool DEPTH_TEST_ENABLED = GLState::isEnabled(GL_DEPTH_TEST);
+		const bool CULL_FACE_ENABLED = GLState::isEnabled(GL_CULL_FACE);
+
+		GLState::setEnabled(GL_DEPTH_TEST, false);
+		GLState::setEnabled(GL_CULL_FACE, false);
+
+		// draw borders of selected entities
+		GLState::stencilFunc(GL_NOTEQUAL, 1, 0xFF);
+		GLState::stencilMask(0x00);
+
+		mShaderStencil.use();
+
+		mShaderStencil.setMat4("view", frame.camera.view());
+		mShaderStencil.setMat4("projection", frame.camera.projection());
+		mShaderStencil.setFloat("outlineThickness", 50.0f);
+
+		for (const DrawItem& draw : frame.selectedDraws)
+		{
+			mShaderStencil.setMat4("model", draw.model);
+			mShaderStencil.draw(draw.vao, draw.indexCount);
+		}
+
+		GLState::stencilMask(0xFF);
+		GLState::stencilFunc(GL_ALWAYS, 0, 0xFF);
+
+		// Restore original state 
+		GLState::setEnabled(GL_DEPTH_TEST, DEPTH_TEST_ENABLED);
+		GLState::setEnabled(GL_CULL_FACE, CULL_FACE_ENABLED);
+
+		mGpuProfiler.end();
+	}
+
+	void App::renderDrawPBR(ShaderPermutations& shaders, ShaderFeatures frameFeatures, const DrawItem& draw)
+	{
+		// pick the variant that only samples the maps this material actually has
+		Shader& shader = shaders.get(frameFeatures | draw.materialFeatures);
+
+		shader.use();
+		shader.setMat4("model", draw.model);
+		shader.setMat3("normal", draw.normal);
+		shader.setInt("materialIndex", draw.materialIndex);
+
+		// textures are extracted with the draws, so every map a draw has resolves to a name of this frame
+		auto bind = [this, &shader](GLint unit, TextureHandle texture)
+		{
+			auto itr = mTextureNames.find(texture);
+			shader.bindTexture(unit, itr != mTextureNames.end() ? itr->second : 0);
+		};
+
+		if (draw.materialFeatures & ShaderFeature::ALBEDO_MAP)		{ bind(0, draw.textures[0]); }
+		if (draw.materialFeatures & ShaderFeature::NORMAL_MAP)		{ bind(1, draw.textures[1]); }
+		if (draw.materialFeatures & ShaderFeature::ROUGHNESS_MAP)	{ bind(2, draw.textures[2]); }
+		if (draw.materialFeatures & ShaderFeature::METALLIC_MAP)	{ bind(3, draw.textures[3]); }
+		if (draw.materialFeatures & ShaderFeature::OCCLUSION_MAP)	{ bind(4, draw.textures[4]); }
+
+		shader.draw(draw.vao, draw.indexCount);
+	}
+
+	void App::updateFrameUniforms(const RenderSnapshot& frame)
+	{
+		const Camera& camera = frame.camera;
+		const glm::vec4 CLUSTER_PARAMS = mLightClusters.getClusterParams(camera);
+
+		FrameUniforms frameUniforms{};
+		frameUniforms.view						= camera.view();
+		frameUniforms.projection				= camera.projection();
+		frameUniforms.inverseViewProjection		= glm::inverse(frameUniforms.projection * frameUniforms.view);
+		frameUniforms.cameraPosition			= camera.position;
+		frameUniforms.cameraFarPlane			= camera.zFar;
+		frameUniforms.directionalLightDirection	= frame.directionalLight.direction;
+		frameUniforms.directionalLightColor		= frame.directionalLight.color;
+		frameUniforms.clusterTileSize			= { CLUSTER_PARAMS.x, CLUSTER_PARAMS.y };
+		frameUniforms.clusterScale				= CLUSTER_PARAMS.z;
+		frameUniforms.clusterBias				= CLUSTER_PARAMS.w;
+
+		mFrameUniforms.update(frameUniforms);
+	}
+
+	void App::updateMaterials(const RenderSnapshot& frame)
+	{
+		// grow geometrically like the light buffer, materials are added one at a time
+		if (frame.materials.size() > mMaterials.size())
+		{
+			size_t capacity = mMaterials.size();
+
+			while (capacity < frame.materials.size())
+			{
+				capacity *= 2;
+			}
+
+			mMaterials.resize(capacity);
+		}
+
+		mMaterials.update(0, frame.materials.size(), frame.materials.data());
+	}
+
+	void App::updateTextureNames(const RenderSnapshot& frame)
+	{
+		// cleared and refilled so a removed texture never resolves, the buckets are kept from frame to frame
+		mTextureNames.clear();
+
+		for (const StreamedTexture& TEXTURE : frame.textures)
+		{
+			mTextureNames.emplace(TEXTURE.handle, TEXTURE.name);
+		}
+	}
+
+	void App::requestTextureMips(const RenderSnapshot& frame)
+	{
+		auto request = [this](const std::vector<DrawItem>& draws)
+		{
+			for (const DrawItem& draw : draws)
+			{
+				for (TextureHandle texture : draw.textures)
+				{
+					mTextureStreamer.request(texture, draw.screenSizePixels);
+				}
+			}
+		};
+
+		request(frame.selectedDraws);
+
+		for (const std::vector<DrawItem>& draws : frame.drawLists)
+		{
+			request(draws);
+		}
+	}
+
+	void App::collectResults(RenderSnapshot& frame)
+	{
+		RenderResults& results = frame.results;
+
+		results.counters				= GLState::frameCounters();
+		results.passes					= mGpuProfiler.passes();
+		results.droppedGpuFrames		= mGpuProfiler.droppedFrames();
+		results.pointLights				= mLightClusters.lightCount();
+		results.shaderVariants			= mShaderPBR.size() + mShaderGBuffer.size() + mShaderDeferred.size();
+		results.textureLoadsInFlight	= mTextureStreamer.loadsInFlight();
+
+		results.textures.clear();
+
+		for (const StreamedTexture& TEXTURE : frame.textures)
+		{
+			RenderResults::TextureResidency& texture = results.textures.emplace_back();
+			texture.id				= TEXTURE.id;
+			texture.width			= TEXTURE.width;
+			texture.height			= TEXTURE.height;
+
+			mTextureStreamer.getResidency(TEXTURE, texture.residentLevel, texture.sizeBytes);
+		}
+	}
+
+	void App::updateShadowCascadeLevels()
+	{
+		mShadowCascadeLevels = {
+			mScene.selectedCamera.zFar / 32.0f,
+			mScene.selectedCamera.zFar / 16.0f,
+			mScene.selectedCamera.zFar / 8.0f,
+			mScene.selectedCamera.zFar / 4.0f,
+			mScene.selectedCamera.zFar / 2.0f
+		};
+	}
+
+	bool App::loadBenchmarkScene()
+	{
+		const BenchmarkScript& SCRIPT = mBenchmark->script();
+
+		for (const BenchmarkScript::ModelEntry& model : SCRIPT.models)
+		{
+			if (!mScene.loadModel(model.id, model.filepath))
+			{
+				return false;
+			}
+		}
+
+		for (const BenchmarkScript::EntityEntry& entity : SCRIPT.entities)
+		{
+			const ModelHandle MODEL = mScene.findModel(entity.model);
+
+			if (!MODEL)
+			{
+				std::cerr << "ERROR: benchmark entity uses unknown model \'" << entity.model << "\'" << std::endl;
+				return false;
+			}
+
+			addEntityModel3D("", MODEL, entity.transform);
+		}
+
+		for (const PointLight& light : SCRIPT.pointLights)
+		{
+			addEntityPointLight("", light);
+		}
+
+		if (SCRIPT.stress.entityCount > 0)
+		{
+			StressScene::spawn(mScene, SCRIPT.stress);
+		}
+
+		mScene.directionalLight = SCRIPT.directionalLight;
+		mScene.renderPath = SCRIPT.renderPath;
+		mScene.shadowsEnabled = SCRIPT.shadows;
+
+		return true;
+	}
+
+	void App::prepareShaders()
+	{
+		// submit the variants every frame starts with, materials without maps use them directly
+		// and meshes whose variant is still compiling fall back to them
 
-		for (const auto& [entity, model, transform] : entityView.each())
-		{
-			glm::mat4 modelMatrix = transform.matrix();
+		updateShadowCascadeLevels();
 
-			const auto& meshes = model->meshes;
+		const ShaderFeatures FRAME_FEATURES = getFrameFeatures(mShadowCascadeLevels.size(), mScene.shadowsEnabled);
 
-			for (const auto& [id, mesh] : meshes)
-			{
-				mShaderDepth.setMat4("model", modelMatrix * mesh.transform.matrix());
-				mShaderDepth.draw(mesh);
-			}
-		}
+		mShaderPBR.prepare(FRAME_FEATURES);
+		mShaderGBuffer.prepare(0);
+		mShaderDeferred.prepare(FRAME_FEATURES);
+	}
 
-		// Restore original state
-		glCullFace(cullFaceMode);
+	ShaderFeatures App::getFrameFeatures(size_t cascadeCount, bool shadowsEnabled)
+	{
+		ShaderFeatures features = toCascadeFeature(cascadeCount);
 
-		mLightFBO.unbind();
+		if (shadowsEnabled)
+		{
+			features |= ShaderFeature::SHADOWS;
+		}
 
-		// reset viewport
-		setViewport(mScene.selectedCamera.viewport);
+		return features;
 	}
 
-	void App::renderModelPBR(const Model* model, const Transform& transform)
+	ShaderFeatures App::getMaterialFeatures(const Material* material) const
 	{
-		glm::mat4 modelMatrix = transform.matrix();
+		auto hasMap = [](TextureHandle texture)
+		{
+			return (bool)texture;
+		};
 
-		const auto& meshes = model->meshes;
+		ShaderFeatures features = 0;
 
-		for (const auto& [id, mesh] : meshes)
-		{
-			glm::mat4 finalMatrix = modelMatrix * mesh.transform.matrix();
+		if (hasMap(material->albedo))		{ features |= ShaderFeature::ALBEDO_MAP; }
+		if (hasMap(material->normal))		{ features |= ShaderFeature::NORMAL_MAP; }
+		if (hasMap(material->roughness))	{ features |= ShaderFeature::ROUGHNESS_MAP; }
+		if (hasMap(material->metallic))		{ features |= ShaderFeature::METALLIC_MAP; }
+		if (hasMap(material->occlusion))	{ features |= ShaderFeature::OCCLUSION_MAP; }
 
-			mShaderPBR.setMat4("model", finalMatrix);
-			mShaderPBR.setMat3("normal", glm::transpose(glm::inverse(glm::mat3(finalMatrix))));
-			
-			mShaderPBR.bindTexture(0, "material.albedo",    mesh.material->albedo);
-			mShaderPBR.bindTexture(1, "material.normal",    mesh.material->normal);
-			mShaderPBR.bindTexture(2, "material.roughness", mesh.material->roughness);
-			mShaderPBR.bindTexture(3, "material.metallic",  mesh.material->metallic);
-			mShaderPBR.bindTexture(4, "material.occlusion", mesh.material->occlusion);
-			mShaderPBR.bindTexture(5, mLightDepthMaps);
-			mShaderPBR.draw(mesh);
-		}
+		return features;
 	}
 	
-	void App::renderGui()
+	void App::renderGui(GuiDrawData& drawData)
 	{
 		Gui::clear();
 
@@ -545,7 +1313,17 @@ namespace ntr
 		renderAssetsWindow();
 		renderSceneWindow();
 
-		Gui::draw();
+		if (mProfilerOpen)
+		{
+			renderProfilerWindow();
+		}
+
+		if (mStressOpen)
+		{
+			renderStressWindow();
+		}
+
+		Gui::render(drawData);
 	}
 
 	void App::renderMenuBar()
@@ -569,20 +1347,73 @@ namespace ntr
 							std::string filename = path.filename().string();
 							std::string modelID = filename.substr(0, filename.find_last_of('.'));
 
-							while (mScene.findModel(modelID) != Model::EMPTY)
-							{
-								modelID += "+";
-							}
+							modelID = mScene.getModels().getUniqueID(modelID);
+
+							RenderThread::ContextLock lock(mRenderThread);
+							mScene.importModel(modelID, path, &mWorkers);
+						}
+					});
+
+				mFileExplorer.open();
+			}
+
+			if (ImGui::MenuItem("Open Scene"))
+			{
+				mFileExplorer.setTitle("Open Scene");
+				mFileExplorer.setOpenButtonTitle("Open");
+				mFileExplorer.filterFileTypes({ "ntrscene" });
 
-							Model* model = mScene.loadModel(modelID, path);
+				mFileExplorer.setOnFileOpenCallback([this]()
+					{
+						const auto& files = mFileExplorer.getSelectedFiles();
 
-							addEntityModel3D(modelID, model);
+						for (const auto& path : files)
+						{
+							RenderThread::ContextLock lock(mRenderThread);
+							SceneFile::load(path, mScene);
 						}
 					});
 
 				mFileExplorer.open();
 			}
 
+			if (ImGui::BeginMenu("Save Scene"))
+			{
+				static char scenePath[256] = "scene.ntrscene";
+
+				ImGui::InputText("##ScenePath", scenePath, sizeof(scenePath));
+
+				if (ImGui::MenuItem("Save"))
+				{
+					// meshes and textures that are not kept on the CPU are read back from VRAM
+					RenderThread::ContextLock lock(mRenderThread);
+					SceneFile::save(scenePath, mScene);
+				}
+
+				ImGui::EndMenu();
+			}
+
+			// what imported meshes keep on the CPU, exact picking needs at least their positions
+			if (ImGui::BeginMenu("Keep Mesh Data"))
+			{
+				if (ImGui::MenuItem("Vertices", nullptr, mScene.meshCpuData == CpuData::CPU_ALL))
+				{
+					mScene.meshCpuData = CpuData::CPU_ALL;
+				}
+
+				if (ImGui::MenuItem("Positions", nullptr, mScene.meshCpuData == CpuData::CPU_POSITIONS))
+				{
+					mScene.meshCpuData = CpuData::CPU_POSITIONS;
+				}
+
+				if (ImGui::MenuItem("None", nullptr, mScene.meshCpuData == CpuData::CPU_NONE))
+				{
+					mScene.meshCpuData = CpuData::CPU_NONE;
+				}
+
+				ImGui::EndMenu();
+			}
+
 			ImGui::EndMenu();
 		}
 
@@ -593,6 +1424,23 @@ namespace ntr
 				addEntityModel3D();
 			}
 
+			if (ImGui::MenuItem("[Entity] Point Light"))
+			{
+				// place in front of the viewer so the light is immediately visible
+				PointLight light;
+				light.position = mScene.selectedCamera.position + mScene.selectedCamera.front() * 5.0f;
+
+				addEntityPointLight("", light);
+			}
+
+			ImGui::EndMenu();
+		}
+
+		if (ImGui::BeginMenu("View"))
+		{
+			ImGui::MenuItem("GPU Profiler", nullptr, &mProfilerOpen);
+			ImGui::MenuItem("Stress Test", nullptr, &mStressOpen);
+
 			ImGui::EndMenu();
 		}
 
@@ -617,23 +1465,23 @@ namespace ntr
 	{
 		if (ImGui::CollapsingHeader("Meshes"))
 		{
-			static const Mesh* selectedMesh = Mesh::EMPTY;
+			static MeshHandle selectedMesh = {};
 			static bool showRenameError = false;
 			static std::string duplicateID = "";
 			
 			Gui::EditableSelectableResult selectedResult;
-			const auto& MESH_MAP = mScene.getMeshMap();
+			const auto& MESHES = mScene.getMeshes();
 
 			// Iterate through selectable Meshes
 
-			for (const auto& [ID, mesh] : MESH_MAP)
+			for (const auto& [ID, handle, mesh] : MESHES)
 			{
 				ImGui::Bullet();
 				ImGui::SameLine();
 
-				bool isSelected = selectedMesh == mesh;
+				bool isSelected = selectedMesh == handle;
 
-				ImGui::PushID(mesh);
+				ImGui::PushID((int)handle.value);
 
 				auto result = Gui::EditableSelectable(ID, isSelected);
 
@@ -641,7 +1489,7 @@ namespace ntr
 
 				if (result.shouldSelect)
 				{
-					selectedMesh = mesh;
+					selectedMesh = handle;
 					selectedResult = result;
 				}
 			}
@@ -650,26 +1498,18 @@ namespace ntr
 			
 			if (ImGui::IsMouseClicked(0) && !ImGui::IsItemHovered())
 			{
-				selectedMesh = Mesh::EMPTY;
+				selectedMesh = {};
 				showRenameError = false;
 			}
-			else if (selectedResult.shouldRename && selectedMesh != Mesh::EMPTY)
+			else if (selectedResult.shouldRename && selectedMesh)
 			{
-				if (mScene.findMesh(selectedResult.newName) == Mesh::EMPTY)
-				{
-					mScene.replaceMeshID(mScene.findMeshID(selectedMesh), selectedResult.newName);
-					showRenameError = false;
-				}
-				else
-				{
-					showRenameError = true;
-					duplicateID = selectedResult.newName;
-				}
+				showRenameError = !mScene.renameMesh(selectedMesh, selectedResult.newName);
+				duplicateID = selectedResult.newName;
 			}
-			else if (selectedResult.shouldDelete && selectedMesh != Mesh::EMPTY)
+			else if (selectedResult.shouldDelete && selectedMesh)
 			{
-				mScene.removeMesh(mScene.findMeshID(selectedMesh));
-				selectedMesh = Mesh::EMPTY;
+				mScene.removeMesh(selectedMesh);
+				selectedMesh = {};
 				showRenameError = false;
 			}
 
@@ -684,25 +1524,25 @@ namespace ntr
 	{
 		if (ImGui::CollapsingHeader("Textures"))
 		{
-			static TextureHandle textureSelected = Texture::EMPTY;
+			static TextureHandle textureSelected = {};
 			static bool showRenameError = false;
 			static std::string duplicateID = "";
 			
 			Gui::EditableSelectableResult selectedResult;
-			const auto& textureMap = mScene.getTextureMap();
+			const auto& TEXTURES = mScene.getTextures();
 
-			for (const auto& [ID, TEXTURE] : textureMap)
+			for (const auto& [ID, handle, TEXTURE] : TEXTURES)
 			{
 				ImGui::Bullet();
 				ImGui::SameLine();
 
-				bool isSelected = TEXTURE.handle() == textureSelected;
+				bool isSelected = handle == textureSelected;
 
 				auto currResult = Gui::EditableSelectable(ID, isSelected);
 
 				if (currResult.shouldSelect)
 				{
-					textureSelected = TEXTURE.handle();
+					textureSelected = handle;
 					selectedResult = currResult;
 				}
 			}
@@ -710,15 +1550,15 @@ namespace ntr
 			
 			if (ImGui::IsMouseClicked(0) && !ImGui::IsItemHovered())
 			{
-				textureSelected = Texture::EMPTY;
+				textureSelected = {};
 				showRenameError = false;
 
 			}
-			else if (selectedResult.shouldRename && textureSelected != Texture::EMPTY)
+			else if (selectedResult.shouldRename && textureSelected)
 			{
-				if (mScene.findTexture(selectedResult.newName) == Texture::EMPTY)
+				if (mScene.renameTexture(textureSelected, selectedResult.newName))
 				{
-					mScene.replaceTextureID(mScene.findTextureID(textureSelected), selectedResult.newName);
+					showRenameError = false;
 				}
 				else
 				{
@@ -727,10 +1567,11 @@ namespace ntr
 					
 				}
 			}
-			else if (selectedResult.shouldDelete && textureSelected != Texture::EMPTY)
+			else if (selectedResult.shouldDelete && textureSelected)
 			{
-				mScene.removeTexture(mScene.findTextureID(textureSelected));
-				textureSelected = Texture::EMPTY;
+				// the GL texture is deleted behind a fence once the frames in flight are done with it
+				mScene.removeTexture(textureSelected);
+				textureSelected = {};
 				showRenameError = false;
 			}
 
@@ -743,7 +1584,7 @@ namespace ntr
 			{
 				mFileExplorer.setTitle("Load Texture");
 				mFileExplorer.setOpenButtonTitle("Load");
-				mFileExplorer.filterFileTypes({ "jpg", "png" });
+				mFileExplorer.filterFileTypes({ "jpg", "png", "dds", "ktx2" });
 
 				mFileExplorer.setOnFileOpenCallback([this]()
 					{
@@ -753,11 +1594,12 @@ namespace ntr
 						{
 							std::string textureID = path.filename().string();
 
-							while (mScene.findTexture(textureID) != Texture::EMPTY)
+							while (mScene.findTexture(textureID))
 							{
 								textureID += "+";
 							}
 
+							RenderThread::ContextLock lock(mRenderThread);
 							mScene.loadTexture(textureID, path);
 						}
 					});
@@ -771,16 +1613,16 @@ namespace ntr
 	{
 		if (ImGui::CollapsingHeader("Models"))
 		{
-			static Model* selectedModel = Model::EMPTY;
+			static ModelHandle selectedModel = {};
 			static bool showModelRenameError = false;
 			static std::string duplicateModelID = "";
 			Gui::EditableTreeNodeResult selectedModelResult;
 
 			bool addMeshButtonClicked = false;
 
-			auto& meshMap = mScene.getMeshMap();
-			auto& modelMap = mScene.getModelMap();
-			auto& materialMap = mScene.getMaterialMap();
+			auto& meshMap = mScene.getMeshes();
+			auto& modelMap = mScene.getModels();
+			auto& materialMap = mScene.getMaterials();
 
 			size_t numModels = modelMap.size();
 			size_t numMaterials = materialMap.size();
@@ -789,12 +1631,15 @@ namespace ntr
 			unsigned int transformHeaderID = 0;
 			unsigned int materialHeaderID = 0;
 
-			for (auto& [modID, model] : modelMap)
+			for (const auto& [modID, handle, constModel] : modelMap)
 			{
 				static bool showModMeshRenameError = false;
 				static std::string duplicateModMeshID = "";
 
-				bool isModelSelected = (model == selectedModel);
+				// edited in place, the model map itself does not change while iterating
+				Model* model = mScene.getModel(handle);
+
+				bool isModelSelected = (handle == selectedModel);
 
 				ImGui::PushID(("##Model" + modID).c_str());
 
@@ -804,7 +1649,7 @@ namespace ntr
 				
 				if (currModelResult.shouldSelect)
 				{
-					selectedModel = model;
+					selectedModel = handle;
 					selectedModelResult = currModelResult;
 				}
 
@@ -814,6 +1659,10 @@ namespace ntr
 					static MeshInstance* selectedModMesh = nullptr;
 					Gui::EditableTreeNodeResult selectedModMeshResult;
 
+					// the references of the model are updated once after the loops, as that may release meshes and
+					// materials the combos iterate over
+					bool meshesChanged = false;
+
 					ImGui::Indent();
 
 					auto& meshes = model->meshes;
@@ -843,26 +1692,26 @@ namespace ntr
 
 							if (ImGui::TreeNode(("Mesh##" + std::to_string(++meshHeaderID)).c_str()))
 							{
-								if (ImGui::BeginCombo("##MeshData", mScene.findMeshID(modMesh).c_str()))
+								if (ImGui::BeginCombo("##MeshData", mScene.findMeshID(modMesh.mesh).c_str()))
 								{
 									bool noMeshSelected = true;
 
-									for (const auto& [name, mesh] : meshMap)
+									for (const auto& [name, meshHandle, mesh] : meshMap)
 									{
-										const bool IS_SELECTED = (mesh->vao() == modMesh.vao);
+										const bool IS_SELECTED = (meshHandle == modMesh.mesh);
 
 										if (ImGui::Selectable(name.c_str(), IS_SELECTED))
 										{
-											mutModMesh.vao = mesh->vao();
-											mutModMesh.indexCount = mesh->indexCount();
+											mutModMesh.mesh = meshHandle;
+											meshesChanged = true;
 											noMeshSelected = false;
 										}
 									}
 
 									if (ImGui::Selectable("None", noMeshSelected))
 									{
-										mutModMesh.vao = Mesh::EMPTY->vao();
-										mutModMesh.indexCount = Mesh::EMPTY->indexCount();
+										mutModMesh.mesh = {};
+										meshesChanged = true;
 									}
 
 									ImGui::EndCombo(); // MeshData
@@ -875,9 +1724,17 @@ namespace ntr
 							{
 								MeshInstance& mutModMesh = model->meshes[modMeshID];
 
-								ImGui::DragFloat3("Position", &mutModMesh.transform.position.x, 0.1f);
-								ImGui::DragFloat3("Rotation", &mutModMesh.transform.rotation.x, 0.1f);
-								ImGui::DragFloat3("Scale", &mutModMesh.transform.scale.x, 0.1f);
+								bool changed = false;
+
+								changed |= ImGui::DragFloat3("Position", &mutModMesh.transform.position.x, 0.1f);
+								changed |= ImGui::DragFloat3("Rotation", &mutModMesh.transform.rotation.x, 0.1f);
+								changed |= ImGui::DragFloat3("Scale", &mutModMesh.transform.scale.x, 0.1f);
+
+								if (changed)
+								{
+									mutModMesh.updateMatrix();
+									meshesChanged = true;
+								}
 
 								ImGui::TreePop();
 							}
@@ -888,20 +1745,22 @@ namespace ntr
 								{
 									bool noMaterialSelected = true;
 
-									for (const auto& [name, material] : materialMap)
+									for (const auto& [name, materialHandle, material] : materialMap)
 									{
-										const bool IS_SELECTED = (material == modMesh.material);
+										const bool IS_SELECTED = (materialHandle == modMesh.material);
 
 										if (ImGui::Selectable(name.c_str(), IS_SELECTED))
 										{
-											mutModMesh.material = material;
+											mutModMesh.material = materialHandle;
+											meshesChanged = true;
 											noMaterialSelected = false;
 										}
 									}
 
 									if (ImGui::Selectable("None", noMaterialSelected))
 									{
-										mutModMesh.material = mScene.getDefaultMaterial();
+										mutModMesh.material = {};
+										meshesChanged = true;
 									}
 
 									ImGui::EndCombo(); // Material
@@ -918,11 +1777,7 @@ namespace ntr
 					{
 						static unsigned int meshNum = 0;
 
-						model->meshes.try_emplace(
-							"Mesh " + std::to_string(++meshNum),
-							Mesh::EMPTY,
-							mScene.getDefaultMaterial()
-						);
+						model->meshes.try_emplace("Mesh " + std::to_string(++meshNum));
 					}
 
 					ImGui::Unindent(); // CurrModel
@@ -961,6 +1816,12 @@ namespace ntr
 						selectedModMeshID = "None";
 						showModelRenameError = false;
 						duplicateModMeshID = "";
+						meshesChanged = true;
+					}
+
+					if (meshesChanged)
+					{
+						mScene.markModelChanged(handle);
 					}
 
 					if (showModMeshRenameError)
@@ -970,18 +1831,17 @@ namespace ntr
 				}
 			}
 
-			if (selectedModelResult.shouldDelete && selectedModel != Model::EMPTY)
+			if (selectedModelResult.shouldDelete && selectedModel)
 			{
-				mScene.removeModel(mScene.findModelID(selectedModel));
-				selectedModel = Model::EMPTY;
+				mScene.removeModel(selectedModel);
+				selectedModel = {};
 				showModelRenameError = false;
 				duplicateModelID = "";
 			}
-			else if (selectedModelResult.shouldRename && selectedModel != Model::EMPTY)
+			else if (selectedModelResult.shouldRename && selectedModel)
 			{
-				if (mScene.findModel(selectedModelResult.newName) == Model::EMPTY)
+				if (mScene.renameModel(selectedModel, selectedModelResult.newName))
 				{
-					mScene.replaceModelID(mScene.findModelID(selectedModel), selectedModelResult.newName);
 					showModelRenameError = false;
 					duplicateModelID = "";
 				}
@@ -994,7 +1854,7 @@ namespace ntr
 			// Deselect if clicked outside
 			else if (ImGui::IsMouseClicked(0) && !ImGui::IsItemHovered())
 			{
-				selectedModel = Model::EMPTY;
+				selectedModel = {};
 				showModelRenameError = false;
 				duplicateModelID = "";
 			}
@@ -1020,7 +1880,7 @@ namespace ntr
 			if ( ( ImGui::InputTextWithHint("##text", "Add Material...", textBuffer, sizeof(textBuffer), ImGuiInputTextFlags_EnterReturnsTrue) || (ImGui::SameLine(), ImGui::Button("Enter")) )
 				&& textBuffer[0] != '\0')
 			{
-				if (mScene.findMaterial(textBuffer) == Material::EMPTY)
+				if (!mScene.findMaterial(textBuffer))
 				{
 					mScene.addMaterial(textBuffer, {});
 					textBuffer[0] = '\0';
@@ -1039,26 +1899,27 @@ namespace ntr
 				showRenameError = false;
 			}
 
-			static Material* selectedMaterial = Material::EMPTY;
+			static MaterialHandle selectedMaterial = {};
 
 			Gui::EditableTreeNodeResult selectedResult;
 
-			const auto& textureMap = mScene.getTextureMap();
-			const auto& MATERIAL_MAP = mScene.getMaterialMap();
-
-			const Material* const defaultMaterial = mScene.getDefaultMaterial();
+			const auto& TEXTURES = mScene.getTextures();
+			const auto& MATERIAL_MAP = mScene.getMaterials();
 
 			size_t numMaterials = MATERIAL_MAP.size();
 
-			for (auto& [matID, material] : MATERIAL_MAP)
+			for (const auto& [matID, handle, constMaterial] : MATERIAL_MAP)
 			{
-				bool isSelected = material == selectedMaterial;
+				// edited in place, the material map itself does not change while iterating
+				Material* material = mScene.getMaterial(handle);
+
+				bool isSelected = handle == selectedMaterial;
 
 				auto currResult = Gui::EditableTreeNode(matID.c_str(), isSelected);
 
 				if (currResult.shouldSelect)
 				{
-					selectedMaterial = material;
+					selectedMaterial = handle;
 					selectedResult = currResult;
 				}
 
@@ -1068,24 +1929,28 @@ namespace ntr
 
 					ImGui::Indent();
 
+					bool mapsChanged = false;
+
 					if (ImGui::BeginCombo(("Albedo##" + matID).c_str(), mScene.findTextureID(material->albedo).c_str()))
 					{
 						bool noneSelected = true;
 
-						for (const auto& [texID, texture] : textureMap)
+						for (const auto& [texID, texHandle, texture] : TEXTURES)
 						{
-							const bool IS_SELECTED = (texture.handle() == material->albedo);
+							const bool IS_SELECTED = (texHandle == material->albedo);
 
 							if (ImGui::Selectable(texID.c_str(), IS_SELECTED))
 							{
-								material->albedo = texture.handle();
+								material->albedo = texHandle;
+								mapsChanged = true;
 								noneSelected = false;
 							}
 						}
 
 						if (ImGui::Selectable(("None##" + matID).c_str(), noneSelected))
 						{
-							material->albedo = defaultMaterial->albedo;
+							material->albedo = {};
+							mapsChanged = true;
 						}
 
 						ImGui::EndCombo();
@@ -1095,20 +1960,22 @@ namespace ntr
 					{
 						bool noneSelected = true;
 
-						for (const auto& [texID, texture] : textureMap)
+						for (const auto& [texID, texHandle, texture] : TEXTURES)
 						{
-							const bool IS_SELECTED = (texture.handle() == material->normal);
+							const bool IS_SELECTED = (texHandle == material->normal);
 
 							if (ImGui::Selectable(texID.c_str(), IS_SELECTED))
 							{
-								material->normal = texture.handle();
+								material->normal = texHandle;
+								mapsChanged = true;
 								noneSelected = false;
 							}
 						}
 
 						if (ImGui::Selectable(("None##" + matID).c_str(), noneSelected))
 						{
-							material->normal = defaultMaterial->normal;
+							material->normal = {};
+							mapsChanged = true;
 						}
 
 						ImGui::EndCombo();
@@ -1118,20 +1985,22 @@ namespace ntr
 					{
 						bool noneSelected = true;
 
-						for (const auto& [texID, texture] : textureMap)
+						for (const auto& [texID, texHandle, texture] : TEXTURES)
 						{
-							const bool IS_SELECTED = (texture.handle() == material->roughness);
+							const bool IS_SELECTED = (texHandle == material->roughness);
 
 							if (ImGui::Selectable(texID.c_str(), IS_SELECTED))
 							{
-								material->roughness = texture.handle();
+								material->roughness = texHandle;
+								mapsChanged = true;
 								noneSelected = false;
 							}
 						}
 
 						if (ImGui::Selectable(("None##" + matID).c_str(), noneSelected))
 						{
-							material->roughness = defaultMaterial->roughness;
+							material->roughness = {};
+							mapsChanged = true;
 						}
 
 						ImGui::EndCombo();
@@ -1141,20 +2010,22 @@ namespace ntr
 					{
 						bool noneSelected = true;
 
-						for (const auto& [texID, texture] : textureMap)
+						for (const auto& [texID, texHandle, texture] : TEXTURES)
 						{
-							const bool IS_SELECTED = (texture.handle() == material->metallic);
+							const bool IS_SELECTED = (texHandle == material->metallic);
 
 							if (ImGui::Selectable(texID.c_str(), IS_SELECTED))
 							{
-								material->metallic = texture.handle();
+								material->metallic = texHandle;
+								mapsChanged = true;
 								noneSelected = false;
 							}
 						}
 
 						if (ImGui::Selectable(("None##" + matID).c_str(), noneSelected))
 						{
-							material->metallic = defaultMaterial->metallic;
+							material->metallic = {};
+							mapsChanged = true;
 						}
 
 						ImGui::EndCombo();
@@ -1164,25 +2035,40 @@ namespace ntr
 					{
 						bool noneSelected = true;
 
-						for (const auto& [texID, texture] : textureMap)
+						for (const auto& [texID, texHandle, texture] : TEXTURES)
 						{
-							const bool IS_SELECTED = (texture.handle() == material->occlusion);
+							const bool IS_SELECTED = (texHandle == material->occlusion);
 
 							if (ImGui::Selectable(texID.c_str(), IS_SELECTED))
 							{
-								material->occlusion = texture.handle();
+								material->occlusion = texHandle;
+								mapsChanged = true;
 								noneSelected = false;
 							}
 						}
 
 						if (ImGui::Selectable(("None##" + matID).c_str(), noneSelected))
 						{
-							material->occlusion = defaultMaterial->occlusion;
+							material->occlusion = {};
+							mapsChanged = true;
 						}
 
 						ImGui::EndCombo();
 					}
 
+					// Constant factors, scaling the map when one is assigned
+
+					ImGui::ColorEdit4(("Base color##" + matID).c_str(), &material->baseColorFactor.x);
+					ImGui::SliderFloat(("Roughness factor##" + matID).c_str(), &material->roughnessFactor, 0.0f, 1.0f);
+					ImGui::SliderFloat(("Metallic factor##" + matID).c_str(), &material->metallicFactor, 0.0f, 1.0f);
+					ImGui::SliderFloat(("Occlusion strength##" + matID).c_str(), &material->occlusionStrength, 0.0f, 1.0f);
+					ImGui::SliderFloat(("Normal scale##" + matID).c_str(), &material->normalScale, 0.0f, 2.0f);
+
+					if (mapsChanged)
+					{
+						mScene.markMaterialChanged(handle);
+					}
+
 					ImGui::Unindent();
 				}
 			}
@@ -1190,14 +2076,13 @@ namespace ntr
 			// Deselect if clicked outside
 			if (ImGui::IsMouseClicked(0) && !ImGui::IsItemHovered())
 			{
-				selectedMaterial = Material::EMPTY;
+				selectedMaterial = {};
 				showRenameError = false;
 			}
-			else if (selectedResult.shouldRename && selectedMaterial != Material::EMPTY)
+			else if (selectedResult.shouldRename && selectedMaterial)
 			{
-				if (mScene.findMaterial(selectedResult.newName) == Material::EMPTY)
+				if (mScene.renameMaterial(selectedMaterial, selectedResult.newName))
 				{
-					mScene.replaceMaterialID(mScene.findMaterialID(selectedMaterial), selectedResult.newName);
 					showRenameError = false;
 				}
 				else
@@ -1207,10 +2092,10 @@ namespace ntr
 					
 				}
 			}
-			else if (selectedResult.shouldDelete && selectedMaterial != Material::EMPTY)
+			else if (selectedResult.shouldDelete && selectedMaterial)
 			{
-				mScene.removeMaterial(mScene.findMaterialID(selectedMaterial));
-				selectedMaterial = Material::EMPTY;
+				mScene.removeMaterial(selectedMaterial);
+				selectedMaterial = {};
 				showRenameError = false;
 			}
 
@@ -1246,6 +2131,87 @@ namespace ntr
 			mScene.directionalLight.direction.z = std::clamp<float>(mScene.directionalLight.direction.z, -1.0f, 1.0f);
 		}
 
+		// RENDERER
+
+		if (ImGui::CollapsingHeader("Renderer"))
+		{
+			const char* RENDER_PATH_NAMES[] = { "Forward", "Deferred" };
+
+			ImGui::Text("Path     ");
+			ImGui::SameLine();
+
+			if (ImGui::BeginCombo("##RenderPath", RENDER_PATH_NAMES[mScene.renderPath]))
+			{
+				for (int i = 0; i < 2; ++i)
+				{
+					if (ImGui::Selectable(RENDER_PATH_NAMES[i], mScene.renderPath == i))
+					{
+						mScene.renderPath = static_cast<RenderPath>(i);
+					}
+				}
+
+				ImGui::EndCombo();
+			}
+
+			ImGui::Text("Forward  %.3f ms", mAverageFrameTimeMs[RenderPath::FORWARD]);
+			ImGui::Text("Deferred %.3f ms", mAverageFrameTimeMs[RenderPath::DEFERRED]);
+
+			int frameRateLimit = (int)mFramePacer.targetRate();
+
+			if (ImGui::SliderInt("Frame rate limit", &frameRateLimit, 0, 240, frameRateLimit == 0 ? "Off" : "%d"))
+			{
+				mFramePacer.setTargetRate(frameRateLimit);
+			}
+
+			const FramePacerStats PACING = mFramePacer.stats();
+
+			ImGui::Text("Frame time %.3f ms, jitter %.3f ms, worst %.3f ms", PACING.averageMs, PACING.jitterMs, PACING.worstMs);
+			ImGui::Text("Missed frames: %zu, sleep overshoot %.3f ms", PACING.missedFrames, PACING.sleepErrorMs);
+			ImGui::Text("Point lights: %zu", mFrameResults.pointLights);
+			ImGui::Text("Shader variants: %zu", mFrameResults.shaderVariants);
+
+			const GLStateCounters& GL_CALLS = mFrameResults.counters;
+
+			ImGui::Text("GL state calls: %zu issued, %zu filtered", GL_CALLS.issued, GL_CALLS.filtered);
+			ImGui::Text("Draw calls: %zu", GL_CALLS.draws);
+
+			size_t textureBytes = 0;
+
+			for (const RenderResults::TextureResidency& texture : mFrameResults.textures)
+			{
+				textureBytes += texture.sizeBytes;
+			}
+
+			const float MB = 1024.0f * 1024.0f;
+
+			ImGui::Text("Texture memory: %.1f MB", textureBytes / MB);
+
+			int budgetMB = (int)(mTextureBudgetBytes / (size_t)MB);
+
+			if (ImGui::SliderInt("Streaming budget (MB)", &budgetMB, 16, 4096))
+			{
+				mTextureBudgetBytes = (size_t)budgetMB * (size_t)MB;
+			}
+
+			ImGui::Text("Streaming loads in flight: %zu", mFrameResults.textureLoadsInFlight);
+
+			if (ImGui::TreeNode("Texture residency"))
+			{
+				for (const RenderResults::TextureResidency& texture : mFrameResults.textures)
+				{
+					const int LEVEL = texture.residentLevel;
+
+					ImGui::Text("%s: %dx%d of %dx%d (%.2f MB)", texture.id.c_str(),
+						std::max(1, texture.width >> LEVEL), std::max(1, texture.height >> LEVEL),
+						texture.width, texture.height, texture.sizeBytes / MB);
+				}
+
+				ImGui::TreePop();
+			}
+
+			ImGui::Checkbox("Shadows", &mScene.shadowsEnabled);
+		}
+
 		// CAMERA
 
 		if (ImGui::CollapsingHeader("Camera"))
@@ -1316,21 +2282,8 @@ namespace ntr
 			}
 			else if (selectedResult.shouldRename && entitySelected != entt::null)
 			{
-				for (auto [entity, id] : entityView.each())
-				{
-					if (id.str == selectedResult.newName)
-					{
-						showRenameError = true;
-						duplicateID = selectedResult.newName;
-						break;
-					}
-				}
-
-				if (!showRenameError)
-				{
-					StringID& id = mScene.registry.get<StringID>(entitySelected);
-					id.str = selectedResult.newName;
-				}
+				showRenameError = !mScene.renameEntity(entitySelected, selectedResult.newName);
+				duplicateID = selectedResult.newName;
 			}
 
 			if (showRenameError)
@@ -1341,103 +2294,149 @@ namespace ntr
 		
 		if (entitySelected != entt::null)
 		{
-			auto& model = mScene.registry.get<ConstPointer<Model>>(entitySelected);
-			auto& transform = mScene.registry.get<Transform>(entitySelected);
+			// PROPERTIES TAB
 
-			// STENCIL OUTLINE RENDER
+			if (ImGui::CollapsingHeader("Properties"))
+			{
+				// render Transform section
 
-			// Save original state before modifying
-			GLboolean depthTestEnabled = glIsEnabled(GL_DEPTH_TEST);
-			GLboolean cullFaceEnabled = glIsEnabled(GL_CULL_FACE);
+				if (auto* transform = mScene.registry.try_get<Transform>(entitySelected))
+				{
+					if (ImGui::TreeNode("Transform"))
+					{
+						bool changed = false;
 
-			glDisable(GL_DEPTH_TEST);
-			glDisable(GL_CULL_FACE);
+						ImGui::Text("Position");
+						ImGui::SameLine();
+						changed |= ImGui::DragFloat3("##Position", &transform->position.x, 0.1f);
 
-			// draw borders of selected entity
-			glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
-			glStencilMask(0x00);
+						ImGui::Text("Rotation");
+						ImGui::SameLine();
+						changed |= ImGui::DragFloat3("##Rotation", &transform->rotation.x, 0.1f);
 
-			mShaderStencil.use();
+						ImGui::Text("Scale   ");
+						ImGui::SameLine();
+						changed |= ImGui::DragFloat3("##Scale", &transform->scale.x, 0.1f);
 
-			mShaderStencil.setMat4("view", mScene.selectedCamera.view());
-			mShaderStencil.setMat4("projection", mScene.selectedCamera.projection());
-			mShaderStencil.setFloat("outlineThickness", 50.0f);
+						// refreshes the cached WorldMatrix
+						if (changed)
+						{
+							mScene.registry.patch<Transform>(entitySelected);
+						}
 
-			glm::mat4 modelMatrix = transform.matrix();
+						// the transform above is relative to the parent
 
-			const auto& meshes = model->meshes;
+						const entt::entity PARENT = mScene.getParent(entitySelected);
+						const StringID* parentID = PARENT != entt::null ? mScene.registry.try_get<StringID>(PARENT) : nullptr;
 
-			for (const auto& [id, mesh] : meshes)
-			{
+						ImGui::Text("Parent  ");
+						ImGui::SameLine();
 
-				mShaderStencil.setMat4("model", modelMatrix * mesh.transform.matrix());
-				
-				mShaderStencil.draw(mesh);
-			}
+						if (ImGui::BeginCombo("##Parent", parentID ? parentID->str.c_str() : "None"))
+						{
+							if (ImGui::Selectable("None", PARENT == entt::null))
+							{
+								mScene.setParent(entitySelected, entt::null);
+							}
 
-			glStencilMask(0xFF);
-			glStencilFunc(GL_ALWAYS, 0, 0xFF);
+							for (auto [entity, id, entityTransform] : mScene.registry.view<StringID, Transform>().each())
+							{
+								if (entity != entitySelected && ImGui::Selectable(id.str.c_str(), entity == PARENT))
+								{
+									if (!mScene.setParent(entitySelected, entity))
+									{
+										std::cerr << "ERROR: '" << id.str << "' is a child of the selected entity and can't be its parent" << std::endl;
+									}
+								}
+							}
 
-			// Restore original state 
-			if (depthTestEnabled) { glEnable(GL_DEPTH_TEST); }
-			if (cullFaceEnabled) { glEnable(GL_CULL_FACE); }
+							ImGui::EndCombo();
+						}
 
-			// PROPERTIES TAB
+						ImGui::TreePop();
+					}
+				}
 
-			if (ImGui::CollapsingHeader("Properties"))
-			{
-				// render Transform section
+				// render Model section
 
-				if (ImGui::TreeNode("Transform"))
+				if (auto* modelComponent = mScene.registry.try_get<ModelHandle>(entitySelected))
 				{
-					ImGui::Text("Position");
-					ImGui::SameLine();
-					ImGui::DragFloat3("##Position", &transform.position.x, 0.1f);
+					auto& model = *modelComponent;
+
+					if (ImGui::TreeNode("Model"))
+					{
+						if (ImGui::BeginCombo("##model", mScene.findModelID(model).c_str()))
+						{
+							const auto& MODEL_MAP = mScene.getModels();
+							bool noneSelected = true;
+
+							for (const auto& [id, handle, curr_model] : MODEL_MAP)
+							{
+								const bool IS_SELECTED = (handle == model);
+
+								if (ImGui::Selectable(id.c_str(), IS_SELECTED))
+								{
+									model = handle;
+									mScene.registry.patch<ModelHandle>(entitySelected);
+									noneSelected = false;
+								}
+							}
 
-					ImGui::Text("Rotation");
-					ImGui::SameLine();
-					ImGui::DragFloat3("##Rotation", &transform.rotation.x, 0.1f);
+							if (ImGui::Selectable("None", noneSelected))
+							{
+								model = {};
+								mScene.registry.patch<ModelHandle>(entitySelected);
+							}
 
-					ImGui::Text("Scale   ");
-					ImGui::SameLine();
-					ImGui::DragFloat3("##Scale", &transform.scale.x, 0.1f);
+							ImGui::EndCombo();
+						}
 
-					ImGui::TreePop();
+						ImGui::TreePop();
+					}
 				}
 
-				// render Model section
+				// render Point Light section
 
-				if (ImGui::TreeNode("Model"))
+				if (auto* pointLight = mScene.registry.try_get<PointLight>(entitySelected))
 				{
-					if (ImGui::BeginCombo("##model", mScene.findModelID(model).c_str()))
+					if (ImGui::TreeNode("Point Light"))
 					{
-						const auto& MODEL_MAP = mScene.getModelMap();
-						bool noneSelected = true;
+						ImGui::Text("Position");
+						ImGui::SameLine();
+						ImGui::DragFloat3("##LightPosition", &pointLight->position.x, 0.1f);
 
-						for (const auto& [id, curr_model] : MODEL_MAP)
-						{
-							const bool IS_SELECTED = (curr_model == model);
+						ImGui::Text("Color   ");
+						ImGui::SameLine();
+						ImGui::DragFloat3("##LightColor", &pointLight->color.x, 0.1f);
 
-							if (ImGui::Selectable(id.c_str(), IS_SELECTED))
-							{
-								model = curr_model;
-								noneSelected = false;
-							}
-						}
+						pointLight->color.x = std::max(0.0f, pointLight->color.x);
+						pointLight->color.y = std::max(0.0f, pointLight->color.y);
+						pointLight->color.z = std::max(0.0f, pointLight->color.z);
 
-						if (ImGui::Selectable("None", noneSelected))
-						{
-							model = Model::EMPTY;
-						}
+						ImGui::Text("Radius  ");
+						ImGui::SameLine();
+						ImGui::DragFloat("##LightRadius", &pointLight->radius, 0.1f);
 
-						ImGui::EndCombo();
-					}
+						pointLight->radius = std::max(0.01f, pointLight->radius);
 
-					ImGui::TreePop();
+						ImGui::TreePop();
+					}
 				}
 			}
 		}
 
+		// a click in the viewport selects the entity under the cursor, or nothing
+		if (mPickRequested)
+		{
+			if (entitySelected != entt::null)
+			{
+				entityDeselected = entitySelected;
+			}
+
+			entitySelected = mPickedEntity;
+			mPickRequested = false;
+		}
+
 		// Process selected/deselected entity
 		if (entityDeselected != entt::null)
 		{
@@ -1452,6 +2451,131 @@ namespace ntr
 		ImGui::End();
 	}
 
+	void App::renderProfilerWindow()
+	{
+		ImGui::SetNextWindowSize(ImVec2(420, 0), ImGuiCond_FirstUseEver);
+		ImGui::Begin("GPU Profiler", &mProfilerOpen);
+
+		ImGui::Checkbox("Enabled", &mGpuProfilerEnabled);
+		ImGui::SameLine();
+		ImGui::Text("Dropped frames: %zu", mFrameResults.droppedGpuFrames);
+
+		for (const auto& pass : mFrameResults.passes)
+		{
+			ImGui::Separator();
+			ImGui::Text("%s", pass.name.c_str());
+			ImGui::Text("min %.3f ms  avg %.3f ms  p99 %.3f ms", pass.minMs, pass.avgMs, pass.p99Ms);
+
+			// graphs share a scale so passes can be compared at a glance
+			ImGui::PlotLines(("##" + pass.name).c_str(), pass.historyMs.data(), (int)pass.historyCount, (int)pass.historyOffset,
+				nullptr, 0.0f, std::max(pass.p99Ms * 1.5f, 1.0f), ImVec2(-1, 40));
+		}
+
+		ImGui::End();
+	}
+
+	void App::renderStressWindow()
+	{
+		static int entityCount = 10000;
+		static int pointLightCount = 0;
+		static int materialVariants = 16;
+		static int seed = 1;
+		static int maxEntities = 100000;
+
+		ImGui::SetNextWindowSize(ImVec2(420, 0), ImGuiCond_FirstUseEver);
+		ImGui::Begin("Stress Test", &mStressOpen);
+
+		ImGui::InputInt("Entities", &entityCount, 1000, 10000);
+		ImGui::InputInt("Point lights", &pointLightCount, 16, 256);
+		ImGui::InputInt("Material variants", &materialVariants);
+		ImGui::InputInt("Seed", &seed);
+
+		entityCount = std::clamp(entityCount, 0, 1000000);
+		pointLightCount = std::max(pointLightCount, 0);
+		materialVariants = std::clamp(materialVariants, 1, 1024);
+
+		StressSceneSettings settings;
+		settings.entityCount = (size_t)entityCount;
+		settings.pointLightCount = (size_t)pointLightCount;
+		settings.materialVariants = (size_t)materialVariants;
+		settings.seed = (uint32_t)seed;
+
+		// the sweep owns the stress scene while it runs
+		if (!mStressSweep.active())
+		{
+			if (ImGui::Button("Spawn"))
+			{
+				StressScene::spawn(mScene, settings);
+			}
+
+			ImGui::SameLine();
+
+			if (ImGui::Button("Clear"))
+			{
+				StressScene::clear(mScene);
+			}
+		}
+
+		const size_t ENTITIES = StressScene::entityCount(mScene);
+
+		ImGui::Text("Stress entities: %zu", ENTITIES);
+		ImGui::Text("Registry memory: %.1f MB", StressScene::registryBytes(mScene) / (1024.0f * 1024.0f));
+
+		ImGui::Separator();
+		ImGui::InputInt("Sweep up to", &maxEntities, 10000, 100000);
+
+		maxEntities = std::clamp(maxEntities, 1000, 1000000);
+
+		if (!mStressSweep.active())
+		{
+			if (ImGui::Button("Run sweep"))
+			{
+				mStressSweep.start(settings, (size_t)maxEntities);
+			}
+		}
+		else if (ImGui::Button("Stop sweep"))
+		{
+			mStressSweep.stop();
+		}
+
+		const std::vector<StressSweep::Sample>& SAMPLES = mStressSweep.samples();
+
+		if (!SAMPLES.empty())
+		{
+			ImGui::SameLine();
+
+			if (ImGui::Button("Save CSV"))
+			{
+				mStressSweep.writeCsv("stress_sweep.csv");
+			}
+
+			// steps grow geometrically, so the curves are plotted over the step index
+			std::vector<float> frameMs, drawCalls, bytesPerEntity;
+
+			for (const StressSweep::Sample& sample : SAMPLES)
+			{
+				ImGui::Text("%8zu entities  spawn %8.2f ms  frame %7.2f ms  %6.0f draws  %5.1f B/entity",
+					sample.entities, sample.spawnMs, sample.frameMs, sample.drawCalls, sample.bytesPerEntity);
+
+				frameMs.push_back(sample.frameMs);
+				drawCalls.push_back(sample.drawCalls);
+				bytesPerEntity.push_back(sample.bytesPerEntity);
+			}
+
+			auto plot = [](const char* label, const std::vector<float>& values)
+			{
+				ImGui::PlotLines(label, values.data(), (int)values.size(), 0, nullptr,
+					0.0f, std::max(*std::max_element(values.begin(), values.end()) * 1.1f, 1.0f), ImVec2(0, 60));
+			};
+
+			plot("Frame ms", frameMs);
+			plot("Draw calls", drawCalls);
+			plot("Bytes/entity", bytesPerEntity);
+		}
+
+		ImGui::End();
+	}
+
 	void App::renderDebugQuad()
 	{
 		static GLuint quadVAO = 0;
@@ -1472,27 +2596,28 @@ namespace ntr
 				 1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
 			};
 			// setup plane VAO
-			glGenVertexArrays(1, &quadVAO);
-			glGenBuffers(1, &quadVBO);
-			glBindVertexArray(quadVAO);
-			glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-			glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-			glEnableVertexAttribArray(0);
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-			glEnableVertexAttribArray(1);
-			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-		}
-
-		glViewport(
+			glCreateBuffers(1, &quadVBO);
+			glNamedBufferStorage(quadVBO, sizeof(quadVertices), &quadVertices, 0);
+
+			glCreateVertexArrays(1, &quadVAO);
+			glVertexArrayVertexBuffer(quadVAO, 0, quadVBO, 0, 5 * sizeof(float));
+			glEnableVertexArrayAttrib(quadVAO, 0);
+			glVertexArrayAttribFormat(quadVAO, 0, 3, GL_FLOAT, GL_FALSE, 0);
+			glVertexArrayAttribBinding(quadVAO, 0, 0);
+			glEnableVertexArrayAttrib(quadVAO, 1);
+			glVertexArrayAttribFormat(quadVAO, 1, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float));
+			glVertexArrayAttribBinding(quadVAO, 1, 0);
+		}
+
+		GLState::viewport(
 			(GLint)mScene.selectedCamera.viewport.x, 
 			(GLint)mScene.selectedCamera.viewport.y,
 			(GLsizei)(mScene.selectedCamera.viewport.width / 5), 
 			(GLsizei)(mScene.selectedCamera.viewport.height / 5)
 		);
 		
-		glBindVertexArray(quadVAO);
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-		glBindVertexArray(0);
+		GLState::bindVertexArray(quadVAO);
+		GLState::drawArrays(GL_TRIANGLE_STRIP, 0, 4);
 		
 		setViewport(mScene.selectedCamera.viewport);
 	}
@@ -2,25 +2,24 @@
 #define NTR_ARRAY_BUFFER_HPP
 
 #include "ArrayBuffer.h"
+#include "GLState.h"
 
 namespace ntr
 {
 	template<typename T>
-	inline ArrayBuffer<T>::ArrayBuffer(size_t size, const T* data, GLuint binding, GLenum usage)
+	inline ArrayBuffer<T>::ArrayBuffer(size_t size, const T* data, GLuint binding)
 		: mSize{ size }
 		, binding{ binding }
 	{
-		glGenBuffers(1, &mID);
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, mID);
-		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(T) * size, data, usage);
-		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, mID);
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		glCreateBuffers(1, &mID);
+		glNamedBufferStorage(mID, sizeof(T) * size, data, GL_DYNAMIC_STORAGE_BIT);
+		GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, mID);
 	}
 	
 	template<typename T>
 	inline ArrayBuffer<T>::~ArrayBuffer()
 	{
-		glDeleteBuffers(1, &mID);
+		GLState::deleteBuffers(1, &mID);
 	}
 
 	template<typename T>
@@ -32,28 +31,35 @@ namespace ntr
 	template<typename T>
 	inline void ArrayBuffer<T>::bind() const
 	{
-		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, mID);
+		GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, mID);
 	}
 	
 	template<typename T>
-	inline void ArrayBuffer<T>::unbind() const
+	inline void ArrayBuffer<T>::resize(size_t size)
 	{
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		mSize = size;
+
+		// immutable storage can't be reallocated, replace the buffer instead
+		GLState::deleteBuffers(1, &mID);
+
+		glCreateBuffers(1, &mID);
+		glNamedBufferStorage(mID, sizeof(T) * size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+		GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, mID);
 	}
-	
+
 	template<typename T>
 	inline void ArrayBuffer<T>::update(size_t start, size_t end, const T* data)
 	{
 		GLintptr	offset	= sizeof(T) * start;
 		GLsizeiptr	size	= sizeof(T) * (end - start);
 
-		glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, size, data);
+		glNamedBufferSubData(mID, offset, size, data);
 	}
 
 	template<typename T>
 	inline void ArrayBuffer<T>::update(size_t index, const T& data)
 	{
-		glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(T) * index, sizeof(T), &data);
+		glNamedBufferSubData(mID, sizeof(T) * index, sizeof(T), &data);
 	}
 }
 
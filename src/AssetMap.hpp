@@ -0,0 +1,208 @@
+#ifndef NTR_ASSET_MAP_HPP
+#define NTR_ASSET_MAP_HPP
+
+#include <utility>
+
+#include "AssetMap.h"
+
+namespace ntr
+{
+	//#################################################################################################
+	//
+	// ITERATOR IMPLEMENTATION
+	//
+	//#################################################################################################
+
+	template <typename T>
+	template <typename Map, typename Value>
+	inline AssetMap<T>::Iterator<Map, Value>::Iterator(Map& map, size_t index)
+		: mMap{ map }
+		, mIndex{ index }
+	{
+	}
+
+	template <typename T>
+	template <typename Map, typename Value>
+	inline typename AssetMap<T>::template Entry<Value> AssetMap<T>::Iterator<Map, Value>::operator*() const
+	{
+		return { mMap.mIDs[mIndex], mMap.mAssets.handleAt(mIndex), mMap.mAssets[mIndex] };
+	}
+
+	template <typename T>
+	template <typename Map, typename Value>
+	inline typename AssetMap<T>::template Iterator<Map, Value>& AssetMap<T>::Iterator<Map, Value>::operator++()
+	{
+		++mIndex;
+		return *this;
+	}
+
+	template <typename T>
+	template <typename Map, typename Value>
+	inline bool AssetMap<T>::Iterator<Map, Value>::operator!=(const Iterator& itr) const
+	{
+		return mIndex != itr.mIndex;
+	}
+
+	//#################################################################################################
+	//
+	// ASSET MAP IMPLEMENTATION
+	//
+	//#################################################################################################
+
+	template <typename T>
+	inline Handle<T> AssetMap<T>::add(const std::string& id, T&& asset)
+	{
+		if (contains(id))
+		{
+			return {};
+		}
+
+		const Handle<T> HANDLE = mAssets.emplace(std::move(asset));
+
+		if (HANDLE)
+		{
+			mIDs.push_back(id);
+			mHandles.emplace(id, HANDLE);
+		}
+
+		return HANDLE;
+	}
+
+	template <typename T>
+	inline Handle<T> AssetMap<T>::find(const std::string& id) const
+	{
+		auto itr = mHandles.find(id);
+
+		if (itr == mHandles.end())
+		{
+			return {};
+		}
+
+		return itr->second;
+	}
+
+	template <typename T>
+	inline bool AssetMap<T>::contains(const std::string& id) const
+	{
+		return mHandles.find(id) != mHandles.end();
+	}
+
+	template <typename T>
+	inline T* AssetMap<T>::get(Handle<T> handle)
+	{
+		return mAssets.get(handle);
+	}
+
+	template <typename T>
+	inline const T* AssetMap<T>::get(Handle<T> handle) const
+	{
+		return mAssets.get(handle);
+	}
+
+	template <typename T>
+	inline const std::string* AssetMap<T>::findID(Handle<T> handle) const
+	{
+		const size_t INDEX = mAssets.indexOf(handle);
+
+		return INDEX != SlotMap<T>::NPOS ? &mIDs[INDEX] : nullptr;
+	}
+
+	template <typename T>
+	inline std::string AssetMap<T>::getUniqueID(const std::string& id) const
+	{
+		std::string idToUse = id;
+
+		while (contains(idToUse))
+		{
+			idToUse += "+";
+		}
+
+		return idToUse;
+	}
+
+	template <typename T>
+	inline bool AssetMap<T>::rename(Handle<T> handle, const std::string& id)
+	{
+		const size_t INDEX = mAssets.indexOf(handle);
+
+		if (INDEX == SlotMap<T>::NPOS)
+		{
+			return false;
+		}
+
+		if (mIDs[INDEX] == id)
+		{
+			return true;
+		}
+
+		if (contains(id))
+		{
+			return false;
+		}
+
+		mHandles.erase(mIDs[INDEX]);
+		mHandles.emplace(id, handle);
+		mIDs[INDEX] = id;
+
+		return true;
+	}
+
+	template <typename T>
+	inline bool AssetMap<T>::remove(Handle<T> handle)
+	{
+		const size_t INDEX = mAssets.indexOf(handle);
+
+		if (INDEX == SlotMap<T>::NPOS)
+		{
+			return false;
+		}
+
+		mHandles.erase(mIDs[INDEX]);
+
+		// same move of the last element into the gap as the slot map does
+		mIDs[INDEX] = std::move(mIDs.back());
+		mIDs.pop_back();
+
+		mAssets.erase(handle);
+
+		return true;
+	}
+
+	template <typename T>
+	inline size_t AssetMap<T>::indexOf(Handle<T> handle) const
+	{
+		return mAssets.indexOf(handle);
+	}
+
+	template <typename T>
+	inline size_t AssetMap<T>::size() const
+	{
+		return mAssets.size();
+	}
+
+	template <typename T>
+	inline typename AssetMap<T>::template Iterator<AssetMap<T>, T> AssetMap<T>::begin()
+	{
+		return { *this, 0 };
+	}
+
+	template <typename T>
+	inline typename AssetMap<T>::template Iterator<AssetMap<T>, T> AssetMap<T>::end()
+	{
+		return { *this, size() };
+	}
+
+	template <typename T>
+	inline typename AssetMap<T>::template Iterator<const AssetMap<T>, const T> AssetMap<T>::begin() const
+	{
+		return { *this, 0 };
+	}
+
+	template <typename T>
+	inline typename AssetMap<T>::template Iterator<const AssetMap<T>, const T> AssetMap<T>::end() const
+	{
+		return { *this, size() };
+	}
+} // namespace ntr
+
+#endif
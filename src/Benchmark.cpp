@@ -0,0 +1,386 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <glad/glad.h>
+
+#include "Benchmark.h"
+
+namespace ntr
+{
+	namespace
+	{
+		glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t)
+		{
+			const float T2 = t * t;
+			const float T3 = T2 * t;
+
+			return 0.5f * (2.0f * p1 + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * T2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * T3);
+		}
+
+		bool readVec3(std::istream& in, glm::vec3& v)
+		{
+			return (bool)(in >> v.x >> v.y >> v.z);
+		}
+
+		// Escapes text for a JSON string, e.g. the backslashes of Windows paths or quotes in GL_RENDERER.
+		std::string escapeJson(const std::string& text)
+		{
+			std::ostringstream escaped;
+
+			for (char c : text)
+			{
+				switch (c)
+				{
+				case '"':	escaped << "\\\""; break;
+				case '\\':	escaped << "\\\\"; break;
+				case '\b':	escaped << "\\b"; break;
+				case '\f':	escaped << "\\f"; break;
+				case '\n':	escaped << "\\n"; break;
+				case '\r':	escaped << "\\r"; break;
+				case '\t':	escaped << "\\t"; break;
+				default:
+					if ((unsigned char)c < 0x20)
+					{
+						escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)(unsigned char)c << std::dec << std::setfill(' ');
+					}
+					else
+					{
+						escaped << c;
+					}
+					break;
+				}
+			}
+
+			return escaped.str();
+		}
+	}
+
+	bool BenchmarkScript::load(const std::filesystem::path& scriptPath)
+	{
+		std::ifstream file(scriptPath);
+
+		if (!file)
+		{
+			std::cerr << "ERROR: could not open benchmark script: " << scriptPath << std::endl;
+			return false;
+		}
+
+		filepath = scriptPath;
+
+		std::string line;
+		size_t lineNumber = 0;
+
+		while (std::getline(file, line))
+		{
+			++lineNumber;
+
+			line = line.substr(0, line.find('#'));
+
+			std::istringstream in(line);
+			std::string keyword;
+
+			if (!(in >> keyword))
+			{
+				continue;
+			}
+
+			bool ok = true;
+
+			if (keyword == "resolution")
+			{
+				ok = (bool)(in >> width >> height) && width > 0 && height > 0;
+			}
+			else if (keyword == "frames")
+			{
+				ok = (bool)(in >> frames) && frames > 0;
+			}
+			else if (keyword == "warmup")
+			{
+				ok = (bool)(in >> warmupFrames);
+			}
+			else if (keyword == "renderpath")
+			{
+				std::string path;
+				ok = (bool)(in >> path) && (path == "forward" || path == "deferred");
+				renderPath = path == "deferred" ? RenderPath::DEFERRED : RenderPath::FORWARD;
+			}
+			else if (keyword == "shadows")
+			{
+				std::string state;
+				ok = (bool)(in >> state) && (state == "on" || state == "off");
+				shadows = state == "on";
+			}
+			else if (keyword == "model")
+			{
+				ModelEntry& model = models.emplace_back();
+				std::string path;
+				ok = (bool)(in >> model.id >> path);
+				model.filepath = path;
+			}
+			else if (keyword == "entity")
+			{
+				EntityEntry& entity = entities.emplace_back();
+				ok = (bool)(in >> entity.model) && readVec3(in, entity.transform.position);
+
+				// scale and rotation are optional
+				if (ok && readVec3(in, entity.transform.scale))
+				{
+					readVec3(in, entity.transform.rotation);
+				}
+			}
+			else if (keyword == "pointlight")
+			{
+				PointLight& light = pointLights.emplace_back();
+				ok = readVec3(in, light.position) && readVec3(in, light.color) && (bool)(in >> light.radius);
+			}
+			else if (keyword == "sun")
+			{
+				ok = readVec3(in, directionalLight.direction) && readVec3(in, directionalLight.color);
+			}
+			else if (keyword == "stress")
+			{
+				ok = (bool)(in >> stress.entityCount);
+
+				// light count and seed are optional
+				if (ok && in >> stress.pointLightCount)
+				{
+					in >> stress.seed;
+				}
+			}
+			else if (keyword == "camera")
+			{
+				CameraKey& key = cameraPath.emplace_back();
+				key.rotation = { 0.0f, 0.0f, 0.0f };
+				ok = readVec3(in, key.position) && (bool)(in >> key.rotation.x >> key.rotation.y);
+			}
+			else
+			{
+				ok = false;
+			}
+
+			if (!ok)
+			{
+				std::cerr << "ERROR: invalid statement in benchmark script " << scriptPath << ":" << lineNumber << ": " << line << std::endl;
+				return false;
+			}
+		}
+
+		if (cameraPath.empty())
+		{
+			std::cerr << "ERROR: benchmark script " << scriptPath << " has no camera keys" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	Benchmark::Benchmark(const BenchmarkScript& script, const std::filesystem::path& outputPath)
+		: mScript{ script }
+		, mOutputPath{ outputPath }
+		, mFrame{ 0 }
+		, mResultsWritten{ false }
+		, mFrameBegin{}
+		, mFrameTimesMs{}
+		, mDrawCalls{}
+		, mStateCallsIssued{}
+		, mPasses{}
+	{
+		mFrameTimesMs.reserve(mScript.frames);
+		mDrawCalls.reserve(mScript.frames);
+		mStateCallsIssued.reserve(mScript.frames);
+	}
+
+	const BenchmarkScript& Benchmark::script() const
+	{
+		return mScript;
+	}
+
+	bool Benchmark::finished() const
+	{
+		return mFrame >= mScript.warmupFrames + mScript.frames;
+	}
+
+	bool Benchmark::resultsWritten() const
+	{
+		return mResultsWritten;
+	}
+
+	void Benchmark::beginFrame(Camera& camera)
+	{
+		// warmup frames hold the first key, measured frames run the path from its first to its last key
+		const size_t MEASURED_FRAME = mFrame < mScript.warmupFrames ? 0 : mFrame - mScript.warmupFrames;
+		const float T = mScript.frames > 1 ? (float)MEASURED_FRAME / (float)(mScript.frames - 1) : 0.0f;
+
+		const BenchmarkScript::CameraKey POSE = getCameraPose(T);
+
+		camera.position = POSE.position;
+		camera.rotation = POSE.rotation;
+
+		mFrameBegin = std::chrono::steady_clock::now();
+	}
+
+	void Benchmark::endFrame(const GLStateCounters& counters, const std::vector<GpuProfiler::Pass>& passes)
+	{
+		const bool MEASURE = mFrame >= mScript.warmupFrames;
+
+		if (MEASURE)
+		{
+			const std::chrono::duration<float, std::milli> FRAME_TIME = std::chrono::steady_clock::now() - mFrameBegin;
+
+			mFrameTimesMs.push_back(FRAME_TIME.count());
+			mDrawCalls.push_back(counters.draws);
+			mStateCallsIssued.push_back(counters.issued);
+		}
+
+		// GPU results arrive a few frames late, the tail of the warmup is attributed to the measured frames
+		collectPassSamples(passes, MEASURE);
+
+		++mFrame;
+	}
+
+	bool Benchmark::finish(const std::vector<GpuProfiler::Pass>& passes)
+	{
+		collectPassSamples(passes, true);
+
+		std::ofstream file(mOutputPath);
+
+		if (!file)
+		{
+			std::cerr << "ERROR: could not write benchmark results: " << mOutputPath << std::endl;
+			return false;
+		}
+
+		std::vector<float> frameTimes = mFrameTimesMs;
+		std::sort(frameTimes.begin(), frameTimes.end());
+
+		auto average = [](const auto& values)
+			{
+				double sum = 0.0;
+
+				for (auto value : values)
+				{
+					sum += (double)value;
+				}
+
+				return values.empty() ? 0.0 : sum / values.size();
+			};
+
+		auto writeStats = [](std::ostream& out, const std::vector<float>& sorted, double avg)
+			{
+				out << "{\"min\":" << getPercentile(sorted, 0.0f)
+					<< ",\"avg\":" << avg
+					<< ",\"p50\":" << getPercentile(sorted, 50.0f)
+					<< ",\"p90\":" << getPercentile(sorted, 90.0f)
+					<< ",\"p95\":" << getPercentile(sorted, 95.0f)
+					<< ",\"p99\":" << getPercentile(sorted, 99.0f)
+					<< ",\"max\":" << getPercentile(sorted, 100.0f) << "}";
+			};
+
+		const GLubyte* renderer = glGetString(GL_RENDERER);
+
+		file << std::fixed << std::setprecision(4);
+		file << "{\n";
+		file << "\t\"script\": \"" << escapeJson(mScript.filepath.generic_string()) << "\",\n";
+		file << "\t\"renderer\": \"" << escapeJson(renderer ? (const char*)renderer : "") << "\",\n";
+		file << "\t\"resolution\": [" << mScript.width << ", " << mScript.height << "],\n";
+		file << "\t\"renderPath\": \"" << (mScript.renderPath == RenderPath::DEFERRED ? "deferred" : "forward") << "\",\n";
+		file << "\t\"shadows\": " << (mScript.shadows ? "true" : "false") << ",\n";
+		file << "\t\"frames\": " << mFrameTimesMs.size() << ",\n";
+		file << "\t\"warmupFrames\": " << mScript.warmupFrames << ",\n";
+		file << "\t\"stressEntities\": " << mScript.stress.entityCount << ",\n";
+
+		file << "\t\"frameTimeMs\": ";
+		writeStats(file, frameTimes, average(mFrameTimesMs));
+		file << ",\n";
+
+		file << "\t\"drawCalls\": {\"avg\":" << average(mDrawCalls) << ",\"max\":" << (mDrawCalls.empty() ? 0 : *std::max_element(mDrawCalls.begin(), mDrawCalls.end())) << "},\n";
+		file << "\t\"stateCallsIssued\": {\"avg\":" << average(mStateCallsIssued) << "},\n";
+
+		file << "\t\"passesMs\": {";
+
+		for (size_t i = 0; i < mPasses.size(); ++i)
+		{
+			std::vector<float> samples = mPasses[i].samplesMs;
+			std::sort(samples.begin(), samples.end());
+
+			file << (i == 0 ? "\n" : ",\n") << "\t\t\"" << escapeJson(mPasses[i].name) << "\": ";
+			writeStats(file, samples, average(samples));
+		}
+
+		file << "\n\t}\n}\n";
+
+		mResultsWritten = (bool)file;
+
+		std::cout << "Benchmark: " << mFrameTimesMs.size() << " frames, p50 " << getPercentile(frameTimes, 50.0f)
+			<< " ms, p99 " << getPercentile(frameTimes, 99.0f) << " ms, results written to " << mOutputPath << std::endl;
+
+		return mResultsWritten;
+	}
+
+	// Private helper functions
+
+	BenchmarkScript::CameraKey Benchmark::getCameraPose(float t) const
+	{
+		const std::vector<BenchmarkScript::CameraKey>& KEYS = mScript.cameraPath;
+
+		if (KEYS.size() == 1)
+		{
+			return KEYS.front();
+		}
+
+		// Catmull-Rom through every key, end keys repeated so the path starts and ends on them
+
+		const float SEGMENT_T = std::clamp(t, 0.0f, 1.0f) * (float)(KEYS.size() - 1);
+		const size_t SEGMENT = std::min((size_t)SEGMENT_T, KEYS.size() - 2);
+		const float LOCAL_T = SEGMENT_T - (float)SEGMENT;
+
+		const BenchmarkScript::CameraKey& K0 = KEYS[SEGMENT == 0 ? 0 : SEGMENT - 1];
+		const BenchmarkScript::CameraKey& K1 = KEYS[SEGMENT];
+		const BenchmarkScript::CameraKey& K2 = KEYS[SEGMENT + 1];
+		const BenchmarkScript::CameraKey& K3 = KEYS[std::min(SEGMENT + 2, KEYS.size() - 1)];
+
+		return {
+			catmullRom(K0.position, K1.position, K2.position, K3.position, LOCAL_T),
+			catmullRom(K0.rotation, K1.rotation, K2.rotation, K3.rotation, LOCAL_T)
+		};
+	}
+
+	void Benchmark::collectPassSamples(const std::vector<GpuProfiler::Pass>& passes, bool measure)
+	{
+		for (size_t i = 0; i < passes.size(); ++i)
+		{
+			const GpuProfiler::Pass& pass = passes[i];
+
+			if (i == mPasses.size())
+			{
+				mPasses.emplace_back().name = pass.name;
+			}
+
+			PassSamples& samples = mPasses[i];
+
+			// newest sample sits right before historyOffset once the history is full
+			const size_t NEW_SAMPLES = std::min(pass.sampleCount - samples.seen, pass.historyCount);
+
+			for (size_t j = NEW_SAMPLES; j > 0 && measure; --j)
+			{
+				const size_t INDEX = (pass.historyOffset + pass.historyCount - j) % GpuProfiler::HISTORY_SIZE;
+				samples.samplesMs.push_back(pass.historyMs[INDEX]);
+			}
+
+			samples.seen = pass.sampleCount;
+		}
+	}
+
+	float Benchmark::getPercentile(const std::vector<float>& sorted, float percentile)
+	{
+		if (sorted.empty())
+		{
+			return 0.0f;
+		}
+
+		return sorted[(size_t)((sorted.size() - 1) * percentile / 100.0f + 0.5f)];
+	}
+} // namespace ntr
@@ -1,13 +1,16 @@
+#include <iostream>
+
 #include "Buffers.h"
+#include "GLState.h"
 
 ntr::FrameBuffer::FrameBuffer()
 {
-	glGenFramebuffers(1, &mID);
+	glCreateFramebuffers(1, &mID);
 }
 
 ntr::FrameBuffer::~FrameBuffer()
 {
-	glDeleteFramebuffers(1, &mID);
+	ntr::GLState::deleteFramebuffers(1, &mID);
 }
 
 GLuint ntr::FrameBuffer::id() const
@@ -17,10 +20,180 @@ GLuint ntr::FrameBuffer::id() const
 
 void ntr::FrameBuffer::bind() const
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, mID);
+	ntr::GLState::bindFramebuffer(mID);
 }
 
 void ntr::FrameBuffer::unbind() const
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	ntr::GLState::bindFramebuffer(0);
+}
+
+ntr::GBuffer::GBuffer(GLsizei width, GLsizei height)
+	: mID{ 0 }
+	, mAlbedo{ 0 }
+	, mNormal{ 0 }
+	, mMaterial{ 0 }
+	, mDepth{ 0 }
+	, mWidth{ width }
+	, mHeight{ height }
+{
+	init();
+}
+
+ntr::GBuffer::~GBuffer()
+{
+	release();
+}
+
+GLuint ntr::GBuffer::id() const
+{
+	return mID;
+}
+
+GLuint ntr::GBuffer::albedo() const
+{
+	return mAlbedo;
+}
+
+GLuint ntr::GBuffer::normal() const
+{
+	return mNormal;
+}
+
+GLuint ntr::GBuffer::material() const
+{
+	return mMaterial;
+}
+
+GLuint ntr::GBuffer::depth() const
+{
+	return mDepth;
+}
+
+GLsizei ntr::GBuffer::width() const
+{
+	return mWidth;
+}
+
+GLsizei ntr::GBuffer::height() const
+{
+	return mHeight;
+}
+
+void ntr::GBuffer::bind() const
+{
+	ntr::GLState::bindFramebuffer(mID);
+}
+
+void ntr::GBuffer::unbind() const
+{
+	ntr::GLState::bindFramebuffer(0);
+}
+
+void ntr::GBuffer::resize(GLsizei width, GLsizei height)
+{
+	if (width <= 0 || height <= 0 || (width == mWidth && height == mHeight))
+	{
+		return;
+	}
+
+	release();
+
+	mWidth = width;
+	mHeight = height;
+
+	init();
+}
+
+void ntr::GBuffer::init()
+{
+	auto createTarget = [this](GLenum internalFormat)
+		{
+			GLuint texture;
+			glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+			glTextureStorage2D(texture, 1, internalFormat, mWidth, mHeight);
+			glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			return texture;
+		};
+
+	mAlbedo		= createTarget(GL_RGBA8);
+	mNormal		= createTarget(GL_RGBA16_SNORM);
+	mMaterial	= createTarget(GL_RGBA8);
+	mDepth		= createTarget(GL_DEPTH24_STENCIL8);
+
+	glCreateFramebuffers(1, &mID);
+	glNamedFramebufferTexture(mID, GL_COLOR_ATTACHMENT0, mAlbedo, 0);
+	glNamedFramebufferTexture(mID, GL_COLOR_ATTACHMENT1, mNormal, 0);
+	glNamedFramebufferTexture(mID, GL_COLOR_ATTACHMENT2, mMaterial, 0);
+	glNamedFramebufferTexture(mID, GL_DEPTH_STENCIL_ATTACHMENT, mDepth, 0);
+
+	const GLenum DRAW_BUFFERS[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+	glNamedFramebufferDrawBuffers(mID, 3, DRAW_BUFFERS);
+
+	if (glCheckNamedFramebufferStatus(mID, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR::FRAMEBUFFER:: GBuffer is not complete!" << std::endl;
+	}
+}
+
+void ntr::GBuffer::release()
+{
+	const GLuint TEXTURES[] = { mAlbedo, mNormal, mMaterial, mDepth };
+
+	ntr::GLState::deleteFramebuffers(1, &mID);
+	ntr::GLState::deleteTextures(4, TEXTURES);
+}
+
+ntr::RenderTarget::RenderTarget(GLsizei width, GLsizei height)
+	: mID{ 0 }
+	, mColor{ 0 }
+	, mDepth{ 0 }
+	, mWidth{ width }
+	, mHeight{ height }
+{
+	glCreateTextures(GL_TEXTURE_2D, 1, &mColor);
+	glTextureStorage2D(mColor, 1, GL_RGBA8, mWidth, mHeight);
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &mDepth);
+	glTextureStorage2D(mDepth, 1, GL_DEPTH24_STENCIL8, mWidth, mHeight);
+
+	glCreateFramebuffers(1, &mID);
+	glNamedFramebufferTexture(mID, GL_COLOR_ATTACHMENT0, mColor, 0);
+	glNamedFramebufferTexture(mID, GL_DEPTH_STENCIL_ATTACHMENT, mDepth, 0);
+
+	if (glCheckNamedFramebufferStatus(mID, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR::FRAMEBUFFER:: RenderTarget is not complete!" << std::endl;
+	}
+}
+
+ntr::RenderTarget::~RenderTarget()
+{
+	const GLuint TEXTURES[] = { mColor, mDepth };
+
+	ntr::GLState::deleteFramebuffers(1, &mID);
+	ntr::GLState::deleteTextures(2, TEXTURES);
+}
+
+GLuint ntr::RenderTarget::id() const
+{
+	return mID;
+}
+
+GLuint ntr::RenderTarget::color() const
+{
+	return mColor;
+}
+
+GLsizei ntr::RenderTarget::width() const
+{
+	return mWidth;
+}
+
+GLsizei ntr::RenderTarget::height() const
+{
+	return mHeight;
 }
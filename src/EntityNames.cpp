@@ -0,0 +1,116 @@
+#include "EntityNames.h"
+
+namespace ntr
+{
+	EntityNames::EntityNames(entt::registry& registry)
+		: mRegistry{ registry }
+		, mEntities{}
+		, mNames{}
+		, mSuffixes{}
+	{
+		mRegistry.on_construct<StringID>().connect<&EntityNames::onConstruct>(*this);
+		mRegistry.on_update<StringID>().connect<&EntityNames::onUpdate>(*this);
+		mRegistry.on_destroy<StringID>().connect<&EntityNames::onDestroy>(*this);
+	}
+
+	EntityNames::~EntityNames()
+	{
+		mRegistry.on_construct<StringID>().disconnect<&EntityNames::onConstruct>(*this);
+		mRegistry.on_update<StringID>().disconnect<&EntityNames::onUpdate>(*this);
+		mRegistry.on_destroy<StringID>().disconnect<&EntityNames::onDestroy>(*this);
+	}
+
+	entt::entity EntityNames::find(const std::string& name) const
+	{
+		auto itr = mEntities.find(name);
+
+		if (itr == mEntities.end())
+		{
+			return entt::null;
+		}
+
+		return itr->second;
+	}
+
+	bool EntityNames::contains(const std::string& name) const
+	{
+		return mEntities.find(name) != mEntities.end();
+	}
+
+	std::string EntityNames::getUnique(const std::string& name)
+	{
+		if (!contains(name))
+		{
+			return name;
+		}
+
+		// the counter carries over between calls, so spawning many entities with one name does not retry every suffix
+		uint32_t& suffix = mSuffixes[name];
+		std::string uniqueName;
+
+		do
+		{
+			uniqueName = name + "+" + std::to_string(++suffix);
+		}
+		while (contains(uniqueName));
+
+		return uniqueName;
+	}
+
+	bool EntityNames::rename(entt::entity entity, const std::string& name)
+	{
+		const entt::entity OWNER = find(name);
+
+		if (OWNER != entt::null && OWNER != entity)
+		{
+			return false;
+		}
+
+		mRegistry.get<StringID>(entity).str = name;
+		mRegistry.patch<StringID>(entity);
+
+		return true;
+	}
+
+	size_t EntityNames::size() const
+	{
+		return mEntities.size();
+	}
+
+	void EntityNames::onConstruct(entt::registry& registry, entt::entity entity)
+	{
+		StringID& id = registry.get<StringID>(entity);
+
+		if (contains(id.str))
+		{
+			id.str = getUnique(id.str);
+		}
+
+		auto itr = mEntities.emplace(id.str, entity).first;
+		mNames[entity] = &itr->first;
+	}
+
+	void EntityNames::onUpdate(entt::registry& registry, entt::entity entity)
+	{
+		erase(entity);
+		onConstruct(registry, entity);
+	}
+
+	void EntityNames::onDestroy(entt::registry& registry, entt::entity entity)
+	{
+		erase(entity);
+	}
+
+	void EntityNames::erase(entt::entity entity)
+	{
+		auto itr = mNames.find(entity);
+
+		if (itr == mNames.end())
+		{
+			return;
+		}
+
+		mEntities.erase(mEntities.find(*itr->second));
+		mNames.erase(itr);
+	}
+} // namespace ntr
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "FramePacer.h"
+
+namespace ntr
+{
+	namespace
+	{
+		const int64_t NS_PER_SECOND		= 1000000000;
+		const int64_t SLEEP_STEP_NS		= 1000000;
+		const double SLEEP_SMOOTHING	= 0.05;	// weight of each new sleep in the running estimate
+	}
+
+	FramePacer::FramePacer()
+		: mTargetRate{ 0.0 }
+		, mVsync{ false }
+		, mRefreshRate{ 0.0 }
+		, mPeriodNs{ 0 }
+		, mDeadlineNs{ 0 }
+		, mPrevFrameNs{ getTimeNs() }
+		, mFrameTimesNs{}
+		, mFrameCount{ 0 }
+		, mMissedFrames{ 0 }
+		, mSleepMeanNs{ (double)SLEEP_STEP_NS }
+		, mSleepVariance{ 0.0 }
+	{
+	}
+
+	void FramePacer::setTargetRate(double framesPerSecond)
+	{
+		mTargetRate = std::max(framesPerSecond, 0.0);
+		updatePeriod();
+	}
+
+	void FramePacer::setVsync(bool enabled, double refreshRate)
+	{
+		mVsync = enabled;
+		mRefreshRate = refreshRate;
+		updatePeriod();
+	}
+
+	double FramePacer::targetRate() const
+	{
+		return mTargetRate;
+	}
+
+	double FramePacer::wait()
+	{
+		if (mPeriodNs > 0)
+		{
+			const int64_t NOW = getTimeNs();
+
+			// a frame that ran long starts a new schedule instead of rushing the next ones to catch up
+			if (NOW - mDeadlineNs > mPeriodNs)
+			{
+				mDeadlineNs = NOW;
+			}
+			else
+			{
+				sleepUntil(mDeadlineNs);
+			}
+
+			mDeadlineNs += mPeriodNs;
+		}
+
+		const int64_t NOW = getTimeNs();
+		const int64_t FRAME_TIME = NOW - mPrevFrameNs;
+
+		mPrevFrameNs = NOW;
+		mFrameTimesNs[mFrameCount % HISTORY_SIZE] = FRAME_TIME;
+		++mFrameCount;
+
+		if (mPeriodNs > 0 && FRAME_TIME * 2 > mPeriodNs * 3)
+		{
+			++mMissedFrames;
+		}
+
+		return (double)FRAME_TIME / NS_PER_SECOND;
+	}
+
+	FramePacerStats FramePacer::stats() const
+	{
+		FramePacerStats stats;
+		stats.targetMs = mPeriodNs / 1e6;
+		stats.missedFrames = mMissedFrames;
+		stats.sleepErrorMs = std::max(mSleepMeanNs - SLEEP_STEP_NS, 0.0) / 1e6;
+
+		const size_t COUNT = std::min(mFrameCount, HISTORY_SIZE);
+
+		if (COUNT == 0)
+		{
+			return stats;
+		}
+
+		double sum = 0.0;
+		int64_t worst = 0;
+
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			sum += (double)mFrameTimesNs[i];
+			worst = std::max(worst, mFrameTimesNs[i]);
+		}
+
+		const double MEAN = sum / COUNT;
+		double variance = 0.0;
+
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			const double DIFF = (double)mFrameTimesNs[i] - MEAN;
+			variance += DIFF * DIFF;
+		}
+
+		stats.averageMs = MEAN / 1e6;
+		stats.jitterMs = std::sqrt(variance / COUNT) / 1e6;
+		stats.worstMs = worst / 1e6;
+
+		return stats;
+	}
+
+	// Private helper functions
+
+	void FramePacer::updatePeriod()
+	{
+		double rate = mTargetRate;
+
+		if (mVsync && mRefreshRate > 0.0 && rate > 0.0)
+		{
+			// the swap holds the frame to a whole number of refresh intervals anyway
+			const double INTERVALS = std::floor(mRefreshRate / rate);
+			rate = INTERVALS <= 1.0 ? 0.0 : mRefreshRate / INTERVALS;
+		}
+
+		if (rate <= 0.0)
+		{
+			mPeriodNs = 0;
+			return;
+		}
+
+		mPeriodNs = (int64_t)(NS_PER_SECOND / rate);
+
+		// with vsync the wait ends half an interval early, so the swap still makes the intended vblank
+		if (mVsync && mRefreshRate > 0.0)
+		{
+			mDeadlineNs = getTimeNs() + mPeriodNs - (int64_t)(NS_PER_SECOND / mRefreshRate / 2.0);
+		}
+		else
+		{
+			mDeadlineNs = getTimeNs() + mPeriodNs;
+		}
+	}
+
+	void FramePacer::sleepUntil(int64_t deadlineNs)
+	{
+		// sleep in short steps while more than a pessimistic estimate of one step is left, each step refines
+		// the estimate, which decays so it follows changes of the system timer resolution
+
+		for (;;)
+		{
+			const double ESTIMATE = mSleepMeanNs + 2.0 * std::sqrt(mSleepVariance);
+			const int64_t BEGIN = getTimeNs();
+
+			if ((double)(deadlineNs - BEGIN) <= ESTIMATE)
+			{
+				break;
+			}
+
+			std::this_thread::sleep_for(std::chrono::nanoseconds(SLEEP_STEP_NS));
+
+			const double OBSERVED = (double)(getTimeNs() - BEGIN);
+			const double DELTA = OBSERVED - mSleepMeanNs;
+
+			mSleepMeanNs += SLEEP_SMOOTHING * DELTA;
+			mSleepVariance = (1.0 - SLEEP_SMOOTHING) * (mSleepVariance + SLEEP_SMOOTHING * DELTA * DELTA);
+		}
+
+		while (getTimeNs() < deadlineNs)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	int64_t FramePacer::getTimeNs()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+} // namespace ntr
@@ -0,0 +1,155 @@
+#include "GLDeletionQueue.h"
+#include "GLState.h"
+
+namespace ntr
+{
+	std::mutex							GLDeletionQueue::mutex;
+	std::vector<GLDeletionQueue::Object>	GLDeletionQueue::queued;
+	std::deque<GLDeletionQueue::Batch>	GLDeletionQueue::fenced;
+	uint64_t							GLDeletionQueue::submittedFrames	= 0;
+	uint64_t							GLDeletionQueue::renderedFrames		= 0;
+
+	void GLDeletionQueue::deleteVertexArrays(GLsizei count, const GLuint* vaos)
+	{
+		enqueue(ObjectType::VERTEX_ARRAY, count, vaos);
+	}
+
+	void GLDeletionQueue::deleteBuffers(GLsizei count, const GLuint* buffers)
+	{
+		enqueue(ObjectType::BUFFER, count, buffers);
+	}
+
+	void GLDeletionQueue::deleteTextures(GLsizei count, const GLuint* textures)
+	{
+		enqueue(ObjectType::TEXTURE, count, textures);
+	}
+
+	void GLDeletionQueue::submitFrame()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		++submittedFrames;
+	}
+
+	void GLDeletionQueue::collect()
+	{
+		std::vector<Object> signaled;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			++renderedFrames;
+
+			// fence the objects whose last frame is now rendered, behind everything that frame drew
+
+			Batch batch;
+
+			for (size_t i = 0; i < queued.size(); )
+			{
+				if (queued[i].frame <= renderedFrames)
+				{
+					batch.objects.push_back(queued[i]);
+					queued[i] = queued.back();
+					queued.pop_back();
+				}
+				else
+				{
+					++i;
+				}
+			}
+
+			if (!batch.objects.empty())
+			{
+				batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				fenced.push_back(std::move(batch));
+			}
+
+			// only poll, a fence that has not signaled yet is checked again after the next frame
+
+			while (!fenced.empty())
+			{
+				GLint status = GL_UNSIGNALED;
+				glGetSynciv(fenced.front().fence, GL_SYNC_STATUS, 1, nullptr, &status);
+
+				if (status != GL_SIGNALED)
+				{
+					break;
+				}
+
+				glDeleteSync(fenced.front().fence);
+				signaled.insert(signaled.end(), fenced.front().objects.begin(), fenced.front().objects.end());
+				fenced.pop_front();
+			}
+		}
+
+		deleteObjects(signaled);
+	}
+
+	void GLDeletionQueue::flush()
+	{
+		std::vector<Object> objects;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			objects.swap(queued);
+
+			for (Batch& batch : fenced)
+			{
+				glDeleteSync(batch.fence);
+				objects.insert(objects.end(), batch.objects.begin(), batch.objects.end());
+			}
+
+			fenced.clear();
+		}
+
+		glFinish();
+
+		deleteObjects(objects);
+	}
+
+	size_t GLDeletionQueue::pendingCount()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		size_t count = queued.size();
+
+		for (const Batch& batch : fenced)
+		{
+			count += batch.objects.size();
+		}
+
+		return count;
+	}
+
+	// Private helper functions
+
+	void GLDeletionQueue::enqueue(ObjectType type, GLsizei count, const GLuint* names)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		// the frame being built may already have been extracted with the object, so it is the last one that can use it
+		const uint64_t LAST_FRAME = submittedFrames + 1;
+
+		for (GLsizei i = 0; i < count; ++i)
+		{
+			if (names[i] != 0)
+			{
+				queued.push_back({ names[i], type, LAST_FRAME });
+			}
+		}
+	}
+
+	void GLDeletionQueue::deleteObjects(const std::vector<Object>& objects)
+	{
+		for (const Object& object : objects)
+		{
+			switch (object.type)
+			{
+			case ObjectType::VERTEX_ARRAY:	GLState::deleteVertexArrays(1, &object.name); break;
+			case ObjectType::BUFFER:		GLState::deleteBuffers(1, &object.name); break;
+			case ObjectType::TEXTURE:		GLState::deleteTextures(1, &object.name); break;
+			}
+		}
+	}
+} // namespace ntr
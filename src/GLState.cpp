@@ -0,0 +1,354 @@
+#include <algorithm>
+
+#include "GLState.h"
+
+namespace ntr
+{
+	GLState::Shadow GLState::shadow;
+	GLStateCounters GLState::counters;
+	GLStateCounters GLState::lastCounters;
+
+	void GLState::beginFrame()
+	{
+		lastCounters = counters;
+		counters = {};
+	}
+
+	const GLStateCounters& GLState::lastFrameCounters()
+	{
+		return lastCounters;
+	}
+
+	const GLStateCounters& GLState::frameCounters()
+	{
+		return counters;
+	}
+
+	void GLState::setDefaultFramebuffer(GLuint fbo)
+	{
+		shadow.defaultFbo = fbo;
+	}
+
+	GLuint GLState::defaultFramebuffer()
+	{
+		return shadow.defaultFbo;
+	}
+
+	// BINDINGS
+
+	void GLState::useProgram(GLuint program)
+	{
+		if (changed(shadow.program != program))
+		{
+			shadow.program = program;
+			glUseProgram(program);
+		}
+	}
+
+	void GLState::bindVertexArray(GLuint vao)
+	{
+		if (changed(shadow.vao != vao))
+		{
+			shadow.vao = vao;
+			glBindVertexArray(vao);
+		}
+	}
+
+	void GLState::bindFramebuffer(GLuint fbo)
+	{
+		if (fbo == 0)
+		{
+			fbo = shadow.defaultFbo;
+		}
+
+		if (changed(shadow.fbo != fbo))
+		{
+			shadow.fbo = fbo;
+			glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		}
+	}
+
+	void GLState::bindTextureUnit(GLuint unit, GLuint texture)
+	{
+		if (unit >= TEXTURE_UNIT_COUNT)
+		{
+			changed(true);
+			glBindTextureUnit(unit, texture);
+			return;
+		}
+
+		if (changed(shadow.textureUnits[unit] != texture))
+		{
+			shadow.textureUnits[unit] = texture;
+			glBindTextureUnit(unit, texture);
+		}
+	}
+
+	void GLState::bindUploadTexture(GLenum target, GLuint texture)
+	{
+		if (changed(shadow.activeTexture != UPLOAD_TEXTURE_UNIT))
+		{
+			shadow.activeTexture = UPLOAD_TEXTURE_UNIT;
+			glActiveTexture(GL_TEXTURE0 + UPLOAD_TEXTURE_UNIT);
+		}
+
+		if (changed(shadow.uploadTexture != texture || shadow.uploadTarget != target))
+		{
+			shadow.uploadTexture = texture;
+			shadow.uploadTarget = target;
+			glBindTexture(target, texture);
+		}
+	}
+
+	void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+	{
+		GLuint* bound = nullptr;
+
+		if (index < BUFFER_BINDING_COUNT && target == GL_SHADER_STORAGE_BUFFER)
+		{
+			bound = &shadow.shaderStorageBuffers[index];
+		}
+		else if (index < BUFFER_BINDING_COUNT && target == GL_UNIFORM_BUFFER)
+		{
+			bound = &shadow.uniformBuffers[index];
+		}
+
+		if (changed(!bound || *bound != buffer))
+		{
+			if (bound)
+			{
+				*bound = buffer;
+			}
+
+			glBindBufferBase(target, index, buffer);
+		}
+	}
+
+	// FIXED-FUNCTION STATE
+
+	void GLState::setEnabled(GLenum capability, bool enabled)
+	{
+		const int INDEX = getCapabilityIndex(capability);
+
+		if (changed(INDEX < 0 || shadow.capabilities[INDEX] != enabled))
+		{
+			if (INDEX >= 0)
+			{
+				shadow.capabilities[INDEX] = enabled;
+			}
+
+			enabled ? glEnable(capability) : glDisable(capability);
+		}
+	}
+
+	bool GLState::isEnabled(GLenum capability)
+	{
+		const int INDEX = getCapabilityIndex(capability);
+
+		return INDEX >= 0 ? shadow.capabilities[INDEX] : glIsEnabled(capability) == GL_TRUE;
+	}
+
+	void GLState::cullFace(GLenum mode)
+	{
+		if (changed(shadow.cullFaceMode != mode))
+		{
+			shadow.cullFaceMode = mode;
+			glCullFace(mode);
+		}
+	}
+
+	GLenum GLState::cullFaceMode()
+	{
+		return shadow.cullFaceMode;
+	}
+
+	void GLState::depthFunc(GLenum func)
+	{
+		if (changed(shadow.depthFunc != func))
+		{
+			shadow.depthFunc = func;
+			glDepthFunc(func);
+		}
+	}
+
+	void GLState::stencilFunc(GLenum func, GLint ref, GLuint mask)
+	{
+		if (changed(shadow.stencilFunc != func || shadow.stencilRef != ref || shadow.stencilFuncMask != mask))
+		{
+			shadow.stencilFunc = func;
+			shadow.stencilRef = ref;
+			shadow.stencilFuncMask = mask;
+			glStencilFunc(func, ref, mask);
+		}
+	}
+
+	void GLState::stencilMask(GLuint mask)
+	{
+		if (changed(shadow.stencilWriteMask != mask))
+		{
+			shadow.stencilWriteMask = mask;
+			glStencilMask(mask);
+		}
+	}
+
+	void GLState::stencilOp(GLenum stencilFail, GLenum depthFail, GLenum depthPass)
+	{
+		GLenum* ops = shadow.stencilOps;
+
+		if (changed(ops[0] != stencilFail || ops[1] != depthFail || ops[2] != depthPass))
+		{
+			ops[0] = stencilFail;
+			ops[1] = depthFail;
+			ops[2] = depthPass;
+			glStencilOp(stencilFail, depthFail, depthPass);
+		}
+	}
+
+	void GLState::blendFunc(GLenum source, GLenum destination)
+	{
+		if (changed(shadow.blendFunc[0] != source || shadow.blendFunc[1] != destination))
+		{
+			shadow.blendFunc[0] = source;
+			shadow.blendFunc[1] = destination;
+			glBlendFunc(source, destination);
+		}
+	}
+
+	void GLState::clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+	{
+		GLfloat* color = shadow.clearColor;
+
+		if (changed(color[0] != r || color[1] != g || color[2] != b || color[3] != a))
+		{
+			color[0] = r;
+			color[1] = g;
+			color[2] = b;
+			color[3] = a;
+			glClearColor(r, g, b, a);
+		}
+	}
+
+	void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+	{
+		GLint* rect = shadow.viewport;
+
+		if (changed(rect[0] != x || rect[1] != y || rect[2] != width || rect[3] != height))
+		{
+			rect[0] = x;
+			rect[1] = y;
+			rect[2] = width;
+			rect[3] = height;
+			glViewport(x, y, width, height);
+		}
+	}
+
+	// DRAWS
+
+	void GLState::drawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+	{
+		++counters.draws;
+		glDrawElements(mode, count, type, indices);
+	}
+
+	void GLState::drawArrays(GLenum mode, GLint first, GLsizei count)
+	{
+		++counters.draws;
+		glDrawArrays(mode, first, count);
+	}
+
+	// DELETION
+
+	void GLState::deletePrograms(GLsizei count, const GLuint* programs)
+	{
+		for (GLsizei i = 0; i < count; ++i)
+		{
+			// a deleted program stays current until another one is installed, uninstall it so it is actually freed
+			if (shadow.program == programs[i])
+			{
+				shadow.program = 0;
+				glUseProgram(0);
+			}
+
+			glDeleteProgram(programs[i]);
+		}
+	}
+
+	void GLState::deleteVertexArrays(GLsizei count, const GLuint* vaos)
+	{
+		// deleting a bound object reverts its binding to 0
+		for (GLsizei i = 0; i < count; ++i)
+		{
+			if (shadow.vao == vaos[i])
+			{
+				shadow.vao = 0;
+			}
+		}
+
+		glDeleteVertexArrays(count, vaos);
+	}
+
+	void GLState::deleteFramebuffers(GLsizei count, const GLuint* fbos)
+	{
+		for (GLsizei i = 0; i < count; ++i)
+		{
+			if (shadow.fbo == fbos[i])
+			{
+				shadow.fbo = 0;
+			}
+
+			if (shadow.defaultFbo == fbos[i])
+			{
+				shadow.defaultFbo = 0;
+			}
+		}
+
+		glDeleteFramebuffers(count, fbos);
+	}
+
+	void GLState::deleteTextures(GLsizei count, const GLuint* textures)
+	{
+		for (GLsizei i = 0; i < count; ++i)
+		{
+			std::replace(shadow.textureUnits.begin(), shadow.textureUnits.end(), textures[i], 0u);
+
+			if (shadow.uploadTexture == textures[i])
+			{
+				shadow.uploadTexture = 0;
+			}
+		}
+
+		glDeleteTextures(count, textures);
+	}
+
+	void GLState::deleteBuffers(GLsizei count, const GLuint* buffers)
+	{
+		for (GLsizei i = 0; i < count; ++i)
+		{
+			std::replace(shadow.shaderStorageBuffers.begin(), shadow.shaderStorageBuffers.end(), buffers[i], 0u);
+			std::replace(shadow.uniformBuffers.begin(), shadow.uniformBuffers.end(), buffers[i], 0u);
+		}
+
+		glDeleteBuffers(count, buffers);
+	}
+
+	// Private helper functions
+
+	bool GLState::changed(bool different)
+	{
+		different ? ++counters.issued : ++counters.filtered;
+		return different;
+	}
+
+	int GLState::getCapabilityIndex(GLenum capability)
+	{
+		switch (capability)
+		{
+		case GL_BLEND:			return CAPABILITY_BLEND;
+		case GL_CULL_FACE:		return CAPABILITY_CULL_FACE;
+		case GL_DEPTH_TEST:		return CAPABILITY_DEPTH_TEST;
+		case GL_STENCIL_TEST:	return CAPABILITY_STENCIL_TEST;
+		}
+
+		return -1;
+	}
+} // namespace ntr
@@ -0,0 +1,192 @@
+#include <algorithm>
+
+#include "GpuProfiler.h"
+
+namespace ntr
+{
+	GpuProfiler::GpuProfiler()
+		: mFrames{}
+		, mCurrentFrame{ 0 }
+		, mOpenScopes{}
+		, mPasses{}
+		, mPassIndices{}
+		, mDroppedFrames{ 0 }
+	{
+	}
+
+	GpuProfiler::~GpuProfiler()
+	{
+		for (Frame& frame : mFrames)
+		{
+			glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data());
+		}
+	}
+
+	void GpuProfiler::beginFrame()
+	{
+		// collect oldest first, the slot about to be reused is the oldest
+
+		for (size_t i = 1; i <= FRAMES_IN_FLIGHT; ++i)
+		{
+			Frame& frame = mFrames[(mCurrentFrame + i) % FRAMES_IN_FLIGHT];
+
+			if (frame.pending && !collect(frame))
+			{
+				break;
+			}
+		}
+
+		mCurrentFrame = (mCurrentFrame + 1) % FRAMES_IN_FLIGHT;
+
+		Frame& frame = mFrames[mCurrentFrame];
+
+		if (frame.pending)
+		{
+			++mDroppedFrames;
+		}
+
+		frame.scopes.clear();
+		frame.queryCount = 0;
+		frame.pending = false;
+
+		mOpenScopes.clear();
+	}
+
+	void GpuProfiler::begin(const std::string& name)
+	{
+		if (!enabled)
+		{
+			return;
+		}
+
+		auto [itr, inserted] = mPassIndices.try_emplace(name, mPasses.size());
+
+		if (inserted)
+		{
+			mPasses.emplace_back().name = name;
+		}
+
+		Frame& frame = mFrames[mCurrentFrame];
+
+		mOpenScopes.push_back(frame.scopes.size());
+		frame.scopes.push_back({ itr->second, recordTimestamp(frame), 0 });
+	}
+
+	void GpuProfiler::end()
+	{
+		if (mOpenScopes.empty())
+		{
+			return;
+		}
+
+		Frame& frame = mFrames[mCurrentFrame];
+
+		frame.scopes[mOpenScopes.back()].endQuery = recordTimestamp(frame);
+		frame.pending = true;
+
+		mOpenScopes.pop_back();
+	}
+
+	const std::vector<GpuProfiler::Pass>& GpuProfiler::passes() const
+	{
+		return mPasses;
+	}
+
+	size_t GpuProfiler::droppedFrames() const
+	{
+		return mDroppedFrames;
+	}
+
+	// Private helper functions
+
+	bool GpuProfiler::collect(Frame& frame)
+	{
+		// timestamps complete in submission order, so the last one being available means all of them are
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(frame.queries[frame.queryCount - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (available != GL_TRUE)
+		{
+			return false;
+		}
+
+		std::vector<float> passMs(mPasses.size(), -1.0f);
+
+		for (const Scope& scope : frame.scopes)
+		{
+			// scope left open when the frame ended
+			if (scope.endQuery == 0)
+			{
+				continue;
+			}
+
+			GLuint64 beginNs = 0;
+			GLuint64 endNs = 0;
+
+			glGetQueryObjectui64v(frame.queries[scope.beginQuery], GL_QUERY_RESULT, &beginNs);
+			glGetQueryObjectui64v(frame.queries[scope.endQuery], GL_QUERY_RESULT, &endNs);
+
+			float& ms = passMs[scope.pass];
+			ms = std::max(ms, 0.0f) + (float)(endNs - beginNs) / 1000000.0f;
+		}
+
+		for (size_t i = 0; i < mPasses.size(); ++i)
+		{
+			if (passMs[i] < 0.0f)
+			{
+				continue;
+			}
+
+			Pass& pass = mPasses[i];
+
+			++pass.sampleCount;
+
+			if (pass.historyCount < HISTORY_SIZE)
+			{
+				pass.historyMs[pass.historyCount++] = passMs[i];
+			}
+			else
+			{
+				pass.historyMs[pass.historyOffset] = passMs[i];
+				pass.historyOffset = (pass.historyOffset + 1) % HISTORY_SIZE;
+			}
+
+			updateStats(pass);
+		}
+
+		frame.pending = false;
+
+		return true;
+	}
+
+	size_t GpuProfiler::recordTimestamp(Frame& frame)
+	{
+		if (frame.queryCount == frame.queries.size())
+		{
+			GLuint query = 0;
+			glCreateQueries(GL_TIMESTAMP, 1, &query);
+			frame.queries.push_back(query);
+		}
+
+		glQueryCounter(frame.queries[frame.queryCount], GL_TIMESTAMP);
+
+		return frame.queryCount++;
+	}
+
+	void GpuProfiler::updateStats(Pass& pass)
+	{
+		std::vector<float> sorted(pass.historyMs.begin(), pass.historyMs.begin() + pass.historyCount);
+		std::sort(sorted.begin(), sorted.end());
+
+		float sum = 0.0f;
+
+		for (float ms : sorted)
+		{
+			sum += ms;
+		}
+
+		pass.minMs = sorted.front();
+		pass.avgMs = sum / sorted.size();
+		pass.p99Ms = sorted[(sorted.size() - 1) * 99 / 100];
+	}
+} // namespace ntr
@@ -13,6 +13,9 @@ namespace ntr
 
 		ImGui_ImplGlfw_InitForOpenGL(window, true);
 		ImGui_ImplOpenGL3_Init();
+
+		// creates the font texture and shaders while the calling thread has the context, draw() won't need to
+		ImGui_ImplOpenGL3_NewFrame();
 	}
 	
 	void Gui::terminate()
@@ -169,15 +172,62 @@ namespace ntr
 
 	void Gui::clear()
 	{
-		ImGui_ImplOpenGL3_NewFrame();
 		ImGui_ImplGlfw_NewFrame();
 		ImGui::NewFrame();
 	}
 
-	void Gui::draw()
+	void Gui::render(GuiDrawData& drawData)
 	{
 		ImGui::Render();
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		drawData.capture();
+	}
+
+	void Gui::draw(GuiDrawData& drawData)
+	{
+		ImGui_ImplOpenGL3_RenderDrawData(drawData.data());
+	}
+
+	GuiDrawData::GuiDrawData()
+		: mData{}
+	{
+	}
+
+	GuiDrawData::~GuiDrawData()
+	{
+		clear();
+	}
+
+	void GuiDrawData::capture()
+	{
+		clear();
+
+		// the lists ImGui hands out are reused by the next frame, the copy owns clones of them
+		mData = *ImGui::GetDrawData();
+
+		for (ImDrawList*& list : mData.CmdLists)
+		{
+			list = list->CloneOutput();
+		}
+	}
+
+	void GuiDrawData::clear()
+	{
+		for (ImDrawList* list : mData.CmdLists)
+		{
+			IM_DELETE(list);
+		}
+
+		mData.Clear();
+	}
+
+	bool GuiDrawData::empty() const
+	{
+		return mData.CmdLists.empty();
+	}
+
+	ImDrawData* GuiDrawData::data()
+	{
+		return &mData;
 	}
 	
 	FileExplorer::FileExplorer(const std::string& title)
@@ -0,0 +1,67 @@
+#include <cmath>
+
+#include "LightClusters.h"
+
+namespace ntr
+{
+	LightClusters::LightClusters()
+		: mShaderCull{ "shaders/ntr_light_clusters.cs" }
+		, mLights{ 64, nullptr, BINDING_POINT_LIGHTS }
+		, mClusterLightCounts{ CLUSTER_COUNT, nullptr, BINDING_CLUSTER_LIGHT_COUNTS }
+		, mClusterLightIndices{ CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER, nullptr, BINDING_CLUSTER_LIGHT_INDICES }
+		, mLightCount{ 0 }
+	{
+	}
+
+	void LightClusters::update(const Camera& camera, const std::vector<PointLight>& lights)
+	{
+		mLightCount = lights.size();
+
+		// grow geometrically so adding lights one at a time doesn't reallocate every frame
+		if (mLightCount > mLights.size())
+		{
+			size_t capacity = mLights.size();
+
+			while (capacity < mLightCount)
+			{
+				capacity *= 2;
+			}
+
+			mLights.resize(capacity);
+		}
+
+		mLights.update(0, mLightCount, lights.data());
+
+		mClusterLightCounts.bind();
+		mClusterLightIndices.bind();
+
+		mShaderCull.setMat4("view", camera.view());
+		mShaderCull.setMat4("inverseProjection", glm::inverse(camera.projection()));
+		mShaderCull.setFloat("zNear", camera.zNear);
+		mShaderCull.setFloat("zFar", camera.zFar);
+		mShaderCull.setInt("lightCount", (int)mLightCount);
+
+		// one invocation per cluster, work group size is 16x9x4 (see ntr_light_clusters.cs)
+		mShaderCull.dispatch(1, 1, GRID_SIZE_Z / 4);
+
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+
+	glm::vec4 LightClusters::getClusterParams(const Camera& camera) const
+	{
+		// slice = log(depth) * scale + bias, the inverse of the exponential slicing in ntr_light_clusters.cs
+		const float LOG_FAR_OVER_NEAR = std::log(camera.zFar / camera.zNear);
+
+		return {
+			camera.viewport.width / GRID_SIZE_X,
+			camera.viewport.height / GRID_SIZE_Y,
+			GRID_SIZE_Z / LOG_FAR_OVER_NEAR,
+			-(GRID_SIZE_Z * std::log(camera.zNear)) / LOG_FAR_OVER_NEAR
+		};
+	}
+
+	size_t LightClusters::lightCount() const
+	{
+		return mLightCount;
+	}
+} // namespace ntr
@@ -0,0 +1,147 @@
+#include <utility>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include "MappedFile.h"
+
+namespace ntr
+{
+	MappedFile::MappedFile()
+		: mData{ nullptr }
+		, mSize{ 0 }
+	{
+	}
+
+	MappedFile::MappedFile(MappedFile&& file) noexcept
+		: mData{ file.mData }
+		, mSize{ file.mSize }
+	{
+		file.mData = nullptr;
+		file.mSize = 0;
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& file) noexcept
+	{
+		std::swap(mData, file.mData);
+		std::swap(mSize, file.mSize);
+
+		return *this;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	bool MappedFile::open(const std::filesystem::path& filepath)
+	{
+		close();
+
+		// the view keeps the file mapped, so the handles are closed as soon as it exists
+
+#ifdef _WIN32
+		HANDLE file = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER size{};
+
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+
+		if (!mapping)
+		{
+			return false;
+		}
+
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+
+		if (!data)
+		{
+			return false;
+		}
+
+		mData = static_cast<const unsigned char*>(data);
+		mSize = static_cast<size_t>(size.QuadPart);
+#else
+		const int FILE = ::open(filepath.c_str(), O_RDONLY);
+
+		if (FILE < 0)
+		{
+			return false;
+		}
+
+		struct stat status{};
+
+		if (fstat(FILE, &status) != 0 || status.st_size <= 0)
+		{
+			::close(FILE);
+			return false;
+		}
+
+		void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, FILE, 0);
+		::close(FILE);
+
+		if (data == MAP_FAILED)
+		{
+			return false;
+		}
+
+		mData = static_cast<const unsigned char*>(data);
+		mSize = static_cast<size_t>(status.st_size);
+#endif
+
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (!mData)
+		{
+			return;
+		}
+
+#ifdef _WIN32
+		UnmapViewOfFile(mData);
+#else
+		munmap(const_cast<unsigned char*>(mData), mSize);
+#endif
+
+		mData = nullptr;
+		mSize = 0;
+	}
+
+	bool MappedFile::isOpen() const
+	{
+		return mData != nullptr;
+	}
+
+	const unsigned char* MappedFile::data() const
+	{
+		return mData;
+	}
+
+	size_t MappedFile::size() const
+	{
+		return mSize;
+	}
+} // namespace ntr
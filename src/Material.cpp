@@ -2,5 +2,23 @@
 
 namespace ntr
 {
-	const ScopedPointer<Material> Material::EMPTY = new Material();
+	void Material::replaceTextures(TextureHandle texture, TextureHandle new_texture)
+	{
+		for (TextureHandle* map : { &albedo, &normal, &roughness, &metallic, &occlusion })
+		{
+			if (*map == texture)
+			{
+				*map = new_texture;
+			}
+		}
+	}
+
+	MaterialFactors::MaterialFactors(const Material& material)
+		: baseColor{ material.baseColorFactor }
+		, roughness{ material.roughnessFactor }
+		, metallic{ material.metallicFactor }
+		, occlusionStrength{ material.occlusionStrength }
+		, normalScale{ material.normalScale }
+	{
+	}
 }
\ No newline at end of file
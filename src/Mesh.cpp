@@ -1,35 +1,60 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
+#include <glm/geometric.hpp>
+
+#include "GLDeletionQueue.h"
 #include "Mesh.h"
 
 namespace ntr
 {
-    const ScopedPointer<Mesh> Mesh::EMPTY = new Mesh();
-
     Mesh::Mesh()
         : mVAO{ 0 }
         , mVBO{ 0 }
         , mEBO{ 0 }
         , mVertices{}
+        , mPositions{}
         , mIndices{}
+        , mIndexCount{ 0 }
         , mRenderUsage{}
+        , mCpuData{ CpuData::CPU_ALL }
+        , mBoundingRadius{ 0.0f }
+        , mBounds{}
+        , mTriangleBVH{}
     {
     }
 
-    Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, RenderUsage usage)
+    Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, RenderUsage usage, CpuData cpuData, WorkerPool* triangleBVHWorkers)
 		: mVertices{ vertices }
 		, mIndices{ indices }
+        , mIndexCount{ static_cast<GLsizei>(mIndices.size()) }
         , mRenderUsage{ usage }
+        , mCpuData{ cpuData }
 	{
-        initMesh();
+        initMesh(mVertices.data(), mVertices.size(), mIndices.data(), mIndices.size(), triangleBVHWorkers);
 	}
 
-    Mesh::Mesh(std::vector<Vertex>&& vertices, std::vector<GLuint>&& indices, RenderUsage usage)
+    Mesh::Mesh(std::vector<Vertex>&& vertices, std::vector<GLuint>&& indices, RenderUsage usage, CpuData cpuData, WorkerPool* triangleBVHWorkers)
         : mVertices{ std::move(vertices) }
         , mIndices{ std::move(indices) }
+        , mIndexCount{ static_cast<GLsizei>(mIndices.size()) }
+        , mRenderUsage{ usage }
+        , mCpuData{ cpuData }
+    {
+        initMesh(mVertices.data(), mVertices.size(), mIndices.data(), mIndices.size(), triangleBVHWorkers);
+    }
+
+    Mesh::Mesh(const Vertex* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount, RenderUsage usage, CpuData cpuData, TriangleBVH&& triangleBVH)
+        : mVertices{}
+        , mPositions{}
+        , mIndices{}
+        , mIndexCount{ static_cast<GLsizei>(indexCount) }
         , mRenderUsage{ usage }
+        , mCpuData{ cpuData }
+        , mTriangleBVH{ std::move(triangleBVH) }
     {
-        initMesh();
+        initMesh(vertices, vertexCount, indices, indexCount, nullptr);
     }
     
     Mesh::Mesh(Mesh&& mesh) noexcept
@@ -37,8 +62,14 @@ namespace ntr
         , mVBO{ std::move(mesh.mVBO) }
         , mEBO{ std::move(mesh.mEBO) }
         , mVertices{ std::move(mesh.mVertices) }
+        , mPositions{ std::move(mesh.mPositions) }
         , mIndices{ std::move(mesh.mIndices) }
+        , mIndexCount{ std::move(mesh.mIndexCount) }
         , mRenderUsage{ std::move(mesh.mRenderUsage) }
+        , mCpuData{ std::move(mesh.mCpuData) }
+        , mBoundingRadius{ std::move(mesh.mBoundingRadius) }
+        , mBounds{ std::move(mesh.mBounds) }
+        , mTriangleBVH{ std::move(mesh.mTriangleBVH) }
     {
         mesh.mVAO = 0;
         mesh.mVBO = 0;
@@ -51,26 +82,24 @@ namespace ntr
         std::swap(mVBO, mesh.mVBO);
         std::swap(mEBO, mesh.mEBO);
         std::swap(mVertices, mesh.mVertices);
+        std::swap(mPositions, mesh.mPositions);
         std::swap(mIndices, mesh.mIndices);
+        std::swap(mIndexCount, mesh.mIndexCount);
         std::swap(mRenderUsage, mesh.mRenderUsage);
+        std::swap(mCpuData, mesh.mCpuData);
+        std::swap(mBoundingRadius, mesh.mBoundingRadius);
+        std::swap(mBounds, mesh.mBounds);
+        std::swap(mTriangleBVH, mesh.mTriangleBVH);
 
         return *this;
     }
 
     Mesh::~Mesh()
     {
-        if (mVAO != 0)
-        {
-            glDeleteVertexArrays(1, &mVAO);
-        }
-        if (mVBO != 0)
-        {
-            glDeleteBuffers(1, &mVBO);
-        }
-        if (mEBO != 0)
-        {
-            glDeleteBuffers(1, &mEBO);
-        }
+        // frames in flight may still draw the mesh, and the main thread that releases it has no context
+        GLDeletionQueue::deleteVertexArrays(1, &mVAO);
+        GLDeletionQueue::deleteBuffers(1, &mVBO);
+        GLDeletionQueue::deleteBuffers(1, &mEBO);
     }
 
     GLuint Mesh::vao() const
@@ -80,7 +109,69 @@ namespace ntr
 
     GLsizei Mesh::indexCount() const
     {
-        return static_cast<GLsizei>(mIndices.size());
+        return mIndexCount;
+    }
+
+    RenderUsage Mesh::renderUsage() const
+    {
+        return mRenderUsage;
+    }
+
+    float Mesh::boundingRadius() const
+    {
+        return mBoundingRadius;
+    }
+
+    const AABB& Mesh::bounds() const
+    {
+        return mBounds;
+    }
+
+    CpuData Mesh::cpuData() const
+    {
+        return mCpuData;
+    }
+
+    bool Mesh::hasTriangleBVH() const
+    {
+        return !mTriangleBVH.empty();
+    }
+
+    const TriangleBVH& Mesh::triangleBVH() const
+    {
+        return mTriangleBVH;
+    }
+
+    bool Mesh::raycast(const Ray& ray, float maxDistance, TriangleHit& hit) const
+    {
+        return mTriangleBVH.raycast(getTriangleMesh(), ray, maxDistance, hit);
+    }
+
+    void Mesh::readVertices(std::vector<Vertex>& vertices) const
+    {
+        if (mCpuData == CpuData::CPU_ALL)
+        {
+            vertices = mVertices;
+            return;
+        }
+
+        GLint64 size = 0;
+        glGetNamedBufferParameteri64v(mVBO, GL_BUFFER_SIZE, &size);
+
+        vertices.resize(static_cast<size_t>(size) / sizeof(Vertex));
+        glGetNamedBufferSubData(mVBO, 0, vertices.size() * sizeof(Vertex), vertices.data());
+    }
+
+    void Mesh::readIndices(std::vector<GLuint>& indices) const
+    {
+        if (mCpuData != CpuData::CPU_NONE)
+        {
+            indices = mIndices;
+            return;
+        }
+
+        indices.resize(mIndexCount);
+        glGetNamedBufferSubData(mEBO, 0, indices.size() * sizeof(GLuint), indices.data());
     }
 
     void Mesh::printVertices() const
@@ -110,55 +201,143 @@ namespace ntr
     
     // Private helper function
     
-    void Mesh::initMesh()
-    {
-        glGenVertexArrays(1, &mVAO);
-        glBindVertexArray(mVAO);
-
-        glGenBuffers(1, &mVBO);
-        glBindBuffer(GL_ARRAY_BUFFER, mVBO);
-        glBufferData(GL_ARRAY_BUFFER, mVertices.size() * sizeof(Vertex), &mVertices[0], mRenderUsage);
-
-        glGenBuffers(1, &mEBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(GLuint), &mIndices[0], mRenderUsage);
-
-        // set the vertex attribute pointers
-
-        // vertex positions
-        glEnableVertexAttribArray(Vertex::INDEX_POSITION);
-        glVertexAttribPointer(Vertex::INDEX_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(Vertex::INDEX_NORMAL);
-        glVertexAttribPointer(Vertex::INDEX_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(Vertex::INDEX_TEXCOORDS);
-        glVertexAttribPointer(Vertex::INDEX_TEXCOORDS, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(Vertex::INDEX_TANGENT);
-        glVertexAttribPointer(Vertex::INDEX_TANGENT, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(Vertex::INDEX_BITANGENT);
-        glVertexAttribPointer(Vertex::INDEX_BITANGENT, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, biTangent));
-        // ids
-        glEnableVertexAttribArray(Vertex::INDEX_BONE_IDS);
-        glVertexAttribIPointer(Vertex::INDEX_BONE_IDS, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, boneIDs));
-        // weights
-        glEnableVertexAttribArray(Vertex::INDEX_BONE_WEIGHTS);
-        glVertexAttribPointer(Vertex::INDEX_BONE_WEIGHTS, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, weights));
-
-        glBindVertexArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    }
-
-    MeshInstance MeshInstance::EMPTY(Mesh::EMPTY, Material::EMPTY);
-    
-    MeshInstance::MeshInstance(const Mesh* mesh, const Material* material, const Transform& transform)
-        : vao{ mesh->vao() }
-        , indexCount{ mesh-> indexCount() }
+    void Mesh::initMesh(const Vertex* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount, WorkerPool* triangleBVHWorkers)
+    {
+        float radiusSquared = 0.0f;
+
+        mBounds = {};
+
+        if (vertexCount > 0)
+        {
+            mBounds = { vertices[0].position, vertices[0].position };
+        }
+
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            const Vertex& v = vertices[i];
+
+            radiusSquared = std::max(radiusSquared, glm::dot(v.position, v.position));
+
+            mBounds.min = glm::min(mBounds.min, v.position);
+            mBounds.max = glm::max(mBounds.max, v.position);
+        }
+
+        mBoundingRadius = std::sqrt(radiusSquared);
+
+        // immutable storage, static meshes are never written again
+        const GLbitfield STORAGE_FLAGS = mRenderUsage == RenderUsage::STATIC ? 0 : GL_DYNAMIC_STORAGE_BIT;
+
+        glCreateBuffers(1, &mVBO);
+        glNamedBufferStorage(mVBO, vertexCount * sizeof(Vertex), vertices, STORAGE_FLAGS);
+
+        glCreateBuffers(1, &mEBO);
+        glNamedBufferStorage(mEBO, indexCount * sizeof(GLuint), indices, STORAGE_FLAGS);
+
+        // set the vertex attribute formats, all read from binding 0 without binding the VAO
+
+        glCreateVertexArrays(1, &mVAO);
+        glVertexArrayVertexBuffer(mVAO, 0, mVBO, 0, sizeof(Vertex));
+        glVertexArrayElementBuffer(mVAO, mEBO);
+
+        auto setAttribute = [this](GLuint index, GLint size, GLenum type, GLuint offset)
+        {
+            glEnableVertexArrayAttrib(mVAO, index);
+            glVertexArrayAttribBinding(mVAO, index, 0);
+
+            if (type == GL_INT)
+            {
+                glVertexArrayAttribIFormat(mVAO, index, size, type, offset);
+            }
+            else
+            {
+                glVertexArrayAttribFormat(mVAO, index, size, type, GL_FALSE, offset);
+            }
+        };
+
+        setAttribute(Vertex::INDEX_POSITION,      3, GL_FLOAT,  offsetof(Vertex, position));
+        setAttribute(Vertex::INDEX_NORMAL,        3, GL_FLOAT,  offsetof(Vertex, normal));
+        setAttribute(Vertex::INDEX_TEXCOORDS,     2, GL_FLOAT,  offsetof(Vertex, texCoords));
+        setAttribute(Vertex::INDEX_TANGENT,       3, GL_FLOAT,  offsetof(Vertex, tangent));
+        setAttribute(Vertex::INDEX_BITANGENT,     3, GL_FLOAT,  offsetof(Vertex, biTangent));
+        setAttribute(Vertex::INDEX_BONE_IDS,      4, GL_INT,    offsetof(Vertex, boneIDs));
+        setAttribute(Vertex::INDEX_BONE_WEIGHTS,  4, GL_FLOAT,  offsetof(Vertex, weights));
+
+        // the triangle BVH only stores indices, it reads positions from whatever is kept below
+
+        if (triangleBVHWorkers && mCpuData != CpuData::CPU_NONE)
+        {
+            TriangleMesh triangles;
+            triangles.positions = reinterpret_cast<const unsigned char*>(vertices) + offsetof(Vertex, position);
+            triangles.stride = sizeof(Vertex);
+            triangles.indices = indices;
+            triangles.triangleCount = indexCount / 3;
+
+            mTriangleBVH.build(triangles, triangleBVHWorkers);
+        }
+
+        // vertices and indices are the members themselves unless they were passed in place
+
+        if (mCpuData == CpuData::CPU_POSITIONS)
+        {
+            mPositions.reserve(vertexCount);
+
+            for (size_t i = 0; i < vertexCount; ++i)
+            {
+                mPositions.push_back(vertices[i].position);
+            }
+        }
+
+        if (mCpuData != CpuData::CPU_ALL)
+        {
+            std::vector<Vertex>().swap(mVertices);
+        }
+        else if (mVertices.data() != vertices)
+        {
+            mVertices.assign(vertices, vertices + vertexCount);
+        }
+
+        if (mCpuData == CpuData::CPU_NONE)
+        {
+            std::vector<GLuint>().swap(mIndices);
+            mTriangleBVH.clear();
+        }
+        else if (mIndices.data() != indices)
+        {
+            mIndices.assign(indices, indices + indexCount);
+        }
+    }
+
+    TriangleMesh Mesh::getTriangleMesh() const
+    {
+        TriangleMesh triangles;
+
+        if (!mVertices.empty())
+        {
+            triangles.positions = reinterpret_cast<const unsigned char*>(mVertices.data()) + offsetof(Vertex, position);
+            triangles.stride = sizeof(Vertex);
+        }
+        else
+        {
+            triangles.positions = reinterpret_cast<const unsigned char*>(mPositions.data());
+            triangles.stride = sizeof(glm::vec3);
+        }
+
+        triangles.indices = mIndices.data();
+        triangles.triangleCount = mIndices.size() / 3;
+
+        return triangles;
+    }
+
+    MeshInstance::MeshInstance(MeshHandle mesh, MaterialHandle material, const Transform& transform)
+        : mesh{ mesh }
         , material{ material }
         , transform{ transform }
+        , matrix{ transform }
+    {
+    }
+
+    void MeshInstance::updateMatrix()
     {
+        matrix = WorldMatrix(transform);
     }
 } // namespace ntr
\ No newline at end of file
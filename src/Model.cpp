@@ -2,27 +2,24 @@
 
 namespace ntr
 {
-	const ScopedPointer<Model> Model::EMPTY = new Model();
-	
-	void Model::replaceMeshes(const Mesh* mesh, const Mesh* new_mesh)
+	void Model::replaceMeshes(MeshHandle mesh, MeshHandle new_mesh)
 	{
 		for (auto& [id, modelMesh] : meshes)
 		{
-			if (modelMesh.vao == mesh->vao())
+			if (modelMesh.mesh == mesh)
 			{
-				meshes[id].vao = new_mesh->vao();
-				meshes[id].indexCount = new_mesh->indexCount();
+				modelMesh.mesh = new_mesh;
 			}
 		}
 	}
 	
-	void Model::replaceMaterials(const Material* material, const Material* new_material)
+	void Model::replaceMaterials(MaterialHandle material, MaterialHandle new_material)
 	{
 		for (auto& [id, modelMesh] : meshes)
 		{
 			if (modelMesh.material == material)
 			{
-				meshes[id].material = new_material;
+				modelMesh.material = new_material;
 			}
 		}
 	}
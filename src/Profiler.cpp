@@ -0,0 +1,264 @@
+#include "Profiler.h"
+
+#ifdef NTR_PROFILING
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace ntr
+{
+	std::atomic<bool>								Profiler::recording{ false };
+	std::mutex										Profiler::buffersMutex;
+	std::vector<std::unique_ptr<Profiler::ThreadBuffer>>	Profiler::buffers;
+	std::vector<Profiler::ThreadBuffer*>			Profiler::freeBuffers;
+	uint32_t										Profiler::framesLeft		= 0;
+	int64_t											Profiler::captureBeginNs	= 0;
+	std::filesystem::path							Profiler::capturePath;
+
+	thread_local Profiler::ThreadBufferOwner		Profiler::threadBuffer;
+	thread_local std::string						Profiler::threadName;
+
+	namespace
+	{
+		void writeEscaped(std::ostream& out, const std::string& text)
+		{
+			for (char c : text)
+			{
+				if (c == '"' || c == '\\')
+				{
+					out << '\\';
+				}
+
+				out << c;
+			}
+		}
+	}
+
+	Profiler::Zone::Zone(const char* name)
+		: mName{ name }
+		, mStartNs{ recording.load(std::memory_order_relaxed) ? getTimeNs() : -1 }
+	{
+	}
+
+	Profiler::Zone::~Zone()
+	{
+		if (mStartNs >= 0 && recording.load(std::memory_order_relaxed))
+		{
+			Event event{};
+			event.name = mName;
+			event.startNs = mStartNs;
+			event.endNs = getTimeNs();
+			event.type = EventType::ZONE;
+
+			record(event);
+		}
+	}
+
+	void Profiler::capture(uint32_t frames, const std::filesystem::path& filepath)
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+
+		if (recording.load(std::memory_order_relaxed))
+		{
+			return;
+		}
+
+		// buffers of threads that exited since the last capture hold nothing this capture needs
+		for (std::unique_ptr<ThreadBuffer>& buffer : buffers)
+		{
+			if (buffer->retired)
+			{
+				buffer->retired = false;
+				freeBuffers.push_back(buffer.get());
+			}
+
+			buffer->captureBegin = buffer->head.load(std::memory_order_acquire);
+		}
+
+		// the marker ending the current, partial frame starts the first complete one
+		framesLeft = frames + 1;
+		captureBeginNs = getTimeNs();
+		capturePath = filepath;
+
+		recording.store(true, std::memory_order_release);
+	}
+
+	void Profiler::frameMark()
+	{
+		if (!recording.load(std::memory_order_relaxed))
+		{
+			return;
+		}
+
+		Event event{};
+		event.name = "Frame";
+		event.startNs = getTimeNs();
+		event.type = EventType::FRAME;
+
+		record(event);
+
+		std::lock_guard<std::mutex> lock(buffersMutex);
+
+		if (--framesLeft == 0)
+		{
+			recording.store(false, std::memory_order_release);
+			writeTrace();
+		}
+	}
+
+	void Profiler::counter(const char* name, double value)
+	{
+		if (!recording.load(std::memory_order_relaxed))
+		{
+			return;
+		}
+
+		Event event{};
+		event.name = name;
+		event.startNs = getTimeNs();
+		event.value = value;
+		event.type = EventType::COUNTER;
+
+		record(event);
+	}
+
+	void Profiler::setThreadName(const std::string& name)
+	{
+		threadName = name;
+
+		if (threadBuffer.buffer)
+		{
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			threadBuffer.buffer->name = name;
+		}
+	}
+
+	// Private helper functions
+
+	Profiler::ThreadBufferOwner::~ThreadBufferOwner()
+	{
+		if (buffer)
+		{
+			// events of a running capture stay readable, the buffer is reused from the next capture on
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			buffer->retired = true;
+		}
+	}
+
+	void Profiler::record(const Event& event)
+	{
+		ThreadBuffer& buffer = getThreadBuffer();
+
+		// only this thread writes head, the release publishes the event to writeTrace
+		const uint64_t HEAD = buffer.head.load(std::memory_order_relaxed);
+
+		buffer.events[HEAD % EVENTS_PER_THREAD] = event;
+		buffer.head.store(HEAD + 1, std::memory_order_release);
+	}
+
+	Profiler::ThreadBuffer& Profiler::getThreadBuffer()
+	{
+		if (threadBuffer.buffer)
+		{
+			return *threadBuffer.buffer;
+		}
+
+		std::lock_guard<std::mutex> lock(buffersMutex);
+
+		ThreadBuffer* buffer = nullptr;
+
+		if (!freeBuffers.empty())
+		{
+			buffer = freeBuffers.back();
+			freeBuffers.pop_back();
+		}
+		else
+		{
+			buffer = buffers.emplace_back(std::make_unique<ThreadBuffer>()).get();
+			buffer->id = (uint32_t)buffers.size();
+		}
+
+		buffer->captureBegin = buffer->head.load(std::memory_order_relaxed);
+		buffer->name = threadName.empty() ? "Thread " + std::to_string(buffer->id) : threadName;
+
+		threadBuffer.buffer = buffer;
+
+		return *buffer;
+	}
+
+	int64_t Profiler::getTimeNs()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void Profiler::writeTrace()
+	{
+		std::ofstream file(capturePath);
+
+		if (!file)
+		{
+			std::cerr << "ERROR: could not write trace: " << capturePath << std::endl;
+			return;
+		}
+
+		// trace timestamps are in microseconds
+		auto toUs = [](int64_t ns) { return (double)(ns - captureBeginNs) / 1000.0; };
+
+		file << std::fixed << std::setprecision(3);
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Nitor\"}}";
+
+		size_t eventCount = 0;
+
+		for (const std::unique_ptr<ThreadBuffer>& buffer : buffers)
+		{
+			const uint64_t HEAD = buffer->head.load(std::memory_order_acquire);
+
+			// a thread that saw recording just before it stopped may still write the slot after head,
+			// which wraps onto the oldest event, so one slot is left out once the ring is full
+			const uint64_t FIRST = std::max(buffer->captureBegin, HEAD > EVENTS_PER_THREAD ? HEAD - EVENTS_PER_THREAD + 1 : 0);
+
+			if (FIRST == HEAD)
+			{
+				continue;
+			}
+
+			file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":\"";
+			writeEscaped(file, buffer->name);
+			file << "\"}}";
+
+			for (uint64_t i = FIRST; i < HEAD; ++i)
+			{
+				const Event& event = buffer->events[i % EVENTS_PER_THREAD];
+
+				file << ",\n{\"name\":\"";
+				writeEscaped(file, event.name);
+				file << "\",\"pid\":1,\"tid\":" << buffer->id << ",\"ts\":" << toUs(event.startNs);
+
+				switch (event.type)
+				{
+				case EventType::ZONE:
+					file << ",\"ph\":\"X\",\"dur\":" << (double)(event.endNs - event.startNs) / 1000.0 << "}";
+					break;
+				case EventType::COUNTER:
+					file << ",\"ph\":\"C\",\"args\":{\"value\":" << event.value << "}}";
+					break;
+				case EventType::FRAME:
+					file << ",\"ph\":\"i\",\"s\":\"g\"}";
+					break;
+				}
+			}
+
+			eventCount += HEAD - FIRST;
+		}
+
+		file << "\n]}\n";
+
+		std::cout << "Profiler: wrote " << eventCount << " events to " << capturePath << std::endl;
+	}
+} // namespace ntr
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef NTR_REFERENCES_HPP
+#define NTR_REFERENCES_HPP
+
+#include <utility>
+
+#include "References.h"
+
+namespace ntr
+{
+	//#################################################################################################
+	//
+	// REFERENCES IMPLEMENTATION
+	//
+	//#################################################################################################
+
+	template <typename User, typename Asset>
+	inline void References<User, Asset>::set(User user, const std::vector<Asset>& assets, std::vector<Asset>* released)
+	{
+		std::vector<Link> oldLinks;
+
+		auto itr = mLinks.find(user);
+
+		if (itr != mLinks.end())
+		{
+			oldLinks = std::move(itr->second);
+		}
+
+		// link the new assets before unlinking the old ones, so assets that are in both never run out of users
+
+		std::vector<Link> links;
+		links.reserve(assets.size());
+
+		for (Asset asset : assets)
+		{
+			if (asset == Asset{} || findLink(links, asset))
+			{
+				continue;
+			}
+
+			const Link* OLD_LINK = findLink(oldLinks, asset);
+
+			links.push_back(OLD_LINK ? *OLD_LINK : Link{ asset, addUser(asset, user) });
+		}
+
+		for (const Link& oldLink : oldLinks)
+		{
+			if (!findLink(links, oldLink.asset))
+			{
+				removeUser(oldLink, released);
+			}
+		}
+
+		if (links.empty())
+		{
+			mLinks.erase(user);
+		}
+		else
+		{
+			mLinks[user] = std::move(links);
+		}
+	}
+
+	template <typename User, typename Asset>
+	inline void References<User, Asset>::erase(User user, std::vector<Asset>* released)
+	{
+		set(user, {}, released);
+	}
+
+	template <typename User, typename Asset>
+	inline const std::vector<User>& References<User, Asset>::getUsers(Asset asset) const
+	{
+		static const std::vector<User> NO_USERS;
+
+		auto itr = mUsers.find(asset);
+
+		return itr != mUsers.end() ? itr->second : NO_USERS;
+	}
+
+	template <typename User, typename Asset>
+	inline size_t References<User, Asset>::count(Asset asset) const
+	{
+		return getUsers(asset).size();
+	}
+
+	// Private helper functions
+
+	template <typename User, typename Asset>
+	inline uint32_t References<User, Asset>::addUser(Asset asset, User user)
+	{
+		std::vector<User>& users = mUsers[asset];
+		users.push_back(user);
+
+		return (uint32_t)(users.size() - 1);
+	}
+
+	template <typename User, typename Asset>
+	inline void References<User, Asset>::removeUser(const Link& link, std::vector<Asset>* released)
+	{
+		auto itr = mUsers.find(link.asset);
+		std::vector<User>& users = itr->second;
+
+		// move the last user into the gap and point its link at the new slot
+
+		if (link.slot + 1 != users.size())
+		{
+			const User MOVED_USER = users.back();
+			users[link.slot] = MOVED_USER;
+
+			for (Link& movedLink : mLinks[MOVED_USER])
+			{
+				if (movedLink.asset == link.asset)
+				{
+					movedLink.slot = link.slot;
+					break;
+				}
+			}
+		}
+
+		users.pop_back();
+
+		if (users.empty())
+		{
+			mUsers.erase(itr);
+
+			if (released)
+			{
+				released->push_back(link.asset);
+			}
+		}
+	}
+
+	template <typename User, typename Asset>
+	inline const typename References<User, Asset>::Link* References<User, Asset>::findLink(const std::vector<Link>& links, Asset asset)
+	{
+		for (const Link& link : links)
+		{
+			if (link.asset == asset)
+			{
+				return &link;
+			}
+		}
+
+		return nullptr;
+	}
+} // namespace ntr
+
+#endif
@@ -0,0 +1,159 @@
+#include "RenderThread.h"
+#include "Profiler.h"
+
+namespace ntr
+{
+	RenderThread::ContextLock::ContextLock(RenderThread& renderThread)
+		: mRenderThread{ renderThread }
+	{
+		if (!mRenderThread.mThread.joinable() || mRenderThread.mLockDepth++ > 0)
+		{
+			return;
+		}
+
+		NTR_PROFILE_SCOPE("Borrow GL context");
+
+		std::unique_lock<std::mutex> lock(mRenderThread.mMutex);
+
+		mRenderThread.mContextRequested = true;
+		mRenderThread.mCondition.notify_all();
+		mRenderThread.mCondition.wait(lock, [this]() { return mRenderThread.mContextReleased; });
+
+		glfwMakeContextCurrent(mRenderThread.mWindow);
+	}
+
+	RenderThread::ContextLock::~ContextLock()
+	{
+		if (!mRenderThread.mThread.joinable() || --mRenderThread.mLockDepth > 0)
+		{
+			return;
+		}
+
+		glfwMakeContextCurrent(nullptr);
+
+		std::lock_guard<std::mutex> lock(mRenderThread.mMutex);
+
+		mRenderThread.mContextRequested = false;
+		mRenderThread.mCondition.notify_all();
+	}
+
+	RenderThread::RenderThread()
+		: mWindow{ nullptr }
+		, mRender{}
+		, mThread{}
+		, mMutex{}
+		, mCondition{}
+		, mSubmitted{ 0 }
+		, mRendered{ 0 }
+		, mLockDepth{ 0 }
+		, mContextRequested{ false }
+		, mContextReleased{ false }
+		, mStopping{ false }
+	{
+	}
+
+	RenderThread::~RenderThread()
+	{
+		stop();
+	}
+
+	void RenderThread::start(GLFWwindow* window, std::function<void(size_t slot)> render)
+	{
+		mWindow = window;
+		mRender = std::move(render);
+		mStopping = false;
+
+		// a context can only be current on one thread at a time
+		glfwMakeContextCurrent(nullptr);
+
+		mThread = std::thread(&RenderThread::loop, this);
+	}
+
+	void RenderThread::stop()
+	{
+		if (!mThread.joinable())
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStopping = true;
+			mCondition.notify_all();
+		}
+
+		mThread.join();
+
+		glfwMakeContextCurrent(mWindow);
+	}
+
+	size_t RenderThread::acquire()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		mCondition.wait(lock, [this]() { return mSubmitted - mRendered < SLOT_COUNT; });
+
+		return mSubmitted % SLOT_COUNT;
+	}
+
+	void RenderThread::submit()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		++mSubmitted;
+		mCondition.notify_all();
+	}
+
+	void RenderThread::wait()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		mCondition.wait(lock, [this]() { return mRendered == mSubmitted; });
+	}
+
+	// Private helper functions
+
+	void RenderThread::loop()
+	{
+		NTR_PROFILE_THREAD("Render");
+
+		glfwMakeContextCurrent(mWindow);
+
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		for (;;)
+		{
+			mCondition.wait(lock, [this]() { return mRendered < mSubmitted || mContextRequested || mStopping; });
+
+			// submitted frames go first, so a context request or stop also waits for them
+			if (mRendered < mSubmitted)
+			{
+				const size_t SLOT = mRendered % SLOT_COUNT;
+
+				lock.unlock();
+				mRender(SLOT);
+				lock.lock();
+
+				++mRendered;
+				mCondition.notify_all();
+			}
+			else if (mContextRequested)
+			{
+				glfwMakeContextCurrent(nullptr);
+
+				mContextReleased = true;
+				mCondition.notify_all();
+				mCondition.wait(lock, [this]() { return !mContextRequested; });
+				mContextReleased = false;
+
+				glfwMakeContextCurrent(mWindow);
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		glfwMakeContextCurrent(nullptr);
+	}
+} // namespace ntr
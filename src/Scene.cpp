@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <stack>
 
@@ -5,6 +7,7 @@
 #include <glm/gtx/matrix_decompose.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+#include "Profiler.h"
 #include "Scene.h"
 
 namespace ntr
@@ -15,456 +18,476 @@ namespace ntr
 
     Scene::Scene()
         : selectedCamera{ primaryCamera }
-        , M_DEFAULT_TEXTURE_ALBEDO      { 16, 16, {127.0f, 127.0f, 127.0f, 255.0f} }
-        , M_DEFAULT_TEXTURE_NORMAL      { 16, 16, {127.0f, 127.0f, 255.0f, 255.0f} }
-        , M_DEFAULT_TEXTURE_ROUGHNESS   { 16, 16, {127.0f, 127.0f, 127.0f, 255.0f} }
-        , M_DEFAULT_TEXTURE_METALLIC    { 16, 16, {127.0f, 127.0f, 127.0f, 255.0f} }
-        , M_DEFAULT_TEXTURE_OCCLUSION   { 16, 16, {255.0f, 255.0f, 255.0f, 255.0f} }
-        , M_DEFAULT_MATERIAL { new Material
-            {
-                M_DEFAULT_TEXTURE_ALBEDO.handle(),
-                M_DEFAULT_TEXTURE_NORMAL.handle(),
-                M_DEFAULT_TEXTURE_ROUGHNESS.handle(),
-                M_DEFAULT_TEXTURE_METALLIC.handle(),
-                M_DEFAULT_TEXTURE_OCCLUSION.handle()
-            }
-        }
+        , M_DEFAULT_MATERIAL{}
+        , mMeshes{}
+        , mModels{}
+        , mMaterials{}
+        , mTextures{}
+        , mMeshUsers{}
+        , mMaterialUsers{}
+        , mTextureUsers{}
+        , mModelUsers{}
+        , mUnusedTextures{}
+        , mEntityNames{ registry }
+        , mTransformHierarchy{ registry }
+        , mBVH{ registry, mModels, mMeshes }
     {
-
+        registry.on_construct<ModelHandle>().connect<&Scene::onModelAssigned>(*this);
+        registry.on_update<ModelHandle>().connect<&Scene::onModelAssigned>(*this);
+        registry.on_destroy<ModelHandle>().connect<&Scene::onModelRemoved>(*this);
     }
 
     Scene::~Scene()
     {
-        for (auto& [id, model] : mMapModels)
-        {
-            if (model != Model::EMPTY)
-            {
-                delete model;
-            }
-           
-        }
+        registry.on_construct<ModelHandle>().disconnect<&Scene::onModelAssigned>(*this);
+        registry.on_update<ModelHandle>().disconnect<&Scene::onModelAssigned>(*this);
+        registry.on_destroy<ModelHandle>().disconnect<&Scene::onModelRemoved>(*this);
+    }
 
-        for (auto& [id, material] : mMapMaterials)
-        {
-            if (material != Material::EMPTY)
-            {
-                delete material;
-            }
-        }
+    MeshHandle Scene::addMesh(const std::string& id, Mesh&& mesh)
+    {
+        return mMeshes.add(id, std::move(mesh));
+    }
 
-        for (auto& [id, mesh] : mMapMeshes)
-        {
-            if (mesh != Mesh::EMPTY)
-            {
-                delete mesh;
-            }
-        }
+    MeshHandle Scene::findMesh(const std::string& id) const
+    {
+        return mMeshes.find(id);
     }
 
-    Mesh* Scene::findMesh(const std::string& id)
+    Mesh* Scene::getMesh(MeshHandle mesh)
     {
-        auto itr = mMapMeshes.find(id);
+        return mMeshes.get(mesh);
+    }
 
-        if (itr == mMapMeshes.end())
-        {
-            return Mesh::EMPTY;
-        }
+    const Mesh* Scene::getMesh(MeshHandle mesh) const
+    {
+        return mMeshes.get(mesh);
+    }
 
-        return itr->second;
+    bool Scene::renameMesh(MeshHandle mesh, const std::string& id)
+    {
+        return mMeshes.rename(mesh, id);
     }
 
-    void Scene::replaceMeshID(const std::string& id, const std::string& new_id)
+    void Scene::removeMesh(MeshHandle mesh)
     {
-        if (id == new_id)
+        if (!mMeshes.get(mesh))
         {
             return;
         }
 
-        auto itr = mMapMeshes.find(id);
+        // a used mesh is released by the reference update of its last user, an unused one here
+        const std::vector<ModelHandle> MODELS = mMeshUsers.getUsers(mesh);
 
-        // Return if mesh not found or new id already exists
-        if (itr == mMapMeshes.end() || mMapMeshes.find(new_id) != mMapMeshes.end())
+        if (MODELS.empty())
         {
+            releaseMeshes({ mesh });
             return;
         }
 
-        Mesh* mesh = itr->second;
-
-        mMapMeshes[new_id] = mesh;
-        mRmapMeshes[mesh->vao()] = new_id;
-
-        mMapMeshes.erase(id);
-    }
-
-    void Scene::removeMesh(const std::string& id)
-    {
-        const Mesh* meshToRemove = findMesh(id);
-
-        if (meshToRemove == Mesh::EMPTY)
+        for (ModelHandle model : MODELS)
         {
-            return;
+            mModels.get(model)->replaceMeshes(mesh, {});
+            updateModelReferences(model);
         }
 
-        for (auto& [id, model] : mMapModels)
-        {
-            model->replaceMeshes(meshToRemove, Mesh::EMPTY);
-        }
-            
-        mRmapMeshes.erase(meshToRemove->vao());
-        mMapMeshes.erase(id);
+        mBVH.markModelsChanged();
     }
 
-    Model* Scene::loadModel(const std::string& id, const std::filesystem::path& filepath)
+    ModelHandle Scene::loadModel(const std::string& id, const std::filesystem::path& filepath, WorkerPool* triangleBVHWorkers)
     {
-        Assimp::Importer importer;
-        const aiScene* SCENE = importer.ReadFile(filepath.string().c_str(), aiProcess_Triangulate | aiProcess_GenNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace | aiProcess_ImproveCacheLocality);
+        NTR_PROFILE_SCOPE("Scene::loadModel");
 
-        if (!SCENE || SCENE->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !SCENE->mRootNode)
+        if (mModels.contains(id))
         {
-            std::cerr << "ERROR: could not import file: " << filepath << std::endl;
-            return Model::EMPTY;
+            std::cerr << "ERROR: model with ID \'" << id << "\' exists." << std::endl;
+            return {};
         }
 
-        if (mMapModels.find(id) != mMapModels.end())
+        Assimp::Importer importer;
+        const aiScene* SCENE = readModelFile(importer, filepath);
+
+        if (!SCENE)
         {
-            std::cerr << "ERROR: model with ID \'" << id << "\' exists." << std::endl;
-            return Model::EMPTY;
+            return {};
         }
 
-        std::unordered_set<std::filesystem::path> fileCache;
+        ModelHandle model = mModels.add(id, flattenModel(filepath, SCENE, triangleBVHWorkers));
 
-        Model* model = processModel(filepath, SCENE->mRootNode, SCENE);
-
-        mMapModels.emplace(id, model);
-        mRmapModels.emplace(model, id);
+        updateModelReferences(model);
 
         return model;
     }
 
-    Model* Scene::findModel(const std::string& id)
+    entt::entity Scene::importModel(const std::string& id, const std::filesystem::path& filepath, WorkerPool* triangleBVHWorkers)
     {
-        auto itr = mMapModels.find(id);
+        NTR_PROFILE_SCOPE("Scene::importModel");
+
+        Assimp::Importer importer;
+        const aiScene* SCENE = readModelFile(importer, filepath);
 
-        if (itr == mMapModels.end())
+        if (!SCENE)
         {
-            return Model::EMPTY;
+            return entt::null;
         }
 
-        return itr->second;
+        entt::entity root = processModel(id, filepath, SCENE, triangleBVHWorkers);
+
+        processLights(SCENE, root);
+
+        return root;
     }
 
-    void Scene::replaceModelID(const std::string& id, const std::string& new_id)
+    ModelHandle Scene::addModel(const std::string& id, const Model& model)
     {
-        if (id == new_id)
-        {
-            return;
-        }
+        ModelHandle handle = mModels.add(id, Model(model));
 
-        auto itr = mMapModels.find(id);
+        updateModelReferences(handle);
 
-        // Return if model not found or new id already exists
-        if (itr == mMapModels.end() || mMapModels.find(new_id) != mMapModels.end())
-        {
-            return;
-        }
+        return handle;
+    }
 
-        Model* model = itr->second;
+    ModelHandle Scene::findModel(const std::string& id) const
+    {
+        return mModels.find(id);
+    }
 
-        mMapModels[new_id] = model;
-        mRmapModels[model] = new_id;
+    Model* Scene::getModel(ModelHandle model)
+    {
+        return mModels.get(model);
+    }
 
-        mMapModels.erase(id);
+    const Model* Scene::getModel(ModelHandle model) const
+    {
+        return mModels.get(model);
     }
 
-    void Scene::removeModel(const std::string& id)
+    bool Scene::renameModel(ModelHandle model, const std::string& id)
     {
-        const Model* modelToRemove = findModel(id);
+        return mModels.rename(model, id);
+    }
 
-        if (modelToRemove == Model::EMPTY)
+    void Scene::removeModel(ModelHandle model)
+    {
+        if (!mModels.get(model))
         {
             return;
         }
 
-        auto view = registry.view<ConstPointer<Model>>();
+        // patching an entity drops it from the users
+        const std::vector<entt::entity> ENTITIES = mModelUsers.getUsers(model);
 
-        for (auto [entity, model] : view.each())
+        for (entt::entity entity : ENTITIES)
         {
-            if (model == modelToRemove)
-            {
-                model = Model::EMPTY;
-            }
+            registry.get<ModelHandle>(entity) = {};
+            registry.patch<ModelHandle>(entity);
         }
 
-        mRmapModels.erase(modelToRemove);
-        mMapModels.erase(id);
+        mModels.remove(model);
+
+        updateModelReferences(model);
     }
 
-    TextureHandle Scene::loadTexture(const std::string& id, const std::filesystem::path& filepath)
+    TextureHandle Scene::loadTexture(const std::string& id, const std::filesystem::path& filepath, TextureUsage usage)
     {
-        if (mMapTextures.find(id) != mMapTextures.end())
+        if (mTextures.contains(id))
         {
-            return 0;
+            return {};
         }
 
-        const auto& [itr, inserted] =  mMapTextures.emplace(id, filepath);
-
-        TextureHandle texture = itr->second.handle();
-
-        mRmapTextures.emplace(texture, id);
+        return mTextures.add(id, Texture(filepath, usage));
+    }
 
-        return itr->second.handle();
+    TextureHandle Scene::addTexture(const std::string& id, Texture&& texture)
+    {
+        return mTextures.add(id, std::move(texture));
     }
 
     TextureHandle Scene::findTexture(const std::string& id) const
     {
-        auto itr = mMapTextures.find(id);
+        return mTextures.find(id);
+    }
 
-        if (itr == mMapTextures.end())
-        {
-            return 0;
-        }
+    Texture* Scene::getTexture(TextureHandle texture)
+    {
+        return mTextures.get(texture);
+    }
 
-        return itr->second.handle();
+    const Texture* Scene::getTexture(TextureHandle texture) const
+    {
+        return mTextures.get(texture);
     }
 
-    void Scene::replaceTextureID(const std::string& id, const std::string& new_id)
+    bool Scene::renameTexture(TextureHandle texture, const std::string& id)
     {
-        if (id == new_id)
+        return mTextures.rename(texture, id);
+    }
+
+    void Scene::removeTexture(TextureHandle texture)
+    {
+        if (!mTextures.get(texture))
         {
             return;
         }
 
-        auto itr = mMapTextures.find(id);
+        const std::vector<MaterialHandle> MATERIALS = mTextureUsers.getUsers(texture);
 
-        // Return if texture not found or new id already exists
-        if (itr == mMapTextures.end() || mMapTextures.find(new_id) != mMapTextures.end())
+        for (MaterialHandle material : MATERIALS)
         {
-            return;
+            mMaterials.get(material)->replaceTextures(texture, {});
+            updateMaterialReferences(material);
         }
 
-        TextureHandle handle = itr->second.handle();
+        mTextures.remove(texture);
+    }
+
+    MaterialHandle Scene::addMaterial(const std::string& id, const Material& material)
+    {
+        MaterialHandle handle = mMaterials.add(id, Material(material));
 
-        mMapTextures[new_id] = std::move(itr->second);
-        mRmapTextures[handle] = new_id;
+        updateMaterialReferences(handle);
 
-        mMapTextures.erase(id);
+        return handle;
     }
 
-    void Scene::removeTexture(const std::string& id)
+    MaterialHandle Scene::findMaterial(const std::string& id) const
     {
-        TextureHandle textureToRemove = findTexture(id);
-
-        if (textureToRemove == Texture::EMPTY)
-        {
-            return;
-        }
+        return mMaterials.find(id);
+    }
 
-        for (auto& [id, material] : mMapMaterials)
-        {
-            if (material->albedo == textureToRemove)
-            {
-                material->albedo = Texture::EMPTY;
-            }
-            if (material->normal == textureToRemove)
-            {
-                material->normal = Texture::EMPTY;
-            }
-            if (material->roughness == textureToRemove)
-            {
-                material->roughness = Texture::EMPTY;
-            }
-            if (material->metallic == textureToRemove)
-            {
-                material->metallic = Texture::EMPTY;
-            }
-            if (material->occlusion == textureToRemove)
-            {
-                material->occlusion = Texture::EMPTY;
-            }
-        }
+    Material* Scene::getMaterial(MaterialHandle material)
+    {
+        return mMaterials.get(material);
+    }
 
-        mRmapTextures.erase(textureToRemove);
-        mMapTextures.erase(id);
+    const Material* Scene::getMaterial(MaterialHandle material) const
+    {
+        return mMaterials.get(material);
     }
 
-    Material* Scene::addMaterial(const std::string& id, const Material& material)
+    const Material& Scene::getMaterialOrDefault(MaterialHandle material) const
     {
-        if (mMapMaterials.find(id) != mMapMaterials.end())
-        {
-            return Material::EMPTY;
-        }
+        const Material* sceneMaterial = mMaterials.get(material);
 
-        Material* newMaterial = new Material(material);
+        return sceneMaterial ? *sceneMaterial : M_DEFAULT_MATERIAL;
+    }
 
-        mMapMaterials.emplace(id, newMaterial);
-        mRmapMaterials.emplace(newMaterial, id);
+    bool Scene::renameMaterial(MaterialHandle material, const std::string& id)
+    {
+        return mMaterials.rename(material, id);
+    }
 
-        if (newMaterial->albedo == 0)
-        {
-            newMaterial->albedo = M_DEFAULT_TEXTURE_ALBEDO.handle();
-        }
-        if (newMaterial->normal == 0)
-        {
-            newMaterial->normal = M_DEFAULT_TEXTURE_NORMAL.handle();
-        }
-        if (newMaterial->roughness == 0)
+    void Scene::removeMaterial(MaterialHandle material)
+    {
+        if (!mMaterials.get(material))
         {
-            newMaterial->roughness = M_DEFAULT_TEXTURE_ROUGHNESS.handle();
+            return;
         }
-        if (newMaterial->metallic == 0)
+
+        // a used material is released by the reference update of its last user, an unused one here
+        const std::vector<ModelHandle> MODELS = mMaterialUsers.getUsers(material);
+
+        if (MODELS.empty())
         {
-            newMaterial->metallic = M_DEFAULT_TEXTURE_METALLIC.handle();
+            releaseMaterials({ material });
+            return;
         }
-        if (newMaterial->occlusion == 0)
+
+        for (ModelHandle model : MODELS)
         {
-            newMaterial->occlusion = M_DEFAULT_TEXTURE_OCCLUSION.handle();
+            mModels.get(model)->replaceMaterials(material, {});
+            updateModelReferences(model);
         }
+    }
+
+    std::string Scene::findTextureID(TextureHandle texture) const
+    {
+        const std::string* id = mTextures.findID(texture);
 
-        return newMaterial;
+        return id ? *id : "None";
     }
 
-    Material* Scene::findMaterial(const std::string& id)
+    std::string Scene::findMeshID(MeshHandle mesh) const
     {
-        const auto itr = mMapMaterials.find(id);
+        const std::string* id = mMeshes.findID(mesh);
 
-        if (itr == mMapMaterials.end())
-        {
-            return Material::EMPTY;
-        }
+        return id ? *id : "None";
+    }
 
-        return itr->second;
+    std::string Scene::findModelID(ModelHandle model) const
+    {
+        const std::string* id = mModels.findID(model);
+
+        return id ? *id : "None";
     }
 
-    void Scene::replaceMaterialID(const std::string& id, const std::string& new_id)
+    std::string Scene::findMaterialID(MaterialHandle material) const
     {
-        if (id == new_id)
-        {
-            return;
-        }
+        const std::string* id = mMaterials.findID(material);
 
-        auto itr = mMapMaterials.find(id);
+        return id ? *id : "None";
+    }
 
-        // Return if material not found or new id already exists
-        if (itr == mMapMaterials.end() || mMapMaterials.find(new_id) != mMapMaterials.end())
-        {
-            return;
-        }
+    const AssetMap<Model>& Scene::getModels() const
+    {
+        return mModels;
+    }
 
-        Material* material = itr->second;
+    const AssetMap<Material>& Scene::getMaterials() const
+    {
+        return mMaterials;
+    }
 
-        mMapMaterials[new_id] = material;
-        mRmapMaterials[material] = new_id;
+    const AssetMap<Texture>& Scene::getTextures() const
+    {
+        return mTextures;
+    }
 
-        mMapMaterials.erase(id);
+    const AssetMap<Mesh>& Scene::getMeshes() const
+    {
+        return mMeshes;
     }
 
-    void Scene::removeMaterial(const std::string id)
+    std::string Scene::getUniqueEntityID(const std::string& id)
     {
-        const Material* materialToRemove = findMaterial(id);
+        return mEntityNames.getUnique(id);
+    }
 
-        if (materialToRemove == Material::EMPTY)
-        {
-            return;
-        }
+    entt::entity Scene::findEntity(const std::string& id) const
+    {
+        return mEntityNames.find(id);
+    }
 
-        for (auto& [id, model] : mMapModels)
-        {
-            model->replaceMaterials(materialToRemove, M_DEFAULT_MATERIAL);
-        }
+    bool Scene::renameEntity(entt::entity entity, const std::string& id)
+    {
+        return mEntityNames.rename(entity, id);
+    }
 
-        mRmapMaterials.erase(materialToRemove);
-        mMapMaterials.erase(id);
+    bool Scene::setParent(entt::entity entity, entt::entity parent)
+    {
+        return mTransformHierarchy.setParent(entity, parent);
     }
 
-    std::string Scene::findTextureID(TextureHandle texture) const
+    entt::entity Scene::getParent(entt::entity entity) const
     {
-        auto itr = mRmapTextures.find(texture);
+        return mTransformHierarchy.getParent(entity);
+    }
 
-        if (itr == mRmapTextures.end())
-        {
-            return "None";
-        }
+    void Scene::updateTransforms(WorkerPool& workers)
+    {
+        mTransformHierarchy.update(workers);
+        mBVH.update(mTransformHierarchy.getUpdatedEntities());
+    }
 
-        return itr->second;
+    const SceneBVH& Scene::getBVH() const
+    {
+        return mBVH;
     }
 
-    std::string Scene::findMeshID(const Mesh* mesh) const
+    void Scene::markModelChanged(ModelHandle model)
     {
-        auto itr = mRmapMeshes.find(mesh->vao());
+        updateModelReferences(model);
 
-        if (itr == mRmapMeshes.end())
-        {
-            return "None";
-        }
+        mBVH.markModelsChanged();
+    }
 
-        return itr->second;
+    void Scene::markMaterialChanged(MaterialHandle material)
+    {
+        updateMaterialReferences(material);
     }
 
-    std::string Scene::findMeshID(const MeshInstance& mesh) const
+    bool Scene::hasUnusedTextures() const
     {
-        auto itr = mRmapMeshes.find(mesh.vao);
+        return !mUnusedTextures.empty();
+    }
 
-        if (itr == mRmapMeshes.end())
+    void Scene::releaseUnusedTextures()
+    {
+        for (TextureHandle texture : mUnusedTextures)
         {
-            return "None";
+            // removed already, or used again since
+            if (!mTextures.get(texture) || mTextureUsers.count(texture) > 0)
+            {
+                continue;
+            }
+
+            mTextures.remove(texture);
         }
 
-        return itr->second;
+        mUnusedTextures.clear();
     }
 
-    std::string Scene::findModelID(const Model* model) const
+    //-------------------------------------------------------------------------------------------------
+    // PRIVATE MEMBER FUNCTIONS
+    //-------------------------------------------------------------------------------------------------
+
+    void Scene::updateModelReferences(ModelHandle model)
     {
-        auto itr = mRmapModels.find(model);
+        std::vector<MeshHandle> meshes;
+        std::vector<MaterialHandle> materials;
 
-        if (itr == mRmapModels.end())
+        if (const Model* MODEL = mModels.get(model))
         {
-            return "None";
+            meshes.reserve(MODEL->meshes.size());
+            materials.reserve(MODEL->meshes.size());
+
+            for (const auto& [id, meshInstance] : MODEL->meshes)
+            {
+                meshes.push_back(meshInstance.mesh);
+                materials.push_back(meshInstance.material);
+            }
         }
 
-        return itr->second;
+        std::vector<MeshHandle> unusedMeshes;
+        std::vector<MaterialHandle> unusedMaterials;
+
+        mMeshUsers.set(model, meshes, &unusedMeshes);
+        mMaterialUsers.set(model, materials, &unusedMaterials);
+
+        releaseMeshes(unusedMeshes);
+        releaseMaterials(unusedMaterials);
     }
 
-    std::string Scene::findMaterialID(const Material* material) const
+    void Scene::updateMaterialReferences(MaterialHandle material)
     {
-        auto itr = mRmapMaterials.find(material);
+        std::vector<TextureHandle> textures;
 
-        if (itr == mRmapMaterials.end())
+        if (const Material* MATERIAL = mMaterials.get(material))
         {
-            return "None";
+            textures = { MATERIAL->albedo, MATERIAL->normal, MATERIAL->roughness, MATERIAL->metallic, MATERIAL->occlusion };
         }
 
-        return itr->second;
+        mTextureUsers.set(material, textures, &mUnusedTextures);
     }
 
-    const std::map<std::string, Model*>& Scene::getModelMap() const
+    void Scene::releaseMeshes(const std::vector<MeshHandle>& meshes)
     {
-        return mMapModels;
-    }
-
-    const std::map<std::string, Material*>& Scene::getMaterialMap() const
-    {
-        return mMapMaterials;
+        // the GL objects are deleted once no frame in flight draws them any more
+        for (MeshHandle mesh : meshes)
+        {
+            mMeshes.remove(mesh);
+        }
     }
 
-    const std::map<std::string, Texture>& Scene::getTextureMap() const
+    void Scene::releaseMaterials(const std::vector<MaterialHandle>& materials)
     {
-        return mMapTextures;
+        for (MaterialHandle material : materials)
+        {
+            mMaterials.remove(material);
+            updateMaterialReferences(material);
+        }
     }
 
-    const std::map<std::string, Mesh*>& Scene::getMeshMap() const
+    void Scene::onModelAssigned(entt::registry& registry, entt::entity entity)
     {
-        return mMapMeshes;
+        mModelUsers.set(entity, { registry.get<ModelHandle>(entity) });
     }
 
-    const Material* Scene::getDefaultMaterial() const
+    void Scene::onModelRemoved(entt::registry& registry, entt::entity entity)
     {
-        return M_DEFAULT_MATERIAL;
+        mModelUsers.erase(entity);
     }
 
-    //-------------------------------------------------------------------------------------------------
-    // PRIVATE MEMBER FUNCTIONS
-    //-------------------------------------------------------------------------------------------------
-
     void Scene::processCameras(const aiScene* scene)
     {
         for (size_t i = 0; i < scene->mNumCameras; ++i)
@@ -497,8 +520,17 @@ namespace ntr
         }
     }
 
-    void Scene::processLights(const aiScene* scene)
+    void Scene::processLights(const aiScene* scene, entt::entity root)
     {
+        NTR_PROFILE_SCOPE("Scene::processLights");
+
+        // imported lights have no range, cut them off where intensity / distance^2 drops below 1
+        const float MIN_INTENSITY = 1.0f;
+
+        // root carries the transform of the root node, lights are placed relative to it
+        aiMatrix4x4 toRoot = scene->mRootNode->mTransformation;
+        toRoot.Inverse();
+
         for (size_t i = 0; i < scene->mNumLights; ++i)
         {
             aiLight* ai_light = scene->mLights[i];
@@ -506,81 +538,231 @@ namespace ntr
             switch (ai_light->mType)
             {
             case aiLightSource_POINT:
-                
-                PointLight ntrPointLight;
+            {
+                // light position is relative to the node of the same name
+                aiVector3D ai_position = ai_light->mPosition;
+                const aiNode* ai_node = scene->mRootNode->FindNode(ai_light->mName);
+
+                if (ai_node)
+                {
+                    ai_position = getNodeWorldMatrix(ai_node) * ai_position;
+                }
+
+                ai_position = toRoot * ai_position;
+
+                Transform transform;
 
-                ntrPointLight.position = {
-                    ai_light->mPosition.x,
-                    ai_light->mPosition.y,
-                    ai_light->mPosition.z
+                transform.position = {
+                    ai_position.x,
+                    ai_position.y,
+                    ai_position.z
                 };
 
+                PointLight ntrPointLight;
+                ntrPointLight.position = { 0.0f, 0.0f, 0.0f };
+
                 ntrPointLight.color = {
                     ai_light->mColorDiffuse.r,
                     ai_light->mColorDiffuse.g,
                     ai_light->mColorDiffuse.b
                 };
+
+                float maxIntensity = std::max({ ntrPointLight.color.x, ntrPointLight.color.y, ntrPointLight.color.z });
+                ntrPointLight.radius = std::sqrt(std::max(maxIntensity, 0.0f) / MIN_INTENSITY);
+
+                std::string id = ai_light->mName.length > 0 ? ai_light->mName.C_Str() : "point_light";
+
+                entt::entity entity_light = registry.create();
+
+                registry.emplace<StringID>(entity_light, getUniqueEntityID(id));
+                registry.emplace<Transform>(entity_light, transform);
+                registry.emplace<PointLight>(entity_light, ntrPointLight);
+
+                setParent(entity_light, root);
                 
                 break;
             }
+            default:
+                break;
+            }
+        }
+    }
+
+    aiMatrix4x4 Scene::getNodeWorldMatrix(const aiNode* ai_node) const
+    {
+        aiMatrix4x4 matrix = ai_node->mTransformation;
+
+        for (const aiNode* parent = ai_node->mParent; parent; parent = parent->mParent)
+        {
+            matrix = parent->mTransformation * matrix;
         }
+
+        return matrix;
     }
 
-    Model* Scene::processModel(const std::filesystem::path& modelPath, const aiNode* ai_node, const aiScene* ai_scene)
+    const aiScene* Scene::readModelFile(Assimp::Importer& importer, const std::filesystem::path& modelPath)
     {
-        Model* model = new Model();
+        const aiScene* SCENE = nullptr;
+
+        {
+            NTR_PROFILE_SCOPE("Assimp import");
+            SCENE = importer.ReadFile(modelPath.string().c_str(), aiProcess_Triangulate | aiProcess_GenNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace | aiProcess_ImproveCacheLocality);
+        }
+
+        if (!SCENE || SCENE->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !SCENE->mRootNode)
+        {
+            std::cerr << "ERROR: could not import file: " << modelPath << std::endl;
+            return nullptr;
+        }
+
+        return SCENE;
+    }
+
+    entt::entity Scene::processModel(const std::string& id, const std::filesystem::path& modelPath, const aiScene* ai_scene, WorkerPool* triangleBVHWorkers)
+    {
+        NTR_PROFILE_SCOPE("Scene::processModel");
 
         AssetCache assetCache;
 
-        std::stack<const aiNode*> nodeStack;
-        nodeStack.push(ai_node);
+        // One entity per node with meshes, parented to the entity of its nearest such ancestor, and one for the root node
+        // so the import moves as a whole. Nodes without meshes fold their matrices into the local transforms of the
+        // entities below them, TransformHierarchy composes the rest.
+
+        struct PendingNode
+        {
+            const aiNode*   node;
+            aiMatrix4x4     matrix;     // relative to parent
+            entt::entity    parent;
+        };
+
+        entt::entity root = entt::null;
+
+        std::stack<PendingNode> nodeStack;
+        nodeStack.push({ ai_scene->mRootNode, ai_scene->mRootNode->mTransformation, entt::null });
 
         while (!nodeStack.empty())
         {
-            const aiNode* currentNode = nodeStack.top();
+            const PendingNode CURRENT = nodeStack.top();
             nodeStack.pop();
 
-            // Process child nodes
-
-            Transform meshTransform = processMeshTransform(currentNode, ai_scene);
-            
-            size_t numMeshes = currentNode->mNumMeshes;
+            entt::entity entity = CURRENT.parent;
+            aiMatrix4x4 matrix = CURRENT.matrix;
 
-            for (size_t i = 0; i < numMeshes; ++i)
+            if (CURRENT.parent == entt::null || CURRENT.node->mNumMeshes > 0)
             {
-                aiMesh* ai_mesh = ai_scene->mMeshes[currentNode->mMeshes[i]];
+                const bool IS_ROOT = CURRENT.parent == entt::null;
+                const std::string NODE_ID = IS_ROOT || CURRENT.node->mName.length == 0 ? id : CURRENT.node->mName.C_Str();
 
-                Mesh*       mesh            = processMesh(ai_mesh, ai_scene, assetCache);
-                Material*   meshMaterial    = processMeshMaterial(modelPath, ai_mesh, currentNode, ai_scene, assetCache);
-                std::string meshID          = findMeshID(mesh);
+                entity = registry.create();
 
-                // Handle duplicate mesh id in model
+                registry.emplace<StringID>(entity, getUniqueEntityID(NODE_ID));
+                registry.emplace<Transform>(entity, processMeshTransform(CURRENT.matrix));
 
-                while (model->meshes.find(meshID) != model->meshes.end())
+                if (CURRENT.node->mNumMeshes > 0)
                 {
-                    meshID += "+";
+                    Model model;
+                    processNodeMeshes(modelPath, CURRENT.node, ai_scene, Transform(), assetCache, triangleBVHWorkers, model);
+
+                    ModelHandle handle = mModels.add(mModels.getUniqueID(IS_ROOT ? id : id + "/" + NODE_ID), std::move(model));
+                    updateModelReferences(handle);
+
+                    registry.emplace<ModelHandle>(entity, handle);
                 }
 
-                // Create model
+                if (IS_ROOT)
+                {
+                    root = entity;
+                }
+                else
+                {
+                    setParent(entity, CURRENT.parent);
+                }
 
-                model->meshes.try_emplace(meshID, mesh, meshMaterial, meshTransform).first->second;
+                matrix = aiMatrix4x4();
             }
 
             // push children in nodeStack in reverse to maintain original processing order
 
+            for (int i = (int)CURRENT.node->mNumChildren - 1; i >= 0; --i)
+            {
+                const aiNode* childNode = CURRENT.node->mChildren[i];
+                nodeStack.push({ childNode, matrix * childNode->mTransformation, entity });
+            }
+        }
+
+        return root;
+    }
+
+    Model Scene::flattenModel(const std::filesystem::path& modelPath, const aiScene* ai_scene, WorkerPool* triangleBVHWorkers)
+    {
+        NTR_PROFILE_SCOPE("Scene::flattenModel");
+
+        Model model;
+
+        AssetCache assetCache;
+
+        // every node carries its transform relative to the root node, so meshes keep the transforms of all their parent nodes
+
+        std::stack<std::pair<const aiNode*, aiMatrix4x4>> nodeStack;
+        nodeStack.emplace(ai_scene->mRootNode, ai_scene->mRootNode->mTransformation);
+
+        while (!nodeStack.empty())
+        {
+            const auto [currentNode, currentMatrix] = nodeStack.top();
+            nodeStack.pop();
+
+            processNodeMeshes(modelPath, currentNode, ai_scene, processMeshTransform(currentMatrix), assetCache, triangleBVHWorkers, model);
+
+            // push children in nodeStack in reverse to maintain original processing order
+
             int numChildMeshes = (int)currentNode->mNumChildren;
 
             for (int i = numChildMeshes - 1; i >= 0; --i)
             {
-                nodeStack.push(currentNode->mChildren[i]);
+                const aiNode* childNode = currentNode->mChildren[i];
+                nodeStack.emplace(childNode, currentMatrix * childNode->mTransformation);
             }
         }
 
         return model;
     }
 
-    // Creates the ntr::Mesh from the aiMesh, and returns a pointer to the Mesh
-    Mesh* Scene::processMesh(const aiMesh* ai_mesh, const aiScene* ai_scene, AssetCache& assetCache)
+    void Scene::processNodeMeshes
+    (
+        const std::filesystem::path& modelPath,
+        const aiNode* ai_node,
+        const aiScene* ai_scene,
+        const Transform& meshTransform,
+        AssetCache& assetCache,
+        WorkerPool* triangleBVHWorkers,
+        Model& model
+    )
+    {
+        size_t numMeshes = ai_node->mNumMeshes;
+
+        for (size_t i = 0; i < numMeshes; ++i)
+        {
+            aiMesh* ai_mesh = ai_scene->mMeshes[ai_node->mMeshes[i]];
+
+            MeshHandle      mesh            = processMesh(ai_mesh, ai_scene, assetCache, triangleBVHWorkers);
+            MaterialHandle  meshMaterial    = processMeshMaterial(modelPath, ai_mesh, ai_node, ai_scene, assetCache);
+            std::string     meshID          = findMeshID(mesh);
+
+            // Handle duplicate mesh id in model
+
+            while (model.meshes.find(meshID) != model.meshes.end())
+            {
+                meshID += "+";
+            }
+
+            // Create model
+
+            model.meshes.try_emplace(meshID, mesh, meshMaterial, meshTransform);
+        }
+    }
+
+    // Creates the ntr::Mesh from the aiMesh, and returns its handle
+    MeshHandle Scene::processMesh(const aiMesh* ai_mesh, const aiScene* ai_scene, AssetCache& assetCache, WorkerPool* triangleBVHWorkers)
     {
         // Reuse mesh if it already exists
 
@@ -591,25 +773,19 @@ namespace ntr
             return itr->second;
         }
 
+        NTR_PROFILE_SCOPE("Scene::processMesh");
+
         // New mesh: handle duplicate mesh name in map
 
         std::string meshName = ai_mesh->mName.C_Str();
 
-        std::string idToUse = meshName;
-        
-        while (mMapMeshes.find(idToUse) != mMapMeshes.end())
-        {
-            idToUse += "+";
-        }
+        std::string idToUse = mMeshes.getUniqueID(meshName);
 
         // Create and store mesh in map
 
         auto [vertices, indices] = processMeshVerticesAndIndices(ai_mesh);
 
-        Mesh* mesh = new Mesh(std::move(vertices), std::move(indices));
-
-        mMapMeshes.emplace(idToUse, mesh);
-        mRmapMeshes.emplace(mesh->vao(), idToUse);
+        MeshHandle mesh = mMeshes.add(idToUse, Mesh(std::move(vertices), std::move(indices), RenderUsage::DYNAMIC, meshCpuData, triangleBVHWorkers));
 
         // Record mesh in cache for reuse
         assetCache.meshes.try_emplace(ai_mesh, mesh);
@@ -619,6 +795,8 @@ namespace ntr
 
     std::pair<std::vector<Vertex>, std::vector<GLuint>> Scene::processMeshVerticesAndIndices(const aiMesh* ai_mesh)
     {
+        NTR_PROFILE_SCOPE("Scene::processMeshVerticesAndIndices");
+
         std::vector<Vertex> vertices;
         std::vector<GLuint> indices;
 
@@ -695,7 +873,7 @@ namespace ntr
         return { vertices, indices };
     }
 
-    Material* Scene::processMeshMaterial
+    MaterialHandle Scene::processMeshMaterial
     (
         const std::filesystem::path& modelPath, 
         const aiMesh* ai_mesh, 
@@ -704,6 +882,8 @@ namespace ntr
         AssetCache& assetCache
     )
     {
+        NTR_PROFILE_SCOPE("Scene::processMeshMaterial");
+
         aiMaterial* ai_mesh_material = ai_scene->mMaterials[ai_mesh->mMaterialIndex];
 
         // Reuse material if it already exists
@@ -721,91 +901,82 @@ namespace ntr
 
         std::string materialIDToUse = std::string(ai_node->mName.C_Str()) + " - " + ai_mesh->mName.C_Str() + " - " + materialName;
 
-        while (findMaterial(materialIDToUse) != Material::EMPTY)
-        {
-            materialIDToUse += "+";
-        }
+        materialIDToUse = mMaterials.getUniqueID(materialIDToUse);
 
         // process material and textures, then add them to mesh instance
 
-        TextureHandle mapAlbedo = processMaterialTexture(modelPath, ai_mesh_material, aiTextureType_DIFFUSE, 0, assetCache);
-        TextureHandle mapNormal = processMaterialTexture(modelPath, ai_mesh_material, aiTextureType_NORMALS, 0, assetCache);
-        TextureHandle mapRoughness = processMaterialTexture(modelPath, ai_mesh_material, aiTextureType_DIFFUSE_ROUGHNESS, 0, assetCache);
-        TextureHandle mapMetallic = processMaterialTexture(modelPath, ai_mesh_material, aiTextureType_METALNESS, 0, assetCache);
-        TextureHandle mapAO = processMaterialTexture(modelPath, ai_mesh_material, aiTextureType_AMBIENT_OCCLUSION, 0, assetCache);
+        TextureHandle mapAlbedo = processMaterialTexture(modelPath, ai_mesh_material, aiTextureType_DIFFUSE, TextureUsage::COLOR, 0, assetCache);
+        TextureHandle mapNormal = processMaterialTexture(modelPath, ai_mesh_material, aiTextureType_NORMALS, TextureUsage::NORMAL, 0, assetCache);
+        TextureHandle mapRoughness = processMaterialTexture(modelPath, ai_mesh_material, aiTextureType_DIFFUSE_ROUGHNESS, TextureUsage::SINGLE_CHANNEL, 0, assetCache);
+        TextureHandle mapMetallic = processMaterialTexture(modelPath, ai_mesh_material, aiTextureType_METALNESS, TextureUsage::SINGLE_CHANNEL, 0, assetCache);
+        TextureHandle mapAO = processMaterialTexture(modelPath, ai_mesh_material, aiTextureType_AMBIENT_OCCLUSION, TextureUsage::SINGLE_CHANNEL, 0, assetCache);
 
-        Material* ntr_material;
-        bool sameAsDefaultMaterial = true;
+        Material material;
+        material.albedo = mapAlbedo;
+        material.normal = mapNormal;
+        material.roughness = mapRoughness;
+        material.metallic = mapMetallic;
+        material.occlusion = mapAO;
 
-        if (mapAlbedo == Texture::EMPTY)
-        {
-            mapAlbedo = M_DEFAULT_TEXTURE_ALBEDO.handle();
-        }
-        else
-        {
-            sameAsDefaultMaterial = false;
-        }
+        // factors scale their map, so a map starts from a neutral factor and a missing map keeps the Material default,
+        // explicit factors (glTF) override both
 
-        if (mapNormal == Texture::EMPTY)
-        {
-            mapNormal = M_DEFAULT_TEXTURE_NORMAL.handle();
-        }
-        else
+        if (mapAlbedo)
         {
-            sameAsDefaultMaterial = false;
+            material.baseColorFactor = glm::vec4(1.0f);
         }
 
-        if (mapRoughness == Texture::EMPTY)
-        {
-            mapRoughness = M_DEFAULT_TEXTURE_ROUGHNESS.handle();
-        }
-        else
+        if (mapRoughness)
         {
-            sameAsDefaultMaterial = false;
+            material.roughnessFactor = 1.0f;
         }
 
-        if (mapMetallic == Texture::EMPTY)
+        if (mapMetallic)
         {
-            mapMetallic = M_DEFAULT_TEXTURE_METALLIC.handle();
-        }
-        else
-        {
-            sameAsDefaultMaterial = false;
+            material.metallicFactor = 1.0f;
         }
 
-        if (mapAO == Texture::EMPTY)
-        {
-            mapAO = M_DEFAULT_TEXTURE_OCCLUSION.handle();
-        }
-        else
+        bool hasFactors = false;
+
+        aiColor4D ai_base_color;
+        float ai_factor;
+
+        if (ai_mesh_material->Get(AI_MATKEY_BASE_COLOR, ai_base_color) == AI_SUCCESS)
         {
-            sameAsDefaultMaterial = false;
+            // glTF factors are linear, Material stores base color in the same sRGB space as albedo maps
+            material.baseColorFactor.x = std::pow(ai_base_color.r, 1.0f / 2.2f);
+            material.baseColorFactor.y = std::pow(ai_base_color.g, 1.0f / 2.2f);
+            material.baseColorFactor.z = std::pow(ai_base_color.b, 1.0f / 2.2f);
+            material.baseColorFactor.w = ai_base_color.a;
+            hasFactors = true;
         }
 
-        if (sameAsDefaultMaterial)
+        if (ai_mesh_material->Get(AI_MATKEY_ROUGHNESS_FACTOR, ai_factor) == AI_SUCCESS)
         {
-            ntr_material = M_DEFAULT_MATERIAL;
+            material.roughnessFactor = ai_factor;
+            hasFactors = true;
         }
-        else
+
+        if (ai_mesh_material->Get(AI_MATKEY_METALLIC_FACTOR, ai_factor) == AI_SUCCESS)
         {
-            ntr_material = addMaterial(materialIDToUse, {});
-            ntr_material->albedo = mapAlbedo;
-            ntr_material->normal = mapNormal;
-            ntr_material->roughness = mapRoughness;
-            ntr_material->metallic = mapMetallic;
-            ntr_material->occlusion = mapAO;
+            material.metallicFactor = ai_factor;
+            hasFactors = true;
         }
 
+        const bool HAS_MAPS = mapAlbedo || mapNormal || mapRoughness || mapMetallic || mapAO;
+
+        MaterialHandle ntr_material = HAS_MAPS || hasFactors ? addMaterial(materialIDToUse, material) : MaterialHandle{};
+
         // Record material in cache for reuse
         assetCache.materials.emplace(materialName, ntr_material);
 
         return ntr_material;
     }
 
-    Transform Scene::processMeshTransform(const aiNode* ai_node, const aiScene* ai_scene)
+    Transform Scene::processMeshTransform(const aiMatrix4x4& ai_matrix)
     {
         aiVector3D ai_pos, ai_scl, ai_rot;
-        ai_node->mTransformation.Decompose(ai_scl, ai_rot, ai_pos);
+        ai_matrix.Decompose(ai_scl, ai_rot, ai_pos);
 
         Transform ntr_transform;
         ntr_transform.position.x = ai_pos.x;
@@ -826,6 +997,7 @@ namespace ntr
         const std::filesystem::path& modelPath, 
         const aiMaterial* ai_material, 
         aiTextureType ai_texture_type, 
+        TextureUsage usage,
         unsigned int index, 
         AssetCache& assetCache
     )
@@ -834,7 +1006,7 @@ namespace ntr
         
         if (ai_material->GetTexture(ai_texture_type, index, &ai_texture_path) != AI_SUCCESS)
         {
-            return Texture::EMPTY;
+            return {};
         }
 
         std::filesystem::path texturePath = modelPath.parent_path().append(ai_texture_path.C_Str());
@@ -848,16 +1020,13 @@ namespace ntr
             return itr->second;
         }
 
-        // Load texture if not loaded, handle duplicate id, record in cache for reuse
+        NTR_PROFILE_SCOPE("Scene::processMaterialTexture");
 
-        std::string idToUse = texturePath.filename().string();
+        // Load texture if not loaded, handle duplicate id, record in cache for reuse
 
-        while (findTexture(idToUse) != Texture::EMPTY)
-        {
-            idToUse += "+";
-        }
+        std::string idToUse = mTextures.getUniqueID(texturePath.filename().string());
 
-        TextureHandle handle = loadTexture(idToUse, texturePath);
+        TextureHandle handle = loadTexture(idToUse, texturePath, usage);
 
         // Record texture in cache for reuse
         assetCache.textures.emplace(texturePath, handle);
@@ -888,5 +1057,6 @@ namespace ntr
 
         return transform;
     }
+
 } // namespace ntr
 
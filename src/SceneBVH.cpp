@@ -0,0 +1,778 @@
+#include <algorithm>
+#include <numeric>
+
+#include <glm/matrix.hpp>
+
+#include "Profiler.h"
+#include "SceneBVH.h"
+#include "SimdMath.h"
+
+namespace ntr
+{
+	namespace
+	{
+		constexpr float INF = std::numeric_limits<float>::infinity();
+
+		AABB getEmptyAABB()
+		{
+			return { { INF, INF, INF }, { -INF, -INF, -INF } };
+		}
+
+		void grow(AABB& aabb, const AABB& other)
+		{
+			aabb.min = glm::min(aabb.min, other.min);
+			aabb.max = glm::max(aabb.max, other.max);
+		}
+
+		void grow(AABB& aabb, const glm::vec3& point)
+		{
+			aabb.min = glm::min(aabb.min, point);
+			aabb.max = glm::max(aabb.max, point);
+		}
+
+		float getSurfaceArea(const AABB& aabb)
+		{
+			const glm::vec3 EXTENT = aabb.max - aabb.min;
+
+			return 2.0f * (EXTENT.x * EXTENT.y + EXTENT.y * EXTENT.z + EXTENT.z * EXTENT.x);
+		}
+
+		bool overlaps(const AABB& a, const AABB& b)
+		{
+			return a.min.x <= b.max.x && a.max.x >= b.min.x
+				&& a.min.y <= b.max.y && a.max.y >= b.min.y
+				&& a.min.z <= b.max.z && a.max.z >= b.min.z;
+		}
+
+		bool overlaps(const AABB& aabb, const glm::vec3& center, float radiusSquared)
+		{
+			const glm::vec3 OFFSET = glm::clamp(center, aabb.min, aabb.max) - center;
+
+			return glm::dot(OFFSET, OFFSET) <= radiusSquared;
+		}
+
+		// Slab test. entry is where the ray enters the box, 0 if it starts inside.
+		bool intersectRayAABB(const glm::vec3& origin, const glm::vec3& inverseDirection, const AABB& aabb, float maxDistance, float& entry)
+		{
+			float tNear = 0.0f;
+			float tFar = maxDistance;
+
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const float T1 = (aabb.min[axis] - origin[axis]) * inverseDirection[axis];
+				const float T2 = (aabb.max[axis] - origin[axis]) * inverseDirection[axis];
+
+				tNear = std::max(tNear, std::min(T1, T2));
+				tFar = std::min(tFar, std::max(T1, T2));
+			}
+
+			entry = tNear;
+
+			return tNear <= tFar;
+		}
+	}
+
+	SceneBVH::SceneBVH(entt::registry& registry, const AssetMap<Model>& models, const AssetMap<Mesh>& meshes)
+		: mRegistry{ registry }
+		, mModels{ models }
+		, mMeshes{ meshes }
+		, mNodes{}
+		, mItems{}
+		, mItemLeaves{}
+		, mIndices{}
+		, mModelBounds{}
+		, mRefitCount{ 0 }
+		, mStructureChanged{ true }
+	{
+		mRegistry.on_construct<ModelHandle>().connect<&SceneBVH::onStructureChanged>(*this);
+		mRegistry.on_update<ModelHandle>().connect<&SceneBVH::onStructureChanged>(*this);
+		mRegistry.on_destroy<ModelHandle>().connect<&SceneBVH::onStructureChanged>(*this);
+
+		mRegistry.on_construct<WorldMatrix>().connect<&SceneBVH::onStructureChanged>(*this);
+		mRegistry.on_destroy<WorldMatrix>().connect<&SceneBVH::onStructureChanged>(*this);
+	}
+
+	SceneBVH::~SceneBVH()
+	{
+		mRegistry.on_construct<ModelHandle>().disconnect<&SceneBVH::onStructureChanged>(*this);
+		mRegistry.on_update<ModelHandle>().disconnect<&SceneBVH::onStructureChanged>(*this);
+		mRegistry.on_destroy<ModelHandle>().disconnect<&SceneBVH::onStructureChanged>(*this);
+
+		mRegistry.on_construct<WorldMatrix>().disconnect<&SceneBVH::onStructureChanged>(*this);
+		mRegistry.on_destroy<WorldMatrix>().disconnect<&SceneBVH::onStructureChanged>(*this);
+	}
+
+	void SceneBVH::update(const std::vector<entt::entity>& movedEntities)
+	{
+		if (mStructureChanged)
+		{
+			rebuild();
+			return;
+		}
+
+		std::vector<uint32_t> items;
+
+		for (entt::entity entity : movedEntities)
+		{
+			auto found = mIndices.find(entity);
+
+			if (found != mIndices.end())
+			{
+				items.push_back(found->second);
+			}
+		}
+
+		if (items.empty())
+		{
+			return;
+		}
+
+		// Refitting keeps the topology, which degrades as entities drift away from where they were built. Once as many
+		// refits as entities have piled up, a rebuild has paid for itself.
+		if (mRefitCount + items.size() > mItems.size())
+		{
+			rebuild();
+			return;
+		}
+
+		NTR_PROFILE_SCOPE("Refit scene BVH");
+
+		refit(items);
+
+		mRefitCount += items.size();
+
+		NTR_PROFILE_COUNTER("BVH entities refit", items.size());
+	}
+
+	void SceneBVH::markModelsChanged()
+	{
+		mStructureChanged = true;
+	}
+
+	bool SceneBVH::raycast(const Ray& ray, RayHit& hit, float maxDistance) const
+	{
+		if (mNodes.empty())
+		{
+			return false;
+		}
+
+		const glm::vec3 INVERSE_DIRECTION = 1.0f / ray.direction;
+
+		float nearest = maxDistance;
+		bool found = false;
+		float entry = 0.0f;
+
+		if (!intersectRayAABB(ray.origin, INVERSE_DIRECTION, mNodes[0].bounds, nearest, entry))
+		{
+			return false;
+		}
+
+		std::vector<std::pair<uint32_t, float>> stack;
+		stack.emplace_back(0, entry);
+
+		while (!stack.empty())
+		{
+			const auto [index, nodeEntry] = stack.back();
+			stack.pop_back();
+
+			// a nearer hit was found after the node was pushed
+			if (nodeEntry > nearest)
+			{
+				continue;
+			}
+
+			const Node& node = mNodes[index];
+
+			if (node.count > 0)
+			{
+				for (uint32_t i = node.first; i < node.first + node.count; ++i)
+				{
+					if (intersectRayAABB(ray.origin, INVERSE_DIRECTION, mItems[i].bounds, nearest, entry)
+						&& intersectEntity(ray, mItems[i].entity, nearest, hit))
+					{
+						nearest = hit.distance;
+						found = true;
+					}
+				}
+
+				continue;
+			}
+
+			// the nearer child is pushed last, so it is visited first and can cull the other one
+
+			float leftEntry = 0.0f;
+			float rightEntry = 0.0f;
+
+			const bool HIT_LEFT = intersectRayAABB(ray.origin, INVERSE_DIRECTION, mNodes[node.first].bounds, nearest, leftEntry);
+			const bool HIT_RIGHT = intersectRayAABB(ray.origin, INVERSE_DIRECTION, mNodes[node.first + 1].bounds, nearest, rightEntry);
+
+			if (HIT_LEFT && HIT_RIGHT)
+			{
+				if (leftEntry < rightEntry)
+				{
+					stack.emplace_back(node.first + 1, rightEntry);
+					stack.emplace_back(node.first, leftEntry);
+				}
+				else
+				{
+					stack.emplace_back(node.first, leftEntry);
+					stack.emplace_back(node.first + 1, rightEntry);
+				}
+			}
+			else if (HIT_LEFT)
+			{
+				stack.emplace_back(node.first, leftEntry);
+			}
+			else if (HIT_RIGHT)
+			{
+				stack.emplace_back(node.first + 1, rightEntry);
+			}
+		}
+
+		return found;
+	}
+
+	void SceneBVH::raycastAll(const Ray& ray, std::vector<RayHit>& hits, float maxDistance) const
+	{
+		hits.clear();
+
+		if (mNodes.empty())
+		{
+			return;
+		}
+
+		const glm::vec3 INVERSE_DIRECTION = 1.0f / ray.direction;
+
+		std::vector<uint32_t> stack = { 0 };
+
+		while (!stack.empty())
+		{
+			const Node& node = mNodes[stack.back()];
+			stack.pop_back();
+
+			float entry = 0.0f;
+
+			if (!intersectRayAABB(ray.origin, INVERSE_DIRECTION, node.bounds, maxDistance, entry))
+			{
+				continue;
+			}
+
+			if (node.count == 0)
+			{
+				stack.push_back(node.first);
+				stack.push_back(node.first + 1);
+				continue;
+			}
+
+			for (uint32_t i = node.first; i < node.first + node.count; ++i)
+			{
+				RayHit hit;
+
+				if (intersectRayAABB(ray.origin, INVERSE_DIRECTION, mItems[i].bounds, maxDistance, entry)
+					&& intersectEntity(ray, mItems[i].entity, maxDistance, hit))
+				{
+					hits.push_back(std::move(hit));
+				}
+			}
+		}
+
+		std::sort(hits.begin(), hits.end(), [](const RayHit& a, const RayHit& b)
+		{
+			return a.distance < b.distance;
+		});
+	}
+
+	void SceneBVH::queryAABB(const AABB& aabb, std::vector<entt::entity>& entities) const
+	{
+		entities.clear();
+
+		if (mNodes.empty())
+		{
+			return;
+		}
+
+		std::vector<uint32_t> stack = { 0 };
+
+		while (!stack.empty())
+		{
+			const Node& node = mNodes[stack.back()];
+			stack.pop_back();
+
+			if (!overlaps(node.bounds, aabb))
+			{
+				continue;
+			}
+
+			if (node.count == 0)
+			{
+				stack.push_back(node.first);
+				stack.push_back(node.first + 1);
+				continue;
+			}
+
+			for (uint32_t i = node.first; i < node.first + node.count; ++i)
+			{
+				if (overlaps(mItems[i].bounds, aabb))
+				{
+					entities.push_back(mItems[i].entity);
+				}
+			}
+		}
+	}
+
+	void SceneBVH::querySphere(const glm::vec3& center, float radius, std::vector<entt::entity>& entities) const
+	{
+		entities.clear();
+
+		if (mNodes.empty())
+		{
+			return;
+		}
+
+		const float RADIUS_SQUARED = radius * radius;
+
+		std::vector<uint32_t> stack = { 0 };
+
+		while (!stack.empty())
+		{
+			const Node& node = mNodes[stack.back()];
+			stack.pop_back();
+
+			if (!overlaps(node.bounds, center, RADIUS_SQUARED))
+			{
+				continue;
+			}
+
+			if (node.count == 0)
+			{
+				stack.push_back(node.first);
+				stack.push_back(node.first + 1);
+				continue;
+			}
+
+			for (uint32_t i = node.first; i < node.first + node.count; ++i)
+			{
+				if (overlaps(mItems[i].bounds, center, RADIUS_SQUARED))
+				{
+					entities.push_back(mItems[i].entity);
+				}
+			}
+		}
+	}
+
+	size_t SceneBVH::size() const
+	{
+		return mItems.size();
+	}
+
+	size_t SceneBVH::nodeCount() const
+	{
+		return mNodes.size();
+	}
+
+	// Private helper functions
+
+	void SceneBVH::onStructureChanged(entt::registry& registry, entt::entity entity)
+	{
+		mStructureChanged = true;
+	}
+
+	void SceneBVH::rebuild()
+	{
+		NTR_PROFILE_SCOPE("Rebuild scene BVH");
+
+		// models may have been edited or removed since the last build
+		mModelBounds.clear();
+
+		mNodes.clear();
+		mItems.clear();
+		mIndices.clear();
+
+		for (const auto& [entity, model, world] : mRegistry.view<ModelHandle, WorldMatrix>().each())
+		{
+			AABB bounds;
+
+			if (getModelBounds(model, bounds))
+			{
+				mItems.push_back({ entity, {} });
+			}
+		}
+
+		std::vector<uint32_t> order(mItems.size());
+		std::iota(order.begin(), order.end(), 0);
+
+		computeItemBounds(order.data(), order.size());
+
+		std::vector<glm::vec3> centroids(mItems.size());
+
+		for (size_t i = 0; i < mItems.size(); ++i)
+		{
+			centroids[i] = (mItems[i].bounds.min + mItems[i].bounds.max) * 0.5f;
+		}
+
+		if (!mItems.empty())
+		{
+			mNodes.reserve(2 * mItems.size());
+			mNodes.push_back({ getEmptyAABB(), 0, (uint32_t)mItems.size(), NO_PARENT });
+
+			std::vector<uint32_t> stack = { 0 };
+
+			while (!stack.empty())
+			{
+				const uint32_t INDEX = stack.back();
+				stack.pop_back();
+
+				if (splitNode(INDEX, order, centroids))
+				{
+					stack.push_back(mNodes[INDEX].first);
+					stack.push_back(mNodes[INDEX].first + 1);
+				}
+			}
+		}
+
+		// store the items in leaf order, so every leaf is a contiguous range
+
+		std::vector<Item> items(mItems.size());
+
+		for (size_t i = 0; i < order.size(); ++i)
+		{
+			items[i] = mItems[order[i]];
+		}
+
+		mItems.swap(items);
+		mItemLeaves.resize(mItems.size());
+
+		for (uint32_t node = 0; node < (uint32_t)mNodes.size(); ++node)
+		{
+			for (uint32_t i = mNodes[node].first; i < mNodes[node].first + mNodes[node].count; ++i)
+			{
+				mItemLeaves[i] = node;
+				mIndices.emplace(mItems[i].entity, i);
+			}
+		}
+
+		NTR_PROFILE_COUNTER("BVH nodes", mNodes.size());
+
+		mRefitCount = 0;
+		mStructureChanged = false;
+	}
+
+	void SceneBVH::refit(const std::vector<uint32_t>& items)
+	{
+		computeItemBounds(items.data(), items.size());
+
+		// children come after their parent, so one backward pass refits everything
+		if (items.size() * 4 > mNodes.size())
+		{
+			for (size_t i = mNodes.size(); i-- > 0;)
+			{
+				fitNode((uint32_t)i);
+			}
+
+			return;
+		}
+
+		// once a node keeps its bounds, so do its ancestors
+		for (uint32_t item : items)
+		{
+			uint32_t node = mItemLeaves[item];
+
+			while (node != NO_PARENT && fitNode(node))
+			{
+				node = mNodes[node].parent;
+			}
+		}
+	}
+
+	void SceneBVH::computeItemBounds(const uint32_t* items, size_t count)
+	{
+		glm::mat4 matrices[simd::BATCH_SIZE];
+		AABB locals[simd::BATCH_SIZE];
+		AABB worlds[simd::BATCH_SIZE];
+
+		for (size_t first = 0; first < count; first += simd::BATCH_SIZE)
+		{
+			const size_t COUNT = std::min(simd::BATCH_SIZE, count - first);
+
+			for (size_t i = 0; i < COUNT; ++i)
+			{
+				const entt::entity ENTITY = mItems[items[first + i]].entity;
+
+				matrices[i] = mRegistry.get<WorldMatrix>(ENTITY).model;
+				locals[i] = {};
+
+				getModelBounds(mRegistry.get<ModelHandle>(ENTITY), locals[i]);
+			}
+
+			simd::transformAABBs(matrices, locals, COUNT, worlds);
+
+			for (size_t i = 0; i < COUNT; ++i)
+			{
+				mItems[items[first + i]].bounds = worlds[i];
+			}
+		}
+	}
+
+	bool SceneBVH::fitNode(uint32_t index)
+	{
+		Node& node = mNodes[index];
+		AABB bounds = getEmptyAABB();
+
+		if (node.count > 0)
+		{
+			for (uint32_t i = node.first; i < node.first + node.count; ++i)
+			{
+				grow(bounds, mItems[i].bounds);
+			}
+		}
+		else
+		{
+			grow(bounds, mNodes[node.first].bounds);
+			grow(bounds, mNodes[node.first + 1].bounds);
+		}
+
+		const bool CHANGED = bounds.min != node.bounds.min || bounds.max != node.bounds.max;
+
+		node.bounds = bounds;
+
+		return CHANGED;
+	}
+
+	bool SceneBVH::splitNode(uint32_t index, std::vector<uint32_t>& order, const std::vector<glm::vec3>& centroids)
+	{
+		const uint32_t FIRST = mNodes[index].first;
+		const uint32_t COUNT = mNodes[index].count;
+		const uint32_t END = FIRST + COUNT;
+
+		AABB bounds = getEmptyAABB();
+		AABB centroidBounds = getEmptyAABB();
+
+		for (uint32_t i = FIRST; i < END; ++i)
+		{
+			grow(bounds, mItems[order[i]].bounds);
+			grow(centroidBounds, centroids[order[i]]);
+		}
+
+		mNodes[index].bounds = bounds;
+
+		if (COUNT <= MAX_LEAF_SIZE)
+		{
+			return false;
+		}
+
+		// Bin the centroids along every axis and take the plane between two bins with the lowest surface area cost,
+		// the area of each side times the entities in it.
+
+		struct Bin
+		{
+			AABB		bounds = getEmptyAABB();
+			uint32_t	count = 0;
+		};
+
+		auto getBin = [&centroidBounds, &centroids](uint32_t item, int axis, float scale)
+		{
+			return std::min(BIN_COUNT - 1, (uint32_t)((centroids[item][axis] - centroidBounds.min[axis]) * scale));
+		};
+
+		float bestCost = INF;
+		int bestAxis = -1;
+		uint32_t bestPlane = 0;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float EXTENT = centroidBounds.max[axis] - centroidBounds.min[axis];
+
+			if (EXTENT <= 0.0f)
+			{
+				continue;
+			}
+
+			const float SCALE = BIN_COUNT / EXTENT;
+
+			Bin bins[BIN_COUNT];
+
+			for (uint32_t i = FIRST; i < END; ++i)
+			{
+				Bin& bin = bins[getBin(order[i], axis, SCALE)];
+
+				grow(bin.bounds, mItems[order[i]].bounds);
+				++bin.count;
+			}
+
+			// plane i splits bins [0, i) from [i, BIN_COUNT)
+
+			float rightAreas[BIN_COUNT];
+			uint32_t rightCounts[BIN_COUNT];
+			Bin right;
+
+			for (uint32_t plane = BIN_COUNT - 1; plane > 0; --plane)
+			{
+				grow(right.bounds, bins[plane].bounds);
+				right.count += bins[plane].count;
+
+				rightAreas[plane] = getSurfaceArea(right.bounds);
+				rightCounts[plane] = right.count;
+			}
+
+			Bin left;
+
+			for (uint32_t plane = 1; plane < BIN_COUNT; ++plane)
+			{
+				grow(left.bounds, bins[plane - 1].bounds);
+				left.count += bins[plane - 1].count;
+
+				if (left.count == 0 || rightCounts[plane] == 0)
+				{
+					continue;
+				}
+
+				const float COST = getSurfaceArea(left.bounds) * left.count + rightAreas[plane] * rightCounts[plane];
+
+				if (COST < bestCost)
+				{
+					bestCost = COST;
+					bestAxis = axis;
+					bestPlane = plane;
+				}
+			}
+		}
+
+		uint32_t middle = FIRST + COUNT / 2;
+
+		// without a plane every centroid is the same point, any split is as good as another
+		if (bestAxis >= 0)
+		{
+			const float SCALE = BIN_COUNT / (centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis]);
+
+			auto split = std::partition(order.begin() + FIRST, order.begin() + END, [&getBin, bestAxis, bestPlane, SCALE](uint32_t item)
+			{
+				return getBin(item, bestAxis, SCALE) < bestPlane;
+			});
+
+			const uint32_t SPLIT = (uint32_t)(split - order.begin());
+
+			if (SPLIT > FIRST && SPLIT < END)
+			{
+				middle = SPLIT;
+			}
+		}
+
+		const uint32_t LEFT = (uint32_t)mNodes.size();
+
+		mNodes.push_back({ getEmptyAABB(), FIRST, middle - FIRST, index });
+		mNodes.push_back({ getEmptyAABB(), middle, END - middle, index });
+
+		mNodes[index].first = LEFT;
+		mNodes[index].count = 0;
+
+		return true;
+	}
+
+	bool SceneBVH::getModelBounds(ModelHandle handle, AABB& bounds)
+	{
+		auto found = mModelBounds.find(handle);
+
+		if (found != mModelBounds.end())
+		{
+			bounds = found->second;
+			return true;
+		}
+
+		const Model* model = mModels.get(handle);
+
+		if (!model)
+		{
+			return false;
+		}
+
+		AABB modelBounds = getEmptyAABB();
+		bool hasGeometry = false;
+
+		for (const auto& [id, mesh] : model->meshes)
+		{
+			const Mesh* meshData = mMeshes.get(mesh.mesh);
+
+			if (!meshData || meshData->indexCount() == 0)
+			{
+				continue;
+			}
+
+			AABB meshBounds;
+			simd::transformAABBs(&mesh.matrix.model, &meshData->bounds(), 1, &meshBounds);
+
+			grow(modelBounds, meshBounds);
+			hasGeometry = true;
+		}
+
+		if (!hasGeometry)
+		{
+			return false;
+		}
+
+		mModelBounds.emplace(handle, modelBounds);
+		bounds = modelBounds;
+
+		return true;
+	}
+
+	bool SceneBVH::intersectEntity(const Ray& ray, entt::entity entity, float maxDistance, RayHit& hit) const
+	{
+		const ModelHandle* handle = mRegistry.try_get<ModelHandle>(entity);
+		const WorldMatrix* world = mRegistry.try_get<WorldMatrix>(entity);
+		const Model* model = handle ? mModels.get(*handle) : nullptr;
+
+		if (!model || !world)
+		{
+			return false;
+		}
+
+		bool found = false;
+
+		// an affine transform keeps distances along the ray in units of the transformed direction
+		for (const auto& [id, mesh] : model->meshes)
+		{
+			const Mesh* meshData = mMeshes.get(mesh.mesh);
+
+			if (!meshData || meshData->indexCount() == 0)
+			{
+				continue;
+			}
+
+			const glm::mat4 TO_MESH = glm::inverse(world->model * mesh.matrix.model);
+			const Ray MESH_RAY = { glm::vec3(TO_MESH * glm::vec4(ray.origin, 1.0f)), glm::vec3(TO_MESH * glm::vec4(ray.direction, 0.0f)) };
+
+			TriangleHit triangleHit;
+			float entry = 0.0f;
+
+			if (meshData->hasTriangleBVH())
+			{
+				if (!meshData->raycast(MESH_RAY, maxDistance, triangleHit))
+				{
+					continue;
+				}
+
+				hit.distance = triangleHit.distance;
+				hit.exact = true;
+				hit.triangle = triangleHit.triangle;
+				hit.barycentrics = { triangleHit.u, triangleHit.v };
+			}
+			else
+			{
+				if (!intersectRayAABB(MESH_RAY.origin, 1.0f / MESH_RAY.direction, meshData->bounds(), maxDistance, entry))
+				{
+					continue;
+				}
+
+				hit.distance = entry;
+				hit.exact = false;
+			}
+
+			hit.entity = entity;
+			hit.meshID = id;
+			maxDistance = hit.distance;
+			found = true;
+		}
+
+		return found;
+	}
+} // namespace ntr
@@ -0,0 +1,1067 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+#include <unordered_map>
+
+#include "MappedFile.h"
+#include "Profiler.h"
+#include "SceneFile.h"
+#include "TextureFile.h"
+
+namespace ntr
+{
+	namespace
+	{
+		const char MAGIC[4] = { 'N', 'T', 'R', 'S' };
+
+		constexpr uint64_t ALIGNMENT = 64;
+
+		constexpr uint32_t NONE				= UINT32_MAX;
+		constexpr uint32_t DEFAULT_MATERIAL	= UINT32_MAX - 1;	// an empty MaterialHandle
+
+		// Component sections hold count entity indices, then count components from the next aligned offset.
+		enum SectionType : uint32_t
+		{
+			STRINGS,			// chars, referenced by StringRef
+			SETTINGS,			// SettingsRecord
+			TEXTURES,			// TextureRecord
+			TEXTURE_LEVELS,		// BlobRef, finest level first
+			MATERIALS,			// MaterialRecord
+			MESHES,				// MeshRecord
+			MODELS,				// ModelRecord
+			MESH_INSTANCES,		// MeshInstanceRecord, grouped by model
+			ENTITIES,			// no data, the count is the number of entities
+			ENTITY_IDS,			// components: StringRef
+			TRANSFORMS,			// components: Transform
+			PARENTS,			// components: entity index
+			MODEL_REFS,			// components: model index
+			POINT_LIGHTS,		// components: PointLight
+			BLOBS,				// geometry, BVHs and mip levels, referenced by BlobRef
+			SECTION_TYPE_COUNT
+		};
+
+		struct FileHeader
+		{
+			char		magic[4];
+			uint32_t	version;
+			uint32_t	sectionCount;
+			uint32_t	reserved;
+		};
+
+		struct SectionEntry
+		{
+			uint32_t	type;
+			uint32_t	count;
+			uint64_t	offset;		// from the start of the file
+			uint64_t	size;
+		};
+
+		struct StringRef
+		{
+			uint32_t	offset;
+			uint32_t	length;
+		};
+
+		struct BlobRef
+		{
+			uint64_t	offset;		// from the start of the BLOBS section
+			uint64_t	size;
+		};
+
+		struct SettingsRecord
+		{
+			glm::vec3	cameraPosition;
+			glm::vec3	cameraRotation;
+			glm::vec3	lightDirection;
+			glm::vec3	lightColor;
+			uint32_t	renderPath;
+			uint32_t	shadowsEnabled;
+		};
+
+		struct TextureRecord
+		{
+			StringRef	id;
+			StringRef	filepath;
+			uint32_t	usage;
+			int32_t		filter;
+			uint32_t	format;
+			int32_t		width;
+			int32_t		height;
+			int32_t		channels;
+			uint32_t	firstLevel;
+			uint32_t	levelCount;		// 0 loads filepath instead
+		};
+
+		struct MaterialRecord
+		{
+			StringRef	id;
+			uint32_t	textures[5];	// albedo, normal, roughness, metallic, occlusion
+			glm::vec4	baseColorFactor;
+			float		roughnessFactor;
+			float		metallicFactor;
+			float		occlusionStrength;
+			float		normalScale;
+		};
+
+		struct MeshRecord
+		{
+			StringRef	id;
+			uint32_t	renderUsage;
+			uint32_t	reserved;
+			BlobRef		vertices;
+			BlobRef		indices;
+			BlobRef		bvhNodes;		// empty without a triangle BVH
+			BlobRef		bvhTriangles;
+		};
+
+		struct ModelRecord
+		{
+			StringRef	id;
+			uint32_t	firstInstance;
+			uint32_t	instanceCount;
+		};
+
+		struct MeshInstanceRecord
+		{
+			StringRef	name;
+			uint32_t	mesh;
+			uint32_t	material;
+			Transform	transform;
+		};
+
+		static_assert(std::is_trivially_copyable_v<Vertex>, "Vertex is stored as is");
+		static_assert(std::is_trivially_copyable_v<Transform>, "Transform is stored as is");
+		static_assert(std::is_trivially_copyable_v<PointLight>, "PointLight is stored as is");
+
+		uint64_t align(uint64_t offset)
+		{
+			return (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+		}
+
+		// Streams the blobs to the file as they are added, the tables go after them once everything is known.
+		class Writer
+		{
+		public:
+
+			Writer(const std::filesystem::path& filepath)
+				: mFile{ filepath, std::ios::binary }
+				, mStrings{}
+				, mSections{}
+				, mBlobsOffset{ align(sizeof(FileHeader) + SECTION_TYPE_COUNT * sizeof(SectionEntry)) } // one entry per type
+				, mBlobsSize{ 0 }
+			{
+				pad(mBlobsOffset);
+			}
+
+			bool isOpen() const
+			{
+				return mFile.is_open();
+			}
+
+			StringRef addString(const std::string& str)
+			{
+				StringRef ref{ (uint32_t)mStrings.size(), (uint32_t)str.size() };
+				mStrings.insert(mStrings.end(), str.begin(), str.end());
+
+				return ref;
+			}
+
+			BlobRef addBlob(const void* data, size_t size)
+			{
+				mBlobsSize = align(mBlobsSize);
+				pad(mBlobsOffset + mBlobsSize);
+
+				mFile.write(static_cast<const char*>(data), size);
+
+				BlobRef ref{ mBlobsSize, size };
+				mBlobsSize += size;
+
+				return ref;
+			}
+
+			template<typename T>
+			void addSection(SectionType type, const std::vector<T>& records)
+			{
+				std::vector<unsigned char> bytes(records.size() * sizeof(T));
+				std::memcpy(bytes.data(), records.data(), bytes.size());
+
+				mSections.push_back({ type, (uint32_t)records.size(), std::move(bytes) });
+			}
+
+			template<typename T>
+			void addComponentSection(SectionType type, const std::vector<uint32_t>& entities, const std::vector<T>& components)
+			{
+				const size_t COMPONENTS_OFFSET = align(entities.size() * sizeof(uint32_t));
+
+				std::vector<unsigned char> bytes(COMPONENTS_OFFSET + components.size() * sizeof(T));
+				std::memcpy(bytes.data(), entities.data(), entities.size() * sizeof(uint32_t));
+				std::memcpy(bytes.data() + COMPONENTS_OFFSET, components.data(), components.size() * sizeof(T));
+
+				mSections.push_back({ type, (uint32_t)entities.size(), std::move(bytes) });
+			}
+
+			void addCount(SectionType type, size_t count)
+			{
+				mSections.push_back({ type, (uint32_t)count, {} });
+			}
+
+			bool finish()
+			{
+				std::vector<SectionEntry> entries;
+				entries.push_back({ BLOBS, 0, mBlobsOffset, mBlobsSize });
+
+				uint64_t offset = align(mBlobsOffset + mBlobsSize);
+
+				pad(offset);
+
+				entries.push_back({ STRINGS, 0, offset, mStrings.size() });
+				mFile.write(mStrings.data(), mStrings.size());
+				offset = align(offset + mStrings.size());
+
+				for (const Section& SECTION : mSections)
+				{
+					pad(offset);
+
+					entries.push_back({ SECTION.type, SECTION.count, offset, SECTION.bytes.size() });
+					mFile.write(reinterpret_cast<const char*>(SECTION.bytes.data()), SECTION.bytes.size());
+					offset = align(offset + SECTION.bytes.size());
+				}
+
+				FileHeader header{};
+				std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+				header.version = SceneFile::VERSION;
+				header.sectionCount = (uint32_t)entries.size();
+
+				mFile.seekp(0);
+				mFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+				mFile.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(SectionEntry));
+
+				return (bool)mFile;
+			}
+
+		private:
+
+			struct Section
+			{
+				SectionType					type;
+				uint32_t					count;
+				std::vector<unsigned char>	bytes;
+			};
+
+			std::ofstream			mFile;
+			std::vector<char>		mStrings;
+			std::vector<Section>	mSections;
+			uint64_t				mBlobsOffset;
+			uint64_t				mBlobsSize;
+
+			// zeros up to offset
+			void pad(uint64_t offset)
+			{
+				static const char ZEROS[ALIGNMENT] = {};
+
+				for (uint64_t position = (uint64_t)mFile.tellp(); mFile && position < offset; position += ALIGNMENT)
+				{
+					mFile.write(ZEROS, std::min(ALIGNMENT, offset - position));
+				}
+			}
+		};
+
+		// Checks every offset against the mapped file before handing out pointers into it.
+		class Reader
+		{
+		public:
+
+			bool open(const std::filesystem::path& filepath)
+			{
+				if (!mFile.open(filepath))
+				{
+					std::cerr << "ERROR: could not open scene file: " << filepath << std::endl;
+					return false;
+				}
+
+				const FileHeader* header = reinterpret_cast<const FileHeader*>(mFile.data());
+
+				if (mFile.size() < sizeof(FileHeader) || std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0)
+				{
+					std::cerr << "ERROR: not a scene file: " << filepath << std::endl;
+					return false;
+				}
+
+				if (header->version != SceneFile::VERSION)
+				{
+					std::cerr << "ERROR: scene file version " << header->version << " is not supported, expected "
+						<< SceneFile::VERSION << ": " << filepath << std::endl;
+					return false;
+				}
+
+				if (sizeof(FileHeader) + (uint64_t)header->sectionCount * sizeof(SectionEntry) > mFile.size())
+				{
+					std::cerr << "ERROR: scene file is truncated: " << filepath << std::endl;
+					return false;
+				}
+
+				std::fill(std::begin(mSections), std::end(mSections), nullptr);
+
+				const SectionEntry* entries = reinterpret_cast<const SectionEntry*>(mFile.data() + sizeof(FileHeader));
+
+				for (uint32_t i = 0; i < header->sectionCount; ++i)
+				{
+					const SectionEntry& ENTRY = entries[i];
+
+					if (ENTRY.offset % ALIGNMENT != 0 || ENTRY.offset > mFile.size() || ENTRY.size > mFile.size() - ENTRY.offset)
+					{
+						std::cerr << "ERROR: scene file is truncated: " << filepath << std::endl;
+						return false;
+					}
+
+					// unknown sections are skipped
+					if (ENTRY.type < SECTION_TYPE_COUNT && !mSections[ENTRY.type])
+					{
+						mSections[ENTRY.type] = &ENTRY;
+					}
+				}
+
+				return true;
+			}
+
+			size_t getCount(SectionType type) const
+			{
+				return mSections[type] ? mSections[type]->count : 0;
+			}
+
+			template<typename T>
+			bool getRecords(SectionType type, const T*& records, size_t& count) const
+			{
+				count = getCount(type);
+				records = count > 0 ? reinterpret_cast<const T*>(mFile.data() + mSections[type]->offset) : nullptr;
+
+				return count == 0 || mSections[type]->size >= count * sizeof(T);
+			}
+
+			template<typename T>
+			bool getComponents(SectionType type, size_t entityCount, const uint32_t*& entities, const T*& components, size_t& count) const
+			{
+				count = getCount(type);
+				entities = nullptr;
+				components = nullptr;
+
+				if (count == 0)
+				{
+					return true;
+				}
+
+				const uint64_t COMPONENTS_OFFSET = align(count * sizeof(uint32_t));
+
+				if (mSections[type]->size < COMPONENTS_OFFSET + count * sizeof(T))
+				{
+					return false;
+				}
+
+				entities = reinterpret_cast<const uint32_t*>(mFile.data() + mSections[type]->offset);
+				components = reinterpret_cast<const T*>(mFile.data() + mSections[type]->offset + COMPONENTS_OFFSET);
+
+				// an entity has at most one component of each type
+				std::vector<bool> seen(entityCount, false);
+
+				for (size_t i = 0; i < count; ++i)
+				{
+					if (entities[i] >= entityCount || seen[entities[i]])
+					{
+						return false;
+					}
+
+					seen[entities[i]] = true;
+				}
+
+				return true;
+			}
+
+			bool getString(const StringRef& ref, std::string& str) const
+			{
+				const SectionEntry* strings = mSections[STRINGS];
+
+				if (!strings || (uint64_t)ref.offset + ref.length > strings->size)
+				{
+					return false;
+				}
+
+				str.assign(reinterpret_cast<const char*>(mFile.data() + strings->offset + ref.offset), ref.length);
+
+				return true;
+			}
+
+			// Returns nullptr if ref is not inside the BLOBS section.
+			const unsigned char* getBlob(const BlobRef& ref) const
+			{
+				const SectionEntry* blobs = mSections[BLOBS];
+
+				if (!blobs || ref.offset % ALIGNMENT != 0 || ref.offset > blobs->size || ref.size > blobs->size - ref.offset)
+				{
+					return nullptr;
+				}
+
+				return mFile.data() + blobs->offset + ref.offset;
+			}
+
+		private:
+
+			MappedFile			mFile;
+			const SectionEntry*	mSections[SECTION_TYPE_COUNT];
+		};
+
+		template<typename T>
+		uint32_t findIndex(const std::unordered_map<T, uint32_t>& indices, const T& key)
+		{
+			auto itr = indices.find(key);
+
+			return itr != indices.end() ? itr->second : NONE;
+		}
+
+		// Returns false if image is not a complete mip chain of a supported format.
+		bool getTextureLevels(const Reader& reader, const TextureRecord& record, const BlobRef* levels, size_t levelCount, CompressedImageView& image)
+		{
+			// a longer chain than the size allows would shift the size by 32 or more below
+			if (record.width <= 0 || record.height <= 0 || TextureFile::getBlockSize(record.format) == 0
+				|| record.levelCount > (uint32_t)TextureFile::getMaxLevelCount(record.width, record.height)
+				|| (uint64_t)record.firstLevel + record.levelCount > levelCount)
+			{
+				return false;
+			}
+
+			image.format = record.format;
+			image.width = record.width;
+			image.height = record.height;
+			image.channels = record.channels;
+
+			for (uint32_t i = 0; i < record.levelCount; ++i)
+			{
+				const BlobRef& LEVEL = levels[record.firstLevel + i];
+				const unsigned char* data = reader.getBlob(LEVEL);
+
+				if (!data || LEVEL.size != TextureFile::getLevelSize(record.format, std::max(1, record.width >> i), std::max(1, record.height >> i)))
+				{
+					return false;
+				}
+
+				image.levels.push_back(data);
+				image.levelSizes.push_back((size_t)LEVEL.size);
+			}
+
+			return true;
+		}
+
+		// Returns false if the geometry is damaged, a missing or damaged triangle BVH only leaves bvh empty.
+		bool getMeshData(const Reader& reader, const MeshRecord& record, const Vertex*& vertices, size_t& vertexCount,
+			const GLuint*& indices, size_t& indexCount, TriangleBVH& bvh)
+		{
+			vertices = reinterpret_cast<const Vertex*>(reader.getBlob(record.vertices));
+			indices = reinterpret_cast<const GLuint*>(reader.getBlob(record.indices));
+			vertexCount = (size_t)(record.vertices.size / sizeof(Vertex));
+			indexCount = (size_t)(record.indices.size / sizeof(GLuint));
+
+			if (!vertices || !indices || record.vertices.size % sizeof(Vertex) != 0 || record.indices.size % (3 * sizeof(GLuint)) != 0)
+			{
+				return false;
+			}
+
+			if (!std::all_of(indices, indices + indexCount, [vertexCount](GLuint index) { return index < vertexCount; }))
+			{
+				return false;
+			}
+
+			const unsigned char* nodes = reader.getBlob(record.bvhNodes);
+			const uint32_t* triangles = reinterpret_cast<const uint32_t*>(reader.getBlob(record.bvhTriangles));
+
+			if (nodes && triangles && record.bvhNodes.size > 0 && record.bvhNodes.size % TriangleBVH::NODE_SIZE == 0
+				&& record.bvhTriangles.size == indexCount / 3 * sizeof(uint32_t))
+			{
+				bvh.assign(nodes, (size_t)(record.bvhNodes.size / TriangleBVH::NODE_SIZE), triangles, indexCount / 3);
+			}
+
+			return true;
+		}
+
+		// The strings and blobs of a texture, read before anything is added to the scene.
+		struct TextureData
+		{
+			std::string			id;
+			std::string			filepath;
+			TextureUsage		usage		= TextureUsage::COLOR;
+			TextureFilter		filter		= TextureFilter::BILINEAR;
+			CompressedImageView	image;
+			bool				hasLevels	= false;	// without a complete mip chain filepath is loaded, if there is one
+		};
+
+		// The geometry of a mesh, pointing into the mapped file.
+		struct MeshData
+		{
+			std::string		id;
+			const Vertex*	vertices	= nullptr;
+			size_t			vertexCount	= 0;
+			const GLuint*	indices		= nullptr;
+			size_t			indexCount	= 0;
+			RenderUsage		usage		= RenderUsage::DYNAMIC;
+			TriangleBVH		bvh;
+		};
+	}
+
+	bool SceneFile::save(const std::filesystem::path& filepath, const Scene& scene)
+	{
+		NTR_PROFILE_SCOPE("SceneFile::save");
+
+		Writer writer(filepath);
+
+		if (!writer.isOpen())
+		{
+			std::cerr << "ERROR: could not write scene file: " << filepath << std::endl;
+			return false;
+		}
+
+		// settings
+
+		SettingsRecord settings{};
+		settings.cameraPosition = scene.selectedCamera.position;
+		settings.cameraRotation = scene.selectedCamera.rotation;
+		settings.lightDirection = scene.directionalLight.direction;
+		settings.lightColor = scene.directionalLight.color;
+		settings.renderPath = (uint32_t)scene.renderPath;
+		settings.shadowsEnabled = scene.shadowsEnabled ? 1 : 0;
+
+		writer.addSection(SETTINGS, std::vector<SettingsRecord>{ settings });
+
+		// textures, with their cooked mip chain from the cooker cache, or from VRAM if the source is gone
+
+		std::unordered_map<TextureHandle, uint32_t> textureIndices;
+		std::vector<TextureRecord> textures;
+		std::vector<BlobRef> levels;
+
+		for (const auto& [id, handle, texture] : scene.getTextures())
+		{
+			TextureRecord record{};
+			record.id = writer.addString(id);
+			record.filepath = writer.addString(texture.filepath().string());
+			record.usage = texture.usage();
+			record.filter = texture.filter();
+			record.firstLevel = (uint32_t)levels.size();
+
+			CompressedImage image;
+
+			if (texture.compressed() && ((!texture.filepath().empty() && Texture::loadCompressed(texture.filepath(), texture.usage(), image))
+				|| texture.readCompressed(image)))
+			{
+				record.format = image.format;
+				record.width = image.width;
+				record.height = image.height;
+				record.channels = image.channels;
+				record.levelCount = (uint32_t)image.levels.size();
+
+				for (const auto& level : image.levels)
+				{
+					levels.push_back(writer.addBlob(level.data(), level.size()));
+				}
+			}
+
+			textureIndices.emplace(handle, (uint32_t)textures.size());
+			textures.push_back(record);
+		}
+
+		writer.addSection(TEXTURES, textures);
+		writer.addSection(TEXTURE_LEVELS, levels);
+
+		// materials
+
+		std::unordered_map<MaterialHandle, uint32_t> materialIndices;
+		std::vector<MaterialRecord> materials;
+
+		for (const auto& [id, handle, material] : scene.getMaterials())
+		{
+			const TextureHandle TEXTURES[5] = { material.albedo, material.normal, material.roughness, material.metallic, material.occlusion };
+
+			MaterialRecord record{};
+			record.id = writer.addString(id);
+			record.baseColorFactor = material.baseColorFactor;
+			record.roughnessFactor = material.roughnessFactor;
+			record.metallicFactor = material.metallicFactor;
+			record.occlusionStrength = material.occlusionStrength;
+			record.normalScale = material.normalScale;
+
+			for (size_t i = 0; i < 5; ++i)
+			{
+				record.textures[i] = findIndex(textureIndices, TEXTURES[i]);
+			}
+
+			materialIndices.emplace(handle, (uint32_t)materials.size());
+			materials.push_back(record);
+		}
+
+		materialIndices.emplace(MaterialHandle{}, DEFAULT_MATERIAL);
+
+		writer.addSection(MATERIALS, materials);
+
+		// meshes, read back from VRAM if they are not kept on the CPU
+
+		std::unordered_map<MeshHandle, uint32_t> meshIndices;
+		std::vector<MeshRecord> meshes;
+		std::vector<Vertex> vertices;
+		std::vector<GLuint> indices;
+
+		for (const auto& [id, handle, mesh] : scene.getMeshes())
+		{
+			mesh.readVertices(vertices);
+			mesh.readIndices(indices);
+
+			MeshRecord record{};
+			record.id = writer.addString(id);
+			record.renderUsage = mesh.renderUsage();
+			record.vertices = writer.addBlob(vertices.data(), vertices.size() * sizeof(Vertex));
+			record.indices = writer.addBlob(indices.data(), indices.size() * sizeof(GLuint));
+
+			if (mesh.hasTriangleBVH())
+			{
+				const TriangleBVH& BVH = mesh.triangleBVH();
+
+				record.bvhNodes = writer.addBlob(BVH.nodeData(), BVH.nodeCount() * TriangleBVH::NODE_SIZE);
+				record.bvhTriangles = writer.addBlob(BVH.triangles().data(), BVH.triangles().size() * sizeof(uint32_t));
+			}
+
+			meshIndices.emplace(handle, (uint32_t)meshes.size());
+			meshes.push_back(record);
+		}
+
+		writer.addSection(MESHES, meshes);
+
+		// models
+
+		std::unordered_map<ModelHandle, uint32_t> modelIndices;
+		std::vector<ModelRecord> models;
+		std::vector<MeshInstanceRecord> instances;
+
+		for (const auto& [id, handle, model] : scene.getModels())
+		{
+			ModelRecord record{};
+			record.id = writer.addString(id);
+			record.firstInstance = (uint32_t)instances.size();
+			record.instanceCount = (uint32_t)model.meshes.size();
+
+			for (const auto& [name, instance] : model.meshes)
+			{
+				MeshInstanceRecord instanceRecord{};
+				instanceRecord.name = writer.addString(name);
+				instanceRecord.mesh = findIndex(meshIndices, instance.mesh);
+				instanceRecord.material = findIndex(materialIndices, instance.material);
+				instanceRecord.transform = instance.transform;
+
+				instances.push_back(instanceRecord);
+			}
+
+			modelIndices.emplace(handle, (uint32_t)models.size());
+			models.push_back(record);
+		}
+
+		writer.addSection(MODELS, models);
+		writer.addSection(MESH_INSTANCES, instances);
+
+		// entities, numbered in the order they are first seen
+
+		std::unordered_map<entt::entity, uint32_t> entityIndices;
+
+		auto getEntityIndex = [&entityIndices](entt::entity entity)
+		{
+			return entityIndices.emplace(entity, (uint32_t)entityIndices.size()).first->second;
+		};
+
+		std::vector<uint32_t> componentEntities;
+
+		{
+			std::vector<StringRef> ids;
+
+			for (const auto& [entity, id] : scene.registry.view<const StringID>().each())
+			{
+				componentEntities.push_back(getEntityIndex(entity));
+				ids.push_back(writer.addString(id.str));
+			}
+
+			writer.addComponentSection(ENTITY_IDS, componentEntities, ids);
+			componentEntities.clear();
+		}
+
+		{
+			std::vector<Transform> transforms;
+
+			for (const auto& [entity, transform] : scene.registry.view<const Transform>().each())
+			{
+				componentEntities.push_back(getEntityIndex(entity));
+				transforms.push_back(transform);
+			}
+
+			writer.addComponentSection(TRANSFORMS, componentEntities, transforms);
+			componentEntities.clear();
+		}
+
+		{
+			std::vector<uint32_t> modelRefs;
+
+			for (const auto& [entity, model] : scene.registry.view<const ModelHandle>().each())
+			{
+				componentEntities.push_back(getEntityIndex(entity));
+				modelRefs.push_back(findIndex(modelIndices, model));
+			}
+
+			writer.addComponentSection(MODEL_REFS, componentEntities, modelRefs);
+			componentEntities.clear();
+		}
+
+		{
+			std::vector<PointLight> pointLights;
+
+			for (const auto& [entity, light] : scene.registry.view<const PointLight>().each())
+			{
+				componentEntities.push_back(getEntityIndex(entity));
+				pointLights.push_back(light);
+			}
+
+			writer.addComponentSection(POINT_LIGHTS, componentEntities, pointLights);
+			componentEntities.clear();
+		}
+
+		{
+			std::vector<uint32_t> parents;
+
+			for (const auto& [entity, parent] : scene.registry.view<const Parent>().each())
+			{
+				const entt::entity PARENT = scene.getParent(entity);
+
+				if (PARENT != entt::null)
+				{
+					componentEntities.push_back(getEntityIndex(entity));
+					parents.push_back(getEntityIndex(PARENT));
+				}
+			}
+
+			writer.addComponentSection(PARENTS, componentEntities, parents);
+			componentEntities.clear();
+		}
+
+		writer.addCount(ENTITIES, entityIndices.size());
+
+		if (!writer.finish())
+		{
+			std::cerr << "ERROR: could not write scene file: " << filepath << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool SceneFile::load(const std::filesystem::path& filepath, Scene& scene)
+	{
+		NTR_PROFILE_SCOPE("SceneFile::load");
+
+		Reader reader;
+
+		if (!reader.open(filepath))
+		{
+			return false;
+		}
+
+		const SettingsRecord* settings = nullptr;
+		const TextureRecord* textureRecords = nullptr;
+		const BlobRef* levelRecords = nullptr;
+		const MaterialRecord* materialRecords = nullptr;
+		const MeshRecord* meshRecords = nullptr;
+		const ModelRecord* modelRecords = nullptr;
+		const MeshInstanceRecord* instanceRecords = nullptr;
+
+		size_t settingsCount = 0;
+		size_t textureCount = 0;
+		size_t levelCount = 0;
+		size_t materialCount = 0;
+		size_t meshCount = 0;
+		size_t modelCount = 0;
+		size_t instanceCount = 0;
+
+		if (!reader.getRecords(SETTINGS, settings, settingsCount)
+			|| !reader.getRecords(TEXTURES, textureRecords, textureCount)
+			|| !reader.getRecords(TEXTURE_LEVELS, levelRecords, levelCount)
+			|| !reader.getRecords(MATERIALS, materialRecords, materialCount)
+			|| !reader.getRecords(MESHES, meshRecords, meshCount)
+			|| !reader.getRecords(MODELS, modelRecords, modelCount)
+			|| !reader.getRecords(MESH_INSTANCES, instanceRecords, instanceCount))
+		{
+			std::cerr << "ERROR: scene file is damaged: " << filepath << std::endl;
+			return false;
+		}
+
+		// every section is read and checked before the scene is touched, a damaged file adds nothing to it
+
+		std::vector<TextureData> textureData(textureCount);
+
+		for (size_t i = 0; i < textureCount; ++i)
+		{
+			const TextureRecord& RECORD = textureRecords[i];
+			TextureData& data = textureData[i];
+
+			if (!reader.getString(RECORD.id, data.id) || !reader.getString(RECORD.filepath, data.filepath))
+			{
+				std::cerr << "ERROR: scene file is damaged: " << filepath << std::endl;
+				return false;
+			}
+
+			data.usage = RECORD.usage <= TextureUsage::SINGLE_CHANNEL ? (TextureUsage)RECORD.usage : TextureUsage::COLOR;
+			data.filter = RECORD.filter == TextureFilter::NEAREST ? TextureFilter::NEAREST : TextureFilter::BILINEAR;
+			data.hasLevels = RECORD.levelCount > 0 && getTextureLevels(reader, RECORD, levelRecords, levelCount, data.image);
+		}
+
+		std::vector<std::string> materialIDs(materialCount);
+
+		for (size_t i = 0; i < materialCount; ++i)
+		{
+			if (!reader.getString(materialRecords[i].id, materialIDs[i]))
+			{
+				std::cerr << "ERROR: scene file is damaged: " << filepath << std::endl;
+				return false;
+			}
+		}
+
+		std::vector<MeshData> meshData(meshCount);
+
+		for (size_t i = 0; i < meshCount; ++i)
+		{
+			const MeshRecord& RECORD = meshRecords[i];
+			MeshData& data = meshData[i];
+
+			if (!reader.getString(RECORD.id, data.id)
+				|| !getMeshData(reader, RECORD, data.vertices, data.vertexCount, data.indices, data.indexCount, data.bvh))
+			{
+				std::cerr << "ERROR: scene file is damaged: " << filepath << std::endl;
+				return false;
+			}
+
+			data.usage = RECORD.renderUsage == RenderUsage::STATIC || RECORD.renderUsage == RenderUsage::STREAM
+				? (RenderUsage)RECORD.renderUsage : RenderUsage::DYNAMIC;
+		}
+
+		std::vector<std::string> modelIDs(modelCount);
+		std::vector<std::string> instanceNames(instanceCount);
+
+		for (size_t i = 0; i < modelCount; ++i)
+		{
+			const ModelRecord& RECORD = modelRecords[i];
+
+			if (!reader.getString(RECORD.id, modelIDs[i]) || (uint64_t)RECORD.firstInstance + RECORD.instanceCount > instanceCount)
+			{
+				std::cerr << "ERROR: scene file is damaged: " << filepath << std::endl;
+				return false;
+			}
+
+			for (uint32_t j = RECORD.firstInstance; j < RECORD.firstInstance + RECORD.instanceCount; ++j)
+			{
+				if (!reader.getString(instanceRecords[j].name, instanceNames[j]))
+				{
+					std::cerr << "ERROR: scene file is damaged: " << filepath << std::endl;
+					return false;
+				}
+			}
+		}
+
+		const size_t ENTITY_COUNT = reader.getCount(ENTITIES);
+
+		const uint32_t* idEntities = nullptr;
+		const uint32_t* transformEntities = nullptr;
+		const uint32_t* modelEntities = nullptr;
+		const uint32_t* lightEntities = nullptr;
+		const uint32_t* parentEntities = nullptr;
+
+		const StringRef* idRecords = nullptr;
+		const Transform* transforms = nullptr;
+		const uint32_t* modelRefs = nullptr;
+		const PointLight* lights = nullptr;
+		const uint32_t* parents = nullptr;
+
+		size_t idCount = 0;
+		size_t transformCount = 0;
+		size_t modelRefCount = 0;
+		size_t lightCount = 0;
+		size_t parentCount = 0;
+
+		if (!reader.getComponents(ENTITY_IDS, ENTITY_COUNT, idEntities, idRecords, idCount)
+			|| !reader.getComponents(TRANSFORMS, ENTITY_COUNT, transformEntities, transforms, transformCount)
+			|| !reader.getComponents(MODEL_REFS, ENTITY_COUNT, modelEntities, modelRefs, modelRefCount)
+			|| !reader.getComponents(POINT_LIGHTS, ENTITY_COUNT, lightEntities, lights, lightCount)
+			|| !reader.getComponents(PARENTS, ENTITY_COUNT, parentEntities, parents, parentCount))
+		{
+			std::cerr << "ERROR: scene file is damaged: " << filepath << std::endl;
+			return false;
+		}
+
+		// entity ids that are taken get a suffix from the scene's name index as they are inserted
+
+		std::vector<StringID> stringIDs(idCount);
+
+		for (size_t i = 0; i < idCount; ++i)
+		{
+			if (!reader.getString(idRecords[i], stringIDs[i].str))
+			{
+				std::cerr << "ERROR: scene file is damaged: " << filepath << std::endl;
+				return false;
+			}
+		}
+
+		// settings
+
+		if (settingsCount > 0)
+		{
+			scene.selectedCamera.position = settings->cameraPosition;
+			scene.selectedCamera.rotation = settings->cameraRotation;
+			scene.directionalLight.direction = settings->lightDirection;
+			scene.directionalLight.color = settings->lightColor;
+			scene.renderPath = settings->renderPath == RenderPath::DEFERRED ? RenderPath::DEFERRED : RenderPath::FORWARD;
+			scene.shadowsEnabled = settings->shadowsEnabled != 0;
+		}
+
+		// textures, uploaded from the mapped mip chains
+
+		std::vector<TextureHandle> textures(textureCount);
+
+		{
+			NTR_PROFILE_SCOPE("Upload textures");
+
+			for (size_t i = 0; i < textureCount; ++i)
+			{
+				const TextureData& DATA = textureData[i];
+				const std::string ID = scene.getTextures().getUniqueID(DATA.id);
+
+				if (DATA.hasLevels)
+				{
+					// streaming reads the finer mips from the source, without one every level is uploaded now
+					const std::filesystem::path SOURCE = std::filesystem::exists(DATA.filepath) ? std::filesystem::path(DATA.filepath) : std::filesystem::path();
+
+					textures[i] = scene.addTexture(ID, Texture(DATA.image, SOURCE, DATA.usage, DATA.filter));
+				}
+				else if (!DATA.filepath.empty())
+				{
+					textures[i] = scene.loadTexture(ID, DATA.filepath, DATA.usage);
+				}
+			}
+		}
+
+		// materials
+
+		std::vector<MaterialHandle> materials(materialCount);
+
+		for (size_t i = 0; i < materialCount; ++i)
+		{
+			const MaterialRecord& RECORD = materialRecords[i];
+
+			auto getTexture = [&textures](uint32_t index)
+			{
+				return index < textures.size() ? textures[index] : TextureHandle();
+			};
+
+			Material material;
+			material.albedo = getTexture(RECORD.textures[0]);
+			material.normal = getTexture(RECORD.textures[1]);
+			material.roughness = getTexture(RECORD.textures[2]);
+			material.metallic = getTexture(RECORD.textures[3]);
+			material.occlusion = getTexture(RECORD.textures[4]);
+			material.baseColorFactor = RECORD.baseColorFactor;
+			material.roughnessFactor = RECORD.roughnessFactor;
+			material.metallicFactor = RECORD.metallicFactor;
+			material.occlusionStrength = RECORD.occlusionStrength;
+			material.normalScale = RECORD.normalScale;
+
+			materials[i] = scene.addMaterial(scene.getMaterials().getUniqueID(materialIDs[i]), material);
+		}
+
+		// meshes, uploaded from the mapped geometry
+
+		std::vector<MeshHandle> meshes(meshCount);
+
+		{
+			NTR_PROFILE_SCOPE("Upload meshes");
+
+			for (size_t i = 0; i < meshCount; ++i)
+			{
+				MeshData& data = meshData[i];
+
+				meshes[i] = scene.addMesh(scene.getMeshes().getUniqueID(data.id),
+					Mesh(data.vertices, data.vertexCount, data.indices, data.indexCount, data.usage, scene.meshCpuData, std::move(data.bvh)));
+			}
+		}
+
+		// models
+
+		std::vector<ModelHandle> models(modelCount);
+
+		for (size_t i = 0; i < modelCount; ++i)
+		{
+			const ModelRecord& RECORD = modelRecords[i];
+
+			Model model;
+
+			for (uint32_t j = RECORD.firstInstance; j < RECORD.firstInstance + RECORD.instanceCount; ++j)
+			{
+				const MeshInstanceRecord& INSTANCE = instanceRecords[j];
+
+				// DEFAULT_MATERIAL and NONE both leave the handle empty
+				const MeshHandle MESH = INSTANCE.mesh < meshes.size() ? meshes[INSTANCE.mesh] : MeshHandle{};
+				const MaterialHandle MATERIAL = INSTANCE.material < materials.size() ? materials[INSTANCE.material] : MaterialHandle{};
+
+				model.meshes.emplace(instanceNames[j], MeshInstance(MESH, MATERIAL, INSTANCE.transform));
+			}
+
+			models[i] = scene.addModel(scene.getModels().getUniqueID(modelIDs[i]), model);
+		}
+
+		// entities, every component inserted in bulk
+
+		NTR_PROFILE_SCOPE("Create entities");
+
+		std::vector<entt::entity> entities(ENTITY_COUNT);
+		std::vector<entt::entity> targets;
+
+		scene.registry.create(entities.begin(), entities.end());
+
+		auto setTargets = [&entities, &targets](const uint32_t* indices, size_t count)
+		{
+			targets.resize(count);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				targets[i] = entities[indices[i]];
+			}
+		};
+
+		setTargets(idEntities, idCount);
+		scene.registry.insert<StringID>(targets.begin(), targets.end(), stringIDs.begin());
+
+		setTargets(transformEntities, transformCount);
+		scene.registry.insert<Transform>(targets.begin(), targets.end(), transforms);
+
+		setTargets(lightEntities, lightCount);
+		scene.registry.insert<PointLight>(targets.begin(), targets.end(), lights);
+
+		std::vector<ModelHandle> modelHandles;
+		modelHandles.reserve(modelRefCount);
+
+		for (size_t i = 0; i < modelRefCount; ++i)
+		{
+			modelHandles.push_back(modelRefs[i] < models.size() ? models[modelRefs[i]] : ModelHandle{});
+		}
+
+		setTargets(modelEntities, modelRefCount);
+		scene.registry.insert<ModelHandle>(targets.begin(), targets.end(), modelHandles.begin());
+
+		for (size_t i = 0; i < parentCount; ++i)
+		{
+			if (parents[i] < ENTITY_COUNT)
+			{
+				scene.setParent(entities[parentEntities[i]], entities[parents[i]]);
+			}
+		}
+
+		return true;
+	}
+} // namespace ntr
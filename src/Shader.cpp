@@ -1,14 +1,25 @@
+#include <cstring>
 #include <fstream>
+#include <iterator>
 #include <sstream>
 #include <iostream>
 #include <unordered_map>
 
 #include <glad/glad.h>
 
+#include "GLState.h"
 #include "Shader.h"
+#include "ShaderCache.h"
 
 namespace ntr
 {
+    // GL_KHR_parallel_shader_compile / GL_ARB_parallel_shader_compile, not in the core profile glad was generated for
+    constexpr GLenum NTR_GL_COMPLETION_STATUS = 0x91B1;
+
+    typedef void (APIENTRYP PFN_NTR_GLMAXSHADERCOMPILERTHREADS)(GLuint count);
+
+    bool Shader::parallelCompileEnabled = false;
+
     //#################################################################################################
     //
     // SHADER IMPLEMENTATION
@@ -17,10 +28,46 @@ namespace ntr
 
     Shader::Shader()
         : mID                        { 0 }
+        , mCacheKey                  { 0 }
+        , mPending                   { false }
     {
     }
+
+    Shader::Shader(Shader&& shader) noexcept
+        : mID                        { shader.mID }
+        , mCacheKey                  { shader.mCacheKey }
+        , mPendingStages             { std::move(shader.mPendingStages) }
+        , mPending                   { shader.mPending }
+    {
+        shader.mID = 0;
+        shader.mPendingStages.clear();
+        shader.mPending = false;
+    }
+
+    Shader& Shader::operator=(Shader&& shader) noexcept
+    {
+        if (this != &shader)
+        {
+            // stages of a program replaced before it was finalized are not needed anymore
+            for (GLuint stage : mPendingStages)
+            {
+                glDeleteShader(stage);
+            }
+
+            mID = shader.mID;
+            mCacheKey = shader.mCacheKey;
+            mPendingStages = std::move(shader.mPendingStages);
+            mPending = shader.mPending;
+
+            shader.mID = 0;
+            shader.mPendingStages.clear();
+            shader.mPending = false;
+        }
+
+        return *this;
+    }
     
-    Shader::Shader(const std::string& vertexFilepath, const std::string& fragmentFilepath, const std::string& geometryFilepath)
+    Shader::Shader(const std::string& vertexFilepath, const std::string& fragmentFilepath, const std::string& geometryFilepath, const std::vector<std::string>& defines)
         : Shader{}
     {
         std::string vertexCode, fragmentCode, geometryCode;
@@ -59,51 +106,116 @@ namespace ntr
             std::cout << "ERROR: " << e.what() << std::endl;
         }
 
-        const char* vShaderCode = vertexCode.c_str();
-        const char* fShaderCode = fragmentCode.c_str();
+        if (!defines.empty())
+        {
+            vertexCode = injectDefines(vertexCode, defines);
+            fragmentCode = injectDefines(fragmentCode, defines);
+
+            if (geometryFilepath != "")
+            {
+                geometryCode = injectDefines(geometryCode, defines);
+            }
+        }
 
-        unsigned int vertex, fragment;
+        // reuse the program binary from a previous run if the sources and driver are unchanged
 
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "vertex");
+        const uint64_t CACHE_KEY = ShaderCache::getKey({ vertexCode, fragmentCode, geometryCode });
 
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "fragment");
+        mID = ShaderCache::load(CACHE_KEY);
 
-        unsigned int geometry{};
-        if (geometryFilepath != "")
+        if (mID != 0)
         {
-            const char* gShaderCode = geometryCode.c_str();
-            geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
-            glCompileShader(geometry);
-            checkCompileErrors(geometry, "geometry");
+            return;
         }
 
-        mID = glCreateProgram();
-        glAttachShader(mID, vertex);
-        glAttachShader(mID, fragment);
+        std::vector<std::pair<GLenum, std::string>> stages = {
+            { GL_VERTEX_SHADER, vertexCode },
+            { GL_FRAGMENT_SHADER, fragmentCode }
+        };
 
         if (geometryFilepath != "")
         {
-            glAttachShader(mID, geometry);
+            stages.push_back({ GL_GEOMETRY_SHADER, geometryCode });
         }
 
-        glLinkProgram(mID);
-        checkCompileErrors(mID, "program");
+        submit(stages, CACHE_KEY);
+    }
 
-        // shaders are linked into program, so these are no longer necessary
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
+    Shader::Shader(const std::string& computeFilepath)
+        : Shader{}
+    {
+        std::string computeCode;
+        std::ifstream cShaderFile;
 
-        if (geometryFilepath != "")
+        cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+
+        try
         {
-            glDeleteShader(geometry);
+            cShaderFile.open(computeFilepath);
+
+            std::stringstream cShaderStream;
+            cShaderStream << cShaderFile.rdbuf();
+
+            cShaderFile.close();
+
+            computeCode = cShaderStream.str();
         }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR: " << e.what() << std::endl;
+        }
+
+        const uint64_t CACHE_KEY = ShaderCache::getKey({ computeCode });
+
+        mID = ShaderCache::load(CACHE_KEY);
+
+        if (mID != 0)
+        {
+            return;
+        }
+
+        submit({ { GL_COMPUTE_SHADER, computeCode } }, CACHE_KEY);
+    }
+
+    Shader Shader::fromSpirv(const std::string& vertexFilepath, const std::string& fragmentFilepath)
+    {
+        Shader shader;
+
+        auto readBinary = [](const std::string& filepath)
+        {
+            std::ifstream file(filepath, std::ios::binary);
+
+            if (!file)
+            {
+                std::cout << "ERROR: could not open SPIR-V module: " << filepath << std::endl;
+            }
+
+            return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        };
+
+        const std::vector<char> VERTEX_BINARY = readBinary(vertexFilepath);
+        const std::vector<char> FRAGMENT_BINARY = readBinary(fragmentFilepath);
+
+        GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderBinary(1, &vertex, GL_SHADER_BINARY_FORMAT_SPIR_V, VERTEX_BINARY.data(), (GLsizei)VERTEX_BINARY.size());
+        glSpecializeShader(vertex, "main", 0, nullptr, nullptr);
+        shader.checkCompileErrors(vertex, "vertex");
+
+        GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderBinary(1, &fragment, GL_SHADER_BINARY_FORMAT_SPIR_V, FRAGMENT_BINARY.data(), (GLsizei)FRAGMENT_BINARY.size());
+        glSpecializeShader(fragment, "main", 0, nullptr, nullptr);
+        shader.checkCompileErrors(fragment, "fragment");
+
+        shader.mID = glCreateProgram();
+        glAttachShader(shader.mID, vertex);
+        glAttachShader(shader.mID, fragment);
+        glLinkProgram(shader.mID);
+        shader.checkCompileErrors(shader.mID, "program");
+
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+
+        return shader;
     }
 
     GLuint Shader::id() const
@@ -113,7 +225,91 @@ namespace ntr
 
     void Shader::use() const
     {
-        glUseProgram(mID);
+        finalize();
+        GLState::useProgram(mID);
+    }
+
+    bool Shader::isReady() const
+    {
+        if (!mPending || !parallelCompileEnabled)
+        {
+            return true;
+        }
+
+        GLint completed = GL_FALSE;
+        glGetProgramiv(mID, NTR_GL_COMPLETION_STATUS, &completed);
+
+        return completed == GL_TRUE;
+    }
+
+    void Shader::finalize() const
+    {
+        if (!mPending)
+        {
+            return;
+        }
+
+        for (GLuint stage : mPendingStages)
+        {
+            GLint type = 0;
+            glGetShaderiv(stage, GL_SHADER_TYPE, &type);
+
+            switch (type)
+            {
+            case GL_VERTEX_SHADER:      checkCompileErrors(stage, "vertex");    break;
+            case GL_FRAGMENT_SHADER:    checkCompileErrors(stage, "fragment");  break;
+            case GL_GEOMETRY_SHADER:    checkCompileErrors(stage, "geometry");  break;
+            case GL_COMPUTE_SHADER:     checkCompileErrors(stage, "compute");   break;
+            }
+
+            // shaders are linked into program, so these are no longer necessary
+            glDeleteShader(stage);
+        }
+
+        checkCompileErrors(mID, "program");
+
+        ShaderCache::store(mCacheKey, mID);
+
+        mPendingStages.clear();
+        mPending = false;
+    }
+
+    bool Shader::enableParallelCompile(GLADloadproc getProcAddress)
+    {
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+
+        const char* maxThreadsName = nullptr;
+
+        for (GLint i = 0; i < extensionCount && !maxThreadsName; ++i)
+        {
+            const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+
+            if (std::strcmp(extension, "GL_KHR_parallel_shader_compile") == 0)
+            {
+                maxThreadsName = "glMaxShaderCompilerThreadsKHR";
+            }
+            else if (std::strcmp(extension, "GL_ARB_parallel_shader_compile") == 0)
+            {
+                maxThreadsName = "glMaxShaderCompilerThreadsARB";
+            }
+        }
+
+        if (!maxThreadsName)
+        {
+            return false;
+        }
+
+        auto maxShaderCompilerThreads = (PFN_NTR_GLMAXSHADERCOMPILERTHREADS)getProcAddress(maxThreadsName);
+
+        if (maxShaderCompilerThreads)
+        {
+            maxShaderCompilerThreads(0xFFFFFFFF); // let the driver choose the thread count
+        }
+
+        parallelCompileEnabled = true;
+
+        return true;
     }
 
     void Shader::setBool(const std::string& name, bool value) const
@@ -178,107 +374,143 @@ namespace ntr
 
     void Shader::draw(const Mesh& mesh)
     {
-        glBindVertexArray(mesh.vao());
-        glDrawElements(GL_TRIANGLES, mesh.indexCount(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        GLState::bindVertexArray(mesh.vao());
+        GLState::drawElements(GL_TRIANGLES, mesh.indexCount(), GL_UNSIGNED_INT, 0);
     }
 
     void Shader::draw(const Mesh* mesh)
     {
-        glBindVertexArray(mesh->vao());
-        glDrawElements(GL_TRIANGLES, mesh->indexCount(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        GLState::bindVertexArray(mesh->vao());
+        GLState::drawElements(GL_TRIANGLES, mesh->indexCount(), GL_UNSIGNED_INT, 0);
     }
 
-    void Shader::draw(const MeshInstance& mesh)
+    void Shader::draw(GLuint vao, GLsizei indexCount)
     {
-        glBindVertexArray(mesh.vao);
-        glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        GLState::bindVertexArray(vao);
+        GLState::drawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
     }
 
-    void Shader::draw(const Model& model)
+    void Shader::drawFullscreenTriangle()
     {
-        const auto& meshes = model.meshes;
+        // core profile requires a bound VAO even without vertex attributes
+        static GLuint emptyVAO = 0;
 
-        for (const auto& [id, mesh] : meshes)
+        if (emptyVAO == 0)
         {
-            draw(mesh);
+            glCreateVertexArrays(1, &emptyVAO);
         }
+
+        GLState::bindVertexArray(emptyVAO);
+        GLState::drawArrays(GL_TRIANGLES, 0, 3);
     }
 
-    void Shader::draw(const Model* model)
+    void Shader::dispatch(GLuint groupsX, GLuint groupsY, GLuint groupsZ)
     {
-        const auto& meshes = model->meshes;
-
-        for (const auto& [id, mesh] : meshes)
-        {
-            draw(mesh);
-        }
+        use();
+        glDispatchCompute(groupsX, groupsY, groupsZ);
     }
 
     void Shader::bindTexture(GLint unit, const Texture& texture)
     {
-        glActiveTexture(GL_TEXTURE0 + unit);
-        glBindTexture(GL_TEXTURE_2D, texture.handle());
+        GLState::bindTextureUnit(unit, texture.id());
     }
 
-    void Shader::bindTexture(GLint unit, TextureHandle texture)
+    void Shader::bindTexture(GLint unit, GLuint texture)
     {
-        glActiveTexture(GL_TEXTURE0 + unit);
-        glBindTexture(GL_TEXTURE_2D, texture);
+        GLState::bindTextureUnit(unit, texture);
     }
 
     void Shader::bindTexture(GLint unit, const DepthTexture2D& texture)
     {
-        glActiveTexture(GL_TEXTURE0 + unit);
-        glBindTexture(GL_TEXTURE_2D, texture.id());
+        GLState::bindTextureUnit(unit, texture.id());
     }
 
     void Shader::bindTexture(GLint unit, const std::string& name, const Texture& texture) const
     {
-        glActiveTexture(GL_TEXTURE0 + unit);
-        glUniform1i(glGetUniformLocation(mID, name.c_str()), unit);
-        glBindTexture(GL_TEXTURE_2D, texture.handle());
+        setInt(name, unit);
+        GLState::bindTextureUnit(unit, texture.id());
     }
 
-    void Shader::bindTexture(GLint unit, const std::string& name, TextureHandle texture) const
+    void Shader::bindTexture(GLint unit, const std::string& name, GLuint texture) const
     {
-        glActiveTexture(GL_TEXTURE0 + unit);
-        glUniform1i(glGetUniformLocation(mID, name.c_str()), unit);
-        glBindTexture(GL_TEXTURE_2D, texture);
+        setInt(name, unit);
+        GLState::bindTextureUnit(unit, texture);
     }
 
     void Shader::bindTexture(GLint unit, const std::string& name, const DepthTexture2D& texture) const
     {
-        glActiveTexture(GL_TEXTURE0 + unit);
-        glUniform1i(glGetUniformLocation(mID, name.c_str()), unit);
-        glBindTexture(GL_TEXTURE_2D, texture.id());
+        setInt(name, unit);
+        GLState::bindTextureUnit(unit, texture.id());
     }
 
     void Shader::bindTexture(GLint unit, const Texture2DArray& textureArray)
     {
-        glActiveTexture(GL_TEXTURE0 + unit);
-        glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray.id());
+        GLState::bindTextureUnit(unit, textureArray.id());
     }
 
     void Shader::unbindTexture(GLint unit)
     {
-        glActiveTexture(GL_TEXTURE0 + unit);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        GLState::bindTextureUnit(unit, 0);
     }
 
     void Shader::unbindTextures(GLint start_unit, GLint end_unit)
     {
         for (GLint i = start_unit; i <= end_unit; ++i)
         {
-            glActiveTexture(GL_TEXTURE0 + i);
-            glBindTexture(GL_TEXTURE_2D, 0);
+            GLState::bindTextureUnit(i, 0);
         }
     }
 
     // Private helper functions
 
+    void Shader::submit(const std::vector<std::pair<GLenum, std::string>>& stages, uint64_t cacheKey)
+    {
+        // compile and link without asking for the result, so the driver keeps working on this program
+        // while more are submitted, errors are reported by finalize() when the program is first used
+
+        mID = glCreateProgram();
+        glProgramParameteri(mID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+        for (const auto& [type, code] : stages)
+        {
+            const char* shaderCode = code.c_str();
+
+            GLuint stage = glCreateShader(type);
+            glShaderSource(stage, 1, &shaderCode, NULL);
+            glCompileShader(stage);
+            glAttachShader(mID, stage);
+
+            mPendingStages.push_back(stage);
+        }
+
+        glLinkProgram(mID);
+
+        mCacheKey = cacheKey;
+        mPending = true;
+    }
+
+    std::string Shader::injectDefines(const std::string& source, const std::vector<std::string>& defines)
+    {
+        // #version must stay the first directive, so defines go on the line after it
+        size_t versionPos = source.find("#version");
+        size_t insertPos = 0;
+
+        if (versionPos != std::string::npos)
+        {
+            insertPos = source.find('\n', versionPos);
+            insertPos = (insertPos == std::string::npos) ? source.size() : insertPos + 1;
+        }
+
+        std::string defineLines;
+
+        for (const std::string& define : defines)
+        {
+            defineLines += "#define " + define + "\n";
+        }
+
+        return source.substr(0, insertPos) + defineLines + source.substr(insertPos);
+    }
+
 	void Shader::checkCompileErrors(const unsigned int& shaderID, const std::string& type) const
 	{
         GLint success;
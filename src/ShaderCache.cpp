@@ -0,0 +1,163 @@
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+#include "Hash.h"
+#include "ShaderCache.h"
+
+namespace ntr
+{
+	bool					ShaderCache::enabled	= true;
+	std::filesystem::path	ShaderCache::directory	= "shader_cache";
+
+	namespace
+	{
+		// 'NTRB', bump CACHE_FORMAT_VERSION whenever the entry layout changes
+		constexpr uint32_t CACHE_MAGIC			= 0x4252544E;
+		constexpr uint32_t CACHE_FORMAT_VERSION	= 1;
+
+		struct EntryHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t key;
+			uint32_t binaryFormat;
+			uint32_t binarySize;
+		};
+
+		std::string getGLString(GLenum name)
+		{
+			const GLubyte* str = glGetString(name);
+			return str ? reinterpret_cast<const char*>(str) : "";
+		}
+	}
+
+	uint64_t ShaderCache::getKey(const std::vector<std::string>& sources)
+	{
+		// binaries are only valid for the driver that produced them
+		static const uint64_t DRIVER_HASH = hashString(hashString(hashString(FNV_OFFSET_BASIS,
+			getGLString(GL_VENDOR)),
+			getGLString(GL_RENDERER)),
+			getGLString(GL_VERSION));
+
+		uint64_t hash = DRIVER_HASH;
+
+		for (const std::string& source : sources)
+		{
+			hash = hashString(hash, source);
+		}
+
+		return hash;
+	}
+
+	GLuint ShaderCache::load(uint64_t key)
+	{
+		if (!enabled || !isSupported())
+		{
+			return 0;
+		}
+
+		std::ifstream file(getEntryPath(key), std::ios::binary);
+
+		if (!file)
+		{
+			return 0;
+		}
+
+		EntryHeader header{};
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+		if (!file || header.magic != CACHE_MAGIC || header.version != CACHE_FORMAT_VERSION || header.key != key)
+		{
+			return 0;
+		}
+
+		std::vector<char> binary(header.binarySize);
+		file.read(binary.data(), binary.size());
+
+		if (!file)
+		{
+			return 0;
+		}
+
+		GLuint program = glCreateProgram();
+		glProgramBinary(program, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+
+		GLint success = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+		if (!success)
+		{
+			// driver rejected the binary (usually after a driver update), fall back to compiling from source
+			glDeleteProgram(program);
+			file.close();
+
+			std::error_code ec;
+			std::filesystem::remove(getEntryPath(key), ec);
+
+			return 0;
+		}
+
+		return program;
+	}
+
+	void ShaderCache::store(uint64_t key, GLuint program)
+	{
+		if (!enabled || !isSupported())
+		{
+			return;
+		}
+
+		GLint success = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+		GLint binarySize = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+
+		if (!success || binarySize <= 0)
+		{
+			return;
+		}
+
+		std::vector<char> binary(binarySize);
+		GLenum binaryFormat = 0;
+		glGetProgramBinary(program, binarySize, nullptr, &binaryFormat, binary.data());
+
+		std::error_code ec;
+		std::filesystem::create_directories(directory, ec);
+
+		std::ofstream file(getEntryPath(key), std::ios::binary | std::ios::trunc);
+
+		if (!file)
+		{
+			std::cerr << "ERROR: could not write shader cache entry: " << getEntryPath(key) << std::endl;
+			return;
+		}
+
+		EntryHeader header{ CACHE_MAGIC, CACHE_FORMAT_VERSION, key, binaryFormat, (uint32_t)binarySize };
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(binary.data(), binary.size());
+	}
+
+	bool ShaderCache::isSupported()
+	{
+		static const bool SUPPORTED = []()
+		{
+			GLint formatCount = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+			return formatCount > 0;
+		}();
+
+		return SUPPORTED;
+	}
+
+	std::filesystem::path ShaderCache::getEntryPath(uint64_t key)
+	{
+		std::stringstream filename;
+		filename << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+
+		return directory / filename.str();
+	}
+} // namespace ntr
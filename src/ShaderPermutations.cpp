@@ -0,0 +1,110 @@
+#include <glad/glad.h>
+
+#include <bitset>
+#include <utility>
+
+#include "GLState.h"
+#include "ShaderPermutations.h"
+
+namespace ntr
+{
+	ShaderPermutations::ShaderPermutations(const std::string& vertexFilepath, const std::string& fragmentFilepath, const std::string& geometryFilepath)
+		: mVertexFilepath{ vertexFilepath }
+		, mFragmentFilepath{ fragmentFilepath }
+		, mGeometryFilepath{ geometryFilepath }
+	{
+	}
+
+	ShaderPermutations::~ShaderPermutations()
+	{
+		for (auto& [features, shader] : mVariants)
+		{
+			const GLuint PROGRAM = shader.id();
+			GLState::deletePrograms(1, &PROGRAM);
+		}
+	}
+
+	Shader& ShaderPermutations::get(ShaderFeatures features)
+	{
+		Shader& requested = prepare(features);
+
+		if (requested.isReady())
+		{
+			return requested;
+		}
+
+		// features a fallback may drop, it renders with default material values / unshadowed until the variant is ready
+		const ShaderFeatures OPTIONAL_FEATURES = ShaderFeature::MATERIAL_MAPS | ShaderFeature::SHADOWS;
+
+		Shader* fallback = nullptr;
+		size_t fallbackFeatureCount = 0;
+
+		for (auto& [variantFeatures, shader] : mVariants)
+		{
+			bool sameRequired = (variantFeatures & ~OPTIONAL_FEATURES) == (features & ~OPTIONAL_FEATURES);
+			bool isSubset = (variantFeatures & ~features) == 0;
+
+			if (!sameRequired || !isSubset || !shader.isReady())
+			{
+				continue;
+			}
+
+			// prefer the closest match
+			size_t featureCount = std::bitset<32>(variantFeatures).count();
+
+			if (!fallback || featureCount > fallbackFeatureCount)
+			{
+				fallback = &shader;
+				fallbackFeatureCount = featureCount;
+			}
+		}
+
+		return fallback ? *fallback : requested;
+	}
+
+	Shader& ShaderPermutations::prepare(ShaderFeatures features)
+	{
+		auto itr = mVariants.find(features);
+
+		if (itr != mVariants.end())
+		{
+			return itr->second;
+		}
+
+		Shader shader(mVertexFilepath, mFragmentFilepath, mGeometryFilepath, toDefines(features));
+
+		return mVariants.emplace(features, std::move(shader)).first->second;
+	}
+
+	size_t ShaderPermutations::size() const
+	{
+		return mVariants.size();
+	}
+
+	std::vector<std::string> ShaderPermutations::toDefines(ShaderFeatures features)
+	{
+		static const std::pair<ShaderFeature, const char*> FEATURE_NAMES[] = {
+			{ ShaderFeature::ALBEDO_MAP,	"ALBEDO_MAP" },
+			{ ShaderFeature::NORMAL_MAP,	"NORMAL_MAP" },
+			{ ShaderFeature::ROUGHNESS_MAP,	"ROUGHNESS_MAP" },
+			{ ShaderFeature::METALLIC_MAP,	"METALLIC_MAP" },
+			{ ShaderFeature::OCCLUSION_MAP,	"OCCLUSION_MAP" },
+			{ ShaderFeature::SHADOWS,		"SHADOWS" }
+		};
+
+		std::vector<std::string> defines;
+
+		for (const auto& [feature, name] : FEATURE_NAMES)
+		{
+			if (features & feature)
+			{
+				defines.push_back(name);
+			}
+		}
+
+		ShaderFeatures cascadeCount = (features & SHADER_FEATURE_CASCADE_MASK) >> SHADER_FEATURE_CASCADE_SHIFT;
+		defines.push_back("CASCADE_COUNT " + std::to_string(cascadeCount));
+
+		return defines;
+	}
+} // namespace ntr
@@ -0,0 +1,572 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define NTR_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define NTR_SIMD_SSE
+#endif
+
+#include "SimdMath.h"
+
+namespace ntr::simd
+{
+	namespace
+	{
+		// Lanes holds as many floats as one register of the instruction set. The kernels below are written once against
+		// it and loop over a batch Lanes::COUNT elements at a time.
+
+#if defined(NTR_SIMD_AVX2)
+
+		constexpr const char* INSTRUCTION_SET = "AVX2";
+
+		struct Lanes
+		{
+			static constexpr size_t COUNT = 8;
+
+			__m256 v;
+		};
+
+		using Mask = __m256;
+		using Ints = __m256i;
+
+		inline Lanes load(const float* p)				{ return { _mm256_load_ps(p) }; }
+		inline void store(float* p, Lanes a)			{ _mm256_store_ps(p, a.v); }
+		inline Lanes splat(float f)						{ return { _mm256_set1_ps(f) }; }
+		inline Lanes operator+(Lanes a, Lanes b)		{ return { _mm256_add_ps(a.v, b.v) }; }
+		inline Lanes operator-(Lanes a, Lanes b)		{ return { _mm256_sub_ps(a.v, b.v) }; }
+		inline Lanes operator*(Lanes a, Lanes b)		{ return { _mm256_mul_ps(a.v, b.v) }; }
+		inline Lanes operator/(Lanes a, Lanes b)		{ return { _mm256_div_ps(a.v, b.v) }; }
+		inline Lanes abs(Lanes a)						{ return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+		inline Lanes roundNearest(Lanes a)				{ return { _mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC) }; }
+		inline Ints toInts(Lanes a)						{ return _mm256_cvtps_epi32(a.v); }
+		inline Lanes select(Mask mask, Lanes a, Lanes b)	{ return { _mm256_blendv_ps(b.v, a.v, mask) }; }
+		inline Lanes negateWhere(Mask mask, Lanes a)	{ return { _mm256_xor_ps(a.v, _mm256_and_ps(mask, _mm256_set1_ps(-0.0f))) }; }
+
+		inline Mask isBitSet(Ints ints, int32_t bit)
+		{
+			const Ints BIT = _mm256_set1_epi32(bit);
+			return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(ints, BIT), BIT));
+		}
+
+#elif defined(NTR_SIMD_SSE)
+
+		constexpr const char* INSTRUCTION_SET = "SSE";
+
+		struct Lanes
+		{
+			static constexpr size_t COUNT = 4;
+
+			__m128 v;
+		};
+
+		using Mask = __m128;
+		using Ints = __m128i;
+
+		inline Lanes load(const float* p)				{ return { _mm_load_ps(p) }; }
+		inline void store(float* p, Lanes a)			{ _mm_store_ps(p, a.v); }
+		inline Lanes splat(float f)						{ return { _mm_set1_ps(f) }; }
+		inline Lanes operator+(Lanes a, Lanes b)		{ return { _mm_add_ps(a.v, b.v) }; }
+		inline Lanes operator-(Lanes a, Lanes b)		{ return { _mm_sub_ps(a.v, b.v) }; }
+		inline Lanes operator*(Lanes a, Lanes b)		{ return { _mm_mul_ps(a.v, b.v) }; }
+		inline Lanes operator/(Lanes a, Lanes b)		{ return { _mm_div_ps(a.v, b.v) }; }
+		inline Lanes abs(Lanes a)						{ return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+		inline Lanes roundNearest(Lanes a)				{ return { _mm_cvtepi32_ps(_mm_cvtps_epi32(a.v)) }; } // default rounding mode
+		inline Ints toInts(Lanes a)						{ return _mm_cvtps_epi32(a.v); }
+		inline Lanes select(Mask mask, Lanes a, Lanes b)	{ return { _mm_or_ps(_mm_and_ps(mask, a.v), _mm_andnot_ps(mask, b.v)) }; }
+		inline Lanes negateWhere(Mask mask, Lanes a)	{ return { _mm_xor_ps(a.v, _mm_and_ps(mask, _mm_set1_ps(-0.0f))) }; }
+
+		inline Mask isBitSet(Ints ints, int32_t bit)
+		{
+			const Ints BIT = _mm_set1_epi32(bit);
+			return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(ints, BIT), BIT));
+		}
+
+#else
+
+		constexpr const char* INSTRUCTION_SET = "scalar";
+
+		struct Lanes
+		{
+			static constexpr size_t COUNT = 1;
+
+			float v;
+		};
+
+		using Mask = bool;
+		using Ints = int32_t;
+
+		inline Lanes load(const float* p)				{ return { *p }; }
+		inline void store(float* p, Lanes a)			{ *p = a.v; }
+		inline Lanes splat(float f)						{ return { f }; }
+		inline Lanes operator+(Lanes a, Lanes b)		{ return { a.v + b.v }; }
+		inline Lanes operator-(Lanes a, Lanes b)		{ return { a.v - b.v }; }
+		inline Lanes operator*(Lanes a, Lanes b)		{ return { a.v * b.v }; }
+		inline Lanes operator/(Lanes a, Lanes b)		{ return { a.v / b.v }; }
+		inline Lanes abs(Lanes a)						{ return { std::fabs(a.v) }; }
+		inline Lanes roundNearest(Lanes a)				{ return { std::nearbyint(a.v) }; }
+		inline Ints toInts(Lanes a)						{ return (Ints)a.v; } // already rounded
+		inline Lanes select(Mask mask, Lanes a, Lanes b)	{ return mask ? a : b; }
+		inline Lanes negateWhere(Mask mask, Lanes a)	{ return { mask ? -a.v : a.v }; }
+		inline Mask isBitSet(Ints ints, int32_t bit)	{ return (ints & bit) != 0; }
+
+#endif
+
+		constexpr float RADIANS_PER_DEGREE = 3.14159265358979f / 180.0f;
+
+		// Reducing by quarter turns in degrees is exact, the remaining angle is at most 45 degrees, where the Cephes
+		// sinf/cosf polynomials are accurate to float precision.
+		inline void sinCosDegrees(Lanes degrees, Lanes& sine, Lanes& cosine)
+		{
+			const Lanes QUADRANT = roundNearest(degrees * splat(1.0f / 90.0f));
+			const Lanes X = (degrees - QUADRANT * splat(90.0f)) * splat(RADIANS_PER_DEGREE);
+			const Lanes X2 = X * X;
+
+			const Lanes SIN = X + X * X2 * (splat(-1.6666654611e-1f) + X2 * (splat(8.3321608736e-3f) + X2 * splat(-1.9515295891e-4f)));
+			const Lanes COS = splat(1.0f) - splat(0.5f) * X2 + X2 * X2 * (splat(4.166664568298827e-2f) + X2 * (splat(-1.388731625493765e-3f) + X2 * splat(2.443315711809948e-5f)));
+
+			// quadrant q: sin = (sin, cos, -sin, -cos)[q], cos = (cos, -sin, -cos, sin)[q]
+			const Ints Q = toInts(QUADRANT);
+			const Ints Q_NEXT = toInts(QUADRANT + splat(1.0f));
+			const Mask SWAP = isBitSet(Q, 1);
+
+			sine = negateWhere(isBitSet(Q, 2), select(SWAP, COS, SIN));
+			cosine = negateWhere(isBitSet(Q_NEXT, 2), select(SWAP, SIN, COS));
+		}
+
+		inline void storeMatrix(const MatrixBatch& batch, size_t lane, glm::mat4& matrix)
+		{
+			for (int column = 0; column < 4; ++column)
+			{
+				for (int row = 0; row < 4; ++row)
+				{
+					matrix[column][row] = batch.m[column][row][lane];
+				}
+			}
+		}
+
+		inline void storeMatrix(const Matrix3Batch& batch, size_t lane, glm::mat3& matrix)
+		{
+			for (int column = 0; column < 3; ++column)
+			{
+				for (int row = 0; row < 3; ++row)
+				{
+					matrix[column][row] = batch.m[column][row][lane];
+				}
+			}
+		}
+
+		template<typename Task>
+		double getBestTimeMs(Task&& task)
+		{
+			double best = 0.0;
+
+			for (int run = 0; run < 5; ++run)
+			{
+				const auto START = std::chrono::steady_clock::now();
+				task();
+				const double TIME_MS = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - START).count();
+
+				best = run == 0 ? TIME_MS : std::min(best, TIME_MS);
+			}
+
+			return best;
+		}
+
+		// relative to the magnitude of the value, absolute below 1
+		inline float getError(float expected, float actual)
+		{
+			return std::fabs(expected - actual) / std::max(std::fabs(expected), 1.0f);
+		}
+	} // namespace
+
+	void TransformBatch::load(const Transform* transforms, size_t count)
+	{
+		for (size_t lane = 0; lane < BATCH_SIZE; ++lane)
+		{
+			const Transform& transform = lane < count ? transforms[lane] : Transform{};
+
+			for (int i = 0; i < 3; ++i)
+			{
+				position[i][lane] = transform.position[i];
+				rotation[i][lane] = transform.rotation[i];
+				scale[i][lane] = transform.scale[i];
+			}
+		}
+	}
+
+	void MatrixBatch::load(const glm::mat4* matrices, size_t count)
+	{
+		for (size_t lane = 0; lane < BATCH_SIZE; ++lane)
+		{
+			const glm::mat4 MATRIX = lane < count ? matrices[lane] : glm::mat4(1.0f);
+
+			for (int column = 0; column < 4; ++column)
+			{
+				for (int row = 0; row < 4; ++row)
+				{
+					m[column][row][lane] = MATRIX[column][row];
+				}
+			}
+		}
+	}
+
+	void MatrixBatch::store(glm::mat4* matrices, size_t count) const
+	{
+		for (size_t lane = 0; lane < std::min(count, BATCH_SIZE); ++lane)
+		{
+			storeMatrix(*this, lane, matrices[lane]);
+		}
+	}
+
+	void Matrix3Batch::store(glm::mat3* matrices, size_t count) const
+	{
+		for (size_t lane = 0; lane < std::min(count, BATCH_SIZE); ++lane)
+		{
+			storeMatrix(*this, lane, matrices[lane]);
+		}
+	}
+
+	void AABBBatch::load(const AABB* aabbs, size_t count)
+	{
+		for (size_t lane = 0; lane < BATCH_SIZE; ++lane)
+		{
+			const AABB& aabb = lane < count ? aabbs[lane] : AABB{};
+
+			for (int i = 0; i < 3; ++i)
+			{
+				min[i][lane] = aabb.min[i];
+				max[i][lane] = aabb.max[i];
+			}
+		}
+	}
+
+	void AABBBatch::store(AABB* aabbs, size_t count) const
+	{
+		for (size_t lane = 0; lane < std::min(count, BATCH_SIZE); ++lane)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				aabbs[lane].min[i] = min[i][lane];
+				aabbs[lane].max[i] = max[i][lane];
+			}
+		}
+	}
+
+	const char* instructionSet()
+	{
+		return INSTRUCTION_SET;
+	}
+
+	void compose(const TransformBatch& transforms, MatrixBatch& matrices)
+	{
+		const Lanes ZERO = splat(0.0f);
+		const Lanes ONE = splat(1.0f);
+
+		for (size_t lane = 0; lane < BATCH_SIZE; lane += Lanes::COUNT)
+		{
+			Lanes sinX, cosX, sinY, cosY, sinZ, cosZ;
+
+			sinCosDegrees(load(&transforms.rotation[0][lane]), sinX, cosX);
+			sinCosDegrees(load(&transforms.rotation[1][lane]), sinY, cosY);
+			sinCosDegrees(load(&transforms.rotation[2][lane]), sinZ, cosZ);
+
+			const Lanes SCALE_X = load(&transforms.scale[0][lane]);
+			const Lanes SCALE_Y = load(&transforms.scale[1][lane]);
+			const Lanes SCALE_Z = load(&transforms.scale[2][lane]);
+
+			const Lanes SIN_X_SIN_Y = sinX * sinY;
+			const Lanes COS_X_SIN_Y = cosX * sinY;
+
+			// columns of Rx * Ry * Rz * S, the order of Transform::matrix()
+
+			store(&matrices.m[0][0][lane], cosY * cosZ * SCALE_X);
+			store(&matrices.m[0][1][lane], (cosX * sinZ + SIN_X_SIN_Y * cosZ) * SCALE_X);
+			store(&matrices.m[0][2][lane], (sinX * sinZ - COS_X_SIN_Y * cosZ) * SCALE_X);
+			store(&matrices.m[0][3][lane], ZERO);
+
+			store(&matrices.m[1][0][lane], (ZERO - cosY * sinZ) * SCALE_Y);
+			store(&matrices.m[1][1][lane], (cosX * cosZ - SIN_X_SIN_Y * sinZ) * SCALE_Y);
+			store(&matrices.m[1][2][lane], (sinX * cosZ + COS_X_SIN_Y * sinZ) * SCALE_Y);
+			store(&matrices.m[1][3][lane], ZERO);
+
+			store(&matrices.m[2][0][lane], sinY * SCALE_Z);
+			store(&matrices.m[2][1][lane], (ZERO - sinX * cosY) * SCALE_Z);
+			store(&matrices.m[2][2][lane], cosX * cosY * SCALE_Z);
+			store(&matrices.m[2][3][lane], ZERO);
+
+			store(&matrices.m[3][0][lane], load(&transforms.position[0][lane]));
+			store(&matrices.m[3][1][lane], load(&transforms.position[1][lane]));
+			store(&matrices.m[3][2][lane], load(&transforms.position[2][lane]));
+			store(&matrices.m[3][3][lane], ONE);
+		}
+	}
+
+	void inverseTranspose(const MatrixBatch& matrices, Matrix3Batch& normals)
+	{
+		for (size_t lane = 0; lane < BATCH_SIZE; lane += Lanes::COUNT)
+		{
+			Lanes a[3], b[3], c[3];
+
+			for (int row = 0; row < 3; ++row)
+			{
+				a[row] = load(&matrices.m[0][row][lane]);
+				b[row] = load(&matrices.m[1][row][lane]);
+				c[row] = load(&matrices.m[2][row][lane]);
+			}
+
+			// the rows of the inverse of the columns a, b, c are b x c, c x a and a x b over the determinant
+
+			const Lanes B_CROSS_C[3] = { b[1] * c[2] - b[2] * c[1], b[2] * c[0] - b[0] * c[2], b[0] * c[1] - b[1] * c[0] };
+			const Lanes C_CROSS_A[3] = { c[1] * a[2] - c[2] * a[1], c[2] * a[0] - c[0] * a[2], c[0] * a[1] - c[1] * a[0] };
+			const Lanes A_CROSS_B[3] = { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+
+			const Lanes INVERSE_DETERMINANT = splat(1.0f) / (a[0] * B_CROSS_C[0] + a[1] * B_CROSS_C[1] + a[2] * B_CROSS_C[2]);
+
+			for (int row = 0; row < 3; ++row)
+			{
+				store(&normals.m[0][row][lane], B_CROSS_C[row] * INVERSE_DETERMINANT);
+				store(&normals.m[1][row][lane], C_CROSS_A[row] * INVERSE_DETERMINANT);
+				store(&normals.m[2][row][lane], A_CROSS_B[row] * INVERSE_DETERMINANT);
+			}
+		}
+	}
+
+	void transformAABBs(const MatrixBatch& matrices, const AABBBatch& aabbs, AABBBatch& transformed)
+	{
+		const Lanes HALF = splat(0.5f);
+
+		for (size_t lane = 0; lane < BATCH_SIZE; lane += Lanes::COUNT)
+		{
+			Lanes center[3], extent[3];
+
+			for (int i = 0; i < 3; ++i)
+			{
+				const Lanes MIN = load(&aabbs.min[i][lane]);
+				const Lanes MAX = load(&aabbs.max[i][lane]);
+
+				center[i] = (MIN + MAX) * HALF;
+				extent[i] = (MAX - MIN) * HALF;
+			}
+
+			// transform the center, and project the extents onto each axis through the absolute matrix (Arvo)
+
+			for (int row = 0; row < 3; ++row)
+			{
+				Lanes newCenter = load(&matrices.m[3][row][lane]);
+				Lanes newExtent = splat(0.0f);
+
+				for (int column = 0; column < 3; ++column)
+				{
+					const Lanes M = load(&matrices.m[column][row][lane]);
+
+					newCenter = newCenter + M * center[column];
+					newExtent = newExtent + abs(M) * extent[column];
+				}
+
+				store(&transformed.min[row][lane], newCenter - newExtent);
+				store(&transformed.max[row][lane], newCenter + newExtent);
+			}
+		}
+	}
+
+	void composeWorldMatrices(const Transform* transforms, size_t count, WorldMatrix* worlds)
+	{
+		TransformBatch transformBatch;
+		MatrixBatch matrixBatch;
+		Matrix3Batch normalBatch;
+
+		for (size_t first = 0; first < count; first += BATCH_SIZE)
+		{
+			const size_t BATCH_COUNT = std::min(BATCH_SIZE, count - first);
+
+			transformBatch.load(transforms + first, BATCH_COUNT);
+			compose(transformBatch, matrixBatch);
+			inverseTranspose(matrixBatch, normalBatch);
+
+			for (size_t lane = 0; lane < BATCH_COUNT; ++lane)
+			{
+				storeMatrix(matrixBatch, lane, worlds[first + lane].model);
+				storeMatrix(normalBatch, lane, worlds[first + lane].normal);
+			}
+		}
+	}
+
+	void inverseTransposes(const glm::mat4* matrices, size_t count, glm::mat3* normals)
+	{
+		MatrixBatch matrixBatch;
+		Matrix3Batch normalBatch;
+
+		for (size_t first = 0; first < count; first += BATCH_SIZE)
+		{
+			const size_t BATCH_COUNT = std::min(BATCH_SIZE, count - first);
+
+			matrixBatch.load(matrices + first, BATCH_COUNT);
+			inverseTranspose(matrixBatch, normalBatch);
+			normalBatch.store(normals + first, BATCH_COUNT);
+		}
+	}
+
+	void transformAABBs(const glm::mat4* matrices, const AABB* aabbs, size_t count, AABB* transformed)
+	{
+		MatrixBatch matrixBatch;
+		AABBBatch aabbBatch;
+		AABBBatch transformedBatch;
+
+		for (size_t first = 0; first < count; first += BATCH_SIZE)
+		{
+			const size_t BATCH_COUNT = std::min(BATCH_SIZE, count - first);
+
+			matrixBatch.load(matrices + first, BATCH_COUNT);
+			aabbBatch.load(aabbs + first, BATCH_COUNT);
+			transformAABBs(matrixBatch, aabbBatch, transformedBatch);
+			transformedBatch.store(transformed + first, BATCH_COUNT);
+		}
+	}
+
+	void benchmark(size_t count, std::ostream& out)
+	{
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> randomPosition(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> randomRotation(-180.0f, 180.0f);
+		std::uniform_real_distribution<float> randomScale(0.1f, 10.0f);
+
+		std::vector<Transform> transforms(count);
+		std::vector<AABB> aabbs(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			transforms[i].position	= { randomPosition(random), randomPosition(random), randomPosition(random) };
+			transforms[i].rotation	= { randomRotation(random), randomRotation(random), randomRotation(random) };
+			transforms[i].scale		= { randomScale(random), randomScale(random), randomScale(random) };
+
+			const glm::vec3 CORNER = { randomPosition(random), randomPosition(random), randomPosition(random) };
+			aabbs[i] = { CORNER, CORNER + glm::vec3(randomScale(random), randomScale(random), randomScale(random)) };
+		}
+
+		std::vector<WorldMatrix> expectedWorlds(count), worlds(count);
+		std::vector<glm::mat4> matrices(count);
+		std::vector<glm::mat3> expectedNormals(count), normals(count);
+		std::vector<AABB> expectedAABBs(count), transformedAABBs(count);
+
+		out << "Math kernels, " << count << " elements, " << instructionSet() << ", best of 5 runs" << std::endl;
+		out << std::left << std::setw(24) << "kernel" << std::right
+			<< std::setw(12) << "GLM ms" << std::setw(12) << "SIMD ms" << std::setw(10) << "speedup" << std::setw(14) << "max error" << std::endl;
+
+		auto printRow = [&out](const char* name, double glmMs, double simdMs, float error)
+		{
+			out << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3)
+				<< std::setw(12) << glmMs << std::setw(12) << simdMs << std::setw(9) << std::setprecision(2) << glmMs / simdMs << "x"
+				<< std::setw(14) << std::scientific << std::setprecision(2) << error << std::defaultfloat << std::endl;
+		};
+
+		// TRS to world and normal matrix
+
+		const double GLM_COMPOSE_MS = getBestTimeMs([&]()
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				expectedWorlds[i] = WorldMatrix(transforms[i]);
+			}
+		});
+
+		const double SIMD_COMPOSE_MS = getBestTimeMs([&]() { composeWorldMatrices(transforms.data(), count, worlds.data()); });
+
+		float composeError = 0.0f;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			matrices[i] = expectedWorlds[i].model;
+
+			for (int column = 0; column < 4; ++column)
+			{
+				for (int row = 0; row < 4; ++row)
+				{
+					composeError = std::max(composeError, getError(expectedWorlds[i].model[column][row], worlds[i].model[column][row]));
+				}
+			}
+
+			for (int column = 0; column < 3; ++column)
+			{
+				for (int row = 0; row < 3; ++row)
+				{
+					composeError = std::max(composeError, getError(expectedWorlds[i].normal[column][row], worlds[i].normal[column][row]));
+				}
+			}
+		}
+
+		printRow("TRS + normal matrix", GLM_COMPOSE_MS, SIMD_COMPOSE_MS, composeError);
+
+		// inverse transpose alone
+
+		const double GLM_INVERSE_MS = getBestTimeMs([&]()
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				expectedNormals[i] = glm::transpose(glm::inverse(glm::mat3(matrices[i])));
+			}
+		});
+
+		const double SIMD_INVERSE_MS = getBestTimeMs([&]() { inverseTransposes(matrices.data(), count, normals.data()); });
+
+		float inverseError = 0.0f;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			for (int column = 0; column < 3; ++column)
+			{
+				for (int row = 0; row < 3; ++row)
+				{
+					inverseError = std::max(inverseError, getError(expectedNormals[i][column][row], normals[i][column][row]));
+				}
+			}
+		}
+
+		printRow("inverse transpose", GLM_INVERSE_MS, SIMD_INVERSE_MS, inverseError);
+
+		// AABB transform
+
+		const double GLM_AABB_MS = getBestTimeMs([&]()
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				const glm::vec3 CENTER = (aabbs[i].min + aabbs[i].max) * 0.5f;
+				const glm::vec3 EXTENT = (aabbs[i].max - aabbs[i].min) * 0.5f;
+
+				glm::mat3 absolute(matrices[i]);
+
+				for (int column = 0; column < 3; ++column)
+				{
+					absolute[column] = glm::abs(absolute[column]);
+				}
+
+				const glm::vec3 NEW_CENTER = glm::vec3(matrices[i] * glm::vec4(CENTER, 1.0f));
+				const glm::vec3 NEW_EXTENT = absolute * EXTENT;
+
+				expectedAABBs[i] = { NEW_CENTER - NEW_EXTENT, NEW_CENTER + NEW_EXTENT };
+			}
+		});
+
+		const double SIMD_AABB_MS = getBestTimeMs([&]() { transformAABBs(matrices.data(), aabbs.data(), count, transformedAABBs.data()); });
+
+		float aabbError = 0.0f;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				aabbError = std::max(aabbError, getError(expectedAABBs[i].min[axis], transformedAABBs[i].min[axis]));
+				aabbError = std::max(aabbError, getError(expectedAABBs[i].max[axis], transformedAABBs[i].max[axis]));
+			}
+		}
+
+		printRow("AABB transform", GLM_AABB_MS, SIMD_AABB_MS, aabbError);
+	}
+} // namespace ntr::simd
@@ -0,0 +1,224 @@
+#ifndef NTR_SLOT_MAP_HPP
+#define NTR_SLOT_MAP_HPP
+
+#include <utility>
+
+#include "SlotMap.h"
+
+namespace ntr
+{
+	//#################################################################################################
+	//
+	// HANDLE IMPLEMENTATION
+	//
+	//#################################################################################################
+
+	template <typename T>
+	inline uint32_t Handle<T>::index() const
+	{
+		return value & INDEX_MASK;
+	}
+
+	template <typename T>
+	inline uint32_t Handle<T>::generation() const
+	{
+		return value >> INDEX_BITS;
+	}
+
+	template <typename T>
+	inline Handle<T>::operator bool() const
+	{
+		return value != 0;
+	}
+
+	template <typename T>
+	inline bool Handle<T>::operator==(Handle<T> handle) const
+	{
+		return value == handle.value;
+	}
+
+	template <typename T>
+	inline bool Handle<T>::operator!=(Handle<T> handle) const
+	{
+		return value != handle.value;
+	}
+
+	//#################################################################################################
+	//
+	// SLOT MAP IMPLEMENTATION
+	//
+	//#################################################################################################
+
+	template <typename T>
+	template <typename... Args>
+	inline Handle<T> SlotMap<T>::emplace(Args&&... args)
+	{
+		uint32_t slotIndex = mFreeSlot;
+
+		if (slotIndex != NO_SLOT)
+		{
+			mFreeSlot = mSlots[slotIndex].index;
+		}
+		else if (mSlots.size() <= Handle<T>::INDEX_MASK)
+		{
+			// generations start at 1, so slot 0 never gets the empty handle
+			slotIndex = (uint32_t)mSlots.size();
+			mSlots.push_back({ NO_SLOT, 1 });
+		}
+		else
+		{
+			return {};
+		}
+
+		Slot& slot = mSlots[slotIndex];
+		slot.index = (uint32_t)mValues.size();
+
+		const Handle<T> HANDLE{ (slot.generation << Handle<T>::INDEX_BITS) | slotIndex };
+
+		mValues.emplace_back(std::forward<Args>(args)...);
+		mHandles.push_back(HANDLE);
+
+		return HANDLE;
+	}
+
+	template <typename T>
+	inline bool SlotMap<T>::erase(Handle<T> handle)
+	{
+		const size_t INDEX = indexOf(handle);
+
+		if (INDEX == NPOS)
+		{
+			return false;
+		}
+
+		// move the last element into the gap
+
+		if (INDEX + 1 != mValues.size())
+		{
+			mValues[INDEX] = std::move(mValues.back());
+			mHandles[INDEX] = mHandles.back();
+			mSlots[mHandles[INDEX].index()].index = (uint32_t)INDEX;
+		}
+
+		mValues.pop_back();
+		mHandles.pop_back();
+
+		// a new generation invalidates handle, the one wrapping around to 0 is skipped
+
+		Slot& slot = mSlots[handle.index()];
+
+		slot.generation = (slot.generation + 1) & Handle<T>::GENERATION_MASK;
+		slot.generation = slot.generation != 0 ? slot.generation : 1;
+		slot.index = mFreeSlot;
+
+		mFreeSlot = handle.index();
+
+		return true;
+	}
+
+	template <typename T>
+	inline bool SlotMap<T>::contains(Handle<T> handle) const
+	{
+		return indexOf(handle) != NPOS;
+	}
+
+	template <typename T>
+	inline T* SlotMap<T>::get(Handle<T> handle)
+	{
+		const size_t INDEX = indexOf(handle);
+
+		return INDEX != NPOS ? &mValues[INDEX] : nullptr;
+	}
+
+	template <typename T>
+	inline const T* SlotMap<T>::get(Handle<T> handle) const
+	{
+		const size_t INDEX = indexOf(handle);
+
+		return INDEX != NPOS ? &mValues[INDEX] : nullptr;
+	}
+
+	template <typename T>
+	inline size_t SlotMap<T>::indexOf(Handle<T> handle) const
+	{
+		if (!handle || handle.index() >= mSlots.size())
+		{
+			return NPOS;
+		}
+
+		const Slot& SLOT = mSlots[handle.index()];
+
+		// free slots are one generation ahead of every handle to them
+		if (SLOT.generation != handle.generation())
+		{
+			return NPOS;
+		}
+
+		return SLOT.index;
+	}
+
+	template <typename T>
+	inline Handle<T> SlotMap<T>::handleAt(size_t index) const
+	{
+		return mHandles[index];
+	}
+
+	template <typename T>
+	inline T& SlotMap<T>::operator[](size_t index)
+	{
+		return mValues[index];
+	}
+
+	template <typename T>
+	inline const T& SlotMap<T>::operator[](size_t index) const
+	{
+		return mValues[index];
+	}
+
+	template <typename T>
+	inline size_t SlotMap<T>::size() const
+	{
+		return mValues.size();
+	}
+
+	template <typename T>
+	inline bool SlotMap<T>::empty() const
+	{
+		return mValues.empty();
+	}
+
+	template <typename T>
+	inline typename std::vector<T>::iterator SlotMap<T>::begin()
+	{
+		return mValues.begin();
+	}
+
+	template <typename T>
+	inline typename std::vector<T>::iterator SlotMap<T>::end()
+	{
+		return mValues.end();
+	}
+
+	template <typename T>
+	inline typename std::vector<T>::const_iterator SlotMap<T>::begin() const
+	{
+		return mValues.begin();
+	}
+
+	template <typename T>
+	inline typename std::vector<T>::const_iterator SlotMap<T>::end() const
+	{
+		return mValues.end();
+	}
+} // namespace ntr
+
+namespace std
+{
+	template <typename T>
+	inline size_t hash<ntr::Handle<T>>::operator()(ntr::Handle<T> handle) const
+	{
+		return hash<uint32_t>()(handle.value);
+	}
+} // namespace std
+
+#endif
@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <type_traits>
+
+#include "StressScene.h"
+
+namespace ntr
+{
+	namespace
+	{
+		// [0, 1) from the top 24 bits, the same on every standard library
+		float random01(std::mt19937& rng)
+		{
+			return (float)(rng() >> 8) / 16777216.0f;
+		}
+
+		float random(std::mt19937& rng, float min, float max)
+		{
+			return min + (max - min) * random01(rng);
+		}
+
+		template<typename T>
+		size_t getPoolBytes(entt::registry& registry)
+		{
+			const auto& pool = registry.storage<T>();
+
+			// empty types have no payload, every pool keeps a dense and a sparse entity array
+			const size_t PAYLOAD = std::is_empty_v<T> ? 0 : sizeof(T);
+
+			return pool.capacity() * (PAYLOAD + 2 * sizeof(entt::entity));
+		}
+	}
+
+	bool StressScene::spawn(Scene& scene, const StressSceneSettings& settings)
+	{
+		clear(scene);
+
+		if (settings.entityCount == 0 && settings.pointLightCount == 0)
+		{
+			return true;
+		}
+
+		// handles, adding the variants moves the models
+
+		std::vector<ModelHandle> sources;
+
+		for (const auto& [id, handle, model] : scene.getModels())
+		{
+			if (!model.meshes.empty())
+			{
+				sources.push_back(handle);
+			}
+		}
+
+		if (sources.empty())
+		{
+			std::cerr << "ERROR: stress scene needs at least one model in the scene" << std::endl;
+			return false;
+		}
+
+		std::mt19937 rng(settings.seed);
+
+		// model variants, one material each
+
+		std::vector<ModelHandle> variants;
+
+		const size_t VARIANT_COUNT = std::max<size_t>(1, settings.materialVariants);
+
+		for (size_t i = 0; i < VARIANT_COUNT; ++i)
+		{
+			Material material;
+			material.baseColorFactor = { random(rng, 0.1f, 1.0f), random(rng, 0.1f, 1.0f), random(rng, 0.1f, 1.0f), 1.0f };
+			material.roughnessFactor = random(rng, 0.05f, 1.0f);
+			material.metallicFactor = random01(rng) < 0.3f ? 1.0f : 0.0f;
+
+			const MaterialHandle VARIANT_MATERIAL = scene.addMaterial(VARIANT_PREFIX + std::string("material_") + std::to_string(i), material);
+
+			Model variant = *scene.getModel(sources[i % sources.size()]);
+
+			for (auto& [id, mesh] : variant.meshes)
+			{
+				mesh.material = VARIANT_MATERIAL;
+			}
+
+			variants.emplace_back(scene.addModel(VARIANT_PREFIX + std::string("model_") + std::to_string(i), variant));
+		}
+
+		// entities spread over a square that keeps the density constant as the count grows
+
+		const float HALF_SIDE = 0.5f * settings.spacing * std::sqrt((float)std::max<size_t>(1, settings.entityCount));
+
+		std::vector<entt::entity> entities(settings.entityCount);
+		std::vector<Transform> transforms(settings.entityCount);
+		std::vector<ModelHandle> models;
+
+		models.reserve(settings.entityCount);
+
+		for (Transform& transform : transforms)
+		{
+			const float SCALE = random(rng, 0.5f, 1.5f);
+
+			transform.position = { random(rng, -HALF_SIDE, HALF_SIDE), 0.0f, random(rng, -HALF_SIDE, HALF_SIDE) };
+			transform.rotation = { 0.0f, random(rng, 0.0f, 360.0f), 0.0f };
+			transform.scale = { SCALE, SCALE, SCALE };
+
+			models.push_back(variants[rng() % variants.size()]);
+		}
+
+		scene.registry.create(entities.begin(), entities.end());
+		scene.registry.insert<StressEntity>(entities.begin(), entities.end());
+		scene.registry.insert<Transform>(entities.begin(), entities.end(), transforms.begin());
+		scene.registry.insert<ModelHandle>(entities.begin(), entities.end(), models.begin());
+
+		// point lights over the same area
+
+		std::vector<entt::entity> lightEntities(settings.pointLightCount);
+		std::vector<PointLight> lights(settings.pointLightCount);
+
+		for (PointLight& light : lights)
+		{
+			light.position = { random(rng, -HALF_SIDE, HALF_SIDE), random(rng, 1.0f, 4.0f), random(rng, -HALF_SIDE, HALF_SIDE) };
+			light.radius = 4.0f * settings.spacing;
+			light.color = glm::vec3(random(rng, 0.2f, 1.0f), random(rng, 0.2f, 1.0f), random(rng, 0.2f, 1.0f)) * 50.0f;
+		}
+
+		scene.registry.create(lightEntities.begin(), lightEntities.end());
+		scene.registry.insert<StressEntity>(lightEntities.begin(), lightEntities.end());
+		scene.registry.insert<PointLight>(lightEntities.begin(), lightEntities.end(), lights.begin());
+
+		return true;
+	}
+
+	void StressScene::clear(Scene& scene)
+	{
+		auto view = scene.registry.view<StressEntity>();
+
+		std::vector<entt::entity> entities(view.begin(), view.end());
+		scene.registry.destroy(entities.begin(), entities.end());
+
+		// no entity uses the variants any more, so removing them does not walk a large registry
+
+		std::vector<ModelHandle> models;
+
+		for (const auto& [id, handle, model] : scene.getModels())
+		{
+			if (id.rfind(VARIANT_PREFIX, 0) == 0)
+			{
+				models.push_back(handle);
+			}
+		}
+
+		for (ModelHandle model : models)
+		{
+			scene.removeModel(model);
+		}
+
+		// the materials were released with their models, unless a variant had no meshes to use its material
+
+		std::vector<MaterialHandle> materials;
+
+		for (const auto& [id, handle, material] : scene.getMaterials())
+		{
+			if (id.rfind(VARIANT_PREFIX, 0) == 0)
+			{
+				materials.push_back(handle);
+			}
+		}
+
+		for (MaterialHandle material : materials)
+		{
+			scene.removeMaterial(material);
+		}
+	}
+
+	size_t StressScene::entityCount(Scene& scene)
+	{
+		return scene.registry.storage<StressEntity>().size();
+	}
+
+	size_t StressScene::registryBytes(Scene& scene)
+	{
+		return getPoolBytes<StressEntity>(scene.registry)
+			+ getPoolBytes<Transform>(scene.registry)
+			+ getPoolBytes<WorldMatrix>(scene.registry)
+			+ getPoolBytes<ModelHandle>(scene.registry)
+			+ getPoolBytes<PointLight>(scene.registry);
+	}
+
+	void StressSweep::start(const StressSceneSettings& settings, size_t maxEntities)
+	{
+		mSettings = settings;
+		mSteps.clear();
+		mSamples.clear();
+
+		// 1k, 3k, 10k, 30k, ... evenly spaced on a log scale
+		for (size_t decade = 1000; decade < maxEntities; decade *= 10)
+		{
+			mSteps.push_back(decade);
+
+			if (decade * 3 < maxEntities)
+			{
+				mSteps.push_back(decade * 3);
+			}
+		}
+
+		mSteps.push_back(maxEntities);
+
+		mStep = 0;
+		mFrame = 0;
+		mActive = true;
+	}
+
+	void StressSweep::stop()
+	{
+		mActive = false;
+	}
+
+	bool StressSweep::active() const
+	{
+		return mActive;
+	}
+
+	void StressSweep::update(Scene& scene, float frameTimeMs, const GLStateCounters& lastFrame)
+	{
+		if (!mActive)
+		{
+			return;
+		}
+
+		// frame 0 spawns, the frame after it is the first one rendering the step
+		if (mFrame == 0)
+		{
+			spawnStep(scene);
+			++mFrame;
+			return;
+		}
+
+		Sample& sample = mSamples.back();
+
+		if (mFrame > warmupFrames)
+		{
+			sample.frameMs += frameTimeMs;
+			sample.drawCalls += (float)lastFrame.draws;
+		}
+
+		if (++mFrame <= warmupFrames + measuredFrames)
+		{
+			return;
+		}
+
+		sample.frameMs /= (float)measuredFrames;
+		sample.drawCalls /= (float)measuredFrames;
+		sample.bytesPerEntity = (float)StressScene::registryBytes(scene) / (float)std::max<size_t>(1, sample.entities);
+
+		mFrame = 0;
+
+		if (++mStep == mSteps.size())
+		{
+			mActive = false;
+		}
+	}
+
+	const std::vector<StressSweep::Sample>& StressSweep::samples() const
+	{
+		return mSamples;
+	}
+
+	bool StressSweep::writeCsv(const std::filesystem::path& filepath) const
+	{
+		std::ofstream file(filepath);
+
+		if (!file)
+		{
+			std::cerr << "ERROR: could not write stress sweep: " << filepath << std::endl;
+			return false;
+		}
+
+		file << "entities,spawn_ms,frame_ms,draw_calls,bytes_per_entity\n";
+
+		for (const Sample& sample : mSamples)
+		{
+			file << sample.entities << "," << sample.spawnMs << "," << sample.frameMs << "," << sample.drawCalls << "," << sample.bytesPerEntity << "\n";
+		}
+
+		return (bool)file;
+	}
+
+	// Private helper functions
+
+	void StressSweep::spawnStep(Scene& scene)
+	{
+		StressSceneSettings settings = mSettings;
+		settings.entityCount = mSteps[mStep];
+
+		const auto BEGIN = std::chrono::steady_clock::now();
+
+		if (!StressScene::spawn(scene, settings))
+		{
+			mActive = false;
+			return;
+		}
+
+		const std::chrono::duration<float, std::milli> SPAWN_TIME = std::chrono::steady_clock::now() - BEGIN;
+
+		Sample& sample = mSamples.emplace_back();
+		sample.entities = settings.entityCount;
+		sample.spawnMs = SPAWN_TIME.count();
+	}
+} // namespace ntr
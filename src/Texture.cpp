@@ -1,12 +1,18 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <vector>
 
+#include "GLDeletionQueue.h"
+#include "GLState.h"
 #include "Image.h"
 #include "Texture.h"
+#include "TextureFile.h"
 
 namespace ntr
 {
 	TextureFilter Texture::defaultFilter = TextureFilter::BILINEAR;
+	int Texture::streamingResidentSize = 128;
 
 	//#################################################################################################
 	//
@@ -20,12 +26,38 @@ namespace ntr
 		, mHeight{ 0 }
 		, mChannels{ 0 }
 		, mFilter{ defaultFilter }
+		, mSizeBytes{ 0 }
+		, mCompressed{ false }
+		, mFilepath{}
+		, mUsage{ TextureUsage::COLOR }
+		, mFormat{ 0 }
+		, mLevelSizes{}
+		, mResidentLevel{ 0 }
+		, mPinnedLevel{ 0 }
 	{
 	}
 
-	Texture::Texture(const std::filesystem::path& filepath, TextureFilter filter)
-		: mFilter{ filter }
+	Texture::Texture(const std::filesystem::path& filepath, TextureUsage usage, TextureFilter filter)
+		: Texture{}
 	{
+		mFilter = filter;
+		mFilepath = filepath;
+		mUsage = usage;
+
+		CompressedImage compressedImage;
+
+		if (loadCompressed(filepath, usage, compressedImage))
+		{
+			initCompressed(compressedImage);
+			return;
+		}
+
+		if (TextureFile::isCompressedFile(filepath))
+		{
+			init(GL_RGBA, nullptr);
+			return;
+		}
+
 		Image image(filepath);
 
 		mWidth = image.width();
@@ -55,6 +87,14 @@ namespace ntr
 		, mWidth{ width }
 		, mHeight{ height }
 		, mChannels{ 4 }
+		, mSizeBytes{ 0 }
+		, mCompressed{ false }
+		, mFilepath{}
+		, mUsage{ TextureUsage::COLOR }
+		, mFormat{ 0 }
+		, mLevelSizes{}
+		, mResidentLevel{ 0 }
+		, mPinnedLevel{ 0 }
 	{
 		const size_t SIZE = static_cast<size_t>(width * height * mChannels);
 		std::vector<unsigned char> pixels(SIZE);
@@ -69,6 +109,16 @@ namespace ntr
 
 		init(GL_RGBA, pixels.data());
 	}
+
+	Texture::Texture(const CompressedImageView& image, const std::filesystem::path& filepath, TextureUsage usage, TextureFilter filter)
+		: Texture{}
+	{
+		mFilter = filter;
+		mFilepath = filepath;
+		mUsage = usage;
+
+		initCompressed(image);
+	}
 	
 	Texture::Texture(Texture&& texture) noexcept
 		: mID{ std::move(texture.mID) }
@@ -76,10 +126,19 @@ namespace ntr
 		, mHeight{ std::move(texture.mHeight) }
 		, mChannels{ std::move(texture.mChannels) }
 		, mFilter{ std::move(texture.mFilter) }
+		, mSizeBytes{ std::move(texture.mSizeBytes) }
+		, mCompressed{ std::move(texture.mCompressed) }
+		, mFilepath{ std::move(texture.mFilepath) }
+		, mUsage{ std::move(texture.mUsage) }
+		, mFormat{ std::move(texture.mFormat) }
+		, mLevelSizes{ std::move(texture.mLevelSizes) }
+		, mResidentLevel{ std::move(texture.mResidentLevel) }
+		, mPinnedLevel{ std::move(texture.mPinnedLevel) }
 	{
 		texture.mID = 0;
 		texture.mWidth = 0;
 		texture.mHeight = 0;
+		texture.mSizeBytes = 0;
 	}
 
 	Texture& Texture::operator=(Texture&& texture) noexcept
@@ -89,13 +148,22 @@ namespace ntr
 		std::swap(mHeight, texture.mHeight);
 		std::swap(mChannels, texture.mChannels);
 		std::swap(mFilter, texture.mFilter);
+		std::swap(mSizeBytes, texture.mSizeBytes);
+		std::swap(mCompressed, texture.mCompressed);
+		std::swap(mFilepath, texture.mFilepath);
+		std::swap(mUsage, texture.mUsage);
+		std::swap(mFormat, texture.mFormat);
+		std::swap(mLevelSizes, texture.mLevelSizes);
+		std::swap(mResidentLevel, texture.mResidentLevel);
+		std::swap(mPinnedLevel, texture.mPinnedLevel);
 
 		return *this;
 	}
 
 	Texture::~Texture()
 	{
-		glDeleteTextures(1, &mID);
+		// frames in flight may still sample the texture
+		GLDeletionQueue::deleteTextures(1, &mID);
 	}
 
 	int Texture::channels() const
@@ -103,6 +171,11 @@ namespace ntr
 		return mChannels;
 	}
 
+	bool Texture::compressed() const
+	{
+		return mCompressed;
+	}
+
 	TextureFilter Texture::filter() const
 	{
 		return mFilter;
@@ -113,7 +186,7 @@ namespace ntr
 		return mHeight;
 	}
 
-	TextureHandle Texture::handle() const
+	GLuint Texture::id() const
 	{
 		return mID;
 	}
@@ -123,20 +196,168 @@ namespace ntr
 		return mWidth;
 	}
 
+	size_t Texture::sizeBytes() const
+	{
+		return mSizeBytes;
+	}
+
+	const std::filesystem::path& Texture::filepath() const
+	{
+		return mFilepath;
+	}
+
+	TextureUsage Texture::usage() const
+	{
+		return mUsage;
+	}
+
+	GLenum Texture::format() const
+	{
+		return mFormat;
+	}
+
+	int Texture::levelCount() const
+	{
+		return static_cast<int>(mLevelSizes.size());
+	}
+
+	size_t Texture::levelSizeBytes(int level) const
+	{
+		return mLevelSizes[level];
+	}
+
+	int Texture::residentLevel() const
+	{
+		return mResidentLevel;
+	}
+
+	int Texture::pinnedLevel() const
+	{
+		return mPinnedLevel;
+	}
+
+	bool Texture::streamable() const
+	{
+		return mCompressed && mPinnedLevel > 0;
+	}
+
+	bool Texture::readCompressed(CompressedImage& image) const
+	{
+		if (!mCompressed || mResidentLevel > 0)
+		{
+			return false;
+		}
+
+		image.format = mFormat;
+		image.width = mWidth;
+		image.height = mHeight;
+		image.channels = mChannels;
+		image.levels.clear();
+
+		for (int i = 0; i < levelCount(); ++i)
+		{
+			std::vector<unsigned char> level(mLevelSizes[i]);
+			glGetCompressedTextureImage(mID, i, (GLsizei)level.size(), level.data());
+
+			image.levels.push_back(std::move(level));
+		}
+
+		return true;
+	}
+
+	bool Texture::loadCompressed(const std::filesystem::path& filepath, TextureUsage usage, CompressedImage& image)
+	{
+		if (TextureFile::isCompressedFile(filepath))
+		{
+			return TextureFile::load(filepath, image);
+		}
+
+		return TextureCooker::enabled && TextureCooker::cook(filepath, usage, image);
+	}
+
 	void Texture::init(GLenum format, const unsigned char* pixels)
 	{
-		glGenTextures(1, &mID);
+		glCreateTextures(GL_TEXTURE_2D, 1, &mID);
+
+		initParameters();
+
+		// images that failed to load stay an empty texture, immutable storage needs a size
+		if (mWidth <= 0 || mHeight <= 0)
+		{
+			return;
+		}
+
+		GLenum internalFormat = GL_RGBA8;
+
+		if (format == GL_RED)
+		{
+			internalFormat = GL_R8;
+		}
+		else if (format == GL_RGB)
+		{
+			internalFormat = GL_RGB8;
+		}
+
+		const GLsizei LEVELS = (GLsizei)std::log2(std::max(mWidth, mHeight)) + 1;
+
+		glTextureStorage2D(mID, LEVELS, internalFormat, mWidth, mHeight);
+
+		if (pixels)
+		{
+			glTextureSubImage2D(mID, 0, 0, 0, mWidth, mHeight, format, GL_UNSIGNED_BYTE, pixels);
+			glGenerateTextureMipmap(mID);
+		}
+
+		// full mip chain adds a third
+		mSizeBytes = static_cast<size_t>(mWidth) * mHeight * mChannels * 4 / 3;
+	}
+
+	void Texture::initCompressed(const CompressedImageView& image)
+	{
+		mWidth = image.width;
+		mHeight = image.height;
+		mChannels = image.channels;
+		mCompressed = true;
+		mFormat = image.format;
+
+		mLevelSizes.clear();
+
+		mLevelSizes = image.levelSizes;
+
+		// only the small mips go up front when streaming, the rest is requested by TextureStreamer once the texture is seen
+		mPinnedLevel = 0;
+
+		while (streamingResidentSize > 0 && !mFilepath.empty() && mPinnedLevel + 1 < levelCount()
+			&& std::max(mWidth >> mPinnedLevel, mHeight >> mPinnedLevel) > streamingResidentSize)
+		{
+			++mPinnedLevel;
+		}
 
-		glBindTexture(GL_TEXTURE_2D, mID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, mWidth, mHeight, 0, format, GL_UNSIGNED_BYTE, pixels);
-		glGenerateMipmap(GL_TEXTURE_2D);
+		mResidentLevel = mPinnedLevel;
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mFilter);
+		// mutable storage, so TextureStreamer can release levels again
+		glCreateTextures(GL_TEXTURE_2D, 1, &mID);
+		glTextureParameteri(mID, GL_TEXTURE_BASE_LEVEL, mResidentLevel);
+		glTextureParameteri(mID, GL_TEXTURE_MAX_LEVEL, levelCount() - 1);
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+		GLState::bindUploadTexture(GL_TEXTURE_2D, mID);
+
+		for (int i = mResidentLevel; i < levelCount(); ++i)
+		{
+			glCompressedTexImage2D(GL_TEXTURE_2D, i, mFormat, std::max(1, mWidth >> i), std::max(1, mHeight >> i), 0, (GLsizei)image.levelSizes[i], image.levels[i]);
+
+			mSizeBytes += image.levelSizes[i];
+		}
+
+		initParameters();
+	}
+
+	void Texture::initParameters()
+	{
+		glTextureParameteri(mID, GL_TEXTURE_WRAP_S, mChannels == 4 ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+		glTextureParameteri(mID, GL_TEXTURE_WRAP_T, mChannels == 4 ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+		glTextureParameteri(mID, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+		glTextureParameteri(mID, GL_TEXTURE_MAG_FILTER, mFilter);
 	}
 
 	//#################################################################################################
@@ -147,29 +368,25 @@ namespace ntr
 
 	DepthTexture2D::DepthTexture2D(const GLint size)
 	{
-		glGenTextures(1, &mID);
-		glBindTexture(GL_TEXTURE_2D, mID);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		glCreateTextures(GL_TEXTURE_2D, 1, &mID);
+		glTextureStorage2D(mID, 1, GL_DEPTH_COMPONENT24, size, size);
+		glTextureParameteri(mID, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTextureParameteri(mID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTextureParameteri(mID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTextureParameteri(mID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
 		float borderColor[4] = { 1.0f };
-		glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		glTextureParameterfv(mID, GL_TEXTURE_BORDER_COLOR, borderColor);
 
-		glGenFramebuffers(1, &mFBO);
-		glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, mID, 0);
-		glDrawBuffer(GL_NONE);
-		glReadBuffer(GL_NONE);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glCreateFramebuffers(1, &mFBO);
+		glNamedFramebufferTexture(mFBO, GL_DEPTH_ATTACHMENT, mID, 0);
+		glNamedFramebufferDrawBuffer(mFBO, GL_NONE);
+		glNamedFramebufferReadBuffer(mFBO, GL_NONE);
 	}
 
 	DepthTexture2D::~DepthTexture2D()
 	{
-		glDeleteFramebuffers(1, &mFBO);
-		glDeleteTextures(1, &mID);
+		GLState::deleteFramebuffers(1, &mFBO);
+		GLState::deleteTextures(1, &mID);
 	}
 
 	GLuint DepthTexture2D::fbo() const
@@ -190,24 +407,21 @@ namespace ntr
 
 	Texture2DArray::Texture2DArray(GLint resolution, size_t size)
 	{
-		glGenTextures(1, &mID);
-		glBindTexture(GL_TEXTURE_2D_ARRAY, mID);
-		glTexImage3D(
-			GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, resolution, resolution, (GLsizei)size,
-			0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+		glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &mID);
+		glTextureStorage3D(mID, 1, GL_DEPTH_COMPONENT32F, resolution, resolution, (GLsizei)size);
 
-		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		glTextureParameteri(mID, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTextureParameteri(mID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTextureParameteri(mID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTextureParameteri(mID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
 
 		const float BORDER_COLOR[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-		glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, BORDER_COLOR);
+		glTextureParameterfv(mID, GL_TEXTURE_BORDER_COLOR, BORDER_COLOR);
 	}
 
 	Texture2DArray::~Texture2DArray()
 	{
-		glDeleteTextures(1, &mID);
+		GLState::deleteTextures(1, &mID);
 	}
 
 	GLuint Texture2DArray::id() const
@@ -223,32 +437,26 @@ namespace ntr
 
 	DepthTexture3D::DepthTexture3D(const GLint& size)
 	{
-		glGenTextures(1, &mID);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, mID);
-		
-		for (GLuint i = 0; i < 6; ++i)
-		{
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-		}
-
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-		glGenFramebuffers(1, &mFBO);
-		glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
-		glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mID, 0);
-		glDrawBuffer(GL_NONE);
-		glReadBuffer(GL_NONE);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		// storage for all six faces at once
+		glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &mID);
+		glTextureStorage2D(mID, 1, GL_DEPTH_COMPONENT24, size, size);
+
+		glTextureParameteri(mID, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTextureParameteri(mID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTextureParameteri(mID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(mID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(mID, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+		glCreateFramebuffers(1, &mFBO);
+		glNamedFramebufferTexture(mFBO, GL_DEPTH_ATTACHMENT, mID, 0);
+		glNamedFramebufferDrawBuffer(mFBO, GL_NONE);
+		glNamedFramebufferReadBuffer(mFBO, GL_NONE);
 	}
 
 	DepthTexture3D::~DepthTexture3D()
 	{
-		glDeleteFramebuffers(1, &mFBO);
-		glDeleteTextures(1, &mID);
+		GLState::deleteFramebuffers(1, &mFBO);
+		GLState::deleteTextures(1, &mID);
 	}
 
 	GLuint DepthTexture3D::fbo() const
@@ -0,0 +1,511 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "Hash.h"
+#include "Image.h"
+#include "Profiler.h"
+#include "TextureCooker.h"
+
+namespace ntr
+{
+	bool					TextureCooker::enabled		= true;
+	std::filesystem::path	TextureCooker::directory	= "texture_cache";
+
+	namespace
+	{
+		// bump whenever the encoders change so stale cache entries are rebuilt
+		constexpr uint32_t COOKER_VERSION = 1;
+
+		using Pixel = std::array<uint8_t, 4>;
+
+		struct Level
+		{
+			int					width;
+			int					height;
+			std::vector<Pixel>	pixels;
+		};
+
+		// Runs task(begin, end) over [0, count) split across the hardware threads.
+		template<typename Task>
+		void parallelFor(size_t count, const Task& task)
+		{
+			const size_t THREAD_COUNT = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), count));
+			const size_t CHUNK = (count + THREAD_COUNT - 1) / THREAD_COUNT;
+
+			std::vector<std::thread> threads;
+
+			for (size_t begin = CHUNK; begin < count; begin += CHUNK)
+			{
+				threads.emplace_back([&task](size_t begin, size_t end)
+					{
+						NTR_PROFILE_THREAD("Texture cooker");
+						task(begin, end);
+					}, begin, std::min(count, begin + CHUNK));
+			}
+
+			// calling thread takes the first chunk
+			task(0, std::min(count, CHUNK));
+
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+		}
+
+		// Expands to rgba the same way GL does for GL_RED / GL_RG / GL_RGB uploads.
+		Level toLevel(const Image& image)
+		{
+			Level level{ image.width(), image.height(), std::vector<Pixel>((size_t)image.width() * image.height()) };
+
+			const int CHANNELS = image.channels();
+			const unsigned char* src = image.pixels();
+
+			for (size_t i = 0; i < level.pixels.size(); ++i)
+			{
+				Pixel& dst = level.pixels[i];
+				dst = { 0, 0, 0, 255 };
+
+				for (int c = 0; c < CHANNELS; ++c)
+				{
+					dst[c] = src[i * CHANNELS + c];
+				}
+			}
+
+			return level;
+		}
+
+		// 2x2 box filter, normals are renormalized so the shorter averaged vectors don't darken distant lighting
+		Level downsample(const Level& src, TextureUsage usage)
+		{
+			Level dst{ std::max(1, src.width / 2), std::max(1, src.height / 2), {} };
+			dst.pixels.resize((size_t)dst.width * dst.height);
+
+			parallelFor((size_t)dst.height, [&](size_t begin, size_t end)
+				{
+					for (int y = (int)begin; y < (int)end; ++y)
+					{
+						const int Y0 = std::min(y * 2, src.height - 1);
+						const int Y1 = std::min(y * 2 + 1, src.height - 1);
+
+						for (int x = 0; x < dst.width; ++x)
+						{
+							const int X0 = std::min(x * 2, src.width - 1);
+							const int X1 = std::min(x * 2 + 1, src.width - 1);
+
+							const Pixel* samples[4] = {
+								&src.pixels[(size_t)Y0 * src.width + X0],
+								&src.pixels[(size_t)Y0 * src.width + X1],
+								&src.pixels[(size_t)Y1 * src.width + X0],
+								&src.pixels[(size_t)Y1 * src.width + X1]
+							};
+
+							float sum[4] = {};
+
+							for (const Pixel* sample : samples)
+							{
+								for (int c = 0; c < 4; ++c)
+								{
+									sum[c] += (*sample)[c];
+								}
+							}
+
+							Pixel& out = dst.pixels[(size_t)y * dst.width + x];
+
+							if (usage == TextureUsage::NORMAL)
+							{
+								float n[3] = { sum[0] / 510.0f - 1.0f, sum[1] / 510.0f - 1.0f, sum[2] / 510.0f - 1.0f };
+								float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+								length = length > 0.0f ? length : 1.0f;
+
+								for (int c = 0; c < 3; ++c)
+								{
+									sum[c] = (n[c] / length * 0.5f + 0.5f) * 1020.0f;
+								}
+							}
+
+							for (int c = 0; c < 4; ++c)
+							{
+								out[c] = (uint8_t)std::clamp(sum[c] / 4.0f + 0.5f, 0.0f, 255.0f);
+							}
+						}
+					}
+				});
+
+			return dst;
+		}
+
+		void fetchBlock(const Level& level, int blockX, int blockY, Pixel block[16])
+		{
+			for (int y = 0; y < 4; ++y)
+			{
+				for (int x = 0; x < 4; ++x)
+				{
+					// edge blocks repeat the last row / column
+					const int PX = std::min(blockX * 4 + x, level.width - 1);
+					const int PY = std::min(blockY * 4 + y, level.height - 1);
+
+					block[y * 4 + x] = level.pixels[(size_t)PY * level.width + PX];
+				}
+			}
+		}
+
+		// BC4: two 8-bit endpoints and a 3-bit index per pixel, always the 8 value mode (endpoint0 > endpoint1)
+		void encodeBC4(const Pixel block[16], int channel, uint8_t* out)
+		{
+			uint8_t lo = 255;
+			uint8_t hi = 0;
+
+			for (int i = 0; i < 16; ++i)
+			{
+				lo = std::min(lo, block[i][channel]);
+				hi = std::max(hi, block[i][channel]);
+			}
+
+			out[0] = hi;
+			out[1] = lo;
+
+			uint64_t indices = 0;
+
+			if (hi != lo)
+			{
+				// steps of 1/7 from hi to lo, mapped to the index order of the format (0 = hi, 1 = lo, 2-7 in between)
+				static const uint8_t STEP_TO_INDEX[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+
+				const int RANGE = hi - lo;
+
+				for (int i = 0; i < 16; ++i)
+				{
+					int step = ((hi - block[i][channel]) * 7 + RANGE / 2) / RANGE;
+					indices |= (uint64_t)STEP_TO_INDEX[step] << (3 * i);
+				}
+			}
+
+			for (int i = 0; i < 6; ++i)
+			{
+				out[2 + i] = (uint8_t)(indices >> (8 * i));
+			}
+		}
+
+		void encodeBC5(const Pixel block[16], uint8_t* out)
+		{
+			encodeBC4(block, 0, out);
+			encodeBC4(block, 1, out + 8);
+		}
+
+		struct BitWriter
+		{
+			uint8_t*	out;
+			int			position;
+
+			void write(uint32_t value, int bitCount)
+			{
+				for (int i = 0; i < bitCount; ++i, ++position)
+				{
+					if ((value >> i) & 1)
+					{
+						out[position >> 3] |= (uint8_t)(1 << (position & 7));
+					}
+				}
+			}
+		};
+
+		// BC7 mode 6 only: one subset, 7-bit rgba endpoints with a shared p-bit each and 4-bit indices.
+		// Endpoints are fitted along the principal axis of the block, which handles the smooth gradients
+		// of typical albedo maps well, the multi-subset modes would only help on sharp edges.
+		void encodeBC7(const Pixel block[16], uint8_t* out)
+		{
+			static const int WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+			float mean[4] = {};
+
+			for (int i = 0; i < 16; ++i)
+			{
+				for (int c = 0; c < 4; ++c)
+				{
+					mean[c] += block[i][c] / 16.0f;
+				}
+			}
+
+			float covariance[4][4] = {};
+
+			for (int i = 0; i < 16; ++i)
+			{
+				for (int a = 0; a < 4; ++a)
+				{
+					for (int b = 0; b < 4; ++b)
+					{
+						covariance[a][b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+					}
+				}
+			}
+
+			// power iteration for the principal axis
+			float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+			for (int iteration = 0; iteration < 8; ++iteration)
+			{
+				float next[4] = {};
+
+				for (int a = 0; a < 4; ++a)
+				{
+					for (int b = 0; b < 4; ++b)
+					{
+						next[a] += covariance[a][b] * axis[b];
+					}
+				}
+
+				float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+
+				if (length < 1e-6f)
+				{
+					break;
+				}
+
+				for (int c = 0; c < 4; ++c)
+				{
+					axis[c] = next[c] / length;
+				}
+			}
+
+			float tMin = 0.0f;
+			float tMax = 0.0f;
+
+			for (int i = 0; i < 16; ++i)
+			{
+				float t = 0.0f;
+
+				for (int c = 0; c < 4; ++c)
+				{
+					t += (block[i][c] - mean[c]) * axis[c];
+				}
+
+				tMin = std::min(tMin, t);
+				tMax = std::max(tMax, t);
+			}
+
+			// quantize endpoints to 7 bits + p-bit, picking the p-bit with the lower error
+			int quantized[2][4];
+			int pBits[2];
+			int endpoints[2][4];
+
+			for (int e = 0; e < 2; ++e)
+			{
+				float target[4];
+
+				for (int c = 0; c < 4; ++c)
+				{
+					target[c] = std::clamp(mean[c] + axis[c] * (e == 0 ? tMin : tMax), 0.0f, 255.0f);
+				}
+
+				float bestError = -1.0f;
+
+				for (int p = 0; p < 2; ++p)
+				{
+					int candidate[4];
+					float error = 0.0f;
+
+					for (int c = 0; c < 4; ++c)
+					{
+						candidate[c] = std::clamp((int)std::lround((target[c] - p) / 2.0f), 0, 127);
+
+						float diff = target[c] - (candidate[c] * 2 + p);
+						error += diff * diff;
+					}
+
+					if (bestError < 0.0f || error < bestError)
+					{
+						bestError = error;
+						pBits[e] = p;
+						std::copy(candidate, candidate + 4, quantized[e]);
+					}
+				}
+
+				for (int c = 0; c < 4; ++c)
+				{
+					endpoints[e][c] = quantized[e][c] * 2 + pBits[e];
+				}
+			}
+
+			int indices[16];
+
+			for (int i = 0; i < 16; ++i)
+			{
+				int bestError = -1;
+
+				for (int w = 0; w < 16; ++w)
+				{
+					int error = 0;
+
+					for (int c = 0; c < 4; ++c)
+					{
+						int value = ((64 - WEIGHTS[w]) * endpoints[0][c] + WEIGHTS[w] * endpoints[1][c] + 32) >> 6;
+						int diff = value - block[i][c];
+						error += diff * diff;
+					}
+
+					if (bestError < 0 || error < bestError)
+					{
+						bestError = error;
+						indices[i] = w;
+					}
+				}
+			}
+
+			// the anchor index is stored without its top bit, so it must be < 8
+			if (indices[0] >= 8)
+			{
+				std::swap(quantized[0], quantized[1]);
+				std::swap(pBits[0], pBits[1]);
+
+				for (int& index : indices)
+				{
+					index = 15 - index;
+				}
+			}
+
+			std::fill(out, out + 16, 0);
+			BitWriter writer{ out, 0 };
+
+			writer.write(1 << 6, 7); // mode 6
+
+			for (int c = 0; c < 4; ++c)
+			{
+				writer.write(quantized[0][c], 7);
+				writer.write(quantized[1][c], 7);
+			}
+
+			writer.write(pBits[0], 1);
+			writer.write(pBits[1], 1);
+
+			for (int i = 0; i < 16; ++i)
+			{
+				writer.write(indices[i], i == 0 ? 3 : 4);
+			}
+		}
+
+		std::vector<unsigned char> encodeLevel(const Level& level, TextureUsage usage, GLenum format)
+		{
+			const int BLOCKS_X = (level.width + 3) / 4;
+			const int BLOCKS_Y = (level.height + 3) / 4;
+			const size_t BLOCK_SIZE = TextureFile::getBlockSize(format);
+
+			std::vector<unsigned char> data(TextureFile::getLevelSize(format, level.width, level.height));
+
+			parallelFor((size_t)BLOCKS_Y, [&](size_t begin, size_t end)
+				{
+					Pixel block[16];
+
+					for (int y = (int)begin; y < (int)end; ++y)
+					{
+						for (int x = 0; x < BLOCKS_X; ++x)
+						{
+							uint8_t* out = &data[((size_t)y * BLOCKS_X + x) * BLOCK_SIZE];
+
+							fetchBlock(level, x, y, block);
+
+							switch (usage)
+							{
+							case TextureUsage::COLOR:			encodeBC7(block, out);		break;
+							case TextureUsage::NORMAL:			encodeBC5(block, out);		break;
+							case TextureUsage::SINGLE_CHANNEL:	encodeBC4(block, 0, out);	break;
+							}
+						}
+					}
+				});
+
+			return data;
+		}
+	}
+
+	bool TextureCooker::cook(const std::filesystem::path& filepath, TextureUsage usage, CompressedImage& image)
+	{
+		const uint64_t KEY = getKey(filepath, usage);
+
+		if (KEY != 0 && std::filesystem::exists(getEntryPath(KEY)) && TextureFile::loadDDS(getEntryPath(KEY), image))
+		{
+			return true;
+		}
+
+		Image source(filepath);
+
+		if (!source.pixels())
+		{
+			return false;
+		}
+
+		switch (usage)
+		{
+		case TextureUsage::COLOR:			image.format = GL_COMPRESSED_RGBA_BPTC_UNORM;	image.channels = std::max(3, source.channels());	break;
+		case TextureUsage::NORMAL:			image.format = GL_COMPRESSED_RG_RGTC2;			image.channels = 2;									break;
+		case TextureUsage::SINGLE_CHANNEL:	image.format = GL_COMPRESSED_RED_RGTC1;			image.channels = 1;									break;
+		}
+
+		image.width = source.width();
+		image.height = source.height();
+		image.levels.clear();
+
+		Level level = toLevel(source);
+
+		while (true)
+		{
+			image.levels.push_back(encodeLevel(level, usage, image.format));
+
+			if (level.width == 1 && level.height == 1)
+			{
+				break;
+			}
+
+			level = downsample(level, usage);
+		}
+
+		if (KEY != 0)
+		{
+			std::error_code ec;
+			std::filesystem::create_directories(directory, ec);
+
+			TextureFile::saveDDS(getEntryPath(KEY), image);
+		}
+
+		return true;
+	}
+
+	uint64_t TextureCooker::getKey(const std::filesystem::path& filepath, TextureUsage usage)
+	{
+		std::error_code ec;
+
+		const uint64_t FILE_SIZE = (uint64_t)std::filesystem::file_size(filepath, ec);
+
+		if (ec)
+		{
+			return 0;
+		}
+
+		const int64_t WRITE_TIME = (int64_t)std::filesystem::last_write_time(filepath, ec).time_since_epoch().count();
+
+		if (ec)
+		{
+			return 0;
+		}
+
+		uint64_t hash = hashString(FNV_OFFSET_BASIS, std::filesystem::absolute(filepath, ec).generic_string());
+		hash = hashBytes(hash, &FILE_SIZE, sizeof(FILE_SIZE));
+		hash = hashBytes(hash, &WRITE_TIME, sizeof(WRITE_TIME));
+		hash = hashBytes(hash, &usage, sizeof(usage));
+		hash = hashBytes(hash, &COOKER_VERSION, sizeof(COOKER_VERSION));
+
+		return hash;
+	}
+
+	std::filesystem::path TextureCooker::getEntryPath(uint64_t key)
+	{
+		std::stringstream filename;
+		filename << std::hex << std::setw(16) << std::setfill('0') << key << ".dds";
+
+		return directory / filename.str();
+	}
+} // namespace ntr
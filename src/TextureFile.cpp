@@ -0,0 +1,499 @@
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+
+#include "TextureFile.h"
+
+namespace ntr
+{
+	namespace
+	{
+		// GL_EXT_texture_compression_s3tc, not in the core profile glad was generated for
+		constexpr GLenum COMPRESSED_RGB_S3TC_DXT1	= 0x83F0;
+		constexpr GLenum COMPRESSED_RGBA_S3TC_DXT1	= 0x83F1;
+		constexpr GLenum COMPRESSED_RGBA_S3TC_DXT3	= 0x83F2;
+		constexpr GLenum COMPRESSED_RGBA_S3TC_DXT5	= 0x83F3;
+
+		constexpr uint32_t makeFourCC(char a, char b, char c, char d)
+		{
+			return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+		}
+
+		struct FormatInfo
+		{
+			GLenum		format;
+			uint32_t	fourCC;		// legacy DDS header
+			uint32_t	dxgi;		// DDS DX10 header
+			uint32_t	vk;			// KTX2 header
+			int			channels;
+		};
+
+		// DDS BC1 may carry 1-bit alpha, so it is always loaded as RGBA.
+		// sRGB variants are loaded as UNORM, like the stb path which does not decode gamma either.
+		// The first entry of a format is the one written by saveDDS().
+		const FormatInfo FORMATS[] = {
+			{ COMPRESSED_RGB_S3TC_DXT1,		0,								0,	131, 3 },
+			{ COMPRESSED_RGB_S3TC_DXT1,		0,								0,	132, 3 },
+			{ COMPRESSED_RGBA_S3TC_DXT1,	makeFourCC('D', 'X', 'T', '1'),	71,	133, 4 },
+			{ COMPRESSED_RGBA_S3TC_DXT1,	0,								72,	134, 4 },
+			{ COMPRESSED_RGBA_S3TC_DXT3,	makeFourCC('D', 'X', 'T', '3'),	74,	135, 4 },
+			{ COMPRESSED_RGBA_S3TC_DXT3,	0,								75,	136, 4 },
+			{ COMPRESSED_RGBA_S3TC_DXT5,	makeFourCC('D', 'X', 'T', '5'),	77,	137, 4 },
+			{ COMPRESSED_RGBA_S3TC_DXT5,	0,								78,	138, 4 },
+			{ GL_COMPRESSED_RED_RGTC1,		makeFourCC('A', 'T', 'I', '1'),	80,	139, 1 },
+			{ GL_COMPRESSED_RED_RGTC1,		makeFourCC('B', 'C', '4', 'U'),	0,	0,	 1 },
+			{ GL_COMPRESSED_RG_RGTC2,		makeFourCC('A', 'T', 'I', '2'),	83,	141, 2 },
+			{ GL_COMPRESSED_RG_RGTC2,		makeFourCC('B', 'C', '5', 'U'),	0,	0,	 2 },
+			{ GL_COMPRESSED_RGBA_BPTC_UNORM,	0,							98,	145, 4 },
+			{ GL_COMPRESSED_RGBA_BPTC_UNORM,	0,							99,	146, 4 }
+		};
+
+		template<typename Predicate>
+		const FormatInfo* findFormat(Predicate predicate)
+		{
+			auto itr = std::find_if(std::begin(FORMATS), std::end(FORMATS), predicate);
+			return itr != std::end(FORMATS) ? &*itr : nullptr;
+		}
+
+		// DDS
+
+		constexpr uint32_t DDS_MAGIC				= makeFourCC('D', 'D', 'S', ' ');
+		constexpr uint32_t DDS_FOURCC_DX10			= makeFourCC('D', 'X', '1', '0');
+
+		constexpr uint32_t DDSD_CAPS				= 0x1;
+		constexpr uint32_t DDSD_HEIGHT				= 0x2;
+		constexpr uint32_t DDSD_WIDTH				= 0x4;
+		constexpr uint32_t DDSD_PIXELFORMAT			= 0x1000;
+		constexpr uint32_t DDSD_MIPMAPCOUNT			= 0x20000;
+		constexpr uint32_t DDSD_LINEARSIZE			= 0x80000;
+		constexpr uint32_t DDPF_FOURCC				= 0x4;
+		constexpr uint32_t DDSCAPS_COMPLEX			= 0x8;
+		constexpr uint32_t DDSCAPS_TEXTURE			= 0x1000;
+		constexpr uint32_t DDSCAPS_MIPMAP			= 0x400000;
+		constexpr uint32_t DDSCAPS2_CUBEMAP			= 0x200;
+		constexpr uint32_t DDSCAPS2_VOLUME			= 0x200000;
+
+		constexpr uint32_t DDS_DIMENSION_TEXTURE2D	= 3;
+		constexpr uint32_t DDS_MISC_TEXTURECUBE		= 0x4;
+		constexpr uint32_t DDS_ALPHA_MODE_STRAIGHT	= 1;
+		constexpr uint32_t DDS_ALPHA_MODE_OPAQUE	= 3;
+
+		struct DDSPixelFormat
+		{
+			uint32_t size;
+			uint32_t flags;
+			uint32_t fourCC;
+			uint32_t rgbBitCount;
+			uint32_t rBitMask;
+			uint32_t gBitMask;
+			uint32_t bBitMask;
+			uint32_t aBitMask;
+		};
+
+		struct DDSHeader
+		{
+			uint32_t		size;
+			uint32_t		flags;
+			uint32_t		height;
+			uint32_t		width;
+			uint32_t		pitchOrLinearSize;
+			uint32_t		depth;
+			uint32_t		mipMapCount;
+			uint32_t		reserved1[11];
+			DDSPixelFormat	pixelFormat;
+			uint32_t		caps;
+			uint32_t		caps2;
+			uint32_t		caps3;
+			uint32_t		caps4;
+			uint32_t		reserved2;
+		};
+
+		struct DDSHeaderDXT10
+		{
+			uint32_t dxgiFormat;
+			uint32_t resourceDimension;
+			uint32_t miscFlag;
+			uint32_t arraySize;
+			uint32_t miscFlags2;
+		};
+
+		static_assert(sizeof(DDSHeader) == 124, "DDS header must match the file layout");
+		static_assert(sizeof(DDSHeaderDXT10) == 20, "DDS DX10 header must match the file layout");
+
+		// KTX2
+
+		const unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+		// identifier, header and the fixed part of the index, level index follows
+		constexpr std::streamoff KTX2_LEVEL_INDEX_OFFSET = 80;
+
+		struct KTX2Header
+		{
+			uint32_t vkFormat;
+			uint32_t typeSize;
+			uint32_t pixelWidth;
+			uint32_t pixelHeight;
+			uint32_t pixelDepth;
+			uint32_t layerCount;
+			uint32_t faceCount;
+			uint32_t levelCount;
+			uint32_t supercompressionScheme;
+		};
+
+		struct KTX2LevelIndex
+		{
+			uint64_t byteOffset;
+			uint64_t byteLength;
+			uint64_t uncompressedByteLength;
+		};
+
+		// Returns the bytes between the read position and the end of file, or 0 if the stream failed.
+		uint64_t getBytesLeft(std::ifstream& file)
+		{
+			const std::streampos POSITION = file.tellg();
+
+			file.seekg(0, std::ios::end);
+			const std::streampos END = file.tellg();
+			file.seekg(POSITION);
+
+			return file && END >= POSITION ? (uint64_t)(END - POSITION) : 0;
+		}
+
+		// Checked before anything sized by the header is allocated.
+		bool isValidSize(uint32_t width, uint32_t height, uint32_t levelCount)
+		{
+			if (width == 0 || height == 0 || width > (uint32_t)TextureFile::MAX_DIMENSION || height > (uint32_t)TextureFile::MAX_DIMENSION)
+			{
+				return false;
+			}
+
+			return levelCount <= (uint32_t)TextureFile::getMaxLevelCount((int)width, (int)height);
+		}
+
+		bool readLevels(std::ifstream& file, CompressedImage& image, int levelCount)
+		{
+			int width = image.width;
+			int height = image.height;
+
+			for (int i = 0; i < levelCount; ++i)
+			{
+				const size_t LEVEL_SIZE = TextureFile::getLevelSize(image.format, width, height);
+
+				if (LEVEL_SIZE > getBytesLeft(file))
+				{
+					return false;
+				}
+
+				std::vector<unsigned char> level(LEVEL_SIZE);
+				file.read(reinterpret_cast<char*>(level.data()), level.size());
+
+				if (!file)
+				{
+					return false;
+				}
+
+				image.levels.push_back(std::move(level));
+
+				width = std::max(1, width / 2);
+				height = std::max(1, height / 2);
+			}
+
+			return true;
+		}
+	}
+
+	CompressedImageView::CompressedImageView(const CompressedImage& image)
+		: format{ image.format }
+		, width{ image.width }
+		, height{ image.height }
+		, channels{ image.channels }
+		, levels{}
+		, levelSizes{}
+	{
+		for (const auto& level : image.levels)
+		{
+			levels.push_back(level.data());
+			levelSizes.push_back(level.size());
+		}
+	}
+
+	bool TextureFile::isCompressedFile(const std::filesystem::path& filepath)
+	{
+		std::string extension = filepath.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+		return extension == ".dds" || extension == ".ktx2";
+	}
+
+	bool TextureFile::load(const std::filesystem::path& filepath, CompressedImage& image)
+	{
+		std::string extension = filepath.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+		if (extension == ".ktx2")
+		{
+			return loadKTX2(filepath, image);
+		}
+
+		return loadDDS(filepath, image);
+	}
+
+	bool TextureFile::loadDDS(const std::filesystem::path& filepath, CompressedImage& image)
+	{
+		std::ifstream file(filepath, std::ios::binary);
+
+		uint32_t magic = 0;
+		DDSHeader header{};
+
+		file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+		if (!file || magic != DDS_MAGIC || header.size != sizeof(DDSHeader))
+		{
+			std::cerr << "ERROR: not a DDS file: " << filepath << std::endl;
+			return false;
+		}
+
+		if ((header.caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)) || !(header.pixelFormat.flags & DDPF_FOURCC))
+		{
+			std::cerr << "ERROR: only block-compressed 2D DDS textures are supported: " << filepath << std::endl;
+			return false;
+		}
+
+		const FormatInfo* info = nullptr;
+		int channels = 0;
+
+		if (header.pixelFormat.fourCC == DDS_FOURCC_DX10)
+		{
+			DDSHeaderDXT10 headerDX10{};
+			file.read(reinterpret_cast<char*>(&headerDX10), sizeof(headerDX10));
+
+			if (!file || headerDX10.resourceDimension != DDS_DIMENSION_TEXTURE2D || headerDX10.arraySize > 1 || (headerDX10.miscFlag & DDS_MISC_TEXTURECUBE))
+			{
+				std::cerr << "ERROR: only block-compressed 2D DDS textures are supported: " << filepath << std::endl;
+				return false;
+			}
+
+			info = findFormat([&](const FormatInfo& f) { return f.dxgi != 0 && f.dxgi == headerDX10.dxgiFormat; });
+
+			if (info)
+			{
+				bool opaque = (headerDX10.miscFlags2 & 0x7) == DDS_ALPHA_MODE_OPAQUE;
+				channels = opaque ? std::min(info->channels, 3) : info->channels;
+			}
+		}
+		else
+		{
+			info = findFormat([&](const FormatInfo& f) { return f.fourCC != 0 && f.fourCC == header.pixelFormat.fourCC; });
+			channels = info ? info->channels : 0;
+		}
+
+		if (!info)
+		{
+			std::cerr << "ERROR: unsupported DDS format: " << filepath << std::endl;
+			return false;
+		}
+
+		const uint32_t LEVEL_COUNT = (header.flags & DDSD_MIPMAPCOUNT) ? std::max(1u, header.mipMapCount) : 1;
+
+		if (!isValidSize(header.width, header.height, LEVEL_COUNT))
+		{
+			std::cerr << "ERROR: invalid DDS size or mip count: " << filepath << std::endl;
+			return false;
+		}
+
+		image.format = info->format;
+		image.width = (int)header.width;
+		image.height = (int)header.height;
+		image.channels = channels;
+		image.levels.clear();
+
+		int levelCount = (int)LEVEL_COUNT;
+
+		if (!readLevels(file, image, levelCount))
+		{
+			std::cerr << "ERROR: truncated DDS file: " << filepath << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool TextureFile::loadKTX2(const std::filesystem::path& filepath, CompressedImage& image)
+	{
+		std::ifstream file(filepath, std::ios::binary);
+
+		unsigned char identifier[sizeof(KTX2_IDENTIFIER)] = {};
+		KTX2Header header{};
+
+		file.read(reinterpret_cast<char*>(identifier), sizeof(identifier));
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+		if (!file || !std::equal(std::begin(identifier), std::end(identifier), std::begin(KTX2_IDENTIFIER)))
+		{
+			std::cerr << "ERROR: not a KTX2 file: " << filepath << std::endl;
+			return false;
+		}
+
+		if (header.supercompressionScheme != 0)
+		{
+			std::cerr << "ERROR: supercompressed KTX2 files are not supported: " << filepath << std::endl;
+			return false;
+		}
+
+		if (header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1)
+		{
+			std::cerr << "ERROR: only block-compressed 2D KTX2 textures are supported: " << filepath << std::endl;
+			return false;
+		}
+
+		const FormatInfo* info = findFormat([&](const FormatInfo& f) { return f.vk != 0 && f.vk == header.vkFormat; });
+
+		if (!info)
+		{
+			std::cerr << "ERROR: unsupported KTX2 format: " << filepath << std::endl;
+			return false;
+		}
+
+		// levelCount 0 asks the loader to generate mips, which compressed formats can't do, so only the base level is used
+		const uint32_t LEVEL_COUNT = std::max(1u, header.levelCount);
+
+		if (!isValidSize(header.pixelWidth, header.pixelHeight, LEVEL_COUNT))
+		{
+			std::cerr << "ERROR: invalid KTX2 size or level count: " << filepath << std::endl;
+			return false;
+		}
+
+		image.format = info->format;
+		image.width = (int)header.pixelWidth;
+		image.height = (int)header.pixelHeight;
+		image.channels = info->channels;
+		image.levels.clear();
+
+		file.seekg(0, std::ios::end);
+		const uint64_t FILE_SIZE = file ? (uint64_t)file.tellg() : 0;
+
+		std::vector<KTX2LevelIndex> levelIndex(LEVEL_COUNT);
+
+		file.seekg(KTX2_LEVEL_INDEX_OFFSET);
+		file.read(reinterpret_cast<char*>(levelIndex.data()), levelIndex.size() * sizeof(KTX2LevelIndex));
+
+		int width = image.width;
+		int height = image.height;
+
+		for (const KTX2LevelIndex& level : levelIndex)
+		{
+			const size_t LEVEL_SIZE = getLevelSize(image.format, width, height);
+
+			if (!file || level.byteLength != LEVEL_SIZE || level.byteOffset > FILE_SIZE || LEVEL_SIZE > FILE_SIZE - level.byteOffset)
+			{
+				std::cerr << "ERROR: corrupt KTX2 level index: " << filepath << std::endl;
+				return false;
+			}
+
+			std::vector<unsigned char> pixels(LEVEL_SIZE);
+
+			file.seekg((std::streamoff)level.byteOffset);
+			file.read(reinterpret_cast<char*>(pixels.data()), pixels.size());
+
+			image.levels.push_back(std::move(pixels));
+
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+		}
+
+		if (!file)
+		{
+			std::cerr << "ERROR: truncated KTX2 file: " << filepath << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool TextureFile::saveDDS(const std::filesystem::path& filepath, const CompressedImage& image)
+	{
+		const FormatInfo* info = findFormat([&](const FormatInfo& f) { return f.format == image.format && f.dxgi != 0; });
+
+		if (!info || image.levels.empty())
+		{
+			return false;
+		}
+
+		std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+
+		if (!file)
+		{
+			std::cerr << "ERROR: could not write DDS file: " << filepath << std::endl;
+			return false;
+		}
+
+		DDSHeader header{};
+		header.size					= sizeof(DDSHeader);
+		header.flags				= DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+		header.height				= (uint32_t)image.height;
+		header.width				= (uint32_t)image.width;
+		header.pitchOrLinearSize	= (uint32_t)image.levels[0].size();
+		header.mipMapCount			= (uint32_t)image.levels.size();
+		header.pixelFormat.size		= sizeof(DDSPixelFormat);
+		header.pixelFormat.flags	= DDPF_FOURCC;
+		header.pixelFormat.fourCC	= DDS_FOURCC_DX10;
+		header.caps					= DDSCAPS_TEXTURE | (image.levels.size() > 1 ? DDSCAPS_MIPMAP | DDSCAPS_COMPLEX : 0);
+
+		DDSHeaderDXT10 headerDX10{};
+		headerDX10.dxgiFormat			= info->dxgi;
+		headerDX10.resourceDimension	= DDS_DIMENSION_TEXTURE2D;
+		headerDX10.arraySize			= 1;
+		headerDX10.miscFlags2			= image.channels < 4 ? DDS_ALPHA_MODE_OPAQUE : DDS_ALPHA_MODE_STRAIGHT;
+
+		file.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(&headerDX10), sizeof(headerDX10));
+
+		for (const auto& level : image.levels)
+		{
+			file.write(reinterpret_cast<const char*>(level.data()), level.size());
+		}
+
+		return (bool)file;
+	}
+
+	size_t TextureFile::getBlockSize(GLenum format)
+	{
+		switch (format)
+		{
+		case COMPRESSED_RGB_S3TC_DXT1:
+		case COMPRESSED_RGBA_S3TC_DXT1:
+		case GL_COMPRESSED_RED_RGTC1:
+			return 8;
+		case COMPRESSED_RGBA_S3TC_DXT3:
+		case COMPRESSED_RGBA_S3TC_DXT5:
+		case GL_COMPRESSED_RG_RGTC2:
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	size_t TextureFile::getLevelSize(GLenum format, int width, int height)
+	{
+		const size_t BLOCKS_X = (size_t)std::max(1, (width + 3) / 4);
+		const size_t BLOCKS_Y = (size_t)std::max(1, (height + 3) / 4);
+
+		return BLOCKS_X * BLOCKS_Y * getBlockSize(format);
+	}
+
+	int TextureFile::getMaxLevelCount(int width, int height)
+	{
+		int count = 0;
+
+		for (int size = std::max(width, height); size > 0; size /= 2)
+		{
+			++count;
+		}
+
+		return count;
+	}
+} // namespace ntr
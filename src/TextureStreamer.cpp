@@ -0,0 +1,373 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <tuple>
+
+#include "GLState.h"
+#include "Profiler.h"
+#include "TextureStreamer.h"
+
+namespace ntr
+{
+	//#################################################################################################
+	//
+	// STREAMED TEXTURE IMPLEMENTATION
+	//
+	//#################################################################################################
+
+	void StreamedTexture::assign(const std::string& textureID, TextureHandle textureHandle, const Texture& texture)
+	{
+		id			= textureID;
+		handle		= textureHandle;
+		name		= texture.id();
+		width		= texture.width();
+		height		= texture.height();
+		sizeBytes	= texture.sizeBytes();
+		streamable	= texture.streamable();
+
+		if (!streamable)
+		{
+			return;
+		}
+
+		filepath	= texture.filepath();
+		usage		= texture.usage();
+		format		= texture.format();
+		pinnedLevel	= texture.pinnedLevel();
+
+		levelSizes.resize(texture.levelCount());
+
+		for (int i = 0; i < texture.levelCount(); ++i)
+		{
+			levelSizes[i] = texture.levelSizeBytes(i);
+		}
+	}
+
+	//#################################################################################################
+	//
+	// TEXTURE STREAMER IMPLEMENTATION
+	//
+	//#################################################################################################
+
+	TextureStreamer::TextureStreamer()
+		: mFrame{ 0 }
+		, mResidentBytes{ 0 }
+		, mLoadsInFlight{ 0 }
+	{
+	}
+
+	void TextureStreamer::request(const Material* material, float screenSizePixels)
+	{
+		const TextureHandle TEXTURES[] = { material->albedo, material->normal, material->roughness, material->metallic, material->occlusion };
+
+		for (TextureHandle texture : TEXTURES)
+		{
+			request(texture, screenSizePixels);
+		}
+	}
+
+	void TextureStreamer::request(TextureHandle texture, float screenSizePixels)
+	{
+		if (!texture)
+		{
+			return;
+		}
+
+		float& pixels = mRequests[texture];
+		pixels = std::max(pixels, screenSizePixels);
+	}
+
+	void TextureStreamer::update(const std::vector<StreamedTexture>& textures)
+	{
+		++mFrame;
+
+		// refresh targets from this frame's requests
+
+		std::vector<StreamState*> streamable;
+		std::unordered_map<TextureHandle, StreamState> states;
+
+		mResidentBytes = 0;
+
+		for (const StreamedTexture& texture : textures)
+		{
+			if (!texture.streamable)
+			{
+				mResidentBytes += texture.sizeBytes;
+				continue;
+			}
+
+			// states of removed textures are dropped by only carrying over the ones still in the frame
+			auto itr = mStates.find(texture.handle);
+			StreamState& state = states[texture.handle];
+
+			if (itr != mStates.end())
+			{
+				state = std::move(itr->second);
+			}
+			else
+			{
+				state.texture = texture;
+				state.residentLevel = texture.pinnedLevel;
+				state.sizeBytes = texture.sizeBytes;
+				state.targetLevel = texture.pinnedLevel;
+			}
+
+			mResidentBytes += state.sizeBytes;
+
+			auto request = mRequests.find(texture.handle);
+
+			if (request != mRequests.end())
+			{
+				// one texel per pixel across the surface
+				const float TEXELS = (float)std::max(texture.width, texture.height);
+				const int LEVEL = (int)std::floor(std::log2(TEXELS / std::max(request->second, 1.0f)));
+
+				state.targetLevel = std::clamp(LEVEL, 0, texture.pinnedLevel);
+				state.lastNeededFrame = mFrame;
+			}
+		}
+
+		mStates = std::move(states);
+		mRequests.clear();
+
+		streamable.reserve(mStates.size());
+
+		for (auto& [handle, state] : mStates)
+		{
+			streamable.push_back(&state);
+		}
+
+		// upload finished loads
+
+		mLoadsInFlight = 0;
+
+		for (StreamState* state : streamable)
+		{
+			if (!state->load.valid())
+			{
+				continue;
+			}
+
+			if (state->load.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				++mLoadsInFlight;
+				continue;
+			}
+
+			CompressedImage image = state->load.get();
+
+			// the target may have gotten coarser while loading
+			const int LEVEL = std::max(state->loadLevel, state->targetLevel);
+
+			if (!image.levels.empty() && mResidentBytes + getMissingBytes(*state, LEVEL) <= budgetBytes)
+			{
+				mResidentBytes += getMissingBytes(*state, LEVEL);
+				makeResident(*state, image, LEVEL);
+			}
+		}
+
+		// evict until the mips missing this frame fit, mips in use are only evicted if the resident set alone is over budget
+
+		size_t wantedBytes = 0;
+
+		for (const StreamState* state : streamable)
+		{
+			if (state->lastNeededFrame == mFrame && !state->load.valid())
+			{
+				wantedBytes += getMissingBytes(*state, state->targetLevel);
+			}
+		}
+
+		wantedBytes = std::min(wantedBytes, budgetBytes);
+
+		while (mResidentBytes + wantedBytes > budgetBytes)
+		{
+			StreamState* victim = findEvictionVictim(streamable, mResidentBytes > budgetBytes);
+
+			if (!victim)
+			{
+				break;
+			}
+
+			mResidentBytes -= victim->texture.levelSizes[victim->residentLevel];
+			evict(*victim, victim->residentLevel + 1);
+		}
+
+		// start loads, largest missing detail first
+
+		std::vector<StreamState*> wanted;
+
+		for (StreamState* state : streamable)
+		{
+			if (state->lastNeededFrame == mFrame && !state->load.valid() && state->targetLevel < state->residentLevel)
+			{
+				wanted.push_back(state);
+			}
+		}
+
+		std::sort(wanted.begin(), wanted.end(), [](const StreamState* a, const StreamState* b)
+			{
+				return a->residentLevel - a->targetLevel > b->residentLevel - b->targetLevel;
+			});
+
+		size_t pendingBytes = 0;
+
+		for (StreamState* state : wanted)
+		{
+			if (mLoadsInFlight >= maxLoadsInFlight)
+			{
+				break;
+			}
+
+			// settle for a coarser level if the target does not fit
+			int level = state->targetLevel;
+
+			while (level < state->residentLevel && mResidentBytes + pendingBytes + getMissingBytes(*state, level) > budgetBytes)
+			{
+				++level;
+			}
+
+			if (level == state->residentLevel)
+			{
+				continue;
+			}
+
+			pendingBytes += getMissingBytes(*state, level);
+
+			state->loadLevel = level;
+			state->load = std::async(std::launch::async, [filepath = state->texture.filepath, usage = state->texture.usage]()
+				{
+					NTR_PROFILE_THREAD("Texture streaming");
+					NTR_PROFILE_SCOPE("Load compressed texture");
+
+					CompressedImage image;
+					Texture::loadCompressed(filepath, usage, image);
+					return image;
+				});
+
+			++mLoadsInFlight;
+		}
+	}
+
+	void TextureStreamer::getResidency(const StreamedTexture& texture, int& residentLevel, size_t& sizeBytes) const
+	{
+		auto itr = mStates.find(texture.handle);
+
+		if (itr == mStates.end())
+		{
+			residentLevel = texture.pinnedLevel;
+			sizeBytes = texture.sizeBytes;
+			return;
+		}
+
+		residentLevel = itr->second.residentLevel;
+		sizeBytes = itr->second.sizeBytes;
+	}
+
+	size_t TextureStreamer::residentBytes() const
+	{
+		return mResidentBytes;
+	}
+
+	size_t TextureStreamer::loadsInFlight() const
+	{
+		return mLoadsInFlight;
+	}
+
+	size_t TextureStreamer::getMissingBytes(const StreamState& state, int level)
+	{
+		size_t bytes = 0;
+
+		for (int i = level; i < state.residentLevel; ++i)
+		{
+			bytes += state.texture.levelSizes[i];
+		}
+
+		return bytes;
+	}
+
+	void TextureStreamer::makeResident(StreamState& state, const CompressedImage& image, int level)
+	{
+		const StreamedTexture& TEXTURE = state.texture;
+
+		if (level >= state.residentLevel || image.format != TEXTURE.format || image.levels.size() != TEXTURE.levelSizes.size())
+		{
+			return;
+		}
+
+		// levels are redefined one by one, which has no DSA form
+		GLState::bindUploadTexture(GL_TEXTURE_2D, TEXTURE.name);
+
+		for (int i = level; i < state.residentLevel; ++i)
+		{
+			glCompressedTexImage2D(GL_TEXTURE_2D, i, TEXTURE.format, std::max(1, TEXTURE.width >> i), std::max(1, TEXTURE.height >> i), 0,
+				(GLsizei)image.levels[i].size(), image.levels[i].data());
+
+			state.sizeBytes += TEXTURE.levelSizes[i];
+		}
+
+		// upload the finer levels before exposing them
+		glTextureParameteri(TEXTURE.name, GL_TEXTURE_BASE_LEVEL, level);
+
+		state.residentLevel = level;
+	}
+
+	void TextureStreamer::evict(StreamState& state, int level)
+	{
+		const StreamedTexture& TEXTURE = state.texture;
+
+		level = std::min(level, TEXTURE.pinnedLevel);
+
+		if (level <= state.residentLevel)
+		{
+			return;
+		}
+
+		glTextureParameteri(TEXTURE.name, GL_TEXTURE_BASE_LEVEL, level);
+
+		GLState::bindUploadTexture(GL_TEXTURE_2D, TEXTURE.name);
+
+		for (int i = state.residentLevel; i < level; ++i)
+		{
+			// redefining a level as empty releases its storage
+			glTexImage2D(GL_TEXTURE_2D, i, TEXTURE.format, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+			state.sizeBytes -= TEXTURE.levelSizes[i];
+		}
+
+		state.residentLevel = level;
+	}
+
+	TextureStreamer::StreamState* TextureStreamer::findEvictionVictim(const std::vector<StreamState*>& states, bool includeNeeded)
+	{
+		StreamState* victim = nullptr;
+		std::tuple<bool, uint64_t, int> victimRank;
+
+		for (StreamState* state : states)
+		{
+			if (state->residentLevel >= state->texture.pinnedLevel)
+			{
+				continue;
+			}
+
+			const bool ABOVE_TARGET = state->residentLevel < state->targetLevel;
+			const bool NEEDED = state->lastNeededFrame == mFrame;
+
+			if (NEEDED && !ABOVE_TARGET && !includeNeeded)
+			{
+				continue;
+			}
+
+			// mips finer than needed go first, then least recently needed, then the finest resident mip
+			const std::tuple<bool, uint64_t, int> RANK = { !ABOVE_TARGET, state->lastNeededFrame, state->residentLevel };
+
+			if (!victim || RANK < victimRank)
+			{
+				victim = state;
+				victimRank = RANK;
+			}
+		}
+
+		return victim;
+	}
+} // namespace ntr
@@ -37,4 +37,10 @@ namespace ntr
 	{
 		return glm::scale(glm::mat4(1.0f), scale);
 	}
+
+	WorldMatrix::WorldMatrix(const Transform& transform)
+		: model{ transform.matrix() }
+		, normal{ glm::transpose(glm::inverse(glm::mat3(model))) }
+	{
+	}
 } // namespace ntr
\ No newline at end of file
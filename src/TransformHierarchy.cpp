@@ -0,0 +1,398 @@
+#include <algorithm>
+#include <iostream>
+
+#include "Profiler.h"
+#include "SimdMath.h"
+#include "TransformHierarchy.h"
+
+namespace ntr
+{
+	TransformHierarchy::TransformHierarchy(entt::registry& registry)
+		: mRegistry{ registry }
+		, mNodes{}
+		, mLocals{}
+		, mWorlds{}
+		, mIndices{}
+		, mChanged{}
+		, mRanges{}
+		, mUpdated{}
+		, mStructureChanged{ false }
+	{
+		mRegistry.on_construct<Transform>().connect<&TransformHierarchy::onStructureChanged>(*this);
+		mRegistry.on_update<Transform>().connect<&TransformHierarchy::onTransformChanged>(*this);
+		mRegistry.on_destroy<Transform>().connect<&TransformHierarchy::onStructureChanged>(*this);
+		mRegistry.on_destroy<Transform>().connect<&entt::registry::remove<WorldMatrix>>();
+
+		mRegistry.on_construct<Parent>().connect<&TransformHierarchy::onStructureChanged>(*this);
+		mRegistry.on_update<Parent>().connect<&TransformHierarchy::onStructureChanged>(*this);
+		mRegistry.on_destroy<Parent>().connect<&TransformHierarchy::onStructureChanged>(*this);
+	}
+
+	TransformHierarchy::~TransformHierarchy()
+	{
+		mRegistry.on_construct<Transform>().disconnect<&TransformHierarchy::onStructureChanged>(*this);
+		mRegistry.on_update<Transform>().disconnect<&TransformHierarchy::onTransformChanged>(*this);
+		mRegistry.on_destroy<Transform>().disconnect<&TransformHierarchy::onStructureChanged>(*this);
+		mRegistry.on_destroy<Transform>().disconnect<&entt::registry::remove<WorldMatrix>>();
+
+		mRegistry.on_construct<Parent>().disconnect<&TransformHierarchy::onStructureChanged>(*this);
+		mRegistry.on_update<Parent>().disconnect<&TransformHierarchy::onStructureChanged>(*this);
+		mRegistry.on_destroy<Parent>().disconnect<&TransformHierarchy::onStructureChanged>(*this);
+	}
+
+	bool TransformHierarchy::setParent(entt::entity entity, entt::entity parent)
+	{
+		if (parent == entt::null)
+		{
+			mRegistry.remove<Parent>(entity);
+			return true;
+		}
+
+		for (entt::entity ancestor = parent; ancestor != entt::null; ancestor = getParent(ancestor))
+		{
+			if (ancestor == entity)
+			{
+				return false;
+			}
+		}
+
+		mRegistry.emplace_or_replace<Parent>(entity, parent);
+
+		return true;
+	}
+
+	entt::entity TransformHierarchy::getParent(entt::entity entity) const
+	{
+		const Parent* parent = mRegistry.try_get<Parent>(entity);
+
+		return parent && mRegistry.valid(parent->entity) ? parent->entity : entt::null;
+	}
+
+	void TransformHierarchy::update(WorkerPool& workers)
+	{
+		mUpdated.clear();
+
+		if (mStructureChanged)
+		{
+			rebuild();
+		}
+		else if (!mChanged.empty())
+		{
+			collectRanges();
+		}
+		else
+		{
+			return;
+		}
+
+		NTR_PROFILE_SCOPE("Update transform hierarchy");
+
+		for (const Range& RANGE : mRanges)
+		{
+			for (uint32_t i = RANGE.first; i < RANGE.second; ++i)
+			{
+				mUpdated.push_back(mNodes[i].entity);
+			}
+		}
+
+		// splitting replaces ranges by the subtrees of their children
+		const std::vector<Range> UPDATED_RANGES = mRanges;
+
+		splitRanges(workers.size() * 4);
+
+		// Hand out whole ranges, balanced by node count. Each range only reads parents that are outside of every range,
+		// and the workers only touch the arrays of the hierarchy, never the registry.
+
+		std::vector<uint32_t> rangeOffsets(mRanges.size());
+		uint32_t nodeCount = 0;
+
+		for (size_t i = 0; i < mRanges.size(); ++i)
+		{
+			rangeOffsets[i] = nodeCount;
+			nodeCount += mRanges[i].second - mRanges[i].first;
+		}
+
+		workers.parallelFor(nodeCount, MIN_SPLIT_NODES, [this, &rangeOffsets](size_t worker, size_t begin, size_t end)
+		{
+			NTR_PROFILE_SCOPE("Update transform subtrees");
+
+			auto range = std::lower_bound(rangeOffsets.begin(), rangeOffsets.end(), (uint32_t)begin);
+
+			for (; range != rangeOffsets.end() && *range < end; ++range)
+			{
+				const Range& RANGE = mRanges[range - rangeOffsets.begin()];
+				updateNodes(RANGE.first, RANGE.second);
+			}
+		});
+
+		NTR_PROFILE_COUNTER("Transforms updated", nodeCount);
+
+		writeWorlds(UPDATED_RANGES);
+
+		mRanges.clear();
+	}
+
+	const std::vector<entt::entity>& TransformHierarchy::getUpdatedEntities() const
+	{
+		return mUpdated;
+	}
+
+	// Private helper functions
+
+	void TransformHierarchy::onTransformChanged(entt::registry& registry, entt::entity entity)
+	{
+		if (mStructureChanged)
+		{
+			return;
+		}
+
+		auto found = mIndices.find(entity);
+
+		if (found != mIndices.end())
+		{
+			mChanged.push_back(found->second);
+		}
+	}
+
+	void TransformHierarchy::onStructureChanged(entt::registry& registry, entt::entity entity)
+	{
+		mStructureChanged = true;
+		mChanged.clear();
+	}
+
+	void TransformHierarchy::rebuild()
+	{
+		NTR_PROFILE_SCOPE("Rebuild transform hierarchy");
+
+		std::unordered_map<entt::entity, std::vector<entt::entity>> children;
+		std::vector<entt::entity> roots;
+
+		const auto transformView = mRegistry.view<Transform>();
+
+		for (entt::entity entity : transformView)
+		{
+			const entt::entity PARENT = getParent(entity);
+
+			if (PARENT != entt::null && mRegistry.all_of<Transform>(PARENT))
+			{
+				children[PARENT].push_back(entity);
+			}
+			else
+			{
+				roots.push_back(entity);
+			}
+		}
+
+		mNodes.clear();
+		mIndices.clear();
+
+		std::vector<std::pair<entt::entity, uint32_t>> stack;
+
+		auto addTree = [this, &children, &stack](entt::entity root)
+		{
+			stack.emplace_back(root, NO_PARENT);
+
+			while (!stack.empty())
+			{
+				const auto [entity, parent] = stack.back();
+				stack.pop_back();
+
+				const uint32_t INDEX = (uint32_t)mNodes.size();
+
+				mNodes.push_back({ entity, parent, INDEX + 1 });
+				mIndices.emplace(entity, INDEX);
+
+				auto found = children.find(entity);
+
+				if (found == children.end())
+				{
+					continue;
+				}
+
+				// pushed in reverse so children keep the order they were found in
+				for (auto child = found->second.rbegin(); child != found->second.rend(); ++child)
+				{
+					if (mIndices.find(*child) == mIndices.end())
+					{
+						stack.emplace_back(*child, INDEX);
+					}
+				}
+			}
+		};
+
+		for (entt::entity root : roots)
+		{
+			addTree(root);
+		}
+
+		// only a cycle of Parent components that bypassed setParent leaves entities unreached
+		for (entt::entity entity : transformView)
+		{
+			if (mIndices.find(entity) == mIndices.end())
+			{
+				std::cerr << "ERROR: Entity " << (uint32_t)entity << " is part of a Parent cycle, treating it as a root" << std::endl;
+				addTree(entity);
+			}
+		}
+
+		// children come after their parent, so one backward pass extends every subtree over its descendants
+		for (size_t i = mNodes.size(); i-- > 0;)
+		{
+			if (mNodes[i].parent != NO_PARENT)
+			{
+				Node& parent = mNodes[mNodes[i].parent];
+				parent.subtreeEnd = std::max(parent.subtreeEnd, mNodes[i].subtreeEnd);
+			}
+		}
+
+		mLocals.resize(mNodes.size());
+		mWorlds.resize(mNodes.size());
+
+		for (size_t i = 0; i < mNodes.size(); ++i)
+		{
+			mLocals[i] = mRegistry.get<Transform>(mNodes[i].entity);
+
+			if (!mRegistry.all_of<WorldMatrix>(mNodes[i].entity))
+			{
+				mRegistry.emplace<WorldMatrix>(mNodes[i].entity);
+			}
+		}
+
+		// every WorldMatrix belongs to a node, sorting by node index makes the storage follow mNodes
+
+		std::vector<uint32_t> nodeIndices; // by entity index
+
+		for (size_t i = 0; i < mNodes.size(); ++i)
+		{
+			const size_t ENTITY_INDEX = (size_t)entt::to_entity(mNodes[i].entity);
+
+			if (ENTITY_INDEX >= nodeIndices.size())
+			{
+				nodeIndices.resize(ENTITY_INDEX + 1);
+			}
+
+			nodeIndices[ENTITY_INDEX] = (uint32_t)i;
+		}
+
+		mRegistry.storage<WorldMatrix>().sort([&nodeIndices](const entt::entity lhs, const entt::entity rhs)
+		{
+			return nodeIndices[entt::to_entity(lhs)] < nodeIndices[entt::to_entity(rhs)];
+		});
+
+		mRanges.clear();
+
+		for (uint32_t root = 0; root < (uint32_t)mNodes.size(); root = mNodes[root].subtreeEnd)
+		{
+			mRanges.emplace_back(root, mNodes[root].subtreeEnd);
+		}
+
+		mChanged.clear();
+		mStructureChanged = false;
+	}
+
+	void TransformHierarchy::collectRanges()
+	{
+		std::sort(mChanged.begin(), mChanged.end());
+		mChanged.erase(std::unique(mChanged.begin(), mChanged.end()), mChanged.end());
+
+		// copied here rather than in the signal, patch() signals before the caller edits the reference it returns
+		for (uint32_t index : mChanged)
+		{
+			mLocals[index] = mRegistry.get<Transform>(mNodes[index].entity);
+		}
+
+		// a changed node inside the subtree of an earlier one is already covered by it
+		mRanges.clear();
+		uint32_t coveredEnd = 0;
+
+		for (uint32_t index : mChanged)
+		{
+			if (index >= coveredEnd)
+			{
+				coveredEnd = mNodes[index].subtreeEnd;
+				mRanges.emplace_back(index, coveredEnd);
+			}
+		}
+
+		mChanged.clear();
+	}
+
+	void TransformHierarchy::splitRanges(size_t targetCount)
+	{
+		// A single changed root would put its whole subtree on one worker. Update the root of the largest range now and
+		// replace the range with the subtrees of its children, until there is enough to share.
+
+		while (mRanges.size() < targetCount)
+		{
+			auto largest = std::max_element(mRanges.begin(), mRanges.end(), [](const Range& a, const Range& b)
+			{
+				return a.second - a.first < b.second - b.first;
+			});
+
+			if (largest == mRanges.end() || largest->second - largest->first < MIN_SPLIT_NODES)
+			{
+				break;
+			}
+
+			const Range RANGE = *largest;
+
+			updateNodes(RANGE.first, RANGE.first + 1);
+
+			std::vector<Range> childRanges;
+
+			for (uint32_t child = RANGE.first + 1; child < RANGE.second; child = mNodes[child].subtreeEnd)
+			{
+				childRanges.emplace_back(child, mNodes[child].subtreeEnd);
+			}
+
+			mRanges.insert(mRanges.erase(largest), childRanges.begin(), childRanges.end());
+		}
+	}
+
+	void TransformHierarchy::updateNodes(uint32_t begin, uint32_t end)
+	{
+		WorldMatrix locals[simd::BATCH_SIZE];
+
+		for (uint32_t first = begin; first < end; first += (uint32_t)simd::BATCH_SIZE)
+		{
+			const uint32_t COUNT = std::min((uint32_t)simd::BATCH_SIZE, end - first);
+
+			simd::composeWorldMatrices(&mLocals[first], COUNT, locals);
+
+			// in order, a parent inside the batch is done before its children
+			for (uint32_t i = 0; i < COUNT; ++i)
+			{
+				const Node& node = mNodes[first + i];
+				WorldMatrix& world = mWorlds[first + i];
+
+				if (node.parent == NO_PARENT)
+				{
+					world = locals[i];
+				}
+				else
+				{
+					const WorldMatrix& PARENT_WORLD = mWorlds[node.parent];
+
+					world.model = PARENT_WORLD.model * locals[i].model;
+					world.normal = PARENT_WORLD.normal * locals[i].normal;
+				}
+			}
+		}
+	}
+
+	void TransformHierarchy::writeWorlds(const std::vector<Range>& ranges)
+	{
+		NTR_PROFILE_SCOPE("Write world matrices");
+
+		// rebuild() sorted the storage into the order of mNodes, the ranges are ascending and don't overlap
+		auto components = mRegistry.storage<WorldMatrix>().begin();
+
+		for (const Range& RANGE : ranges)
+		{
+			for (uint32_t i = RANGE.first; i < RANGE.second; ++i)
+			{
+				components[i] = mWorlds[i];
+			}
+		}
+	}
+} // namespace ntr
@@ -0,0 +1,611 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+// SSE only, unlike the AVX2 batches of SimdMath: one ray against one node is 3 axes, which fill one 4-wide register,
+// and a traversal step has no second box to put in the upper half of an 8-wide one.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define NTR_SIMD_SSE
+#endif
+
+#include <glm/geometric.hpp>
+
+#include "Profiler.h"
+#include "TriangleBVH.h"
+
+namespace ntr
+{
+	namespace
+	{
+		constexpr float INF = std::numeric_limits<float>::infinity();
+
+		AABB getEmptyAABB()
+		{
+			return { { INF, INF, INF }, { -INF, -INF, -INF } };
+		}
+
+		void grow(AABB& aabb, const AABB& other)
+		{
+			aabb.min = glm::min(aabb.min, other.min);
+			aabb.max = glm::max(aabb.max, other.max);
+		}
+
+		void grow(AABB& aabb, const glm::vec3& point)
+		{
+			aabb.min = glm::min(aabb.min, point);
+			aabb.max = glm::max(aabb.max, point);
+		}
+
+		float getSurfaceArea(const AABB& aabb)
+		{
+			const glm::vec3 EXTENT = aabb.max - aabb.min;
+
+			return 2.0f * (EXTENT.x * EXTENT.y + EXTENT.y * EXTENT.z + EXTENT.z * EXTENT.x);
+		}
+
+		// The ray in the form the box test wants it, the w lanes zeroed so they drop out of the slab math.
+		struct RayBoxData
+		{
+#if defined(NTR_SIMD_SSE)
+			__m128 origin;
+			__m128 inverseDirection;
+#else
+			glm::vec3 origin;
+			glm::vec3 inverseDirection;
+#endif
+		};
+
+		RayBoxData getRayBoxData(const Ray& ray)
+		{
+			const glm::vec3 INVERSE_DIRECTION = 1.0f / ray.direction;
+
+#if defined(NTR_SIMD_SSE)
+			return {
+				_mm_setr_ps(ray.origin.x, ray.origin.y, ray.origin.z, 0.0f),
+				_mm_setr_ps(INVERSE_DIRECTION.x, INVERSE_DIRECTION.y, INVERSE_DIRECTION.z, 0.0f)
+			};
+#else
+			return { ray.origin, INVERSE_DIRECTION };
+#endif
+		}
+
+#if defined(NTR_SIMD_SSE)
+
+		inline float horizontalMin(__m128 v)
+		{
+			v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+			v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+			return _mm_cvtss_f32(v);
+		}
+
+		inline float horizontalMax(__m128 v)
+		{
+			v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+			v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+			return _mm_cvtss_f32(v);
+		}
+
+#endif
+
+		// Slab test against a box stored as min[3], index, max[3], count. entry is 0 if the ray starts inside.
+		inline bool intersectRayBox(const float* min, const float* max, const RayBoxData& ray, float maxDistance, float& entry)
+		{
+#if defined(NTR_SIMD_SSE)
+			// The w lanes load the index and count, whose bits read as tiny floats: times the zeroed w of the ray they
+			// become 0, which clamps the entry to the ray start. The exit takes maxDistance instead.
+			const __m128 XYZ_MASK = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+
+			const __m128 T1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(min), ray.origin), ray.inverseDirection);
+			const __m128 T2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(max), ray.origin), ray.inverseDirection);
+
+			const __m128 T_NEAR = _mm_min_ps(T1, T2);
+			const __m128 T_FAR = _mm_or_ps(_mm_and_ps(_mm_max_ps(T1, T2), XYZ_MASK), _mm_setr_ps(0.0f, 0.0f, 0.0f, maxDistance));
+
+			entry = horizontalMax(T_NEAR);
+
+			return entry <= horizontalMin(T_FAR);
+#else
+			float tNear = 0.0f;
+			float tFar = maxDistance;
+
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const float T1 = (min[axis] - ray.origin[axis]) * ray.inverseDirection[axis];
+				const float T2 = (max[axis] - ray.origin[axis]) * ray.inverseDirection[axis];
+
+				tNear = std::max(tNear, std::min(T1, T2));
+				tFar = std::min(tFar, std::max(T1, T2));
+			}
+
+			entry = tNear;
+
+			return tNear <= tFar;
+#endif
+		}
+
+		// Moller-Trumbore, both sides.
+		bool intersectRayTriangle(const Ray& ray, const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, float maxDistance, TriangleHit& hit)
+		{
+			const glm::vec3 EDGE1 = p1 - p0;
+			const glm::vec3 EDGE2 = p2 - p0;
+			const glm::vec3 P = glm::cross(ray.direction, EDGE2);
+			const float DETERMINANT = glm::dot(EDGE1, P);
+
+			if (std::abs(DETERMINANT) < std::numeric_limits<float>::min())
+			{
+				return false;
+			}
+
+			const float INVERSE_DETERMINANT = 1.0f / DETERMINANT;
+			const glm::vec3 T = ray.origin - p0;
+			const float U = glm::dot(T, P) * INVERSE_DETERMINANT;
+
+			if (U < 0.0f || U > 1.0f)
+			{
+				return false;
+			}
+
+			const glm::vec3 Q = glm::cross(T, EDGE1);
+			const float V = glm::dot(ray.direction, Q) * INVERSE_DETERMINANT;
+
+			if (V < 0.0f || U + V > 1.0f)
+			{
+				return false;
+			}
+
+			const float DISTANCE = glm::dot(EDGE2, Q) * INVERSE_DETERMINANT;
+
+			if (DISTANCE < 0.0f || DISTANCE > maxDistance)
+			{
+				return false;
+			}
+
+			hit.distance = DISTANCE;
+			hit.u = U;
+			hit.v = V;
+
+			return true;
+		}
+	}
+
+	const glm::vec3& TriangleMesh::position(uint32_t index) const
+	{
+		return *reinterpret_cast<const glm::vec3*>(positions + index * stride);
+	}
+
+	void TriangleBVH::build(const TriangleMesh& mesh, WorkerPool* workers)
+	{
+		NTR_PROFILE_SCOPE("Build triangle BVH");
+
+		clear();
+
+		const uint32_t TRIANGLE_COUNT = (uint32_t)mesh.triangleCount;
+
+		if (TRIANGLE_COUNT == 0)
+		{
+			return;
+		}
+
+		std::vector<AABB> bounds(TRIANGLE_COUNT);
+		std::vector<glm::vec3> centroids(TRIANGLE_COUNT);
+
+		mTriangles.resize(TRIANGLE_COUNT);
+		std::iota(mTriangles.begin(), mTriangles.end(), 0);
+
+		auto computeBounds = [&mesh, &bounds, &centroids](size_t worker, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				AABB& aabb = bounds[i];
+
+				aabb = getEmptyAABB();
+				grow(aabb, mesh.position(mesh.indices[3 * i + 0]));
+				grow(aabb, mesh.position(mesh.indices[3 * i + 1]));
+				grow(aabb, mesh.position(mesh.indices[3 * i + 2]));
+
+				centroids[i] = (aabb.min + aabb.max) * 0.5f;
+			}
+		};
+
+		mNodes.reserve(2 * TRIANGLE_COUNT / MAX_LEAF_SIZE + 1);
+		mNodes.push_back({ { INF, INF, INF }, 0, { -INF, -INF, -INF }, TRIANGLE_COUNT });
+
+		if (!workers || workers->size() == 1)
+		{
+			computeBounds(0, 0, TRIANGLE_COUNT);
+			buildSubtree(mNodes, bounds, centroids);
+			return;
+		}
+
+		workers->parallelFor(TRIANGLE_COUNT, MIN_PARALLEL_TRIANGLES, computeBounds);
+
+		// Split breadth first, so the pending nodes are about the same size when there are enough of them to share.
+
+		const size_t TARGET_SUBTREES = workers->size() * 4;
+
+		std::vector<uint32_t> queue = { 0 };
+		std::vector<uint32_t> subtrees;
+
+		for (size_t head = 0; head < queue.size(); ++head)
+		{
+			const uint32_t NODE = queue[head];
+
+			if (queue.size() - head + subtrees.size() >= TARGET_SUBTREES || mNodes[NODE].count < MIN_PARALLEL_TRIANGLES)
+			{
+				subtrees.push_back(NODE);
+			}
+			else if (splitNode(mNodes, NODE, bounds, centroids))
+			{
+				queue.push_back(mNodes[NODE].first);
+				queue.push_back(mNodes[NODE].first + 1);
+			}
+		}
+
+		// Every subtree owns its range of mTriangles and is built into its own array, then appended with its child
+		// indices moved past the nodes already there.
+
+		std::vector<std::vector<Node>> subtreeNodes(subtrees.size());
+
+		workers->parallelFor(subtrees.size(), 1, [this, &subtrees, &subtreeNodes, &bounds, &centroids](size_t worker, size_t begin, size_t end)
+		{
+			NTR_PROFILE_SCOPE("Build triangle BVH subtrees");
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				subtreeNodes[i].push_back(mNodes[subtrees[i]]);
+				buildSubtree(subtreeNodes[i], bounds, centroids);
+			}
+		});
+
+		for (size_t i = 0; i < subtrees.size(); ++i)
+		{
+			const std::vector<Node>& NODES = subtreeNodes[i];
+			const uint32_t OFFSET = (uint32_t)mNodes.size() - 1; // local node 0 replaces the subtree root
+
+			for (size_t local = 0; local < NODES.size(); ++local)
+			{
+				Node node = NODES[local];
+
+				if (node.count == 0)
+				{
+					node.first += OFFSET;
+				}
+
+				if (local == 0)
+				{
+					mNodes[subtrees[i]] = node;
+				}
+				else
+				{
+					mNodes.push_back(node);
+				}
+			}
+		}
+	}
+
+	void TriangleBVH::clear()
+	{
+		mNodes.clear();
+		mTriangles.clear();
+	}
+
+	bool TriangleBVH::empty() const
+	{
+		return mNodes.empty();
+	}
+
+	size_t TriangleBVH::nodeCount() const
+	{
+		return mNodes.size();
+	}
+
+	size_t TriangleBVH::bytes() const
+	{
+		return mNodes.size() * sizeof(Node) + mTriangles.size() * sizeof(uint32_t);
+	}
+
+	const void* TriangleBVH::nodeData() const
+	{
+		return mNodes.data();
+	}
+
+	const std::vector<uint32_t>& TriangleBVH::triangles() const
+	{
+		return mTriangles;
+	}
+
+	bool TriangleBVH::assign(const void* nodes, size_t nodeCount, const uint32_t* triangles, size_t triangleCount)
+	{
+		clear();
+
+		mNodes.resize(nodeCount);
+		std::memcpy(mNodes.data(), nodes, nodeCount * sizeof(Node));
+
+		// children always follow their parent, which also keeps raycast from looping on a damaged tree
+
+		for (size_t i = 0; i < mNodes.size(); ++i)
+		{
+			const Node& NODE = mNodes[i];
+
+			const bool VALID = NODE.count > 0
+				? (size_t)NODE.first + NODE.count <= triangleCount
+				: NODE.first > i && (size_t)NODE.first + 1 < mNodes.size();
+
+			if (!VALID)
+			{
+				clear();
+				return false;
+			}
+		}
+
+		mTriangles.assign(triangles, triangles + triangleCount);
+
+		for (uint32_t triangle : mTriangles)
+		{
+			if (triangle >= triangleCount)
+			{
+				clear();
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool TriangleBVH::raycast(const TriangleMesh& mesh, const Ray& ray, float maxDistance, TriangleHit& hit) const
+	{
+		if (mNodes.empty())
+		{
+			return false;
+		}
+
+		const RayBoxData RAY_BOX = getRayBoxData(ray);
+
+		float nearest = maxDistance;
+		bool found = false;
+		float entry = 0.0f;
+
+		if (!intersectRayBox(mNodes[0].min, mNodes[0].max, RAY_BOX, nearest, entry))
+		{
+			return false;
+		}
+
+		std::vector<std::pair<uint32_t, float>> stack;
+		stack.reserve(64);
+		stack.emplace_back(0, entry);
+
+		while (!stack.empty())
+		{
+			const auto [index, nodeEntry] = stack.back();
+			stack.pop_back();
+
+			// a nearer hit was found after the node was pushed
+			if (nodeEntry > nearest)
+			{
+				continue;
+			}
+
+			const Node& node = mNodes[index];
+
+			if (node.count > 0)
+			{
+				for (uint32_t i = node.first; i < node.first + node.count; ++i)
+				{
+					const uint32_t TRIANGLE = mTriangles[i];
+					const uint32_t* INDICES = mesh.indices + 3 * TRIANGLE;
+
+					TriangleHit triangleHit;
+
+					if (intersectRayTriangle(ray, mesh.position(INDICES[0]), mesh.position(INDICES[1]), mesh.position(INDICES[2]), nearest, triangleHit))
+					{
+						triangleHit.triangle = TRIANGLE;
+						hit = triangleHit;
+						nearest = triangleHit.distance;
+						found = true;
+					}
+				}
+
+				continue;
+			}
+
+			// the nearer child is pushed last, so it is visited first and can cull the other one
+
+			const Node& LEFT = mNodes[node.first];
+			const Node& RIGHT = mNodes[node.first + 1];
+
+			float leftEntry = 0.0f;
+			float rightEntry = 0.0f;
+
+			const bool HIT_LEFT = intersectRayBox(LEFT.min, LEFT.max, RAY_BOX, nearest, leftEntry);
+			const bool HIT_RIGHT = intersectRayBox(RIGHT.min, RIGHT.max, RAY_BOX, nearest, rightEntry);
+
+			if (HIT_LEFT && HIT_RIGHT)
+			{
+				if (leftEntry < rightEntry)
+				{
+					stack.emplace_back(node.first + 1, rightEntry);
+					stack.emplace_back(node.first, leftEntry);
+				}
+				else
+				{
+					stack.emplace_back(node.first, leftEntry);
+					stack.emplace_back(node.first + 1, rightEntry);
+				}
+			}
+			else if (HIT_LEFT)
+			{
+				stack.emplace_back(node.first, leftEntry);
+			}
+			else if (HIT_RIGHT)
+			{
+				stack.emplace_back(node.first + 1, rightEntry);
+			}
+		}
+
+		return found;
+	}
+
+	// Private helper functions
+
+	void TriangleBVH::buildSubtree(std::vector<Node>& nodes, const std::vector<AABB>& bounds, const std::vector<glm::vec3>& centroids)
+	{
+		std::vector<uint32_t> stack = { 0 };
+
+		while (!stack.empty())
+		{
+			const uint32_t NODE = stack.back();
+			stack.pop_back();
+
+			if (splitNode(nodes, NODE, bounds, centroids))
+			{
+				stack.push_back(nodes[NODE].first);
+				stack.push_back(nodes[NODE].first + 1);
+			}
+		}
+	}
+
+	bool TriangleBVH::splitNode(std::vector<Node>& nodes, uint32_t index, const std::vector<AABB>& bounds, const std::vector<glm::vec3>& centroids)
+	{
+		const uint32_t FIRST = nodes[index].first;
+		const uint32_t COUNT = nodes[index].count;
+		const uint32_t END = FIRST + COUNT;
+
+		AABB nodeBounds = getEmptyAABB();
+		AABB centroidBounds = getEmptyAABB();
+
+		for (uint32_t i = FIRST; i < END; ++i)
+		{
+			grow(nodeBounds, bounds[mTriangles[i]]);
+			grow(centroidBounds, centroids[mTriangles[i]]);
+		}
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			nodes[index].min[axis] = nodeBounds.min[axis];
+			nodes[index].max[axis] = nodeBounds.max[axis];
+		}
+
+		if (COUNT <= 2)
+		{
+			return false;
+		}
+
+		// Bin the centroids along every axis and take the plane between two bins with the lowest surface area cost,
+		// the area of each side times the triangles in it.
+
+		struct Bin
+		{
+			AABB		bounds = getEmptyAABB();
+			uint32_t	count = 0;
+		};
+
+		auto getBin = [&centroidBounds, &centroids](uint32_t triangle, int axis, float scale)
+		{
+			return std::min(BIN_COUNT - 1, (uint32_t)((centroids[triangle][axis] - centroidBounds.min[axis]) * scale));
+		};
+
+		float bestCost = INF;
+		int bestAxis = -1;
+		uint32_t bestPlane = 0;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float EXTENT = centroidBounds.max[axis] - centroidBounds.min[axis];
+
+			if (EXTENT <= 0.0f)
+			{
+				continue;
+			}
+
+			const float SCALE = BIN_COUNT / EXTENT;
+
+			Bin bins[BIN_COUNT];
+
+			for (uint32_t i = FIRST; i < END; ++i)
+			{
+				Bin& bin = bins[getBin(mTriangles[i], axis, SCALE)];
+
+				grow(bin.bounds, bounds[mTriangles[i]]);
+				++bin.count;
+			}
+
+			// plane i splits bins [0, i) from [i, BIN_COUNT)
+
+			float rightAreas[BIN_COUNT];
+			uint32_t rightCounts[BIN_COUNT];
+			Bin right;
+
+			for (uint32_t plane = BIN_COUNT - 1; plane > 0; --plane)
+			{
+				grow(right.bounds, bins[plane].bounds);
+				right.count += bins[plane].count;
+
+				rightAreas[plane] = getSurfaceArea(right.bounds);
+				rightCounts[plane] = right.count;
+			}
+
+			Bin left;
+
+			for (uint32_t plane = 1; plane < BIN_COUNT; ++plane)
+			{
+				grow(left.bounds, bins[plane - 1].bounds);
+				left.count += bins[plane - 1].count;
+
+				if (left.count == 0 || rightCounts[plane] == 0)
+				{
+					continue;
+				}
+
+				const float COST = getSurfaceArea(left.bounds) * left.count + rightAreas[plane] * rightCounts[plane];
+
+				if (COST < bestCost)
+				{
+					bestCost = COST;
+					bestAxis = axis;
+					bestPlane = plane;
+				}
+			}
+		}
+
+		// a box test costs about as much as a triangle test, small nodes stay leaves unless splitting saves more than that
+		const float AREA = getSurfaceArea(nodeBounds);
+
+		if (COUNT <= MAX_LEAF_SIZE && AREA + bestCost >= AREA * COUNT)
+		{
+			return false;
+		}
+
+		uint32_t middle = FIRST + COUNT / 2;
+
+		// without a plane every centroid is the same point, any split is as good as another
+		if (bestAxis >= 0)
+		{
+			const float SCALE = BIN_COUNT / (centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis]);
+
+			auto split = std::partition(mTriangles.begin() + FIRST, mTriangles.begin() + END, [&getBin, bestAxis, bestPlane, SCALE](uint32_t triangle)
+			{
+				return getBin(triangle, bestAxis, SCALE) < bestPlane;
+			});
+
+			const uint32_t SPLIT = (uint32_t)(split - mTriangles.begin());
+
+			if (SPLIT > FIRST && SPLIT < END)
+			{
+				middle = SPLIT;
+			}
+		}
+
+		const uint32_t LEFT = (uint32_t)nodes.size();
+
+		nodes.push_back({ { INF, INF, INF }, FIRST, { -INF, -INF, -INF }, middle - FIRST });
+		nodes.push_back({ { INF, INF, INF }, middle, { -INF, -INF, -INF }, END - middle });
+
+		nodes[index].first = LEFT;
+		nodes[index].count = 0;
+
+		return true;
+	}
+} // namespace ntr
@@ -0,0 +1,37 @@
+#ifndef NTR_UNIFORM_BUFFER_HPP
+#define NTR_UNIFORM_BUFFER_HPP
+
+#include "GLState.h"
+#include "UniformBuffer.h"
+
+namespace ntr
+{
+	template<typename T>
+	inline UniformBuffer<T>::UniformBuffer(GLuint binding)
+		: binding{ binding }
+	{
+		glCreateBuffers(1, &mID);
+		glNamedBufferStorage(mID, sizeof(T), nullptr, GL_DYNAMIC_STORAGE_BIT);
+		GLState::bindBufferBase(GL_UNIFORM_BUFFER, binding, mID);
+	}
+
+	template<typename T>
+	inline UniformBuffer<T>::~UniformBuffer()
+	{
+		GLState::deleteBuffers(1, &mID);
+	}
+
+	template<typename T>
+	inline void UniformBuffer<T>::bind() const
+	{
+		GLState::bindBufferBase(GL_UNIFORM_BUFFER, binding, mID);
+	}
+
+	template<typename T>
+	inline void UniformBuffer<T>::update(const T& data)
+	{
+		glNamedBufferSubData(mID, 0, sizeof(T), &data);
+	}
+}
+
+#endif
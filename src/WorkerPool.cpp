@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <string>
+
+#include "Profiler.h"
+#include "WorkerPool.h"
+
+namespace ntr
+{
+	WorkerPool::WorkerPool(size_t workerCount)
+		: mThreads{}
+		, mMutex{}
+		, mWake{}
+		, mDone{}
+		, mTask{ nullptr }
+		, mCount{ 0 }
+		, mRanges{ 0 }
+		, mPending{ 0 }
+		, mGeneration{ 0 }
+		, mStopping{ false }
+	{
+		if (workerCount == 0)
+		{
+			const size_t HARDWARE_THREADS = std::thread::hardware_concurrency();
+			workerCount = HARDWARE_THREADS > 2 ? HARDWARE_THREADS - 2 : 1;
+		}
+
+		for (size_t i = 1; i < workerCount; ++i)
+		{
+			mThreads.emplace_back(&WorkerPool::loop, this, i);
+		}
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStopping = true;
+			mWake.notify_all();
+		}
+
+		for (std::thread& thread : mThreads)
+		{
+			thread.join();
+		}
+	}
+
+	size_t WorkerPool::size() const
+	{
+		return mThreads.size() + 1;
+	}
+
+	size_t WorkerPool::parallelFor(size_t count, size_t minRange, const std::function<void(size_t range, size_t begin, size_t end)>& task)
+	{
+		const size_t RANGES = std::clamp<size_t>(count / std::max<size_t>(minRange, 1), 1, size());
+
+		// not worth waking anyone
+		if (RANGES == 1)
+		{
+			task(0, 0, count);
+			return 1;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			mTask = &task;
+			mCount = count;
+			mRanges = RANGES;
+			mPending = RANGES - 1;
+			++mGeneration;
+
+			mWake.notify_all();
+		}
+
+		task(0, 0, count / RANGES);
+
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		mDone.wait(lock, [this]() { return mPending == 0; });
+
+		return RANGES;
+	}
+
+	// Private helper functions
+
+	void WorkerPool::loop(size_t worker)
+	{
+		NTR_PROFILE_THREAD("Worker " + std::to_string(worker));
+
+		uint64_t generation = 0;
+
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		for (;;)
+		{
+			mWake.wait(lock, [this, generation]() { return mGeneration != generation || mStopping; });
+
+			if (mStopping)
+			{
+				break;
+			}
+
+			generation = mGeneration;
+
+			// fewer ranges than workers when there is little to do
+			if (worker >= mRanges)
+			{
+				continue;
+			}
+
+			const Task& task = *mTask;
+			const size_t BEGIN = mCount * worker / mRanges;
+			const size_t END = mCount * (worker + 1) / mRanges;
+
+			lock.unlock();
+			task(worker, BEGIN, END);
+			lock.lock();
+
+			if (--mPending == 0)
+			{
+				mDone.notify_one();
+			}
+		}
+	}
+} // namespace ntr
@@ -1,10 +1,80 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
 #include "App.h"
+#include "Benchmark.h"
+#include "Profiler.h"
+#include "SimdMath.h"
 
-int main()
+int main(int argc, char* argv[])
 {
-	ntr::App app;
+	std::filesystem::path benchmarkScript;
+	std::filesystem::path benchmarkOutput = "benchmark.json";
+	std::filesystem::path scenePath;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		// --capture-frames N: write a CPU trace of loading and the first N frames
+		if (std::strcmp(argv[i], "--capture-frames") == 0 && i + 1 < argc)
+		{
+			const int FRAMES = std::atoi(argv[++i]);
+
+#ifdef NTR_PROFILING
+			NTR_PROFILE_CAPTURE((uint32_t)std::max(FRAMES, 1));
+#else
+			std::cerr << "ERROR: --capture-frames " << FRAMES << " ignored, profiling is disabled in this build" << std::endl;
+#endif
+		}
+		// --benchmark SCRIPT [--benchmark-output JSON]: headless run of a benchmark script, see Benchmark.h
+		else if (std::strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc)
+		{
+			benchmarkScript = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--benchmark-output") == 0 && i + 1 < argc)
+		{
+			benchmarkOutput = argv[++i];
+		}
+		// --scene FILE: start with a saved scene instead of the default one, see SceneFile.h
+		else if (std::strcmp(argv[i], "--scene") == 0 && i + 1 < argc)
+		{
+			scenePath = argv[++i];
+		}
+		// --math-benchmark [N]: time the SIMD math kernels against GLM over N elements and exit, see SimdMath.h
+		else if (std::strcmp(argv[i], "--math-benchmark") == 0)
+		{
+			const int COUNT = i + 1 < argc ? std::atoi(argv[i + 1]) : 0;
+
+			if (COUNT > 0)
+			{
+				++i;
+			}
+
+			ntr::simd::benchmark(COUNT > 0 ? (size_t)COUNT : 1000000, std::cout);
+
+			return 0;
+		}
+	}
+
+	std::unique_ptr<ntr::Benchmark> benchmark;
+
+	if (!benchmarkScript.empty())
+	{
+		ntr::BenchmarkScript script;
+
+		if (!script.load(benchmarkScript))
+		{
+			return EXIT_FAILURE;
+		}
+
+		benchmark = std::make_unique<ntr::Benchmark>(script, benchmarkOutput);
+	}
+
+	ntr::App app(benchmark.get(), scenePath);
 
 	app.run();
 
-	return 0;
+	return benchmark && !benchmark->resultsWritten() ? EXIT_FAILURE : 0;
 }